@@ -1,5 +1,7 @@
 APP_PLATFORM := android-9
-APP_STL := stlport_static
+#stlport has no std::thread/std::future, which the thread pool needs
+APP_STL := gnustl_static
+APP_CPPFLAGS += -std=c++11
 APP_ABI := armeabi
 
 #armeabi armeabi-v7a mips x86
\ No newline at end of file
@@ -12,8 +12,8 @@ namespace pxl {
     typedef int int32;
     typedef unsigned int uint32;
 
-    typedef long int64;
-    typedef unsigned long uint64;
+    typedef long long int64;
+    typedef unsigned long long uint64;
 
     //todo: convert these names into 8, 16, 24, 32 bit + unsigned
     #define SHRT_MIN    (-32768)						/* minimum (signed) short value */
@@ -25,9 +25,9 @@ namespace pxl {
     #define LONG_MIN    (-2147483647L - 1)				/* minimum (signed) long value */
     #define LONG_MAX      2147483647L					/* maximum (signed) long value */
     #define ULONG_MAX     0xffffffffUL					/* maximum unsigned long value */
-    #define LLONG_MAX     9223372036854775807i64		/* maximum signed long long int value */
-    #define LLONG_MIN   (-9223372036854775807i64 - 1)	/* minimum signed long long int value */
-    #define ULLONG_MAX    0xffffffffffffffffui64		/* maximum unsigned long long int value */
+    #define LLONG_MAX     9223372036854775807LL		/* maximum signed long long int value */
+    #define LLONG_MIN   (-9223372036854775807LL - 1)	/* minimum signed long long int value */
+    #define ULLONG_MAX    0xffffffffffffffffULL		/* maximum unsigned long long int value */
 
     #define PXL_24U_MAX (256 * 256 * 256)
     #define PXL_24_MAX 24U_MAX >> 1;
@@ -65,6 +65,11 @@ namespace pxl {
     #include <glew.h>
 //};
 
+//define PXL_MOCK_GL to record gl calls instead of rendering, see graphics/MockGL.h
+#if defined(PXL_MOCK_GL)
+    #include "graphics/MockGL.h"
+#endif
+
 #define SDL_MAIN_HANDLED
 #include <SDL.h>
 
@@ -3,7 +3,12 @@
 
 #include "graphics/Batch.h"
 #include "graphics/ShaderUtils.h"
+#include "graphics/RectPacker.h"
+#include "graphics/DynamicAtlas.h"
+#include "graphics/DistanceField.h"
 #include "graphics/TextureSheet.h"
+#include "graphics/TextureStream.h"
+#include "graphics/TextureCache.h"
 #include "graphics/FontUtils.h"
 #include "graphics/Text.h"
 #include "graphics/Lights.h"
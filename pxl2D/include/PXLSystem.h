@@ -8,6 +8,9 @@
 #include "system/Debug.h"
 #include "system/ImageIO.h"
 #include "system/IO.h"
+#include "system/FileSystem.h"
+#include "system/TextureContainer.h"
+#include "system/ThreadPool.h"
 #include "system/Window.h"
 
 #endif
\ No newline at end of file
@@ -10,50 +10,31 @@
 #include "graphics/ShaderUtils.h"
 #include "graphics/ShaderProgram.h"
 #include "graphics/FrameBuffer.h"
+#include "graphics/StreamBuffer.h"
+#include "graphics/BatchRecorder.h"
 #include "system/Window.h"
 #include "PXLAPI.h"
 
 namespace pxl { namespace graphics {
 
-    enum BlendMode {
-        BLEND, /**> Applies blending when rendering **/
-        NO_BLEND, /**> Doesn't blend when rendering **/
+    enum BatchUploadMode {
+        UPLOAD_BUFFER_DATA, /**> Re-specifies the vertex buffer with glBufferData on every render_all **/
+        UPLOAD_STREAM, /**> Writes sorted vertices straight into a fenced, triple buffered ring buffer (see StreamBuffer) **/
     };
 
-    struct VertexBatch {
-
-        //vertex values
-        int z_depth = 0;
-        bool uses_transparency = false;
-        GLuint texture_id = 0;
-        ShaderProgram* shader = NULL;
-        BlendMode blend_mode;
-        uint16 num_vertices;
-        uint16 num_indices;
-	    uint32 add_id = 0;
-
-        //transform cache values
-        Colour colour;
-        Rect rect;
-        Rect src_rect;
-        Vec2 origin;
-        float rotation;
-    };
+    /** Upload counters for the last render_all call of a batch
+    **/
+    struct BatchUploadStats {
 
-    struct VertexPoint {
+        uint32 bytes_uploaded = 0; /**> Vertex and index bytes sent to the GPU **/
+        uint32 sync_waits = 0; /**> Times the batch had to wait for the GPU to release a ring buffer segment **/
+    };
 
-	    struct VertexPos {
-            float x = 0, y = 0, z = 0;
-	    } pos;
-	    struct Vertex_UVCoord {
-            uint16 x = 0, y = 0;
-	    } uv;
-	    struct Vertex_RGBA {
-            uint8 r = 255, g = 255, b = 255, a = 255;
-        } colour;
+    /** A box around a quad on the screen, used to check which opaque quads can be drawn in either order
+    **/
+    struct QuadBounds {
 
-	    VertexBatch* batch;
-	    uint32 order = 0;
+        float min_x, min_y, max_x, max_y;
     };
 
     /** The Batch class handles batch rendering of textures, texture sheets and sprites with transformations.
@@ -82,8 +63,9 @@ namespace pxl { namespace graphics {
 	    void create_batch(sys::Window* window);
 
 	    /** Renders everything that was added to the batch and clears all data when finished. You
-	    can set where the target will render to using set_target with a FrameBuffer.
-	    @see clear_all(), add()
+	    can set where the target will render to using set_target with a FrameBuffer. Quads in recorders are
+	    merged in first, so every thread recording into them must have finished
+	    @see clear_all(), add(), create_recorder()
 	    **/
 	    void render_all();
 
@@ -108,6 +90,26 @@ namespace pxl { namespace graphics {
 
 	    void set_window_target(sys::Window* window);
 
+	    /** Sets how vertex data is uploaded to the GPU when render_all is called. UPLOAD_STREAM avoids
+	    re-specifying the vertex buffer every frame, which can stall the driver with large batches
+	    @see BatchUploadMode, get_upload_stats()
+	    **/
+	    void set_upload_mode(BatchUploadMode mode);
+	    BatchUploadMode get_upload_mode() { return upload_mode; }
+
+	    /** Sets whether quads are drawn as 4 cpu transformed vertices or as one instance each. Instancing
+	    falls back to DRAW_VERTICES if GL 3.3 or ARB_instanced_arrays isn't supported. Anything already
+	    added is cleared when the mode changes. Shaders are swapped with their instanced variant when
+	    drawing, see get_instanced_shader()
+	    @see BatchDrawMode
+	    **/
+	    void set_draw_mode(BatchDrawMode mode);
+	    BatchDrawMode get_draw_mode() { return quads.get_draw_mode(); }
+
+	    /** Gets the amount of bytes uploaded and sync waits from the last render_all call
+	    **/
+	    const BatchUploadStats& get_upload_stats() { return upload_stats; }
+
 	    /** Adds the specified texture to the batch render queue and transforms it with all specified parameters
 	    @param texture The texture to add to the batch
 	    @param rect Specifies where on the screen the texture will be rendered to
@@ -122,46 +124,110 @@ namespace pxl { namespace graphics {
 		    float rotation = 0, Vec2* rotation_origin = NULL, Vec2* scale_origin = NULL, int z_depth = 0,
 		    Colour colour = COLOUR_WHITE, ShaderProgram* shader = NULL, BlendMode blend_mode = BLEND);
 
+	    /** Adds count sprites to the batch render queue. Gives the same result as calling add() for each sprite,
+	    but the quads are transformed and their colours converted in groups with the fastest supported simd kernel
+	    @param sprites The sprites to add
+	    @param count The amount of sprites
+	    @see QuadKernel, set_quad_kernel()
+	    **/
+	    void add_many(const SpriteInstance* sprites, size_t count);
+
 	    /** Deletes everything made in this batch
 	    **/
 	    void free();
 
-	    /** Gets the amount of items added to the batch
+	    /** Creates a recorder that another thread can record quads into without locking. Recorders are owned
+	    by the batch and are merged into it in creation order whenever render_all is called
+	    @see BatchRecorder
+	    **/
+	    BatchRecorder* create_recorder();
+	    int get_num_recorders() { return recorders.size(); }
+
+	    /** Gets the amount of items added to the batch, including those recorded in its recorders
 	    @return The number of added items
 	    **/
-	    int get_num_added() { return num_added; }
+	    int get_num_added();
 
 	    bool is_created() { return batch_created; }
 
     private:
 	    //batch info
 	    bool batch_created = false;                     /**> Defines whether or not the vertex buffer object has been created **/
-	    int num_added;                                  /**> The current number of added items in this batch **/
 	    FrameBuffer* target_frame_buffer = NULL;    /**> The target frame buffer object to use when rendering **/
 	    ShaderProgram* current_shader = NULL;
-	    BlendMode current_blend_mode;
+	    BlendMode current_blend_mode = NO_BLEND;
+	    bool blend_mode_valid = false;              /**> False when the blend state may have changed outside the batch, so current_blend_mode is ignored **/
 	    Matrix4 proj_view_mat;
         sys::Window* target_window;
         Rect render_bounds;
 
 	    //vertex data
         GLuint vbo_id; /**> The id associated with the vertex buffer object **/
-        GLuint vao_id;
-        GLuint ibo_id;
-
-        uint32 total_vertices = 0;
-        uint32 total_opq_vertices = 0;
-        uint32 total_indices = 0;
-        uint32 indices_count = 0;
-
-        std::vector<VertexPoint> vertices;
-        std::vector<uint32> indices;
+        GLuint vao_id = 0; /**> Vertex array object holding the attrib pointers and index buffer binding, 0 where unsupported **/
+        GLuint ibo_id; /**> Static index buffer holding the (0, 1, 2, 0, 3, 2) + 4k pattern for every quad **/
+        uint32 index_capacity = 0; /**> The amount of quads the index buffer can draw **/
+        GLenum index_type = GL_UNSIGNED_SHORT; /**> GL_UNSIGNED_SHORT while every index fits in 16 bits, otherwise GL_UNSIGNED_INT **/
+        BatchUploadMode upload_mode = UPLOAD_BUFFER_DATA;
+        StreamBuffer vertex_stream; /**> Ring buffer the vertices are written to when using UPLOAD_STREAM **/
+        BatchUploadStats upload_stats;
+
+        BatchRecorder quads;                        /**> Quads added straight to the batch, recorders are appended to it when rendering **/
+        std::vector<BatchRecorder*> recorders;      /**> Recorders created with create_recorder(), in recorder index order **/
+
+        std::vector<VertexPoint> sorted_vertices;   /**> Vertices written out in draw order after sorting (UPLOAD_BUFFER_DATA only) **/
+        std::vector<InstancePoint> sorted_instances;/**> Instances written out in draw order after sorting (UPLOAD_BUFFER_DATA only) **/
+        std::vector<uint32> sorted_quads;           /**> The index into batches of each quad in draw order **/
+        std::vector<uint64> sort_keys;              /**> One packed sort key per added quad, built when sorting **/
+        std::vector<uint64> sort_keys_swap;         /**> Scratch buffer used by the radix sort **/
+        std::vector<uint64> group_keys;             /**> Scratch buffer a run of opaque quads is grouped by state in **/
+        std::vector<QuadBounds> group_bounds;       /**> The bounds of each quad in group_keys **/
 
 	    /** Verifies whether the texture should be added to the batch and returns the result
 	    @param rect Used to check the texture position on the screen
 	    **/
 	    inline bool verify_texture_add(const Texture& texture, Rect* rect);
 
+	    /** Builds the static quad index buffer so that it can draw at least num_quads quads. The
+	    capacity grows geometrically from CONFIG_BATCH_INDEX_CAPACITY
+	    @param num_quads The amount of quads that need to be drawn
+	    **/
+	    void create_index_buffer(uint32 num_quads);
+
+	    /** Packs the sort key for a quad. Keys sort quads in painter order, lower z depths first and then by add order.
+	    Premultiplied quads sort after every straight quad at the same z depth so that they share one blend func
+	    change. The low 31 bits hold the add id, which is also the index of the quad in the vertices list
+	    **/
+	    inline uint64 create_sort_key(const VertexBatch& batch);
+
+	    /** Builds the sort key of every quad and sorts them with an lsd radix sort, then groups each run of opaque
+	    quads at the same z depth by texture, shader and blend mode so they can be drawn with fewer calls
+	    \return The sorted keys, which point into either sort_keys or sort_keys_swap
+	    **/
+	    const uint64* sort_quads();
+
+	    /** Moves each quad in a run of opaque quads back to the last one drawn with the same state, as long as it
+	    only passes quads it doesn't overlap, so grouping never changes which quad is drawn on top
+	    @param keys The sorted keys of the run, reordered in place
+	    **/
+	    void group_opaque_run(uint64* keys, uint32 num_keys);
+
+	    /** Gets the box around a quad's corners on the screen
+	    **/
+	    QuadBounds get_quad_bounds(uint32 id) const;
+
+	    /** Writes the vertices or instances of every quad in draw order and uploads them. The depth of each quad
+	    is worked out from its rank in sorted_keys and written once as it is copied, and the index of each quad
+	    is written into sorted_quads in draw order
+	    @param sorted_keys The sort keys in painter order, from sort_quads()
+	    \return The byte offset of the written data in the bound vertex buffer
+	    **/
+	    uint32 upload_sorted(const uint64* sorted_keys);
+
+	    /** Sets the vertex attrib pointers for DRAW_VERTICES or DRAW_INSTANCED
+	    @param offset The byte offset of the first vertex or instance in the bound vertex buffer
+	    **/
+	    void set_attrib_pointers(uint32 offset);
+
 	    /** Draws each item in the vertex batches list
 	    **/
 	    void draw_vbo();
@@ -0,0 +1,184 @@
+#ifndef _BATCH_RECORDER_H
+#define _BATCH_RECORDER_H
+
+#include <vector>
+#include "graphics/Texture.h"
+#include "graphics/Structs.h"
+#include "graphics/Colour.h"
+#include "graphics/ShaderProgram.h"
+#include "graphics/QuadTransform.h"
+#include "PXLAPI.h"
+
+namespace pxl { namespace graphics {
+
+    enum BlendMode {
+        BLEND, /**> Applies blending when rendering **/
+        NO_BLEND, /**> Doesn't blend when rendering **/
+        BLEND_PREMULTIPLIED, /**> Blends with GL_ONE, GL_ONE_MINUS_SRC_ALPHA for textures with premultiplied alpha. Used for
+                             any transparent quad whose texture has a premultiplied channel **/
+    };
+
+    enum BatchDrawMode {
+        DRAW_VERTICES, /**> Transforms the 4 corners of every quad on the cpu and draws them with the static index buffer **/
+        DRAW_INSTANCED, /**> Uploads one InstancePoint per quad and expands it to 4 corners in the vertex shader **/
+    };
+
+    //instanced drawing needs per-attrib divisors, which gles2 doesn't have
+    #if defined(GL_VERTEX_ATTRIB_ARRAY_DIVISOR)
+        #define BATCH_INSTANCING_SUPPORTED
+    #endif
+
+    /** Per-quad metadata used to sort and draw each added quad. Kept in its own contiguous list
+    so that none of it is uploaded to the GPU with the vertex data
+    **/
+    struct VertexBatch {
+
+        int z_depth = 0;
+        bool uses_transparency = false;
+        GLuint texture_id = 0;
+        ShaderProgram* shader = NULL;
+        BlendMode blend_mode = BLEND;
+	    uint32 add_id = 0;
+    };
+
+    /** A single interleaved vertex as it is uploaded to the GPU (20 bytes)
+    **/
+    struct VertexPoint {
+
+	    struct VertexPos {
+            float x = 0, y = 0, z = 0;
+	    } pos;
+	    struct Vertex_UVCoord {
+            uint16 x = 0, y = 0;
+	    } uv;
+	    struct Vertex_RGBA {
+            uint8 r = 255, g = 255, b = 255, a = 255;
+        } colour;
+    };
+
+    /** A single quad as it is uploaded to the GPU when using DRAW_INSTANCED (48 bytes). The corners are
+    bounds relative to the pivot, rotated by the cos/sin pair and then offset by the pivot
+    **/
+    struct InstancePoint {
+
+        struct InstancePivot {
+            float x = 0, y = 0;
+        } pivot;
+        struct InstanceBounds {
+            float left = 0, top = 0, right = 0, bottom = 0;
+        } bounds;
+        struct InstanceRotation {
+            float c = 1, s = 0;
+        } rotation;
+        struct Instance_UVRect {
+            uint16 x = 0, y = 0, w = 0, h = 0;
+        } uv;
+        struct Instance_RGBA {
+            uint8 r = 255, g = 255, b = 255, a = 255;
+        } colour;
+        float z = 0;
+    };
+
+    /** Everything add() takes for a single quad, used to add many quads at once with add_many()
+    **/
+    struct SpriteInstance {
+
+        const Texture* texture = NULL;
+        Rect rect;
+        Rect src_rect;
+        bool use_src_rect = false; /**> Uses the whole texture when false **/
+        float rotation = 0;
+        Vec2 rotation_origin;
+        Vec2 scale_origin;
+        bool use_scale_origin = false;
+        int z_depth = 0;
+        Colour colour;
+        ShaderProgram* shader = NULL;
+        BlendMode blend_mode = BLEND;
+    };
+
+    /** The BatchRecorder class records quads for a Batch away from the thread that renders it. Each recorder
+    is only ever written to by one thread at a time and shares nothing with other recorders, so workers can
+    fill their own recorder without any locking.\n
+    Recorders are created with Batch::create_recorder() and are merged into the batch when render_all is called.
+    Quads are drawn in order of (z depth, recorder index, add order), where quads added straight to the batch
+    come before every recorder, so the output matches adding everything from one thread in that order.
+    Recording has to have finished before render_all is called.
+    **/
+    class BatchRecorder {
+
+    public:
+	    BatchRecorder() { }
+
+	    /** Records a quad, taking the same parameters as Batch::add()
+	    @see Batch::add()
+	    **/
+	    void add(const Texture& texture, Rect* rect, Rect* src_rect = NULL,
+		    float rotation = 0, Vec2* rotation_origin = NULL, Vec2* scale_origin = NULL, int z_depth = 0,
+		    Colour colour = COLOUR_WHITE, ShaderProgram* shader = NULL, BlendMode blend_mode = BLEND);
+
+	    /** Records count quads, transforming them in groups with the fastest supported simd kernel
+	    @see Batch::add_many()
+	    **/
+	    void add_many(const SpriteInstance* sprites, size_t count);
+
+	    /** Clears every recorded quad, keeping the memory allocated for the next frame
+	    **/
+	    void clear();
+
+	    /** Appends every quad recorded in another recorder after the quads in this one. Quads recorded in the
+	    other draw mode are converted to this recorder's mode
+	    **/
+	    void append(const BatchRecorder& recorder);
+
+	    /** Sets whether quads are recorded as vertices or instances. Clears every recorded quad if it changes
+	    **/
+	    void set_draw_mode(BatchDrawMode mode);
+	    BatchDrawMode get_draw_mode() { return draw_mode; }
+
+	    /** Frees all memory used by the recorder
+	    **/
+	    void free();
+
+	    int get_num_added() { return num_added; }
+
+    private:
+        friend class Batch;
+
+        BatchDrawMode draw_mode = DRAW_VERTICES;
+	    int num_added = 0;
+        uint32 total_vertices = 0;
+        uint32 total_opq_vertices = 0;
+
+        std::vector<VertexPoint> vertices;          /**> 4 vertices per added quad, in add order **/
+        std::vector<InstancePoint> instances;       /**> 1 instance per added quad when using DRAW_INSTANCED, in add order **/
+        std::vector<VertexBatch> batches;           /**> Metadata for each added quad, in add order **/
+        std::vector<float> transform_scratch;       /**> Quad transforms gathered by add_many (see QuadTransforms) **/
+        std::vector<float> colour_scratch;          /**> Rgba colours gathered by add_many **/
+
+	    /** Grows the per-quad lists so that they can hold at least num_quads quads
+	    **/
+	    void grow_quads(uint32 num_quads);
+
+	    /** Adds the metadata for a new quad. Transparent quads blend with BLEND_PREMULTIPLIED if the texture is
+	    premultiplied or it was asked for, otherwise with BLEND
+	    \return The add id of the quad
+	    **/
+	    uint32 push_quad(const Texture& texture, int z_depth, const Colour& colour, ShaderProgram* shader, BlendMode blend_mode);
+
+	    /** Works out the position, corner bounds and rotation of a quad and writes them at index in transforms
+	    **/
+	    void prepare_transform(const Texture& texture, const Rect& rect, float rotation, const Vec2* rotation_origin,
+	                           const Vec2* scale_origin, QuadTransforms& transforms, uint32 index);
+
+	    /** Sets the uv coordinates of the quad with the specified add id
+	    **/
+	    void set_quad_uvs(uint32 id, const Texture& texture, const Rect* src_rect);
+
+	    /** Fills in the instance of the quad with the specified add id from its transform and colour (DRAW_INSTANCED only)
+	    **/
+	    void set_quad_instance(uint32 id, const QuadTransforms& transforms, uint32 index, const Colour& colour);
+    };
+}};
+
+#endif
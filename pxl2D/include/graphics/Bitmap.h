@@ -14,6 +14,9 @@ namespace pxl { namespace graphics {
 	    uint32 num_channels;
 	    uint32 gl_pixel_mode;
 
+	    /** The byte of each channel in a pixel, or -1 if the channel isn't stored. For packed formats this is the
+	    order of the channels in the packed value instead
+	    **/
 	    struct ChannelIndex {
 
 		    ChannelIndex() { }
@@ -22,16 +25,35 @@ namespace pxl { namespace graphics {
 		    short r = 0, g = 0, b = 0, a = 0;
 
 	    } channel_index;
+
+	    uint32 gl_pixel_type; /**< GL_UNSIGNED_BYTE, or a packed type where a whole pixel is one 16 bit value **/
+	    uint32 bytes_per_pixel;
+	    bool premultiplied; /**< Whether the colour channels have already been multiplied by the alpha **/
     };
 
-    static const Channel CHANNEL_RGB			{ 3, GL_RGB,					{ 0, 1, 2, -1 }		};
-    static const Channel CHANNEL_RGBA			{ 4, GL_RGBA,					{ 0, 1, 2, 3 }		};
+    inline bool operator==(const Channel& a, const Channel& b) {
+	    return a.num_channels == b.num_channels && a.gl_pixel_mode == b.gl_pixel_mode && a.gl_pixel_type == b.gl_pixel_type &&
+		    a.bytes_per_pixel == b.bytes_per_pixel && a.premultiplied == b.premultiplied &&
+		    a.channel_index.r == b.channel_index.r && a.channel_index.g == b.channel_index.g &&
+		    a.channel_index.b == b.channel_index.b && a.channel_index.a == b.channel_index.a;
+    }
+    inline bool operator!=(const Channel& a, const Channel& b) { return !(a == b); }
+
+    static const Channel CHANNEL_RGB			{ 3, GL_RGB,					{ 0, 1, 2, -1 },	GL_UNSIGNED_BYTE,			3, false	};
+    static const Channel CHANNEL_RGBA			{ 4, GL_RGBA,					{ 0, 1, 2, 3 },		GL_UNSIGNED_BYTE,			4, false	};
 
     //android GLES does not support GL_BGRA, so leave out temporarily and maybe add back later
-    //static const Channel CHANNEL_BGRA			{ 4, GL_BGRA,					{ 2, 1, 0, 3 }		};
+    //static const Channel CHANNEL_BGRA			{ 4, GL_BGRA,					{ 2, 1, 0, 3 },		GL_UNSIGNED_BYTE,			4, false	};
+
+    static const Channel CHANNEL_GRAY_ALPHA		{ 2, GL_LUMINANCE_ALPHA,		{ 0, 0, 0, 1 },		GL_UNSIGNED_BYTE,			2, false	};
+    static const Channel CHANNEL_ALPHA			{ 1, GL_ALPHA,					{ -1, -1, -1, 0 },	GL_UNSIGNED_BYTE,			1, false	};
+
+    //rgba with the colour multiplied by the alpha, to be blended with GL_ONE, GL_ONE_MINUS_SRC_ALPHA
+    static const Channel CHANNEL_RGBA_PREMULTIPLIED	{ 4, GL_RGBA,				{ 0, 1, 2, 3 },		GL_UNSIGNED_BYTE,			4, true		};
 
-    static const Channel CHANNEL_GRAY_ALPHA		{ 2, GL_LUMINANCE_ALPHA,		{ 0, 0, 0, 1 }		};
-    static const Channel CHANNEL_ALPHA			{ 1, GL_ALPHA,					{ -1, -1, -1, 0 }	};
+    //16 bit packed formats that take half the memory of rgba, for low memory gpus
+    static const Channel CHANNEL_RGB565			{ 3, GL_RGB,					{ 0, 1, 2, -1 },	GL_UNSIGNED_SHORT_5_6_5,	2, false	};
+    static const Channel CHANNEL_RGBA4444		{ 4, GL_RGBA,					{ 0, 1, 2, 3 },		GL_UNSIGNED_SHORT_4_4_4_4,	2, false	};
 
     class Bitmap {
 
@@ -51,6 +73,13 @@ namespace pxl { namespace graphics {
 		    **/
 		    bool create_bitmap(std::string path);
 		    /**
+		    \*brief: loads the bitmap, converting it to a channel layout as it is decoded. Loading with
+		    CHANNEL_RGBA_PREMULTIPLIED premultiplies the alpha with the pixel kernels at load time
+		    \*param [path]: the path and file name for the bitmap to load
+		    \*param [pixel_channel]: the layout to load the pixels into
+		    **/
+		    bool create_bitmap(std::string path, Channel pixel_channel);
+		    /**
 		    \*brief: constructs the bitmap with specified values
 		    \*param [width]: the width of the image
 		    \*param [height]: the height of the image
@@ -68,15 +97,29 @@ namespace pxl { namespace graphics {
 		    \*brief: constructs the bitmap with specified values
 		    \*param [width]: the width of the image
 		    \*param [height]: the height of the image
-		    \*param [buffer]: an array of pixels for the image
+		    \*param [buffer]: an array of pixels for the image, allocated with new[]. The bitmap takes ownership of it
 		    **/
 		    void create_bitmap(int width, int height, uint8* pixel_buffer, Channel pixel_channel);
+		    /**
+		    \*brief: constructs the bitmap without filling it, for decoders that write every pixel themselves
+		    \*param [width]: the width of the image
+		    \*param [height]: the height of the image
+		    **/
+		    void create_bitmap(int width, int height, Channel pixel_channel);
 		
 		    inline void set_attribs(int bitmap_width, int bitmap_height, Channel pixel_channel);
 
 		    void fill(Colour colour);
 		    void fill(Gradient gradient);
 
+		    /**
+		    \*brief: converts the pixels to another channel layout, such as expanding rgb to rgba, premultiplying the
+		    alpha or packing into 16 bit pixels. Converts in place when the new layout is not bigger
+		    \*param [new_channel]: the layout to convert to
+		    \*return Returns false if the bitmap has no pixels
+		    **/
+		    bool convert(Channel new_channel);
+
 		    /**
 		    \*brief: frees all data from the bitmap
 		    **/
@@ -86,6 +129,7 @@ namespace pxl { namespace graphics {
 		    uint32 get_height() const { return height; }
 		    Channel get_channel() const { return channel; }
 		    uint32 get_num_channels() const { return channel.num_channels; }
+		    uint32 get_bytes_per_pixel() const { return channel.bytes_per_pixel; }
 		    uint8* get_pixels() const { return pixels; }
 
 	    private:
@@ -94,6 +138,7 @@ namespace pxl { namespace graphics {
 		    uint32 width;
 		    uint32 height;
 		    uint8* pixels;
+		    bool pooled_pixels;
 		    uint32 buffer_size;
 		    uint32 row_size;
 		    Channel channel;
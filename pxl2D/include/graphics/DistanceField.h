@@ -0,0 +1,42 @@
+#ifndef _DISTANCE_FIELD_H
+#define _DISTANCE_FIELD_H
+
+#include <vector>
+#include "system/Config.h"
+#include "PXLAPI.h"
+
+namespace pxl { namespace graphics {
+
+    /** One coverage image to turn into a distance field with generate_distance_fields()
+    **/
+    struct DistanceFieldJob {
+
+        const uint8* coverage = NULL; /**> width * height 8 bit coverage values, tightly packed **/
+        uint32 width = 0;
+        uint32 height = 0;
+        uint8* dest = NULL; /**> Where to write the field, (width + spread * 2) * (height + spread * 2) bytes **/
+    };
+
+    /** Generates a signed distance field from an 8 bit coverage image, such as a glyph rendered by FreeType. Pixels
+    with a coverage of 128 or more are inside. The field is bigger than the image by spread on every side, so the
+    distance can fall off around the edges of the image.\n
+    Each value is the distance from the pixel to the closest edge, mapped so 128 is on the edge, 255 is spread or
+    more pixels inside and 0 is spread or more pixels outside. Distances are exact euclidean distances to the
+    nearest pixel on the other side of the edge, less half a pixel, found with two separable passes.\n
+    Runs on the calling thread and doesn't use GL, so it's safe to call from any thread, including pool jobs.
+    @param coverage width * height coverage values
+    @param width, height The size of the coverage image
+    @param spread The distance in pixels the field covers on each side of an edge
+    @param dest Where to write (width + spread * 2) * (height + spread * 2) values
+    **/
+    extern void generate_distance_field(const uint8* coverage, uint32 width, uint32 height, uint32 spread, uint8* dest);
+
+    /** Generates a distance field for every job, spread over the thread pool's workers, and waits for them to
+    finish. When called from a pool job, the fields are generated on the calling thread instead
+    @param jobs The images to generate fields for
+    @param spread The distance in pixels each field covers on each side of an edge
+    **/
+    extern void generate_distance_fields(const std::vector<DistanceFieldJob>& jobs, uint32 spread);
+}};
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef _DYNAMIC_ATLAS_H
+#define _DYNAMIC_ATLAS_H
+
+#include <vector>
+#include "graphics/Texture.h"
+#include "graphics/RectPacker.h"
+#include "system/Config.h"
+#include "PXLAPI.h"
+
+namespace pxl { namespace graphics {
+
+    typedef uint32 AtlasHandle;
+    static const AtlasHandle ATLAS_INVALID_HANDLE = 0;
+
+    /** Usage of a dynamic atlas at the time it was asked for
+    **/
+    struct DynamicAtlasStats {
+
+        uint32 num_entries = 0;
+        uint32 pages_allocated = 0;
+        uint32 pages_in_use = 0; /**> Pages with at least one entry, empty pages stay allocated until compact() **/
+        uint64 used_area = 0; /**> Pixels covered by entries, not counting padding **/
+        uint64 total_area = 0; /**> Pixels in every allocated page **/
+
+        /** The fraction of every page covered by entries
+        **/
+        float occupancy = 0;
+
+        /** How broken up the free space is, from 0 when it's one rect to close to 1 when it's all slivers. Taken as 1
+        minus the biggest free rect of each page over the free area of every page
+        **/
+        float fragmentation = 0;
+    };
+
+    /** The DynamicAtlas class packs images into a few shared textures at runtime, so images that come and go (such
+    as avatars or item icons) can be drawn from the same texture instead of binding one texture each.\n
+    Entries are added and removed at any time. Each add uploads only its own rect with glTexSubImage2D, and a new
+    page is created when none of the existing ones have room. A copy of every page is kept on the cpu, so
+    compact() can repack the entries that are left into as few pages as possible and upload each page once.\n
+    Every function calls GL, so an atlas must only be used from the render thread.
+    **/
+    class DynamicAtlas {
+
+        public:
+            /** Creates an empty atlas, pages are only created once something is added
+            @param page_width, page_height The size of each page texture
+            @param channel The layout of the pages, which added pixels are converted to
+            @param padding Empty pixels left between entries so filtering doesn't bleed between them
+            @param max_pages The most pages to create before adds start failing
+            **/
+            DynamicAtlas(uint32 page_width = CONFIG_DYNAMIC_ATLAS_PAGE_SIZE, uint32 page_height = CONFIG_DYNAMIC_ATLAS_PAGE_SIZE,
+                         Channel channel = CHANNEL_RGBA, uint32 padding = 1, uint32 max_pages = CONFIG_DYNAMIC_ATLAS_MAX_PAGES);
+            ~DynamicAtlas();
+
+            /** Copies a bitmap into the atlas, converting it to the atlas' layout if it's different
+            \return A handle to the entry, or ATLAS_INVALID_HANDLE if it's bigger than a page or every page is full
+            **/
+            AtlasHandle add(const Bitmap* bitmap);
+
+            /** Copies pixels into the atlas
+            @param w, h The size of the image
+            @param pixels w * h pixels, tightly packed in pixel_channel's layout
+            @param pixel_channel The layout of pixels
+            \return A handle to the entry, or ATLAS_INVALID_HANDLE if it's bigger than a page or every page is full
+            **/
+            AtlasHandle add(uint32 w, uint32 h, const uint8* pixels, Channel pixel_channel);
+
+            /** Frees an entry's rect to be used by later adds. The pixels are left in the page until they're overwritten
+            **/
+            void remove(AtlasHandle handle);
+
+            /** Frees a set of entries, rebuilding the free space of each page they were in once rather than once per
+            entry. Invalid handles are skipped
+            **/
+            void remove(const std::vector<AtlasHandle>& handles);
+
+            /** Gets the texture an entry is in, to draw with a Batch. Only valid until the next compact()
+            **/
+            Texture* get_texture(AtlasHandle handle) const;
+
+            /** Gets where an entry is in its texture, to use as the src_rect when drawing it. Only valid until the next
+            compact()
+            **/
+            Rect get_rect(AtlasHandle handle) const;
+
+            /** Gets whether add() would succeed for an image of this size, either in a page with room or a new page
+            **/
+            bool has_room(uint32 w, uint32 h) const;
+
+            bool is_valid(AtlasHandle handle) const { return handle != ATLAS_INVALID_HANDLE && handle <= entries.size() && entries[handle - 1].live; }
+
+            /** Repacks every entry, biggest first, into as few pages as they fit in, frees the pages left empty and
+            re-uploads each page that's kept. Handles stay valid, but the texture and rect of each entry can change.
+            If the repack would need more pages than are allocated, the atlas is left as it was
+            \return Returns the amount of pages freed
+            **/
+            uint32 compact();
+
+            /** Removes every entry and frees every page
+            **/
+            void clear();
+
+            DynamicAtlasStats get_stats() const;
+
+            uint32 get_page_width() const { return page_width; }
+            uint32 get_page_height() const { return page_height; }
+            uint32 get_num_pages() const { return pages.size(); }
+            Texture* get_page(uint32 index) const { return index < pages.size() ? pages[index]->texture : NULL; }
+
+        private:
+            struct Page {
+
+                Texture* texture;
+                Bitmap pixels; /**> The cpu copy of the texture, what compact() moves entries from **/
+                RectPacker packer;
+                uint32 num_entries;
+            };
+
+            struct Entry {
+
+                bool live;
+                uint32 page;
+                PackedRect rect;
+            };
+
+            uint32 page_width;
+            uint32 page_height;
+            Channel channel;
+            PackSettings settings;
+            uint32 max_pages;
+            std::vector<Page*> pages;
+            std::vector<Entry> entries; /**> Indexed by handle - 1 **/
+            std::vector<uint32> free_handles;
+
+            Page* create_page();
+            void free_page(Page* page);
+
+            /** Copies pixels in the atlas' layout into a page's cpu copy, one row at a time
+            **/
+            void write_pixels(Page* page, const PackedRect& rect, const uint8* src, uint32 src_row_size);
+
+            DynamicAtlas(const DynamicAtlas&);
+            DynamicAtlas& operator=(const DynamicAtlas&);
+    };
+}};
+
+#endif
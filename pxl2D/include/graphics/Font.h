@@ -1,22 +1,47 @@
 #ifndef _FONT_H
 #define _FONT_H
 
+#include <list>
+#include <unordered_map>
 #include "graphics/FontUtils.h"
-#include "graphics/TextureSheet.h"
+#include "graphics/DynamicAtlas.h"
 #include "system/Math.h"
 
 typedef struct FT_FaceRec_* FT_Face;
 
 namespace pxl { namespace graphics {
 
+    enum FontRenderMode {
+        FONT_RENDER_BITMAP, /**> Glyphs are stored as coverage at max_font_size, which aliases when drawn smaller and blurs when drawn bigger **/
+        FONT_RENDER_SDF, /**> Glyphs are stored as signed distance fields and drawn with sdf_text_shader, which stays sharp at any size **/
+    };
+
+    /** Where a glyph is drawn from. texture is NULL for glyphs with nothing to draw, such as spaces
+    **/
+    struct Glyph {
+
+        Texture* texture = NULL;
+        Rect rect;
+        uint32 padding = 0; /**> Pixels of distance field on each side of the glyph inside rect, 0 for bitmap glyphs **/
+    };
+
+    /** The Font class loads a font face and rasterises its glyphs the first time they're drawn, packing them into
+    a dynamic atlas. Once every page of the atlas is full, the least recently used glyphs are evicted to make room.
+    Glyphs used since the last end_frame() are never evicted, as a batch that hasn't rendered yet may still draw
+    them from the atlas, so a glyph that doesn't fit alongside them fails to load until the next frame.\n
+    With FONT_RENDER_SDF, each glyph is turned into a distance field on the cpu after it's rasterised, so one font
+    serves every text size.
+    **/
     class Font {
 
 	    public:
 		    /**
 		    \*brief: loads the font
 		    \*param [path]: the path and file name for the font to load
+		    \*param [c_max_font_size]: the pixel size glyphs are rasterised at
+		    \*param [c_render_mode]: whether to store glyphs as bitmaps or distance fields
 		    **/
-		    Font(std::string path, int c_max_font_size = 72);
+		    Font(std::string path, int c_max_font_size = 72, FontRenderMode c_render_mode = FONT_RENDER_BITMAP);
 		    /**
 		    \*brief: font deconstructor
 		    **/
@@ -27,14 +52,28 @@ namespace pxl { namespace graphics {
 		    int width;
 		    int height;
 
-		    Texture* get_glyph_sheet() { return glyph_sheet; }
+		    /** Gets a glyph, rasterising it into the atlas first if it isn't cached, and marks it as used this frame
+		    @param glyph_index The index from get_glyph_index()
+		    \return Returns where to draw the glyph from, valid until the next call. The texture is NULL if the glyph
+		    has nothing to draw or the atlas is full of glyphs used this frame
+		    **/
+		    const Glyph& get_glyph(int glyph_index);
 
-		    const Rect* get_glyph_rects() { return &glyph_rects[0]; }
+		    /** Rasterises every glyph in chars that isn't cached yet, such as the glyphs a menu is about to show.
+		    With FONT_RENDER_SDF the distance fields are generated on the thread pool together, which is far
+		    faster than leaving each one to be generated on the render thread when it's first drawn
+		    @param chars The character codes to load
+		    **/
+		    void preload(const std::string& chars);
 
 		    int get_glyph_index(int char_code);
 		    int get_max_font_size() { return max_font_size; }
 		    int get_max_char_width() { return max_char_width; }
 		    int get_max_char_height() { return max_char_height; }
+		    FontRenderMode get_render_mode() { return render_mode; }
+
+		    uint32 get_num_cached_glyphs() { return glyphs.size(); }
+		    const DynamicAtlas* get_glyph_atlas() { return glyph_atlas; }
 
 		    /**
 		    \*brief: frees all data from the font
@@ -42,22 +81,51 @@ namespace pxl { namespace graphics {
 		    void free();
 
 	    private:
+		    struct CachedGlyph {
+
+			    Glyph glyph;
+			    AtlasHandle handle;
+			    std::list<int>::iterator lru_pos; /**> Position in lru_list **/
+			    int64 last_used_frame = -1; /**> The frame index get_glyph last gave the glyph out in, -1 if it never has **/
+		    };
+
 		    //font info
-		    bool font_loaded;
+		    bool font_loaded = false;
 		    FT_Face f;
-		    Rect* glyph_rects;
 		    uint32 max_font_size;
+		    FontRenderMode render_mode;
 		    uint32 max_char_width = 0;
 		    uint32 max_char_height = 0;
 
-		    TextureSheet* glyph_sheet; /**> Texture sheet containing all glyphs in this font **/
+		    DynamicAtlas* glyph_atlas = NULL; /**> Atlas containing every glyph that's been rasterised and not evicted **/
+		    std::unordered_map<int, CachedGlyph> glyphs; /**> Cached glyphs by glyph index **/
+		    std::list<int> lru_list; /**> Glyph indices, least recently used first **/
+
+		    /** Rasterises a glyph and adds it to the atlas, evicting glyphs until it fits
+		    \return Returns false if the atlas is full of glyphs used this frame
+		    **/
+		    bool load_glyph(int glyph_index, CachedGlyph& cached);
+
+		    /** Renders a glyph with FreeType into tightly packed coverage values
+		    \return Returns false if the glyph couldn't be loaded or has nothing to draw
+		    **/
+		    bool rasterise_glyph(int glyph_index, uint32& w, uint32& h, std::vector<uint8>& pixels);
+
+		    /** Adds rasterised pixels to the atlas as a glyph, evicting the least recently used glyphs in batches until it
+		    fits. Glyphs used this frame are never evicted
+		    \return Returns false if the atlas is full of glyphs used this frame
+		    **/
+		    bool cache_glyph(int glyph_index, CachedGlyph& cached, uint32 w, uint32 h, const uint8* pixels, uint32 padding);
+
+		    Font(const Font&);
+		    Font& operator=(const Font&);
     };
 
     /**
     \*brief: loads and creates a font from the specified path
     \*param [path]: the path and file name for the font to load
     **/
-    extern Font* create_font(std::string path, int c_max_font_size = 72);
+    extern Font* create_font(std::string path, int c_max_font_size = 72, FontRenderMode c_render_mode = FONT_RENDER_BITMAP);
 
 }};
 
@@ -0,0 +1,67 @@
+#ifndef _GL_STATE_H
+#define _GL_STATE_H
+
+#include "graphics/GraphicsAPI.h"
+#include "PXLAPI.h"
+
+namespace pxl { namespace graphics {
+
+    /** Counters of the GL state calls that went through the state cache since the last reset_gl_state_stats
+    **/
+    struct GLStateStats {
+
+        uint32 issued = 0; /**> Calls that changed state and were sent to GL **/
+        uint32 elided = 0; /**> Calls that were skipped as the state was already set **/
+    };
+
+    /** ------------------------------------------------------------------------------------------------
+    The GL state cache remembers the last bound texture, program, framebuffers, vertex array and the blend
+    and depth state, and only calls GL when the requested state differs. Everything in pxl changes this state
+    through the functions below, so code that calls GL directly for the same state has to call
+    invalidate_gl_state afterwards.
+    ------------------------------------------------------------------------------------------------ **/
+
+    /** Binds a texture to GL_TEXTURE_2D on the active texture unit (pxl only ever uses unit 0)
+    **/
+    extern void bind_texture(GLuint id);
+
+    /** Calls glUseProgram with the specified program
+    **/
+    extern void use_program(GLuint id);
+
+    /** Binds a framebuffer. GL_FRAMEBUFFER binds both the read and draw framebuffer
+    @param target GL_FRAMEBUFFER_READ, GL_FRAMEBUFFER_WRITE or GL_FRAMEBUFFER
+    **/
+    extern void bind_framebuffer(GLenum target, GLuint id);
+
+    /** Binds a vertex array object. Does nothing where vertex array objects aren't supported
+    **/
+    extern void bind_vertex_array(GLuint id);
+
+    extern void set_blend_enabled(bool enabled);
+    extern void set_blend_func(GLenum src_factor, GLenum dest_factor);
+    extern void set_depth_test_enabled(bool enabled);
+    extern void set_depth_func(GLenum func);
+    extern void set_depth_mask(bool enabled);
+
+    /** Tells the cache an object has been deleted. GL unbinds deleted objects, so if the object is currently
+    bound the cache treats the binding as 0
+    **/
+    extern void forget_texture(GLuint id);
+    extern void forget_program(GLuint id);
+    extern void forget_framebuffer(GLuint id);
+    extern void forget_vertex_array(GLuint id);
+
+    /** Forgets all cached state so that the next call of each kind is always sent to GL. Use after
+    changing any of the cached state without going through the cache
+    **/
+    extern void invalidate_gl_state();
+
+    /** Gets the amount of issued and elided state calls since the last reset. Call reset_gl_state_stats
+    once per frame to get per frame counts
+    **/
+    extern const GLStateStats& get_gl_state_stats();
+    extern void reset_gl_state_stats();
+}};
+
+#endif
@@ -10,6 +10,15 @@ namespace pxl { namespace graphics {
     extern void set_clear_colour(float r, float g, float b, float a);
     extern void set_clear_depth(float d);
     extern void clear();
+
+    /** Marks the end of a frame, once every batch has rendered (such as right before swapping the window). Fonts
+    never evict glyphs used since the last call, as a batch that hasn't rendered yet may still draw them
+    **/
+    extern void end_frame();
+
+    /** Gets how many times end_frame() has been called
+    **/
+    extern uint64 get_frame_index();
 }};
 
 #endif
\ No newline at end of file
@@ -120,37 +120,37 @@ namespace pxl { namespace graphics {
             \*brief: adds another matrix4 (b) by this matrix and returns the temporary new result
             \*param [b]: constant non-pointer matrix4 reference
             **/
-            Matrix4& add(const Matrix4& b);
+            Matrix4 add(const Matrix4& b);
 
             /**
             \*brief: adds this matrix by a float and returns the temporary new result
             \*param [b]: float to be added by
             **/
-            Matrix4& add(float b);
+            Matrix4 add(float b);
 
             /**
             \*brief: subs another matrix4 (b) by this matrix and returns the temporary new result
             \*param [b]: constant non-pointer matrix4 reference
             **/
-            Matrix4& sub(const Matrix4& b);
+            Matrix4 sub(const Matrix4& b);
 
             /**
             \*brief: subs this matrix by a float and returns the temporary new result
             \*param [b]: float to be subtracted by
             **/
-            Matrix4& sub(float b);
+            Matrix4 sub(float b);
 
 		    /**
 		    \*brief: multiplies another matrix4 (b) by this matrix and returns the temporary new result
 		    \*param [b]: constant non-pointer matrix4 reference
 		    **/
-            Matrix4& mul(const Matrix4& b);
+            Matrix4 mul(const Matrix4& b);
 
             /**
             \*brief: multiplies this matrix by a float and returns the temporary new result
             \*param [b]: float to be multiplied by
             **/
-            Matrix4& mul(float b);
+            Matrix4 mul(float b);
 
             /**
             \*brief: clones this matrix4 and returns the new temporary result
@@ -172,19 +172,19 @@ namespace pxl { namespace graphics {
             \*brief: overrides the equal operator, sets this matrix to the operand and return this matrix
             \*param [b]: matrix to set equal to
             **/
-            Matrix4& operator=(Matrix4& b);
+            Matrix4& operator=(const Matrix4& b);
 
             /**
             \*brief: overrides the addition operator and returns the temporary added matrix result
             \*param [b]: matrix to be added by
             **/
-            Matrix4& operator+(const Matrix4& b) { return add(b); }
+            Matrix4 operator+(const Matrix4& b) { return add(b); }
 
             /**
             \*brief: overrides the addition operator and returns the temporary added matrix result by a float
             \*param [b]: float value to be added by
             **/
-            Matrix4& operator+(float b) { return add(b); }
+            Matrix4 operator+(float b) { return add(b); }
 
             /**
             \*brief: overrides the addition equals operator, adds, and returns the result in this matrix
@@ -210,13 +210,13 @@ namespace pxl { namespace graphics {
             \*brief: overrides the subtraction operator and returns the temporary added matrix result
             \*param [b]: matrix to be subtracted by
             **/
-            Matrix4& operator-(const Matrix4& b) { return sub(b); }
+            Matrix4 operator-(const Matrix4& b) { return sub(b); }
 
             /**
             \*brief: overrides the addition operator and returns the temporary added matrix result by a float
             \*param [b]: float value to be subtracted by
             **/
-            Matrix4& operator-(float b) { return sub(b); }
+            Matrix4 operator-(float b) { return sub(b); }
 
             /**
             \*brief: overrides the subtraction equals operator, subs, and returns the result in this matrix
@@ -242,13 +242,13 @@ namespace pxl { namespace graphics {
 		    \*brief: overrides the multiplication operator and returns the temporary multiplied matrix result
 		    \*param [b]: matrix to be multiplied by
 		    **/
-            Matrix4& operator*(const Matrix4& b) { return mul(b); }
+            Matrix4 operator*(const Matrix4& b) { return mul(b); }
 
             /**
             \*brief: overrides the multiplication operator and returns the temporary multiplied matrix result by a float
             \*param [b]: float value to be multiplied by
             **/
-            Matrix4& operator*(float b) { return mul(b); }
+            Matrix4 operator*(float b) { return mul(b); }
 
             /**
             \*brief: overrides the multiplication equals operator, multiplies, and returns the result in this matrix
@@ -0,0 +1,327 @@
+#ifndef _MOCK_GL_H
+#define _MOCK_GL_H
+
+/** ------------------------------------------------------------------------------------------------
+The mock GL backend replaces every GL function pxl calls with one that records the call into a command
+log instead of talking to a driver, so the renderer can be run, benchmarked and inspected on machines
+without a GPU or a GL context. It is enabled by defining PXL_MOCK_GL for the whole build, in which
+case PXLAPI.h includes this header straight after glew and redirects the GL names below.\n
+Objects get ids from counters, shaders always compile and link, fences are always signalled and buffer
+uploads/mappings are kept in cpu memory so uploaded data can be read back with get_mock_gl_buffer. The base
+level of every texture is kept the same way and read back with get_mock_gl_texture.
+------------------------------------------------------------------------------------------------ **/
+
+#include <vector>
+
+namespace pxl { namespace graphics {
+
+    /** A single recorded GL call
+    **/
+    struct MockGLCommand {
+
+        const char* name = ""; /**> The GL function, such as "glDrawElements" **/
+        long long args[4]; /**> The first 4 integer arguments of the call (pointers and floats are left out). glTexSubImage2D
+                               records its xoffset, yoffset, width and height instead **/
+        unsigned int bytes = 0; /**> Bytes uploaded to the GPU by the call **/
+    };
+
+    /** Totals of everything recorded since the last reset_mock_gl
+    **/
+    struct MockGLStats {
+
+        unsigned int calls = 0; /**> Every recorded GL call **/
+        unsigned int draw_calls = 0; /**> glDrawElements and glDrawArraysInstanced calls **/
+        unsigned int vertices_drawn = 0; /**> Indices drawn by glDrawElements plus vertices per instance drawn by instanced draws **/
+        unsigned int instances_drawn = 0;
+        unsigned int state_changes = 0; /**> Binds, enables/disables, program, blend and depth state calls **/
+        unsigned long long bytes_uploaded = 0; /**> Buffer, mapped buffer and texture bytes sent to the GPU **/
+    };
+
+    /** The GL version and extensions the mock backend reports through the GLEW_ macros
+    **/
+    struct MockGLCaps {
+
+        bool version_3_3 = true;
+        bool arb_instanced_arrays = true;
+        bool arb_sync = true;
+        bool arb_map_buffer_range = true;
+        bool arb_buffer_storage = true;
+    };
+
+    /** The cpu copy of a texture's base level, with rows tightly packed whatever the unpack alignment was
+    **/
+    struct MockGLTexture {
+
+        int width = 0;
+        int height = 0;
+        unsigned int bytes_per_pixel = 0;
+        std::vector<unsigned char> pixels;
+    };
+
+    /** Gets every call recorded since the last reset_mock_gl, in call order
+    **/
+    extern const std::vector<MockGLCommand>& get_mock_gl_log();
+    extern const MockGLStats& get_mock_gl_stats();
+
+    /** Clears the command log and stats. Objects and buffer contents are kept
+    **/
+    extern void reset_mock_gl();
+
+    /** Sets whether calls are added to the command log. Stats are always counted, so turning the log off
+    keeps benchmarks from measuring the log growing
+    **/
+    extern void set_mock_gl_logging(bool enabled);
+
+    /** Sets what the mock backend reports as supported, to test each fallback path
+    **/
+    extern void set_mock_gl_caps(const MockGLCaps& caps);
+
+    /** Gets the cpu copy of a buffer object's contents, or NULL if the buffer doesn't exist
+    **/
+    extern const std::vector<unsigned char>* get_mock_gl_buffer(GLuint id);
+
+    /** Gets the cpu copy of a texture's base level, or NULL if no base level was ever specified for it
+    **/
+    extern const MockGLTexture* get_mock_gl_texture(GLuint id);
+
+    namespace mock {
+
+        extern MockGLCaps caps;
+
+        extern GLenum GlewInit();
+
+        extern void ActiveTexture(GLenum texture);
+        extern void AttachShader(GLuint program, GLuint shader);
+        extern void BindAttribLocation(GLuint program, GLuint index, const GLchar* name);
+        extern void BindBuffer(GLenum target, GLuint buffer);
+        extern void BindFramebuffer(GLenum target, GLuint framebuffer);
+        extern void BindTexture(GLenum target, GLuint texture);
+        extern void BindVertexArray(GLuint array);
+        extern void BlendFunc(GLenum sfactor, GLenum dfactor);
+        extern void BufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+        extern void BufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+        extern void BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data);
+        extern GLenum CheckFramebufferStatus(GLenum target);
+        extern void Clear(GLbitfield mask);
+        extern void ClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+        extern void ClearDepthf(GLfloat depth);
+        extern GLenum ClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout);
+        extern void CompileShader(GLuint shader);
+        extern void CopyTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint x, GLint y, GLsizei width, GLsizei height);
+        extern GLuint CreateProgram();
+        extern GLuint CreateShader(GLenum type);
+        extern void DeleteBuffers(GLsizei n, const GLuint* buffers);
+        extern void DeleteFramebuffers(GLsizei n, const GLuint* framebuffers);
+        extern void DeleteProgram(GLuint program);
+        extern void DeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers);
+        extern void DeleteShader(GLuint shader);
+        extern void DeleteSync(GLsync sync);
+        extern void DeleteTextures(GLsizei n, const GLuint* textures);
+        extern void DeleteVertexArrays(GLsizei n, const GLuint* arrays);
+        extern void DepthFunc(GLenum func);
+        extern void DepthMask(GLboolean flag);
+        extern void DetachShader(GLuint program, GLuint shader);
+        extern void Disable(GLenum cap);
+        extern void DisableVertexAttribArray(GLuint index);
+        extern void DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instancecount);
+        extern void DrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices);
+        extern void Enable(GLenum cap);
+        extern void EnableVertexAttribArray(GLuint index);
+        extern GLsync FenceSync(GLenum condition, GLbitfield flags);
+        extern void FramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+        extern void GenBuffers(GLsizei n, GLuint* buffers);
+        extern void GenFramebuffers(GLsizei n, GLuint* framebuffers);
+        extern void GenTextures(GLsizei n, GLuint* textures);
+        extern void GenVertexArrays(GLsizei n, GLuint* arrays);
+        extern void GetIntegerv(GLenum pname, GLint* data);
+        extern void GetProgramInfoLog(GLuint program, GLsizei buf_size, GLsizei* length, GLchar* info_log);
+        extern void GetProgramiv(GLuint program, GLenum pname, GLint* params);
+        extern void GetShaderInfoLog(GLuint shader, GLsizei buf_size, GLsizei* length, GLchar* info_log);
+        extern void GetShaderiv(GLuint shader, GLenum pname, GLint* params);
+        extern const GLubyte* GetString(GLenum name);
+        extern GLint GetUniformLocation(GLuint program, const GLchar* name);
+        extern void LinkProgram(GLuint program);
+        extern void* MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+        extern void PixelStorei(GLenum pname, GLint param);
+        extern void ProvokingVertex(GLenum mode);
+        extern void ReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels);
+        extern void ShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length);
+        extern void TexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels);
+        extern void TexParameteri(GLenum target, GLenum pname, GLint param);
+        extern void TexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels);
+        extern void Uniform1f(GLint location, GLfloat v0);
+        extern void Uniform1fv(GLint location, GLsizei count, const GLfloat* value);
+        extern void Uniform1i(GLint location, GLint v0);
+        extern void Uniform2f(GLint location, GLfloat v0, GLfloat v1);
+        extern void Uniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2);
+        extern void Uniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3);
+        extern void UniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+        extern GLboolean UnmapBuffer(GLenum target);
+        extern void UseProgram(GLuint program);
+        extern void VertexAttribDivisor(GLuint index, GLuint divisor);
+        extern void VertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer);
+        extern void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    };
+}};
+
+//redirect the gl names used by pxl to the mock backend. glew defines most of them as macros already
+#undef glActiveTexture
+#undef glAttachShader
+#undef glBindAttribLocation
+#undef glBindBuffer
+#undef glBindFramebuffer
+#undef glBindTexture
+#undef glBindVertexArray
+#undef glBlendFunc
+#undef glBufferData
+#undef glBufferStorage
+#undef glBufferSubData
+#undef glCheckFramebufferStatus
+#undef glClear
+#undef glClearColor
+#undef glClearDepthf
+#undef glClientWaitSync
+#undef glCompileShader
+#undef glCopyTexSubImage2D
+#undef glCreateProgram
+#undef glCreateShader
+#undef glDeleteBuffers
+#undef glDeleteFramebuffers
+#undef glDeleteProgram
+#undef glDeleteRenderbuffers
+#undef glDeleteShader
+#undef glDeleteSync
+#undef glDeleteTextures
+#undef glDeleteVertexArrays
+#undef glDepthFunc
+#undef glDepthMask
+#undef glDetachShader
+#undef glDisable
+#undef glDisableVertexAttribArray
+#undef glDrawArraysInstanced
+#undef glDrawElements
+#undef glEnable
+#undef glEnableVertexAttribArray
+#undef glFenceSync
+#undef glFramebufferTexture2D
+#undef glGenBuffers
+#undef glGenFramebuffers
+#undef glGenTextures
+#undef glGenVertexArrays
+#undef glGetIntegerv
+#undef glGetProgramInfoLog
+#undef glGetProgramiv
+#undef glGetShaderInfoLog
+#undef glGetShaderiv
+#undef glGetString
+#undef glGetUniformLocation
+#undef glLinkProgram
+#undef glMapBufferRange
+#undef glPixelStorei
+#undef glProvokingVertex
+#undef glReadPixels
+#undef glShaderSource
+#undef glTexImage2D
+#undef glTexParameteri
+#undef glTexSubImage2D
+#undef glUniform1f
+#undef glUniform1fv
+#undef glUniform1i
+#undef glUniform2f
+#undef glUniform3f
+#undef glUniform4f
+#undef glUniformMatrix4fv
+#undef glUnmapBuffer
+#undef glUseProgram
+#undef glVertexAttribDivisor
+#undef glVertexAttribPointer
+#undef glViewport
+
+#define glActiveTexture pxl::graphics::mock::ActiveTexture
+#define glAttachShader pxl::graphics::mock::AttachShader
+#define glBindAttribLocation pxl::graphics::mock::BindAttribLocation
+#define glBindBuffer pxl::graphics::mock::BindBuffer
+#define glBindFramebuffer pxl::graphics::mock::BindFramebuffer
+#define glBindTexture pxl::graphics::mock::BindTexture
+#define glBindVertexArray pxl::graphics::mock::BindVertexArray
+#define glBlendFunc pxl::graphics::mock::BlendFunc
+#define glBufferData pxl::graphics::mock::BufferData
+#define glBufferStorage pxl::graphics::mock::BufferStorage
+#define glBufferSubData pxl::graphics::mock::BufferSubData
+#define glCheckFramebufferStatus pxl::graphics::mock::CheckFramebufferStatus
+#define glClear pxl::graphics::mock::Clear
+#define glClearColor pxl::graphics::mock::ClearColor
+#define glClearDepthf pxl::graphics::mock::ClearDepthf
+#define glClientWaitSync pxl::graphics::mock::ClientWaitSync
+#define glCompileShader pxl::graphics::mock::CompileShader
+#define glCopyTexSubImage2D pxl::graphics::mock::CopyTexSubImage2D
+#define glCreateProgram pxl::graphics::mock::CreateProgram
+#define glCreateShader pxl::graphics::mock::CreateShader
+#define glDeleteBuffers pxl::graphics::mock::DeleteBuffers
+#define glDeleteFramebuffers pxl::graphics::mock::DeleteFramebuffers
+#define glDeleteProgram pxl::graphics::mock::DeleteProgram
+#define glDeleteRenderbuffers pxl::graphics::mock::DeleteRenderbuffers
+#define glDeleteShader pxl::graphics::mock::DeleteShader
+#define glDeleteSync pxl::graphics::mock::DeleteSync
+#define glDeleteTextures pxl::graphics::mock::DeleteTextures
+#define glDeleteVertexArrays pxl::graphics::mock::DeleteVertexArrays
+#define glDepthFunc pxl::graphics::mock::DepthFunc
+#define glDepthMask pxl::graphics::mock::DepthMask
+#define glDetachShader pxl::graphics::mock::DetachShader
+#define glDisable pxl::graphics::mock::Disable
+#define glDisableVertexAttribArray pxl::graphics::mock::DisableVertexAttribArray
+#define glDrawArraysInstanced pxl::graphics::mock::DrawArraysInstanced
+#define glDrawElements pxl::graphics::mock::DrawElements
+#define glEnable pxl::graphics::mock::Enable
+#define glEnableVertexAttribArray pxl::graphics::mock::EnableVertexAttribArray
+#define glFenceSync pxl::graphics::mock::FenceSync
+#define glFramebufferTexture2D pxl::graphics::mock::FramebufferTexture2D
+#define glGenBuffers pxl::graphics::mock::GenBuffers
+#define glGenFramebuffers pxl::graphics::mock::GenFramebuffers
+#define glGenTextures pxl::graphics::mock::GenTextures
+#define glGenVertexArrays pxl::graphics::mock::GenVertexArrays
+#define glGetIntegerv pxl::graphics::mock::GetIntegerv
+#define glGetProgramInfoLog pxl::graphics::mock::GetProgramInfoLog
+#define glGetProgramiv pxl::graphics::mock::GetProgramiv
+#define glGetShaderInfoLog pxl::graphics::mock::GetShaderInfoLog
+#define glGetShaderiv pxl::graphics::mock::GetShaderiv
+#define glGetString pxl::graphics::mock::GetString
+#define glGetUniformLocation pxl::graphics::mock::GetUniformLocation
+#define glLinkProgram pxl::graphics::mock::LinkProgram
+#define glMapBufferRange pxl::graphics::mock::MapBufferRange
+#define glPixelStorei pxl::graphics::mock::PixelStorei
+#define glProvokingVertex pxl::graphics::mock::ProvokingVertex
+#define glReadPixels pxl::graphics::mock::ReadPixels
+#define glShaderSource pxl::graphics::mock::ShaderSource
+#define glTexImage2D pxl::graphics::mock::TexImage2D
+#define glTexParameteri pxl::graphics::mock::TexParameteri
+#define glTexSubImage2D pxl::graphics::mock::TexSubImage2D
+#define glUniform1f pxl::graphics::mock::Uniform1f
+#define glUniform1fv pxl::graphics::mock::Uniform1fv
+#define glUniform1i pxl::graphics::mock::Uniform1i
+#define glUniform2f pxl::graphics::mock::Uniform2f
+#define glUniform3f pxl::graphics::mock::Uniform3f
+#define glUniform4f pxl::graphics::mock::Uniform4f
+#define glUniformMatrix4fv pxl::graphics::mock::UniformMatrix4fv
+#define glUnmapBuffer pxl::graphics::mock::UnmapBuffer
+#define glUseProgram pxl::graphics::mock::UseProgram
+#define glVertexAttribDivisor pxl::graphics::mock::VertexAttribDivisor
+#define glVertexAttribPointer pxl::graphics::mock::VertexAttribPointer
+#define glViewport pxl::graphics::mock::Viewport
+
+#undef glewInit
+#define glewInit pxl::graphics::mock::GlewInit
+
+//report the capabilities set with set_mock_gl_caps instead of asking the (missing) driver
+#undef GLEW_VERSION_3_3
+#undef GLEW_ARB_instanced_arrays
+#undef GLEW_ARB_sync
+#undef GLEW_ARB_map_buffer_range
+#undef GLEW_ARB_buffer_storage
+#define GLEW_VERSION_3_3 pxl::graphics::mock::caps.version_3_3
+#define GLEW_ARB_instanced_arrays pxl::graphics::mock::caps.arb_instanced_arrays
+#define GLEW_ARB_sync pxl::graphics::mock::caps.arb_sync
+#define GLEW_ARB_map_buffer_range pxl::graphics::mock::caps.arb_map_buffer_range
+#define GLEW_ARB_buffer_storage pxl::graphics::mock::caps.arb_buffer_storage
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef _PIXEL_CONVERT_H
+#define _PIXEL_CONVERT_H
+
+#include "graphics/Bitmap.h"
+#include "PXLAPI.h"
+
+namespace pxl { namespace graphics {
+
+    /** Converts pixels from one channel layout to another. Every conversion goes through 8 bit rgba, a block of
+    pixels at a time, with the premultiply and 16 bit packing done by the pixel kernels. Channels that the source
+    doesn't have are filled with 255, gray is written as the luminance of the colour and premultiplied sources are
+    divided by their alpha before being written to a layout that isn't premultiplied.
+    @param src num_pixels pixels in src_channel's layout
+    @param src_channel The layout of src
+    @param dest Where to write num_pixels pixels in dest_channel's layout. Can be the same memory as src if
+    dest_channel has the same or fewer bytes per pixel
+    @param dest_channel The layout to convert to
+    @param num_pixels The amount of pixels to convert
+    **/
+    extern void convert_pixels(const uint8* src, const Channel& src_channel, uint8* dest, const Channel& dest_channel, uint32 num_pixels);
+}};
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef _PIXEL_KERNELS_H
+#define _PIXEL_KERNELS_H
+
+#include "PXLAPI.h"
+
+namespace pxl { namespace graphics {
+
+    enum PixelKernel {
+        PIXEL_KERNEL_SCALAR, /**> One pixel at a time, used as the reference the other kernels match **/
+        PIXEL_KERNEL_SSE, /**> 16 bytes at a time with SSE2 **/
+        PIXEL_KERNEL_AVX2, /**> 32 bytes at a time with AVX2, picked at runtime if the cpu supports it **/
+        PIXEL_KERNEL_NEON, /**> 16 bytes at a time with NEON, only when compiled for an arm target with NEON **/
+    };
+
+    /** Writes the same pixel to every pixel in dest
+    @param dest Where to write num_pixels * num_channels bytes
+    @param num_pixels The amount of pixels to fill
+    @param pixel The num_channels bytes of the pixel to write
+    @param num_channels The bytes per pixel, from 1 to 4
+    @param kernel The kernel to use, falls back to the scalar kernel if not supported
+    **/
+    extern void fill_pixels(uint8* dest, uint32 num_pixels, const uint8* pixel, uint32 num_channels, PixelKernel kernel);
+    extern void fill_pixels(uint8* dest, uint32 num_pixels, const uint8* pixel, uint32 num_channels);
+
+    /** Checks whether any pixel has an alpha below 255
+    @param pixels num_pixels * num_channels bytes of pixels
+    @param num_pixels The amount of pixels to check
+    @param num_channels The bytes per pixel, from 1 to 4
+    @param alpha_index Which byte of each pixel is the alpha
+    @param kernel The kernel to use, falls back to the scalar kernel if not supported
+    \return Returns true if any of the pixels is not fully opaque
+    **/
+    extern bool scan_transparency(const uint8* pixels, uint32 num_pixels, uint32 num_channels, uint32 alpha_index, PixelKernel kernel);
+    extern bool scan_transparency(const uint8* pixels, uint32 num_pixels, uint32 num_channels, uint32 alpha_index);
+
+    /** Multiplies the colour of every rgba pixel by its alpha, rounding to the nearest value. The alpha is left as is
+    @param pixels num_pixels * 4 bytes of pixels in r, g, b, a order, premultiplied in place
+    @param num_pixels The amount of pixels
+    @param kernel The kernel to use, falls back to the scalar kernel if not supported. AVX2 uses the SSE kernel
+    **/
+    extern void premultiply_pixels(uint8* pixels, uint32 num_pixels, PixelKernel kernel);
+    extern void premultiply_pixels(uint8* pixels, uint32 num_pixels);
+
+    /** Packs rgba pixels into 16 bit GL_UNSIGNED_SHORT_4_4_4_4 pixels, keeping the top 4 bits of each channel.
+    dest can be the same memory as pixels
+    @param pixels num_pixels * 4 bytes of pixels in r, g, b, a order
+    @param num_pixels The amount of pixels
+    @param dest Where to write num_pixels packed pixels
+    @param kernel The kernel to use, falls back to the scalar kernel if not supported. AVX2 and NEON use the SSE and scalar kernels
+    **/
+    extern void pack_rgba4444(const uint8* pixels, uint32 num_pixels, uint16* dest, PixelKernel kernel);
+    extern void pack_rgba4444(const uint8* pixels, uint32 num_pixels, uint16* dest);
+
+    /** Packs rgba pixels into 16 bit GL_UNSIGNED_SHORT_5_6_5 pixels, dropping the alpha and keeping the top 5, 6 and 5
+    bits of r, g and b. dest can be the same memory as pixels
+    **/
+    extern void pack_rgb565(const uint8* pixels, uint32 num_pixels, uint16* dest, PixelKernel kernel);
+    extern void pack_rgb565(const uint8* pixels, uint32 num_pixels, uint16* dest);
+
+    /** Copies a run of pixels, such as one row of a bitmap into a row of a bigger one. dest and src must not overlap
+    @param dest Where to write num_bytes bytes
+    @param src The bytes to copy
+    @param num_bytes The amount of bytes to copy
+    @param kernel The kernel to use, falls back to the scalar kernel (memcpy) if not supported
+    **/
+    extern void copy_pixels(uint8* dest, const uint8* src, uint32 num_bytes, PixelKernel kernel);
+    extern void copy_pixels(uint8* dest, const uint8* src, uint32 num_bytes);
+
+    /** Returns whether a kernel is compiled in and supported by the cpu
+    **/
+    extern bool is_pixel_kernel_supported(PixelKernel kernel);
+
+    /** Gets the kernel used when none is specified. Defaults to the fastest supported kernel
+    **/
+    extern PixelKernel get_pixel_kernel();
+
+    /** Sets the kernel used when none is specified, ignored if the kernel isn't supported
+    **/
+    extern void set_pixel_kernel(PixelKernel kernel);
+}};
+
+#endif
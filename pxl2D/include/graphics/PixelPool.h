@@ -0,0 +1,94 @@
+#ifndef _PIXEL_POOL_H
+#define _PIXEL_POOL_H
+
+#include <vector>
+#include <mutex>
+#include "PXLAPI.h"
+#include "system/Config.h"
+
+namespace pxl { namespace graphics {
+
+    /** ------------------------------------------------------------------------------------------------
+    The pixel pool hands out the pixel buffers used by bitmaps. Every buffer starts on a 64 byte boundary
+    and its size is rounded up to a size class (a multiple of 64 bytes, with 4 classes between each power
+    of 2), so kernels can work on whole vectors up to the end of the last row. Freed buffers are kept per
+    size class and reused by the next allocation of the same class instead of going back to the heap, which
+    stops loading thousands of small sprites from fragmenting it. All functions are thread safe.
+    ------------------------------------------------------------------------------------------------ **/
+
+    struct PixelPoolStats {
+
+        uint64 outstanding_bytes = 0; /**> Bytes currently handed out and not freed, including arena allocations **/
+        uint64 peak_bytes = 0; /**> The most outstanding bytes there have been since the last reset_pixel_pool_stats **/
+        uint64 pooled_bytes = 0; /**> Bytes of freed buffers kept for reuse **/
+        uint32 allocations = 0;
+        uint32 reuses = 0; /**> Allocations that were given a pooled buffer instead of a new one **/
+    };
+
+    /** A bump allocator for one-shot loads, such as every bitmap of a level. Allocations are never freed
+    individually, the whole arena is released at once with release() or when it's destroyed. The arena has to
+    outlive every bitmap whose pixels came from it.
+    **/
+    class PixelArena {
+
+        public:
+            /**
+            @param block_size The size of each block the arena allocates. Allocations bigger than this get their own block
+            **/
+            PixelArena(uint32 block_size = CONFIG_PIXEL_ARENA_BLOCK_SIZE);
+            ~PixelArena();
+
+            /** Allocates size bytes from the arena, aligned to 64 bytes
+            **/
+            uint8* alloc(uint32 size);
+
+            /** Frees every block the arena has allocated. Buffers that were never given to free_pixels stop counting
+            as outstanding in the pool stats
+            **/
+            void release();
+
+            uint64 get_used_bytes() const { return used_bytes; }
+            uint64 get_reserved_bytes() const { return reserved_bytes; }
+
+        private:
+            std::vector<uint8*> blocks;
+            std::mutex arena_mutex;
+            uint32 block_size;
+            uint32 block_offset;
+            uint32 current_block_size;
+            uint64 used_bytes = 0;
+            uint64 reserved_bytes = 0;
+            uint64 outstanding_bytes = 0; /**> Bytes allocated that haven't been given to free_pixels, guarded by the pool mutex **/
+
+            friend void free_pixels(uint8* pixels);
+
+            PixelArena(const PixelArena&);
+            PixelArena& operator=(const PixelArena&);
+    };
+
+    /** Allocates a pixel buffer of at least size bytes, aligned to 64 bytes. Comes from the current arena if one
+    is set with set_pixel_arena, otherwise from the pool
+    **/
+    extern uint8* alloc_pixels(uint32 size);
+
+    /** Gives a buffer from alloc_pixels back to the pool. Buffers from an arena are left for the arena to release
+    **/
+    extern void free_pixels(uint8* pixels);
+
+    /** Sets the arena alloc_pixels allocates from on every thread, or NULL to go back to the pool
+    **/
+    extern void set_pixel_arena(PixelArena* arena);
+    extern PixelArena* get_pixel_arena();
+
+    /** Frees every pooled buffer back to the heap
+    **/
+    extern void trim_pixel_pool();
+
+    extern PixelPoolStats get_pixel_pool_stats();
+
+    /** Resets the counters and sets the peak to the current outstanding bytes
+    **/
+    extern void reset_pixel_pool_stats();
+}};
+
+#endif
@@ -39,6 +39,47 @@ namespace pxl { namespace graphics {
 	    //[END_VERTEX]
     );
 
+    /**
+	    ------------- instanced vertex shader -------------
+	    vertex shader used by batches in DRAW_INSTANCED mode.
+	    each instance is one quad, the corner is picked
+	    from gl_VertexID (drawn as a 4 vertex triangle fan)
+	    and transformed the same way the batch transforms
+	    vertices on the cpu. outputs match the basic
+	    vertex shader so any fragment shader can be used
+    **/
+    extern const char* instanced_vertex_shader_str = GLSL(
+	    //[START_VERTEX]
+
+	    attribute mediump vec2 a_position;
+	    attribute mediump vec4 a_tex_coord;
+        attribute lowp vec4 a_colour;
+        attribute mediump vec4 a_bounds;
+        attribute mediump vec2 a_rotation;
+        attribute mediump float a_depth;
+
+        uniform mat4 matrix;
+
+	    varying vec4 v_colour;
+        varying vec2 tex_coord;
+        flat out float z_depth;
+
+	    void main() {
+            //corners go (0, 0), (1, 0), (1, 1), (0, 1) like the cpu transformed vertices
+            vec2 corner = vec2(float(gl_VertexID == 1 || gl_VertexID == 2), float(gl_VertexID >= 2));
+            vec2 offset = mix(a_bounds.xy, a_bounds.zw, corner);
+            vec2 pos = a_position + vec2((a_rotation.x * offset.x) - (a_rotation.y * offset.y),
+                                         (a_rotation.y * offset.x) + (a_rotation.x * offset.y));
+
+		    v_colour = a_colour;
+            tex_coord = a_tex_coord.xy + (a_tex_coord.zw * corner);
+            z_depth = a_depth;
+            gl_Position = matrix * vec4(pos.x, pos.y, 0, 1);
+	    }
+
+	    //[END_VERTEX]
+    );
+
     /**
 	    ------------ default fragment shader ------------
 	    author: Richman Stewart
@@ -418,6 +459,35 @@ namespace pxl { namespace graphics {
 
 	    //[END_FRAGMENT]
     );
+
+    /**
+
+	    ------------ distance field text shader ------------
+
+	    draws text from a font using FONT_RENDER_SDF. the
+	    glyph's distance field is 0.5 on its edge, which is
+	    smoothed over the width of one screen pixel so the
+	    edges stay sharp at any scale
+
+    **/
+    extern const char* sdf_text_shader_str = GLSL(
+	    //[START_FRAGMENT]
+
+	    uniform sampler2D t0;
+
+	    varying vec4 v_colour;
+        varying vec2 tex_coord;
+        flat in float z_depth;
+
+	    void main() {
+            float distance = texture2D(t0, tex_coord).a;
+            float smoothing = max(fwidth(distance) * 0.5, 0.001);
+            gl_FragColor = vec4(v_colour.rgb, smoothstep(0.5 - smoothing, 0.5 + smoothing, distance));
+            gl_FragDepth = z_depth;
+	    }
+
+	    //[END_FRAGMENT]
+    );
 }};
 
 #endif
\ No newline at end of file
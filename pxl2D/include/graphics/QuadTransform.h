@@ -0,0 +1,65 @@
+#ifndef _QUAD_TRANSFORM_H
+#define _QUAD_TRANSFORM_H
+
+#include "PXLAPI.h"
+
+namespace pxl { namespace graphics {
+
+    struct VertexPoint;
+
+    enum QuadKernel {
+        QUAD_KERNEL_SCALAR, /**> Plain float maths, used as the reference the other kernels match **/
+        QUAD_KERNEL_SSE, /**> 4 quads at a time with SSE2 **/
+        QUAD_KERNEL_AVX2, /**> 8 quads at a time with AVX2, only used when set with set_quad_kernel and the cpu supports it **/
+        QUAD_KERNEL_NEON, /**> 4 quads at a time with NEON, only when compiled for an arm target with NEON **/
+    };
+
+    /** Structure of arrays describing count quads, where each of the 4 corners is a point on the bounds
+    rotated by (c, s) and offset by (x, y). Corners go (left, top), (right, top), (right, bottom), (left, bottom)
+    **/
+    struct QuadTransforms {
+
+        float* x = NULL;
+        float* y = NULL;
+        float* left = NULL;
+        float* top = NULL;
+        float* right = NULL;
+        float* bottom = NULL;
+        float* c = NULL; /**> Cosine of the rotation, 1 when not rotated **/
+        float* s = NULL; /**> Sine of the rotation, 0 when not rotated **/
+    };
+
+    /** Writes the x and y positions of the 4 vertices of every quad into dest. Every kernel gives the same
+    result as QUAD_KERNEL_SCALAR, as they all do the same multiplies, subtracts and adds in the same order
+    (this relies on floating point contraction into fma being disabled, which is the msvc default)
+    @param quads The quad transforms to read from
+    @param count The amount of quads
+    @param dest Where to write count * 4 vertex positions
+    @param kernel The kernel to use, falls back to the scalar kernel if not supported
+    **/
+    extern void transform_quads(const QuadTransforms& quads, uint32 count, VertexPoint* dest, QuadKernel kernel);
+    extern void transform_quads(const QuadTransforms& quads, uint32 count, VertexPoint* dest);
+
+    /** Converts rgba float colours (0 to 1) into bytes and writes them to all 4 vertices of each quad in dest
+    @param colours count * 4 floats in r, g, b, a order
+    @param count The amount of quads
+    @param dest Where to write count * 4 vertex colours
+    @param kernel The kernel to use, falls back to the scalar kernel if not supported
+    **/
+    extern void convert_quad_colours(const float* colours, uint32 count, VertexPoint* dest, QuadKernel kernel);
+    extern void convert_quad_colours(const float* colours, uint32 count, VertexPoint* dest);
+
+    /** Returns whether a kernel is compiled in and supported by the cpu
+    **/
+    extern bool is_quad_kernel_supported(QuadKernel kernel);
+
+    /** Gets the kernel used when none is specified. Defaults to SSE or NEON when supported, otherwise scalar
+    **/
+    extern QuadKernel get_quad_kernel();
+
+    /** Sets the kernel used when none is specified, ignored if the kernel isn't supported
+    **/
+    extern void set_quad_kernel(QuadKernel kernel);
+}};
+
+#endif
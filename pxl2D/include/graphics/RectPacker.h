@@ -0,0 +1,138 @@
+#ifndef _RECT_PACKER_H
+#define _RECT_PACKER_H
+
+#include <vector>
+#include "graphics/Structs.h"
+#include "system/Config.h"
+#include "PXLAPI.h"
+
+namespace pxl { namespace graphics {
+
+    enum PackMethod {
+        PACK_MAX_RECTS, /**> Tracks every free rectangle and places into the one that leaves the shortest side over. Tightest packing **/
+        PACK_SKYLINE, /**> Tracks the top edge of what's been placed and places as low as it can. Faster, with more waste under the skyline **/
+    };
+
+    struct PackSettings {
+
+        PackMethod method = PACK_MAX_RECTS;
+        bool allow_rotation = false; /**> Lets rects be turned 90 degrees clockwise if they fit better that way **/
+        uint32 padding = 0; /**> Empty pixels left between neighbouring rects, so filtering doesn't bleed between them **/
+        bool power_of_two = false; /**> Rounds the packed width and height up to powers of two **/
+        uint32 max_width = CONFIG_TEXTURE_SHEET_MAX_SIZE;
+        uint32 max_height = CONFIG_TEXTURE_SHEET_MAX_SIZE;
+    };
+
+    /** A rect to place and where it was placed. w and h are the size in the sheet, so they're swapped from the size
+    given if the rect was rotated
+    **/
+    struct PackedRect {
+
+        uint32 x = 0, y = 0, w = 0, h = 0;
+        bool rotated = false; /**> Whether the rect was turned 90 degrees clockwise to fit **/
+        bool packed = false; /**> Whether the rect was placed, only false if it didn't fit **/
+
+        Rect to_rect() const { return Rect(float(x), float(y), float(w), float(h)); }
+    };
+
+    /** The RectPacker class places rects into a sheet without overlapping, entirely on the cpu. It can place rects
+    one at a time into a sheet of a fixed size with insert(), or place a whole set at once with pack(), which
+    sorts them and finds the smallest sheet they fit in.
+    **/
+    class RectPacker {
+
+        public:
+            RectPacker();
+
+            /** Empties the packer and sets the size of the sheet to place into
+            **/
+            void init(uint32 width, uint32 height, const PackSettings& settings = PackSettings());
+
+            /** Places a rect into the sheet
+            @param w, h The size of the rect, not counting padding
+            @param rect Set to where the rect was placed
+            \return Returns false if there's no room left for the rect
+            **/
+            bool insert(uint32 w, uint32 h, PackedRect& rect);
+
+            /** Gets whether insert() would find room for a rect, without placing it
+            **/
+            bool can_insert(uint32 w, uint32 h) const;
+
+            /** Frees a rect placed by insert() so its area can be used again. Only the free areas around the rect are
+            joined with it, so this costs about as much as an insert. Freeing can still leave the sheet fragmented, as
+            nothing that's placed is moved
+            @param rect A rect this packer placed and that hasn't been removed already
+            \return Returns false if the packer uses PACK_SKYLINE, which can't free rects, or didn't place the rect
+            **/
+            bool remove(const PackedRect& rect);
+
+            /** Frees a set of rects placed by insert(), rebuilding the free areas once from every rect that's left
+            rather than joining each freed rect in. Faster than remove() for each rect once a good share of the sheet
+            is freed, and leaves the same free areas. Rects the packer didn't place are skipped
+            \return Returns the amount of rects freed
+            **/
+            uint32 remove(const std::vector<PackedRect>& rects);
+
+            /** Places a set of rects, trying bigger sheets until they all fit. Rects are placed biggest first, which
+            packs far tighter than placing them in the order given. The sheet is cropped to what was used afterwards
+            @param rects The rects to place. Set the w and h of each one, the rest is filled in
+            @param settings How to place them and the biggest sheet to try
+            \return Returns false if they didn't all fit in the max size. Rects that did fit are still placed
+            **/
+            bool pack(std::vector<PackedRect>& rects, const PackSettings& settings = PackSettings());
+
+            uint32 get_width() const { return width; }
+            uint32 get_height() const { return height; }
+
+            /** Gets the area of every rect placed, not counting padding
+            **/
+            uint64 get_used_area() const { return used_area; }
+            float get_occupancy() const { return width * height != 0 ? float(used_area) / (float(width) * height) : 0; }
+
+            /** Gets the area of the biggest rect that could still be inserted with PACK_MAX_RECTS, or 0 with PACK_SKYLINE
+            **/
+            uint64 get_largest_free_area() const;
+
+        private:
+            /** A rect in bin space, where every rect is padded on its right and bottom and the bin is padded to match
+            **/
+            struct Area {
+
+                int32 x, y, w, h;
+            };
+
+            /** One horizontal segment of the skyline
+            **/
+            struct SkylineNode {
+
+                int32 x, y, w;
+            };
+
+            PackSettings settings;
+            uint32 width;
+            uint32 height;
+            int32 bin_width;
+            int32 bin_height;
+            uint64 used_area;
+            std::vector<Area> free_areas;
+            std::vector<Area> used_areas; /**> Every rect placed with PACK_MAX_RECTS, padded, to rebuild free_areas from **/
+            std::vector<SkylineNode> skyline;
+            std::vector<Area> join_queue; /**> Areas waiting to be joined in by join_free_area **/
+
+            bool find_max_rects(int32 w, int32 h, Area& area, bool& rotated) const;
+            void place_max_rects(const Area& area);
+            void split_free_areas(const Area& used);
+            void prune_free_areas();
+            bool remove_used_area(const PackedRect& rect, Area& freed);
+            void join_free_area(const Area& freed);
+            bool is_inside_free_area(const Area& area) const;
+            void sort_free_areas();
+            void rebuild_free_areas();
+            bool find_skyline(int32 w, int32 h, Area& area, bool& rotated, size_t& node_index) const;
+            bool fit_skyline(size_t node_index, int32 w, int32 h, int32& y) const;
+            void place_skyline(size_t node_index, const Area& area);
+    };
+}};
+
+#endif
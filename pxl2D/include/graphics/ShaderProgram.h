@@ -26,6 +26,11 @@ namespace pxl { namespace graphics {
 		    \*brief: gets the program id
 		    **/
 		    uint32 get_program_id() { return program_id; }
+
+		    /**
+		    \*brief: uses the program for rendering, through the gl state cache
+		    **/
+		    void bind();
 		    uint32 get_matrix_loc() { return matrix_loc; }
 		    uint32 get_uniform_location(int index) { return locations[index]; }
 		    uint32 add_uniform_location(std::string uniform_name);
@@ -33,6 +38,11 @@ namespace pxl { namespace graphics {
 		    void print_program_log(GLuint program_id);
 		    void print_shader_log(GLuint shader_id);
 
+		    /**
+		    \*brief: set once a batch has reported that this shader has no instanced variant, so it's only reported once
+		    **/
+		    bool missing_instanced_reported = false;
+
 	    private:
 		    //shaderprogram ids
 		    uint32 vertex_id;
@@ -5,10 +5,10 @@
 #include <iostream>
 #include "graphics/ShaderProgram.h"
 
-class Batch;
-
 namespace pxl { namespace graphics {
 
+    class Batch;
+
     /**
     \*brief: creates a shader program from the specified vertex and fragment shader paths
     \*param [vertex_file]: the path to the vertex shader file
@@ -42,13 +42,32 @@ namespace pxl { namespace graphics {
     extern ShaderProgram* outline_shader;
     extern ShaderProgram* glow_shader;
     extern ShaderProgram* text_shader;
+    extern ShaderProgram* sdf_text_shader;
     extern ShaderProgram* point_light_shader;
 
+    //instanced variants of the premade shaders, used by batches in DRAW_INSTANCED mode
+    extern ShaderProgram* default_instanced_shader;
+
     /**
     \*brief: initialises prebuilt shaders, note: this should only ever be called by PXL
     **/
     extern const void init_shader();
 
+    /**
+    \*brief: gets the instanced variant of a shader, used by batches in DRAW_INSTANCED mode
+    \*param [shader]: the shader to get the variant of, NULL gets the default instanced shader
+    \*return: the registered variant, or NULL if it has none. Batches draw shaders without a variant with the
+    default instanced shader and show an exception
+    **/
+    extern ShaderProgram* get_instanced_shader(ShaderProgram* shader);
+
+    /**
+    \*brief: registers a shader created with instanced_vertex_shader_str as the instanced variant of a shader
+    \*param [shader]: the shader used with a batch in DRAW_VERTICES mode
+    \*param [instanced_shader]: the shader that will be used in its place in DRAW_INSTANCED mode
+    **/
+    extern void register_instanced_shader(ShaderProgram* shader, ShaderProgram* instanced_shader);
+
     /**
     \*brief: sets a prebuilt default shader onto the specified batch
     \*param [batch]: the batch object to set the shader to
@@ -0,0 +1,93 @@
+#ifndef _STREAM_BUFFER_H
+#define _STREAM_BUFFER_H
+
+#include <vector>
+#include "graphics/GraphicsAPI.h"
+#include "PXLAPI.h"
+
+namespace pxl { namespace graphics {
+
+    #define STREAM_BUFFER_NUM_SEGMENTS 3            /**> The amount of frames that can be in flight before a segment is reused **/
+
+    //fences and buffer range mapping are needed to stream, gles2 has neither so it always falls back to glBufferData
+    #if defined(GL_SYNC_GPU_COMMANDS_COMPLETE) && defined(GL_MAP_UNSYNCHRONIZED_BIT)
+        #define STREAM_BUFFER_SUPPORTED
+    #endif
+
+    /** The StreamBuffer class streams per-frame data to the GPU through a ring buffer split into
+    STREAM_BUFFER_NUM_SEGMENTS segments. Each segment is fenced after it has been drawn with and is only
+    written to again once the GPU has finished with it.\n
+    Where glBufferStorage is available the whole ring is persistently mapped once, otherwise each segment
+    is mapped with glMapBufferRange using unsynchronised and invalidate range flags. If neither is supported,
+    writes go to a cpu staging buffer which is uploaded with glBufferData on unmap.
+    **/
+    class StreamBuffer {
+
+	    public:
+		    StreamBuffer();
+		    ~StreamBuffer();
+
+		    /** Creates the ring buffer
+		    @param buffer_target The buffer target to bind to, such as GL_ARRAY_BUFFER
+		    @param segment_size The size in bytes of each segment. The ring is grown if a map asks for more
+		    **/
+		    void create(GLenum buffer_target, uint32 segment_size);
+
+		    /** Binds the ring buffer, waits for the next segment to be free and maps it for writing
+		    @param size The amount of bytes that will be written
+		    \return A pointer to write size bytes to, or NULL if the buffer has not been created
+		    **/
+		    uint8* map(uint32 size);
+
+		    /** Finishes writing to the mapped segment. The segment is left bound
+		    \return The byte offset of the segment in the buffer, used for attrib pointer/draw offsets
+		    **/
+		    uint32 unmap();
+
+		    /** Places a fence after all draws that read from the current segment and moves on to the next one
+		    **/
+		    void fence();
+
+		    /** Deletes the ring buffer and all fences
+		    **/
+		    void free();
+
+		    bool is_created() { return buffer_created; }
+		    bool is_persistent() { return persistent; }
+		    bool is_streaming() { return streaming; }
+		    GLuint get_id() { return id; }
+
+		    /** Gets the amount of times map had to block on a fence since the last reset_stats
+		    **/
+		    uint32 get_sync_waits() { return sync_waits; }
+		    /** Gets the amount of bytes mapped for writing since the last reset_stats
+		    **/
+		    uint32 get_bytes_uploaded() { return bytes_uploaded; }
+		    void reset_stats() { sync_waits = 0; bytes_uploaded = 0; }
+
+	    private:
+		    bool buffer_created = false;
+		    bool persistent = false;
+		    bool streaming = false;                 /**> Whether the ring is used at all, false when falling back to glBufferData **/
+		    GLuint id = 0;
+		    GLenum target = 0;
+		    uint32 segment_size = 0;
+		    uint32 segment = 0;                     /**> The index of the segment currently being written to **/
+		    uint32 map_size = 0;
+		    uint8* persistent_ptr = NULL;
+		    std::vector<uint8> staging;             /**> Written to instead of the ring when streaming isn't supported **/
+            #if defined(STREAM_BUFFER_SUPPORTED)
+		        GLsync fences[STREAM_BUFFER_NUM_SEGMENTS];
+            #endif
+
+		    uint32 sync_waits = 0;
+		    uint32 bytes_uploaded = 0;
+
+		    /** Creates the GL buffer storage for all segments, recreating it if it already exists
+		    **/
+		    void create_storage();
+		    void wait_fence(uint32 index);
+    };
+}};
+
+#endif
@@ -80,6 +80,8 @@ namespace pxl { namespace graphics {
 		    float height = 0;				/*> The height boundaries of the text */
 		    Rect rect;					/*> The rendering boundaries */
 		    Rect src_rect;				/*> The texture source rendering boundaries */
+		    Texture* glyph_texture = NULL;	/*> The atlas page the current glyph is drawn from */
+		    uint32 glyph_padding = 0;		/*> Distance field around the current glyph, drawn but not counted in the layout */
 		    Vec2 origin;				/*> The origin point of the text to perform rotation and scaling transformations */
 		    Vec2 temp_origin;			/*> The origin used to calculate when rendering */
 		    Vec2 font_scale;			/*> The scale of the font texture */
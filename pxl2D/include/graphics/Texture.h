@@ -4,6 +4,7 @@
 #include "graphics/GraphicsAPI.h"
 #include "graphics/Structs.h"
 #include "graphics/Bitmap.h"
+#include "system/TextureContainer.h"
 #include "PXLAPI.h"
 #include "system/Exception.h"
 
@@ -24,7 +25,18 @@ namespace pxl { namespace graphics {
 		    bool texture_created; /**< Defines whether the texture has been created or not **/
 		    bool has_transparency = false;
 
-		    bool create_texture(std::string file_path);
+		    /** Creates the texture from a png, or from a pxt texture container if the path ends in .pxt
+		    @param file_path The path and file name of the png or pxt to load
+		    @param premultiply_alpha Loads the png as CHANNEL_RGBA_PREMULTIPLIED, so a Batch draws the texture with
+		    BLEND_PREMULTIPLIED. Avoids dark fringes where transparent pixels are filtered or rendered into a FrameBuffer.
+		    Ignored for pxt files, which are uploaded in the layout they were stored in
+		    **/
+		    bool create_texture(std::string file_path, bool premultiply_alpha = false);
+		    /** Creates the texture from an opened pxt texture container, uploading every mip level it holds. Raw payloads
+		    are uploaded straight from the mapped file. Mipmapped filtering is used if the mip chain goes down to 1x1
+		    @param container The opened container
+		    **/
+		    bool create_texture(sys::TextureContainer& container);
 		    /** Creates the texture from specified bitmap
 		    @param bitmap Holds all pixel information for an image
 		    @param pixel_mode The pixel type of the pixel data (default is R, G, B, A)
@@ -43,6 +55,12 @@ namespace pxl { namespace graphics {
 		    bool check_has_transparency();
 		
 		    void update_data(uint8* pixels);
+		    /** Uploads pixels into part of the texture with glTexSubImage2D, leaving the rest as is
+		    @param x, y The top left of the area to update
+		    @param w, h The size of the area to update
+		    @param pixels w * h pixels, tightly packed in the texture's channel layout
+		    **/
+		    void update_sub_data(int x, int y, int w, int h, const uint8* pixels);
 
 		    /** Deletes all texture information
 		    **/
@@ -65,6 +83,9 @@ namespace pxl { namespace graphics {
 		    **/
 		    GLint get_id() const { return id; }
 		    Channel get_channel() const { return channel; }
+		    /** Gets whether the pixels of the texture have premultiplied alpha, which is taken from its channel
+		    **/
+		    bool is_premultiplied() const { return channel.premultiplied; }
 
 	    protected:
 		    int width; /**< The width of the texture **/
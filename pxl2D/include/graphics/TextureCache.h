@@ -0,0 +1,105 @@
+#ifndef _TEXTURE_CACHE_H
+#define _TEXTURE_CACHE_H
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include "graphics/Texture.h"
+#include "system/Config.h"
+#include "PXLAPI.h"
+
+namespace pxl { namespace graphics {
+
+    /** Counters of a texture cache since it was created or its stats were last reset. bytes_resident and
+    textures_resident are always the current values
+    **/
+    struct TextureCacheStats {
+
+        uint32 hits = 0; /**> Acquires that were given a texture that was already loaded **/
+        uint32 misses = 0; /**> Acquires that had to load the texture **/
+        uint32 evictions = 0; /**> Unreferenced textures freed to keep under the byte budget **/
+        uint64 bytes_resident = 0; /**> Texture bytes currently loaded, referenced or not **/
+        uint32 textures_resident = 0;
+
+        float get_hit_rate() const { return hits + misses != 0 ? float(hits) / (hits + misses) : 0; }
+    };
+
+    /** The TextureCache class shares textures loaded from files so each file is only read, decoded and uploaded
+    once while it's in use. Textures are reference counted: acquire() adds a reference and release() removes one.
+    Textures with no references stay loaded in case they're acquired again, until the bytes of every loaded texture
+    go over the byte budget, at which point the least recently released ones are freed first.\n
+    Textures can be keyed by their path, or by a hash of their file contents so that identical files under different
+    paths share one texture. Loading and freeing calls GL, so a cache must only be used from the render thread.
+    **/
+    class TextureCache {
+
+        public:
+            TextureCache(uint64 byte_budget = CONFIG_TEXTURE_CACHE_BYTE_BUDGET);
+            ~TextureCache();
+
+            /** Gets the texture of a file, loading it if it isn't cached, and adds a reference to it
+            @param file_path The path and file name of the png or pxt to load
+            @param premultiply_alpha Loads the texture with premultiplied alpha, cached apart from the straight version
+            \return The texture, or NULL if it couldn't be loaded. It must be given back with release() and not deleted
+            **/
+            Texture* acquire(std::string file_path, bool premultiply_alpha = false);
+
+            /** The same as acquire(), but keyed by a hash of the file's contents rather than its path. The file is
+            mapped and hashed on every call, which is far cheaper than decoding it but not free
+            **/
+            Texture* acquire_by_content(std::string file_path, bool premultiply_alpha = false);
+
+            /** Removes a reference from a texture given out by acquire(). The texture stays loaded until it's evicted
+            **/
+            void release(Texture* texture);
+
+            /** Sets the most bytes of textures to keep loaded, evicting unreferenced textures straight away if the
+            cache is over it. Referenced textures are never evicted, so the cache can go over its budget if they
+            alone are bigger than it
+            **/
+            void set_byte_budget(uint64 byte_budget);
+            uint64 get_byte_budget() const { return budget; }
+
+            /** Frees every texture that has no references
+            **/
+            void evict_unused();
+
+            /** Frees every texture, referenced or not. Textures given out before this are no longer valid
+            **/
+            void clear();
+
+            const TextureCacheStats& get_stats() const { return stats; }
+            void reset_stats();
+
+        private:
+            struct Entry {
+
+                Texture* texture = NULL;
+                uint32 refs = 0;
+                uint64 bytes = 0;
+                std::list<std::string>::iterator lru_pos; /**> Position in unused_list, only valid while refs is 0 **/
+            };
+
+            uint64 budget;
+            TextureCacheStats stats;
+            std::unordered_map<std::string, Entry> entries;
+            std::unordered_map<Texture*, std::string> texture_keys;
+            std::list<std::string> unused_list; /**> Keys of unreferenced textures, least recently released first **/
+
+            /** Gets a cached texture by key or loads it from file_path, adding a reference either way
+            **/
+            Texture* acquire_key(const std::string& key, const std::string& file_path, bool premultiply_alpha);
+
+            /** Frees unreferenced textures, least recently released first, until the cache is within max_bytes
+            **/
+            void evict_to(uint64 max_bytes);
+            void evict(std::unordered_map<std::string, Entry>::iterator it);
+    };
+
+    /** Gets the cache shared by the whole program, created with the default byte budget on first use. It's never
+    destroyed, so call clear() on it before the gl context goes if its textures should be freed
+    **/
+    extern TextureCache* get_texture_cache();
+}};
+
+#endif
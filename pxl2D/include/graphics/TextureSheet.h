@@ -3,6 +3,7 @@
 
 #include <vector>
 #include "graphics/Batch.h"
+#include "graphics/RectPacker.h"
 
 namespace pxl { namespace graphics {
 
@@ -22,7 +23,11 @@ namespace pxl { namespace graphics {
 		    Colour bg_colour;
 
 		    /**
-		    \*brief: creates the texture sheet from all added bitmaps and textures
+		    \*brief: creates the texture sheet from all added bitmaps and textures. If any bitmaps were added, the sheet is built
+		    from them on the cpu with composite and uploaded once without changing the viewport, and textures are not drawn
+		    \*param [sheet_channel]: the layout of the sheet. Blending transparent textures into the sheet's frame buffer leaves
+		    its colour multiplied by alpha, so sheets built from premultiplied textures should use CHANNEL_RGBA_PREMULTIPLIED
+		    to be drawn with BLEND_PREMULTIPLIED, which keeps the edges of transparent textures from darkening
 		    **/
 		    void create_sheet(Channel sheet_channel = CHANNEL_RGBA, bool dispose_batch = true, bool dispose_list = false, bool clear_list = true);
 
@@ -43,6 +48,46 @@ namespace pxl { namespace graphics {
 				     int z_depth = 0, Colour colour = COLOUR_WHITE, 
 				     ShaderProgram* shader = NULL, BlendMode blend_mode = BLEND);
 
+		    /**
+		    \*brief: adds a bitmap to be copied into the sheet at its own size on the cpu. Bitmaps are copied rather than
+		    blended, so where they overlap the last one added wins. The bitmap isn't copied until the sheet is created, so
+		    it has to stay alive until then
+		    \*param [x], [y]: the top left of the bitmap in the sheet
+		    **/
+		    void add(Bitmap* bitmap, uint32 x, uint32 y);
+
+		    /**
+		    \*brief: adds a bitmap to be placed by pack rather than at a rect given by hand. The bitmap isn't copied, so it
+		    has to stay alive until the sheet is created
+		    \*return the index of the bitmap's rect in get_packed_rects
+		    **/
+		    uint32 add_packed(Bitmap* bitmap);
+
+		    /**
+		    \*brief: places every bitmap added with add_packed and sizes the sheet to fit them. Bitmaps placed by hand aren't
+		    avoided, so a sheet should use one or the other
+		    \*param [settings]: the packing method, rotation, padding, power of two sizing and biggest sheet size to use
+		    \*return false if the bitmaps don't all fit within the max size in settings
+		    **/
+		    bool pack(const PackSettings& settings = PackSettings());
+
+		    /**
+		    \*brief: copies every bitmap added into a bitmap the size of the sheet, converting them to the sheet's layout and
+		    filling the gaps with bg_colour. Rows are copied with the simd pixel kernels in bands on the worker threads, and
+		    the result doesn't depend on how the bands are scheduled. Called from a pool job, the bands are copied inline. This doesn't touch GL, so sheets can be built and
+		    checked without a context
+		    \*param [sheet_bitmap]: the bitmap to build the sheet in, recreated at the sheet's size
+		    \*param [sheet_channel]: the layout of the sheet
+		    \*return false if pack hasn't placed every packed bitmap or no bitmaps were added
+		    **/
+		    bool composite(Bitmap& sheet_bitmap, Channel sheet_channel = CHANNEL_RGBA);
+
+		    /**
+		    \*brief: gets where each bitmap added with add_packed was placed, in the order they were added. Rotated rects
+		    hold their bitmap turned 90 degrees clockwise
+		    **/
+		    const std::vector<PackedRect>& get_packed_rects() const { return packed_rects; }
+
 		    void set_width(int new_width) { width = new_width; }
 		    void set_height(int new_height) { height = new_height; }
 
@@ -54,6 +99,16 @@ namespace pxl { namespace graphics {
 	    private:
             Batch* batch = NULL;
 		    std::vector<Texture*> texture_list;
+		    std::vector<Bitmap*> packed_bitmaps;
+		    std::vector<PackedRect> packed_rects;
+		    std::vector<Bitmap*> placed_bitmaps;
+		    std::vector<PackedRect> placed_rects;
+		    bool packed = false;
+
+		    /**
+		    \*brief: marks the sheet as created and disposes of whatever create_sheet was asked to
+		    **/
+		    void finish_sheet(bool dispose_batch, bool dispose_list, bool clear_list);
     };
 }};
 
@@ -0,0 +1,64 @@
+#ifndef _TEXTURE_STREAM_H
+#define _TEXTURE_STREAM_H
+
+#include <string>
+#include "graphics/Texture.h"
+#include "system/ImageIO.h"
+#include "system/Config.h"
+#include "PXLAPI.h"
+
+namespace pxl { namespace graphics {
+
+    /** The TextureStream class loads a png into a texture over several frames. The texture is created at full size
+    straight away, then each update decodes strips of rows with a PNGStream and uploads them with glTexSubImage2D
+    until its time budget runs out. Only one strip is ever held in memory, rather than the whole image and its copy
+    in the bitmap.\n
+    Call update() once per frame on the render thread. The texture can be drawn while it streams, rows that haven't
+    been uploaded yet are undefined.
+    **/
+    class TextureStream {
+
+        public:
+            TextureStream();
+            ~TextureStream();
+
+            /** Opens a png and creates the texture it streams into at the png's full size
+            @param file_name The path and file name of the png
+            @param texture The texture to stream into. It's recreated, so any contents are lost
+            @param channel The layout to upload in. If this value is NULL, the png's own layout is used
+            @param strip_rows The amount of rows decoded and uploaded at a time
+            \return Returns false if the png couldn't be opened
+            **/
+            bool open(std::string file_name, Texture* texture, const Channel* channel = NULL,
+                      uint32 strip_rows = CONFIG_TEXTURE_STREAM_STRIP_ROWS);
+
+            /** Decodes and uploads strips until budget microseconds have passed. At least one strip is uploaded in
+            each call, so every update makes progress
+            @param budget The time to spend in microseconds
+            \return Returns true once every row has been uploaded or the png turned out to be corrupt
+            **/
+            bool update(uint32 budget = CONFIG_TEXTURE_STREAM_FRAME_BUDGET);
+
+            /** Stops streaming and frees the strip. The texture keeps whatever was uploaded
+            **/
+            void close();
+
+            bool is_finished() const { return finished; }
+            bool has_error() const { return png.has_error(); }
+            uint32 get_rows_uploaded() const { return rows_uploaded; }
+            float get_progress() const { return png.get_height() != 0 ? float(rows_uploaded) / png.get_height() : 0; }
+
+        private:
+            sys::PNGStream png;
+            Texture* texture;
+            uint8* strip; /**> strip_rows rows in the upload layout, from the pixel pool **/
+            uint32 strip_rows;
+            uint32 rows_uploaded;
+            bool finished;
+
+            TextureStream(const TextureStream&);
+            TextureStream& operator=(const TextureStream&);
+    };
+}};
+
+#endif
@@ -17,7 +17,33 @@ namespace pxl { namespace sys {
 
     //batch config
     #define CONFIG_BATCH_VERTEX_RESIZE                 64           /**< Incremental vertex batch resize - the amount to resize and allocate if a new add goes over the vertex batch capacity vector **/
-    #define CONFIG_BATCH_INDICES_RESIZE                48           /**< Incremental indices batch resize - the amount to resize and allocate if a new add goes over the indices capacity vector **/
+    #define CONFIG_BATCH_INDEX_CAPACITY                1024         /**< Initial amount of quads the static quad index buffer is built for - doubled whenever a render goes over it **/
+    #define CONFIG_BATCH_STREAM_SEGMENT_SIZE           65536        /**< Initial size in bytes of each ring buffer segment used by batches in UPLOAD_STREAM mode **/
+
+    //pixel pool config
+    #define CONFIG_PIXEL_POOL_MAX_CLASS_SIZE           16777216     /**< Pixel buffers bigger than this are allocated straight from the heap and never pooled **/
+    #define CONFIG_PIXEL_POOL_MAX_POOLED_BYTES         67108864     /**< Freed pixel buffers are given back to the heap once the pool holds this many bytes **/
+    #define CONFIG_PIXEL_ARENA_BLOCK_SIZE              4194304      /**< Default size of each block a pixel arena allocates **/
+
+    //texture stream config
+    #define CONFIG_TEXTURE_STREAM_STRIP_ROWS           64           /**< Rows a texture stream decodes and uploads at a time - the only part of the image held in memory **/
+    #define CONFIG_TEXTURE_STREAM_FRAME_BUDGET         2000         /**< Default time in microseconds a texture stream spends decoding and uploading in each update **/
+
+    //texture cache config
+    #define CONFIG_TEXTURE_CACHE_BYTE_BUDGET           134217728    /**< Default bytes of textures a texture cache keeps loaded before evicting unreferenced ones **/
+
+    //texture sheet config
+    #define CONFIG_TEXTURE_SHEET_MAX_SIZE              4096         /**< Default biggest width and height a packed texture sheet can grow to **/
+    #define CONFIG_TEXTURE_SHEET_BAND_ROWS             64           /**< Rows of a sheet each worker thread copies bitmaps into at a time when compositing on the cpu **/
+
+    //dynamic atlas config
+    #define CONFIG_DYNAMIC_ATLAS_PAGE_SIZE             1024         /**< Default width and height of each page texture of a dynamic atlas **/
+    #define CONFIG_DYNAMIC_ATLAS_MAX_PAGES             8            /**< Default most pages a dynamic atlas creates before adds start failing **/
+
+    //font config
+    #define CONFIG_FONT_GLYPH_PAGE_SIZE                1024         /**< Width and height of each page of a font's glyph atlas **/
+    #define CONFIG_FONT_GLYPH_MAX_PAGES                4            /**< Pages a font's glyph atlas grows to before the least recently used glyphs are evicted **/
+    #define CONFIG_FONT_SDF_SPREAD                     8            /**< Pixels a distance field glyph's field reaches past its edges, the most an outline or glow can extend **/
 
     /** -------------------------------------------------------
 					    PXL error codes
@@ -32,11 +58,14 @@ namespace pxl { namespace sys {
     #define ERROR_EMPTY_FILE                        "EMPTY_FILE"
     #define ERROR_SHADER_LINK_FAILED                "SHADER_LINK_FAILED"
     #define ERROR_SHADER_COMPILE_FAILED             "SHADER_COMPILE_FAILED"
+    #define ERROR_SHADER_NOT_INSTANCED              "SHADER_NOT_INSTANCED"
     #define ERROR_INVALID_PNG                       "INVALID_PNG"
+    #define ERROR_INVALID_TEXTURE_CONTAINER         "INVALID_TEXTURE_CONTAINER"
     #define ERROR_TEXTURE_CREATION_FAILED           "TEXTURE_CREATION_FAILED"
     #define ERROR_BATCH_ADD_FAILED                  "BATCH_ADD_FAILED"
     #define ERROR_TEXTURE_SHEET_CREATION_FAILED     "TEXTURE_SHEET_CREATION_FAILED"
     #define ERROR_TEXTURE_SHEET_ADD_FAILED          "TEXTURE_SHEET_ADD_FAILED"
+    #define ERROR_ATLAS_ADD_FAILED                  "ATLAS_ADD_FAILED"
 }};
 
 #endif
\ No newline at end of file
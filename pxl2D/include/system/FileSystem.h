@@ -0,0 +1,136 @@
+#ifndef _FILE_SYSTEM_H
+#define _FILE_SYSTEM_H
+
+#include <string>
+#include <unordered_map>
+#include "system/IO.h"
+#include "PXLAPI.h"
+
+#if defined(PLATFORM_ANDROID)
+struct AAssetManager;
+#endif
+
+namespace pxl { namespace sys {
+
+    /** ------------------------------------------------------------------------------------------------
+    The FileSystem class is where MappedFile gets file contents from. Every file pxl reads (pngs, texture
+    containers, shaders and anything passed to read_file_contents) is opened through the current file system, so
+    the same paths can be served from a directory, an archive or the assets of an apk without copying them
+    anywhere first.\n
+    Backends fill in a MappedFile with a read only view of the file and a function to release it with, which is
+    called when the MappedFile is closed.
+    ------------------------------------------------------------------------------------------------ **/
+    class FileSystem {
+
+        public:
+            virtual ~FileSystem() { }
+
+            /** Opens a file and points file at its contents. file is already closed when this is called
+            \return Returns false if the file doesn't exist or couldn't be read
+            **/
+            virtual bool open(const std::string& file_name, MappedFile& file) = 0;
+            virtual bool exists(const std::string& file_name) = 0;
+
+        protected:
+            /** Gives a MappedFile its view. release is called with data, size and handle when the file is closed,
+            and can be NULL if the view lives as long as the file system
+            **/
+            static void set_view(MappedFile& file, const uint8* data, size_t size, bool mapped,
+                                 MappedFile::ReleaseFunc release, void* handle);
+    };
+
+    /** ------------------------------------------------------------------------------------------------
+    Serves files from a directory on disk, mapping them into memory where the platform allows it and reading them
+    into a heap buffer where it doesn't. This is the default file system, rooted at the working directory.
+    ------------------------------------------------------------------------------------------------ **/
+    class DirectoryFileSystem : public FileSystem {
+
+        public:
+            /** @param root The directory that file names are relative to, with or without a trailing slash. An empty
+            root uses file names as they are
+            **/
+            DirectoryFileSystem(std::string root = "");
+
+            bool open(const std::string& file_name, MappedFile& file);
+            bool exists(const std::string& file_name);
+
+            const std::string& get_root() const { return root; }
+
+        private:
+            std::string root;
+
+            std::string get_path(const std::string& file_name) const;
+    };
+
+    /** ------------------------------------------------------------------------------------------------
+    Serves files out of a zip archive (such as an apk) mapped into memory. Stored entries are handed out as views
+    straight into the mapping, deflated entries are inflated into a heap buffer when they're opened. The archive
+    stays mapped until the file system is destroyed, so it has to outlive every file opened through it.
+    ------------------------------------------------------------------------------------------------ **/
+    class ZipFileSystem : public FileSystem {
+
+        public:
+            ZipFileSystem();
+            ~ZipFileSystem();
+
+            /** Maps an archive from disk and reads its central directory, closing any archive already open
+            @param archive_name The path and file name of the archive
+            @param prefix Only entries under this directory are served, with it removed from their names. For
+            example "assets/" serves the assets of an apk by the same names AAssetManager uses
+            \return Returns false if the archive couldn't be read or isn't a zip
+            **/
+            bool open_archive(std::string archive_name, std::string prefix = "");
+            void close_archive();
+
+            bool open(const std::string& file_name, MappedFile& file);
+            bool exists(const std::string& file_name);
+
+            size_t get_num_entries() const { return entries.size(); }
+
+        private:
+            struct Entry {
+
+                uint16 method;
+                uint32 stored_size;
+                uint32 size;
+                uint32 header_offset; /**> Offset of the entry's local header in the archive **/
+            };
+
+            MappedFile archive;
+            std::unordered_map<std::string, Entry> entries;
+
+            ZipFileSystem(const ZipFileSystem&);
+            ZipFileSystem& operator=(const ZipFileSystem&);
+    };
+
+    #if defined(PLATFORM_ANDROID)
+    /** ------------------------------------------------------------------------------------------------
+    Serves the assets of the apk straight from the AAssetManager. Uncompressed assets are mapped out of the apk by
+    the asset manager and handed out without a copy, compressed ones are inflated once into a buffer the asset
+    owns.
+    ------------------------------------------------------------------------------------------------ **/
+    class AndroidAssetFileSystem : public FileSystem {
+
+        public:
+            AndroidAssetFileSystem(AAssetManager* asset_manager);
+
+            bool open(const std::string& file_name, MappedFile& file);
+            bool exists(const std::string& file_name);
+
+        private:
+            AAssetManager* asset_manager;
+    };
+    #endif
+
+    /** \*brief: sets the file system every MappedFile is opened through. It isn't owned and has to outlive every
+    file opened through it. Set it before anything is loaded, it isn't safe to change while other threads read files
+    \*param [file_system]: the file system to use, or NULL to go back to the working directory
+    **/
+    extern void set_file_system(FileSystem* file_system);
+
+    /** \*brief: gets the file system every MappedFile is opened through
+    **/
+    extern FileSystem* get_file_system();
+}};
+
+#endif
@@ -2,10 +2,58 @@
 #define _IO_H
 
 #include <string>
+#include "PXLAPI.h"
 
 namespace pxl { namespace sys {
 
-    //loads file contents
+    class FileSystem;
+
+    /** ------------------------------------------------------------------------------------------------
+    A read only view of a whole file mapped into memory, so it can be read without copying it through a
+    stream. The view comes from a FileSystem, which maps the file where it can and reads it into a heap
+    buffer where it can't, so get_data is valid either way while the file is open.
+    ------------------------------------------------------------------------------------------------ **/
+    class MappedFile {
+
+        public:
+            typedef void (*ReleaseFunc)(const uint8* data, size_t size, void* handle);
+
+            MappedFile();
+            /** Unmaps the file if it's still open
+            **/
+            ~MappedFile();
+
+            /** Maps the whole of a file into memory, closing any file already open
+            @param file_name The path and file name of the file to map
+            @param file_system The file system to open it from. If this value is NULL, get_file_system() is used
+            \return Returns false if the file doesn't exist or couldn't be read
+            **/
+            bool open(std::string file_name, FileSystem* file_system = NULL);
+            void close();
+
+            const uint8* get_data() const { return data; }
+            size_t get_size() const { return size; }
+            bool is_open() const { return opened; }
+
+            /** Returns whether the data is a real memory mapping rather than a heap copy
+            **/
+            bool is_mapped() const { return mapped; }
+
+        private:
+            const uint8* data;
+            size_t size;
+            bool mapped;
+            bool opened;
+            ReleaseFunc release; /**> Gives the view back to the file system it came from **/
+            void* handle;
+
+            friend class FileSystem;
+
+            MappedFile(const MappedFile&);
+            MappedFile& operator=(const MappedFile&);
+    };
+
+    //loads file contents through the current file system
     //todo: can maybe have pxl_file which contains more information such as file name, contents, size, ect
     std::string read_file_contents(std::string file_name);
 
@@ -3,20 +3,96 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
+#include <future>
 #include "graphics/Bitmap.h"
+#include "system/ThreadPool.h"
+#include "PXLAPI.h"
 
 namespace pxl { namespace sys {
 
+    /**
+    \*brief: sets up the file system assets are read from. On android this serves the apk's assets directly through
+    the AAssetManager, elsewhere files are read relative to the working directory
+    **/
     extern void init_assets();
 
     /**
     \*brief: loads the contents of a png image into a Bitmap
     \*param [file_name]: the path and file name of the png to load
     \*param [bitmap]: The bitmap object to load the png data into. If this value is NULL, a new bitmap will be created with the new values
+    \*param [channel]: the layout to decode into, converted row by row as the png is decoded. If this value is NULL, the
+    png's own layout is used. Palette, low bit depth and 16 bit pngs are always expanded or reduced to 8 bits per channel
     \*return Returns a newly created bitmap if the bitmap parameter is NULL, otherwise the specified bitmap will be returned. However, 
     if an error occurs NULL will be returned.
     **/
-    extern graphics::Bitmap* load_png(std::string file_name, graphics::Bitmap* bitmap = NULL);
+    extern graphics::Bitmap* load_png(std::string file_name, graphics::Bitmap* bitmap = NULL, const graphics::Channel* channel = NULL);
+    /**
+    \*brief: loads a png held in memory into a Bitmap, such as a file mapped with MappedFile or an entry in an archive
+    \*param [data]: the png file contents. It's only read during the call
+    \*param [size]: the size of the png file contents in bytes
+    \*param [bitmap]: The bitmap object to load the png data into. If this value is NULL, a new bitmap will be created with the new values
+    \*param [name]: the name used for the png in error messages
+    \*param [channel]: the layout to decode into. If this value is NULL, the png's own layout is used
+    \*return Returns a newly created bitmap if the bitmap parameter is NULL, otherwise the specified bitmap will be returned. However,
+    if an error occurs NULL will be returned.
+    **/
+    extern graphics::Bitmap* load_png_from_memory(const uint8* data, size_t size, graphics::Bitmap* bitmap = NULL, std::string name = "png in memory", const graphics::Channel* channel = NULL);
+    /**
+    \*brief: decodes a list of pngs into new bitmaps on worker threads. load_png is reentrant, so every png is decoded
+    on its own worker. Textures have to be created from the bitmaps on the render thread once their futures are ready
+    \*param [file_names]: the path and file name of every png to load
+    \*param [pool]: the thread pool to decode on. If this value is NULL, the shared pool from get_thread_pool is used
+    \*return Returns a future for each file name in the same order, which gives the newly created bitmap, or NULL if the
+    png could not be loaded. The caller owns the bitmaps.
+    **/
+    extern std::vector<std::future<graphics::Bitmap*>> load_png_batch(const std::vector<std::string>& file_names, ThreadPool* pool = NULL);
+
+    struct PNGStreamState;
+
+    /** Decodes a png a strip of rows at a time instead of all at once, so only the strip being decoded has to be held
+    in memory. Rows are converted to the target layout as they're decoded, the same as load_png. Interlaced pngs only
+    have whole rows after their last pass, so they're decoded whole on the first read and handed out from there
+    @see graphics::TextureStream
+    **/
+    class PNGStream {
+
+        public:
+            PNGStream();
+            ~PNGStream();
+
+            /** Maps a png and reads its header, ready for the first read_rows call
+            @param file_name The path and file name of the png
+            @param channel The layout to decode into. If this value is NULL, the png's own layout is used
+            \return Returns false if the png doesn't exist or its header is invalid
+            **/
+            bool open(std::string file_name, const graphics::Channel* channel = NULL);
+
+            /** Decodes the next num_rows rows (or what's left of the png) into dest
+            @param dest Where to write the rows, num_rows * get_width() * bytes per pixel of the channel bytes
+            @param num_rows The most rows to decode
+            \return The amount of rows decoded, 0 once every row has been read or if the png is corrupt
+            **/
+            uint32 read_rows(uint8* dest, uint32 num_rows);
+            void close();
+
+            uint32 get_width() const;
+            uint32 get_height() const;
+            uint32 get_next_row() const;
+            graphics::Channel get_channel() const;
+            bool is_finished() const;
+            bool has_error() const;
+
+            /** Gets whether any row decoded so far has a pixel that isn't fully opaque
+            **/
+            bool has_transparency() const;
+
+        private:
+            PNGStreamState* state;
+
+            PNGStream(const PNGStream&);
+            PNGStream& operator=(const PNGStream&);
+    };
 }};
 
 #endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef _LZ4_H
+#define _LZ4_H
+
+#include <cstddef>
+#include "PXLAPI.h"
+
+namespace pxl { namespace sys {
+
+    /** ------------------------------------------------------------------------------------------------
+    A small implementation of the LZ4 block format (no frame header or checksums), used to compress texture
+    container payloads. Decompression only copies bytes, so it's far cheaper than inflating a png.
+    ------------------------------------------------------------------------------------------------ **/
+
+    /** Gets the most bytes lz4_compress can write for src_size bytes of input
+    **/
+    extern size_t lz4_compress_bound(size_t src_size);
+
+    /** Compresses src into an lz4 block with a greedy single hash match finder
+    @param src The bytes to compress
+    @param src_size The amount of bytes in src
+    @param dest Where to write the compressed block
+    @param dest_capacity The size of dest, which must be at least lz4_compress_bound(src_size)
+    \return The size of the compressed block, or 0 if dest is too small
+    **/
+    extern size_t lz4_compress(const uint8* src, size_t src_size, uint8* dest, size_t dest_capacity);
+
+    /** Decompresses an lz4 block. Every read and write is bounds checked, so corrupt blocks fail rather than
+    reading or writing past the buffers
+    @param src The compressed block
+    @param src_size The size of the compressed block
+    @param dest Where to write the decompressed bytes
+    @param dest_size The exact size of the decompressed data
+    \return Returns false if the block is corrupt or doesn't decompress to exactly dest_size bytes
+    **/
+    extern bool lz4_decompress(const uint8* src, size_t src_size, uint8* dest, size_t dest_size);
+}};
+
+#endif
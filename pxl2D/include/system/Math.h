@@ -1,5 +1,5 @@
-#ifndef _MATH_H
-#define _MATH_H
+#ifndef _PXL_MATH_H
+#define _PXL_MATH_H
 
 #include "PXLAPI.h"
 
@@ -0,0 +1,145 @@
+#ifndef _TEXTURE_CONTAINER_H
+#define _TEXTURE_CONTAINER_H
+
+#include <string>
+#include <vector>
+#include "graphics/Bitmap.h"
+#include "system/IO.h"
+#include "PXLAPI.h"
+
+namespace pxl { namespace sys {
+
+    /** ------------------------------------------------------------------------------------------------
+    pxt is pxl's own texture container. It holds pixels already in the layout they're uploaded in, along with
+    their mip chain and whether they're transparent, so loading one is a file mapping and an upload with no
+    decoding. Payloads are either raw, in which case they're uploaded straight out of the mapped file, or lz4
+    compressed, which is only a copy loop to undo.\n
+    Layout (native byte order): TextureContainerHeader, then num_mips TextureContainerMip entries, then each
+    mip's payload starting on a 64 byte boundary.
+    ------------------------------------------------------------------------------------------------ **/
+
+    #define TEXTURE_CONTAINER_MAGIC         0x31545850  /**> "PXT1" **/
+    #define TEXTURE_CONTAINER_VERSION       1
+    #define TEXTURE_CONTAINER_EXTENSION     ".pxt"
+
+    enum TextureContainerFlags {
+        TEXTURE_CONTAINER_TRANSPARENT = 1, /**> At least one pixel of the base level isn't fully opaque **/
+        TEXTURE_CONTAINER_LZ4 = 2, /**> Every mip payload is an lz4 block **/
+    };
+
+    /** The first 64 bytes of a pxt file. The channel is stored field by field so that any Channel can be stored
+    **/
+    struct TextureContainerHeader {
+
+        uint32 magic;
+        uint32 version;
+        uint32 width;
+        uint32 height;
+        uint32 num_channels;
+        uint32 gl_pixel_mode;
+        uint32 gl_pixel_type;
+        uint32 bytes_per_pixel;
+        int16 channel_index[4];
+        uint32 premultiplied;
+        uint32 flags;
+        uint32 num_mips;
+        uint32 reserved[3];
+    };
+
+    struct TextureContainerMip {
+
+        uint32 width;
+        uint32 height;
+        uint64 offset; /**> Byte offset of the payload from the start of the file **/
+        uint64 stored_size; /**> Size of the payload in the file **/
+        uint64 size; /**> Size of the pixels once decompressed **/
+    };
+
+    /** A pxt file opened for reading. The file is mapped rather than read, so raw payloads are never copied
+    before they're uploaded
+    **/
+    class TextureContainer {
+
+        public:
+            TextureContainer();
+            ~TextureContainer();
+
+            /** Maps a pxt file and checks that its header, mip table and payloads are valid
+            @param file_name The path and file name of the pxt to open
+            \return Returns false if the file doesn't exist or isn't a valid pxt
+            **/
+            bool open(std::string file_name);
+
+            /** Opens a pxt held in memory. The memory has to stay valid until the container is closed
+            **/
+            bool open_from_memory(const uint8* data, size_t size, std::string name = "texture container in memory");
+            void close();
+
+            /** Gets the pixels of a mip level in the container's channel layout. Raw payloads point straight into the
+            mapped file. Lz4 payloads are decompressed into a buffer the container owns, which the next call reuses
+            @param level The mip level, where 0 is the full size image
+            \return The pixels, or NULL if the level doesn't exist or its payload is corrupt
+            **/
+            const uint8* get_mip_pixels(uint32 level);
+
+            uint32 get_width() const { return header.width; }
+            uint32 get_height() const { return header.height; }
+            uint32 get_num_mips() const { return header.num_mips; }
+            uint32 get_mip_width(uint32 level) const { return level < mips.size() ? mips[level].width : 0; }
+            uint32 get_mip_height(uint32 level) const { return level < mips.size() ? mips[level].height : 0; }
+            graphics::Channel get_channel() const { return channel; }
+            bool has_transparency() const { return (header.flags & TEXTURE_CONTAINER_TRANSPARENT) != 0; }
+            bool is_compressed() const { return (header.flags & TEXTURE_CONTAINER_LZ4) != 0; }
+            bool is_open() const { return opened; }
+
+            /** Returns whether the mip chain goes all the way down to 1x1, which gles2 needs to sample with mipmaps
+            **/
+            bool has_full_mip_chain() const;
+
+        private:
+            MappedFile file;
+            const uint8* data;
+            size_t size;
+            bool opened;
+            std::string name;
+
+            TextureContainerHeader header;
+            std::vector<TextureContainerMip> mips; /**> Copied out of the file, as memory passed to open_from_memory may not be aligned **/
+            graphics::Channel channel;
+
+            uint8* scratch; /**> Decompressed pixels of the last lz4 mip, from the pixel pool **/
+            uint32 scratch_size;
+
+            /** Checks the header and mip table of the opened data and reads the channel out of the header
+            **/
+            bool validate();
+
+            TextureContainer(const TextureContainer&);
+            TextureContainer& operator=(const TextureContainer&);
+    };
+
+    /**
+    \*brief: writes a bitmap to a pxt file in the bitmap's channel layout
+    \*param [file_name]: the path and file name of the pxt to write
+    \*param [bitmap]: the bitmap to write
+    \*param [compress]: compresses each mip with lz4. Worth it for anything loaded from storage slower than the cpu can copy
+    \*param [generate_mips]: writes a box filtered mip chain down to 1x1 after the base level
+    \*return Returns false if the bitmap has no pixels or the file couldn't be written
+    **/
+    extern bool save_texture_container(std::string file_name, graphics::Bitmap* bitmap, bool compress = true, bool generate_mips = false);
+
+    /**
+    \*brief: converts a png to a pxt file, decoding it once with load_png so every later load skips the decode
+    \*param [png_file_name]: the path and file name of the png to convert
+    \*param [file_name]: the path and file name of the pxt to write
+    \*param [channel]: the layout to store the pixels in, such as CHANNEL_RGBA_PREMULTIPLIED or CHANNEL_RGB565. If this
+    value is NULL, the png's own layout is used
+    \*param [compress]: compresses each mip with lz4
+    \*param [generate_mips]: writes a box filtered mip chain down to 1x1 after the base level
+    \*return Returns false if the png couldn't be loaded or the file couldn't be written
+    **/
+    extern bool convert_png_to_container(std::string png_file_name, std::string file_name, const graphics::Channel* channel = NULL,
+                                         bool compress = true, bool generate_mips = false);
+}};
+
+#endif
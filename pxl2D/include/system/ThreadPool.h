@@ -0,0 +1,71 @@
+#ifndef _THREAD_POOL_H
+#define _THREAD_POOL_H
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <memory>
+#include "PXLAPI.h"
+
+namespace pxl { namespace sys {
+
+    /** ------------------------------------------------------------------------------------------------
+    A fixed set of worker threads that run submitted jobs in the order they were submitted. Jobs must not
+    call GL, as the GL context is only current on the render thread.
+    ------------------------------------------------------------------------------------------------ **/
+    class ThreadPool {
+
+        public:
+            /** Starts the worker threads
+            @param num_threads The amount of workers. 0 uses one per hardware thread
+            **/
+            ThreadPool(uint32 num_threads = 0);
+            /** Waits for every queued job to finish, then stops the workers
+            **/
+            ~ThreadPool();
+
+            /** Queues a job to run on a worker thread
+            @param job Any callable that takes no arguments
+            \return A future that gets the job's return value once it has run
+            **/
+            template <typename F> std::future<typename std::result_of<F()>::type> submit(F job) {
+                typedef typename std::result_of<F()>::type R;
+
+                std::shared_ptr<std::packaged_task<R()>> task = std::make_shared<std::packaged_task<R()>>(job);
+                std::future<R> result = task->get_future();
+                {
+                    std::lock_guard<std::mutex> lock(queue_mutex);
+                    jobs.push([task]() { (*task)(); });
+                }
+                queue_condition.notify_one();
+                return result;
+            }
+
+            uint32 get_num_threads() const { return workers.size(); }
+
+            /** Returns whether the calling thread is one of this pool's workers. Code that waits on the pool has to
+            do its work inline when this is true, as waiting from inside a job can leave no worker free to run it
+            **/
+            bool is_worker_thread() const;
+
+        private:
+            std::vector<std::thread> workers;
+            std::queue<std::function<void()>> jobs;
+            std::mutex queue_mutex;
+            std::condition_variable queue_condition;
+            bool stopping = false;
+
+            void run_worker();
+    };
+
+    /** Gets the pool shared by pxl's asynchronous loaders. It's created with one worker per hardware thread
+    the first time it's used
+    **/
+    extern ThreadPool* get_thread_pool();
+}};
+
+#endif
@@ -1,12 +1,33 @@
 #include "graphics/Batch.h"
 #include <algorithm>
+#include <cstring>
+#include "graphics/GLState.h"
 #include "system/Exception.h"
 #include "system/Debug.h"
 
 namespace pxl { namespace graphics {
 
     //cpp constants (hidden from public)
-    #define MIN_DEPTH_CHANGE (1.0f / PXL_24U_MAX);                          //the minimum depth value that can be added/subbed in a float
+    #define MIN_DEPTH_CHANGE (1.0f / PXL_24U_MAX)                           //the minimum depth value that can be added/subbed in a float
+    #define SORT_KEY_ID_MASK 0x7fffffffULL                                  //the low bits of a sort key that hold the add id
+    #define SORT_KEY_PREMULTIPLIED_BIT (1ULL << 31)                         //set for premultiplied quads so they sort after straight quads at the same z depth
+    #define SORT_KEY_RADIX_BITS 8                                           //the amount of key bits sorted per radix pass
+    #define SORT_KEY_RADIX_SIZE (1 << SORT_KEY_RADIX_BITS)
+    #define SORT_KEY_NUM_PASSES (64 / SORT_KEY_RADIX_BITS)
+    #define GROUP_WINDOW 32                                                 //the most quads an opaque quad is moved back over to join quads of the same state
+
+    /** Fills and uploads the bound element array buffer with the indices of num_quads quads
+    \return The amount of bytes uploaded
+    **/
+    template <typename T> static uint32 upload_quad_indices(uint32 num_quads) {
+        std::vector<T> indices(num_quads * 6);
+        for (uint32 n = 0, i = 0; n < num_quads * 6; n += 6, i += 4) {
+            indices[n] = i;         indices[n + 1] = i + 1;     indices[n + 2] = i + 2;
+            indices[n + 3] = i;     indices[n + 4] = i + 3;     indices[n + 5] = i + 2;
+        }
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(T), &indices[0], GL_STATIC_DRAW);
+        return indices.size() * sizeof(T);
+    }
 
     Batch::Batch(sys::Window* window) {
         batch_created = false;
@@ -18,8 +39,17 @@ namespace pxl { namespace graphics {
 
         {
             //create the vbo
+            #if defined(GL_VERTEX_ARRAY_BINDING)
+                glGenVertexArrays(1, &vao_id);
+            #endif
+            bind_vertex_array(vao_id);
             glGenBuffers(1, &vbo_id);
             glGenBuffers(1, &ibo_id);
+            index_capacity = 0;
+            create_index_buffer(CONFIG_BATCH_INDEX_CAPACITY);
+            if (upload_mode == UPLOAD_STREAM) {
+                vertex_stream.create(GL_ARRAY_BUFFER, CONFIG_BATCH_STREAM_SEGMENT_SIZE);
+            }
 
             batch_created = true;
         }
@@ -47,7 +77,7 @@ namespace pxl { namespace graphics {
         //view_mat -= 4;
 
         glDisable(GL_CULL_FACE);
-        glEnable(GL_DEPTH_TEST);
+        set_depth_test_enabled(true);
 
         //flat identifiers in shaders (non interpolated) use the first inputted vertex to pass to the fragment shader
         glProvokingVertex(GL_FIRST_VERTEX_CONVENTION);
@@ -60,7 +90,7 @@ namespace pxl { namespace graphics {
             current_shader = shader;
 
             //use specified program id
-            glUseProgram(current_shader->get_program_id());
+            current_shader->bind();
 
             //set matrix uniform in the vertex shader for the program
             glUniformMatrix4fv(current_shader->get_matrix_loc(), 1, false, proj_view_mat.get_raw_matrix());
@@ -68,173 +98,207 @@ namespace pxl { namespace graphics {
     }
 
     void Batch::use_blend_mode(BlendMode blend_mode) {
-        //if (current_blend_mode != blend_mode) {
+        if (!blend_mode_valid || current_blend_mode != blend_mode) {
             current_blend_mode = blend_mode;
+            blend_mode_valid = true;
             if (current_blend_mode == BLEND) {
-			    glEnable(GL_BLEND);
-                glDepthMask(GL_FALSE);
-                glDepthFunc(GL_LESS);
-			    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			    set_blend_enabled(true);
+                set_depth_mask(false);
+                set_depth_func(GL_LESS);
+			    set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            }else if (current_blend_mode == BLEND_PREMULTIPLIED) {
+			    set_blend_enabled(true);
+                set_depth_mask(false);
+                set_depth_func(GL_LESS);
+			    set_blend_func(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
             }else if (current_blend_mode == NO_BLEND) {
-			    glDisable(GL_BLEND);
-                glDepthMask(GL_TRUE);
-                glDepthFunc(GL_LESS);
+			    set_blend_enabled(false);
+                set_depth_mask(true);
+                set_depth_func(GL_LESS);
             }
-        //}
+        }
     }
 
     void Batch::add(const Texture& texture, Rect* rect, Rect* src_rect, 
 	    float rotation, Vec2* rotation_origin, Vec2* scale_origin, 
 	    int z_depth, Colour colour, ShaderProgram* shader, BlendMode blend_mode) {
         if (verify_texture_add(texture, rect)) {
-            if (total_vertices >= vertices.size()) {
-                int prev_size = vertices.size();
+            quads.add(texture, rect, src_rect, rotation, rotation_origin, scale_origin, z_depth, colour, shader, blend_mode);
+        }
+    }
 
-                vertices.resize(prev_size + CONFIG_BATCH_VERTEX_RESIZE);
+    void Batch::add_many(const SpriteInstance* sprites, size_t count) {
+        quads.add_many(sprites, count);
+    }
 
-                VertexBatch* last_batch;
-                for (int n = 0; n < CONFIG_BATCH_VERTEX_RESIZE; ++n) {
-                    if (n % 4 == 0) {
-                        last_batch = new VertexBatch();
-                        last_batch->num_vertices = 4;
-                    }
-                    vertices[n + prev_size].batch = last_batch;
+    BatchRecorder* Batch::create_recorder() {
+        BatchRecorder* recorder = new BatchRecorder();
+        recorder->set_draw_mode(quads.get_draw_mode());
+        recorders.push_back(recorder);
+        return recorder;
+    }
+
+    int Batch::get_num_added() {
+        int total = quads.get_num_added();
+        for (size_t n = 0; n < recorders.size(); ++n) total += recorders[n]->get_num_added();
+        return total;
+    }
+
+    inline bool Batch::verify_texture_add(const Texture& texture, Rect* rect) {
+	    return true;
+        if (texture.texture_created) {
+            if (rect->x + rect->w > render_bounds.x && rect->y + rect->h > render_bounds.y && rect->x < render_bounds.w && rect->y < render_bounds.h) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Batch::create_index_buffer(uint32 num_quads) {
+        uint32 capacity = index_capacity > 0 ? index_capacity : CONFIG_BATCH_INDEX_CAPACITY;
+        while (capacity < num_quads) capacity *= 2;
+        index_capacity = capacity;
+
+        //16 bit indices can address 65536 vertices (16384 quads), after that 32 bit indices are used
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_id);
+        if (index_capacity * 4 <= USHRT_MAX + 1) {
+            index_type = GL_UNSIGNED_SHORT;
+            upload_stats.bytes_uploaded += upload_quad_indices<uint16>(index_capacity);
+        }else {
+            index_type = GL_UNSIGNED_INT;
+            upload_stats.bytes_uploaded += upload_quad_indices<uint32>(index_capacity);
+        }
+    }
+
+    uint64 Batch::create_sort_key(const VertexBatch& batch) {
+        //bias the z depth to unsigned so lower z depths are sorted first
+        uint64 z = uint32(batch.z_depth) ^ 0x80000000u;
+
+        uint64 premultiplied = batch.blend_mode == BLEND_PREMULTIPLIED ? SORT_KEY_PREMULTIPLIED_BIT : 0;
+
+        return (z << 32) | premultiplied | (batch.add_id & SORT_KEY_ID_MASK);
+    }
+
+    /** Returns whether two quads are drawn with the same texture, shader and blend mode
+    **/
+    static inline bool same_draw_state(const VertexBatch& a, const VertexBatch& b) {
+        return a.texture_id == b.texture_id && a.shader == b.shader && a.blend_mode == b.blend_mode;
+    }
+
+    static inline bool bounds_overlap(const QuadBounds& a, const QuadBounds& b) {
+        return a.min_x < b.max_x && b.min_x < a.max_x && a.min_y < b.max_y && b.min_y < a.max_y;
+    }
+
+    QuadBounds Batch::get_quad_bounds(uint32 id) const {
+        QuadBounds bounds;
+        if (quads.draw_mode == DRAW_INSTANCED) {
+            //the corners are worked out the same way the instanced shader does, so both draw modes group alike
+            const InstancePoint& inst = quads.instances[id];
+            const float xs[2] = { inst.bounds.left, inst.bounds.right }, ys[2] = { inst.bounds.top, inst.bounds.bottom };
+            for (int i = 0; i < 4; ++i) {
+                float x = inst.pivot.x + ((inst.rotation.c * xs[i & 1]) - (inst.rotation.s * ys[i >> 1]));
+                float y = inst.pivot.y + ((inst.rotation.s * xs[i & 1]) + (inst.rotation.c * ys[i >> 1]));
+                if (i == 0) {
+                    bounds.min_x = bounds.max_x = x;
+                    bounds.min_y = bounds.max_y = y;
                 }
+                bounds.min_x = std::min(bounds.min_x, x); bounds.max_x = std::max(bounds.max_x, x);
+                bounds.min_y = std::min(bounds.min_y, y); bounds.max_y = std::max(bounds.max_y, y);
             }
-            if (total_indices >= indices.size()) {
-                indices.resize(indices.size() + CONFIG_BATCH_INDICES_RESIZE);
+        }else {
+            const VertexPoint* v = &quads.vertices[id * 4];
+            bounds.min_x = bounds.max_x = v[0].pos.x;
+            bounds.min_y = bounds.max_y = v[0].pos.y;
+            for (int i = 1; i < 4; ++i) {
+                bounds.min_x = std::min(bounds.min_x, v[i].pos.x); bounds.max_x = std::max(bounds.max_x, v[i].pos.x);
+                bounds.min_y = std::min(bounds.min_y, v[i].pos.y); bounds.max_y = std::max(bounds.max_y, v[i].pos.y);
             }
+        }
+        return bounds;
+    }
 
-            VertexPoint* v = &vertices[total_vertices];
-            VertexBatch& batch = *v->batch;
-            batch.num_vertices = 4;
-            batch.num_indices = 6;
-            batch.texture_id = texture.get_id();
-            batch.shader = shader;
-            batch.z_depth = z_depth;
-            batch.blend_mode = blend_mode;
-		    batch.add_id = num_added;
-            if (texture.has_transparency || colour.a != 1.0f) {
-                batch.uses_transparency = true;
-                batch.blend_mode = BLEND;
-            }else {
-                batch.uses_transparency = false;
-                batch.blend_mode = NO_BLEND;
-                total_opq_vertices += 4;
+    void Batch::group_opaque_run(uint64* keys, uint32 num_keys) {
+        //each quad moves back to join the last quad with the same state, but only over quads it doesn't overlap.
+        //quads that overlap keep their painter order, so the depths taken from the rank still put the newest on top
+        group_keys.clear();
+        group_bounds.clear();
+        for (uint32 n = 0; n < num_keys; ++n) {
+            const VertexBatch& batch = quads.batches[uint32(keys[n] & SORT_KEY_ID_MASK)];
+            QuadBounds bounds = get_quad_bounds(uint32(keys[n] & SORT_KEY_ID_MASK));
+
+            size_t insert_at = group_keys.size();
+            for (size_t i = group_keys.size(); i > 0 && group_keys.size() - i < GROUP_WINDOW; --i) {
+                if (same_draw_state(quads.batches[uint32(group_keys[i - 1] & SORT_KEY_ID_MASK)], batch)) {
+                    insert_at = i;
+                    break;
+                }
+                if (bounds_overlap(group_bounds[i - 1], bounds)) break;
             }
+            group_keys.insert(group_keys.begin() + insert_at, keys[n]);
+            group_bounds.insert(group_bounds.begin() + insert_at, bounds);
+        }
+        std::copy(group_keys.begin(), group_keys.end(), keys);
+    }
 
-            uint32 i = indices_count;
-            indices[total_indices] = i;			indices[total_indices + 1] = i + 1;		indices[total_indices + 2] = i + 2;
-            indices[total_indices + 3] = i;		indices[total_indices + 4] = i + 3;		indices[total_indices + 5] = i + 2;
-            total_indices += 6;
-            indices_count += 4;
-
-            total_vertices += 4;
-		    ++num_added;
-
-            /**
-            ==================================================================================
-                                           Set vertex positions
-            ==================================================================================
-            **/
-            //set vertex pos, uvs and colours
-		    //copy rect contents into temp rect
-		    Rect r = *rect;
-
-            //set rotation origin
-		    Vec2 r_origin;
-		    if (rotation_origin != NULL) r_origin = *rotation_origin;
-		    //set scale origin
-		    Vec2 s_origin;
-		    if (scale_origin != NULL) {
-			    s_origin = *scale_origin;
-			    //apply scale origin offset
-			    s_origin.x -= rect->x;
-			    s_origin.y -= rect->y;
-			    if (s_origin.x != 0 && s_origin.y != 0) {
-				    r.x += ((texture.get_width() - rect->w) / (texture.get_width() / s_origin.x));
-				    r.y += ((texture.get_height() - rect->h) / (texture.get_height() / s_origin.y));
-			    }
-		    }
-
-            //apply rotation
-            if (rotation != 0) {
-                //set rotation to degrees rather than radians
-                rotation = rotation / PXL_RADIANS;
-			    float c = math::fast_cos(rotation); float s = math::fast_sin(rotation);
-
-			    r_origin.x -= r.x; r_origin.y -= r.y;
-			    r.x += r_origin.x; r.y += r_origin.y;
-			    r.w -= r_origin.x; r.h -= r_origin.y;
-
-                //set vertex position including scale and rotation
-                v[0].pos.x = r.x + ((c * -r_origin.x) - (s * -r_origin.y));
-                v[0].pos.y = r.y + ((s * -r_origin.x) + (c * -r_origin.y));
-
-                v[1].pos.x = r.x + ((c * r.w) - (s * -r_origin.y));
-                v[1].pos.y = r.y + ((s * r.w) + (c * -r_origin.y));
-
-                v[2].pos.x = r.x + ((c * r.w) - (s * r.h));
-                v[2].pos.y = r.y + ((s * r.w) + (c * r.h));
-
-                v[3].pos.x = r.x + ((c * -r_origin.x) - (s * r.h));
-                v[3].pos.y = r.y + ((s * -r_origin.x) + (c * r.h));
-            }else {
-                //set vertex position including scale
-			    v[0].pos.x = r.x;			v[0].pos.y = r.y;
-			    v[1].pos.x = r.x + r.w;		v[1].pos.y = r.y;
-			    v[2].pos.x = r.x + r.w;		v[2].pos.y = r.y + r.h;
-			    v[3].pos.x = r.x;			v[3].pos.y = r.y + r.h;
-            }
-		    v[0].order = total_vertices + 3;
-		    v[1].order = total_vertices + 2;
-		    v[2].order = total_vertices + 1;
-		    v[3].order = total_vertices;
-
-            /**
-            ==================================================================================
-                                           Set UV vertex coords
-            ==================================================================================
-            **/
-            //default un-normalised uv coords
-            uint16 uv_x = 0; uint16 uv_y = 0; uint16 uv_w = USHRT_MAX; uint16 uv_h = USHRT_MAX;
-            if (src_rect != NULL) {
-                //calculate uv x, y, w, h by the src rect
-                uv_x = (src_rect->x / texture.get_width()) * USHRT_MAX; uv_y = (src_rect->y / texture.get_height()) * USHRT_MAX;
-                uv_w = (src_rect->w / texture.get_width()) * USHRT_MAX; uv_h = (src_rect->h / texture.get_height()) * USHRT_MAX;
+    const uint64* Batch::sort_quads() {
+        uint32 num_keys = quads.num_added;
+        if (sort_keys.size() < num_keys) sort_keys.resize(quads.batches.size());
+        if (sort_keys_swap.size() < num_keys) sort_keys_swap.resize(quads.batches.size());
+
+        //keys are built here rather than on add, as recorded quads only get their add ids when merged
+        for (uint32 n = 0; n < num_keys; ++n) sort_keys[n] = create_sort_key(quads.batches[n]);
+
+        //count every radix digit of every key in one pass over the keys
+        uint32 counts[SORT_KEY_NUM_PASSES][SORT_KEY_RADIX_SIZE] = {};
+        for (uint32 n = 0; n < num_keys; ++n) {
+            uint64 key = sort_keys[n];
+            for (int p = 0; p < SORT_KEY_NUM_PASSES; ++p) {
+                ++counts[p][(key >> (p * SORT_KEY_RADIX_BITS)) & (SORT_KEY_RADIX_SIZE - 1)];
             }
+        }
 
-            //set uv coordinates
-            v[0].uv.x = uv_x;										v[0].uv.y = uv_y;
-            v[1].uv.x = uv_x + uv_w;								v[1].uv.y = uv_y;
-            v[2].uv.x = uv_x + uv_w;								v[2].uv.y = uv_y + uv_h;
-            v[3].uv.x = uv_x;										v[3].uv.y = uv_y + uv_h;
-
-            /**
-            ==================================================================================
-                                           Set vertex colours
-            ==================================================================================
-            **/
-            int i_r = colour.r * 255; int i_g = colour.g * 255; int i_b = colour.b * 255; int i_a = colour.a * 255;
-
-            //set vertex colours
-            for (int n = 0; n < 4; ++n) {
-                v[n].colour.r = i_r;
-                v[n].colour.g = i_g;
-                v[n].colour.b = i_b;
-                v[n].colour.a = i_a;
+        uint64* src = &sort_keys[0];
+        uint64* dest = &sort_keys_swap[0];
+        for (int p = 0; p < SORT_KEY_NUM_PASSES; ++p) {
+            int shift = p * SORT_KEY_RADIX_BITS;
+            uint32* count = counts[p];
+
+            //skip the pass if every key has the same digit, as it wouldn't change the order
+            if (count[(src[0] >> shift) & (SORT_KEY_RADIX_SIZE - 1)] == num_keys) continue;
+
+            //turn the digit counts into offsets and scatter the keys (stable)
+            uint32 offset = 0;
+            for (int d = 0; d < SORT_KEY_RADIX_SIZE; ++d) {
+                uint32 c = count[d];
+                count[d] = offset;
+                offset += c;
             }
+            for (uint32 n = 0; n < num_keys; ++n) {
+                uint64 key = src[n];
+                dest[count[(key >> shift) & (SORT_KEY_RADIX_SIZE - 1)]++] = key;
+            }
+            std::swap(src, dest);
         }
-    }
 
-    inline bool Batch::verify_texture_add(const Texture& texture, Rect* rect) {
-	    return true;
-        if (texture.texture_created) {
-            if (rect->x + rect->w > render_bounds.x && rect->y + rect->h > render_bounds.y && rect->x < render_bounds.w && rect->y < render_bounds.h) {
-                return true;
+        //runs of opaque quads at the same z depth that aren't split by a transparent quad are grouped by state where
+        //that doesn't change which quad covers another. transparent quads keep their add order
+        for (uint32 n = 0; n < num_keys;) {
+            uint32 end = n + 1;
+            const VertexBatch& first = quads.batches[uint32(src[n] & SORT_KEY_ID_MASK)];
+            if (!first.uses_transparency) {
+                bool mixed_state = false;
+                while (end < num_keys && (src[end] >> 32) == (src[n] >> 32)) {
+                    const VertexBatch& batch = quads.batches[uint32(src[end] & SORT_KEY_ID_MASK)];
+                    if (batch.uses_transparency) break;
+                    mixed_state = mixed_state || !same_draw_state(batch, first);
+                    ++end;
+                }
+                if (mixed_state) group_opaque_run(src + n, end - n);
             }
+            n = end;
         }
-        return false;
+
+        return src;
     }
 
     void Batch::set_render_target(FrameBuffer* f) {
@@ -246,179 +310,220 @@ namespace pxl { namespace graphics {
         target_window = window;
     }
 
+    void Batch::set_upload_mode(BatchUploadMode mode) {
+        upload_mode = mode;
+        if (upload_mode == UPLOAD_STREAM) {
+            if (batch_created && !vertex_stream.is_created()) {
+                vertex_stream.create(GL_ARRAY_BUFFER, CONFIG_BATCH_STREAM_SEGMENT_SIZE);
+            }
+        }else {
+            vertex_stream.free();
+        }
+    }
+
+    void Batch::set_draw_mode(BatchDrawMode mode) {
+        #if defined(BATCH_INSTANCING_SUPPORTED)
+            if (mode == DRAW_INSTANCED && !(GLEW_VERSION_3_3 || GLEW_ARB_instanced_arrays)) mode = DRAW_VERTICES;
+        #else
+            mode = DRAW_VERTICES;
+        #endif
+
+        //quads added so far were only written out for the old mode, so each recorder clears itself if it changes
+        quads.set_draw_mode(mode);
+        for (size_t n = 0; n < recorders.size(); ++n) recorders[n]->set_draw_mode(mode);
+    }
+
     void Batch::clear_all() {
-        total_vertices = 0;
-        total_opq_vertices = 0;
-        total_indices = 0;
-        indices_count = 0;
-        num_added = 0;
+        quads.clear();
+        for (size_t n = 0; n < recorders.size(); ++n) recorders[n]->clear();
     }
 
     void Batch::render_all() {
+        upload_stats = BatchUploadStats();
+        vertex_stream.reset_stats();
+
+        //merge recorders in index order after the quads added straight to the batch
+        for (size_t n = 0; n < recorders.size(); ++n) quads.append(*recorders[n]);
+
         //if there are no textures to draw or no vertex data then return
-        if (num_added != 0) {
+        if (quads.num_added != 0) {
             //if a framebuffer is specified, bind to it, if not bind to the default framebuffer
             if (target_frame_buffer != NULL) {
                 target_frame_buffer->bind(GL_FRAMEBUFFER_WRITE);
             }else {
-                glBindFramebuffer(GL_FRAMEBUFFER_WRITE, 0);
+                bind_framebuffer(GL_FRAMEBUFFER_WRITE, 0);
             }
 
             proj_view_mat = (perspective_mat * view_mat).transpose();
 
             //clear depth buffer
-            glDepthMask(GL_TRUE);
-            glDepthFunc(GL_ALWAYS);
+            set_depth_mask(true);
+            set_depth_func(GL_ALWAYS);
             glClearDepthf(1.0f);
             glClear(GL_DEPTH_BUFFER_BIT);
-            glEnable(GL_DEPTH_TEST);
+            set_depth_test_enabled(true);
+
+            //the depth state was just changed and the matrix may have, so the first run always sets both
+            current_shader = NULL;
+            blend_mode_valid = false;
 
             draw_vbo();
 
-            glBindFramebuffer(GL_FRAMEBUFFER_WRITE, 0);
+            bind_framebuffer(GL_FRAMEBUFFER_WRITE, 0);
         }
         clear_all();
     }
 
-    void Batch::draw_vbo() {
-        //loops through each texture and draws the vertex data with that texture id
-        int vertex_offset = 0;
-        int indices_offset = 0;
-	    int vertex_index = 0;
-        int num_vertices = 0;
-        int num_indices = 0;
-        bool changed = false;
-	    VertexBatch* v;
-
-        std::stable_sort(vertices.begin(), vertices.begin() + total_vertices,
-        [](const VertexPoint& a, const VertexPoint& b) {
-            if (a.batch->uses_transparency < b.batch->uses_transparency) return true;
-            if (a.batch->uses_transparency > b.batch->uses_transparency) return false;
-
-            if (a.batch->z_depth < b.batch->z_depth) return false;
-            if (a.batch->z_depth > b.batch->z_depth) return true;
-
-            if (!a.batch->uses_transparency) {
-                if (a.batch->add_id < b.batch->add_id) return false;
-                if (a.batch->add_id > b.batch->add_id) return true;
-            }else {
-                if (a.batch->add_id < b.batch->add_id) return true;
-                if (a.batch->add_id > b.batch->add_id) return false;
-            }
-
-            return false;
-	    });
-
-        //algorithm that calculates the depth buffer value for each vertex batch.
-        //primarily used for z depths. basically, the order in which the vertex is in, the higher/lower the
-        //depth buffer value will be (which is why z depth is sorted in order above)
-	    VertexPoint* vi1 = nullptr;
-	    if (total_opq_vertices > 0) {
-		    vi1 = &vertices[total_opq_vertices - 1];
-		    vi1 -= vi1->batch->num_vertices - 1;
-	    }
-	    VertexPoint* vi2 = nullptr;
-	    if (total_vertices > 0) {
-		    vi2 = &vertices[total_vertices - 1];
-		    vi2 -= vi2->batch->num_vertices - 1;
-	    }
-	    VertexPoint* vih = vi1;
-
-        float depth = 1.0f - MIN_DEPTH_CHANGE;
-        for (int n = 0; n < num_added; ++n) {
-		    bool set_vi1_depth = false;
-		    if (vi2 == nullptr) {
-			    set_vi1_depth = true;
-		    }else if (vi1 == nullptr) {
-			    set_vi1_depth = false;
-		    }else if (vi2 <= vih) {
-                set_vi1_depth = true;
-            }else if (vi1 < &vertices[0]) {
-                set_vi1_depth = false;
-            }else if (vi1->batch->z_depth == vi2->batch->z_depth) {
-                set_vi1_depth = vi1->batch->add_id < vi2->batch->add_id;
-            }else {
-                set_vi1_depth = vi1->batch->z_depth < vi2->batch->z_depth;
-            }
+    uint32 Batch::upload_sorted(const uint64* sorted_keys) {
+        uint32 num_quads = quads.num_added;
+        if (sorted_quads.size() < num_quads) sorted_quads.resize(quads.batches.size());
+        uint32 bytes = (quads.draw_mode == DRAW_INSTANCED) ? num_quads * sizeof(InstancePoint) : quads.total_vertices * sizeof(VertexPoint);
+        upload_stats.bytes_uploaded += bytes;
+
+        //sorted data is either written to a cpu copy or straight into the mapped ring buffer
+        uint8* dest;
+        if (upload_mode == UPLOAD_STREAM) {
+            dest = vertex_stream.map(bytes);
+        }else if (quads.draw_mode == DRAW_INSTANCED) {
+            if (sorted_instances.size() < num_quads) sorted_instances.resize(quads.instances.size());
+            dest = (uint8*)&sorted_instances[0];
+        }else {
+            if (sorted_vertices.size() < quads.total_vertices) sorted_vertices.resize(quads.vertices.size());
+            dest = (uint8*)&sorted_vertices[0];
+        }
 
-            if (set_vi1_depth) {
-                vi1->pos.z = depth;
-                //move vertex index 1 up to the next vertex batch. if the index is out of bounds, only move by 1
-                vi1 -= (vi1 <= &vertices[0]) ? 1 : (vi1 - 1)->batch->num_vertices;
+        //the keys are in painter order (back to front), so a quad's depth comes straight from its rank. opaque
+        //quads are drawn first in reverse (front to back) so hidden pixels fail the depth test early, then
+        //transparent quads are drawn back to front so that they blend over everything behind them
+        uint32 num_opq = quads.total_opq_vertices / 4;
+        uint32 next_opq = num_opq;
+        uint32 next_trans = num_opq;
+        for (uint32 rank = 0; rank < num_quads; ++rank) {
+            uint32 id = uint32(sorted_keys[rank] & SORT_KEY_ID_MASK);
+            uint32 n = quads.batches[id].uses_transparency ? next_trans++ : --next_opq;
+            float depth = 1.0f - ((rank + 1) * MIN_DEPTH_CHANGE);
+
+            sorted_quads[n] = id;
+            if (quads.draw_mode == DRAW_INSTANCED) {
+                InstancePoint* inst = (InstancePoint*)dest + n;
+                *inst = quads.instances[id];
+                inst->z = depth;
             }else {
-                vi2->pos.z = depth;
-                //move vertex index 2 up to the next vertex batch. if the index is out of bounds, only move by 1
-                vi2 -= (vih == nullptr || vi2 <= vih) ? 1 : (vi2 - 1)->batch->num_vertices;
+                VertexPoint* v = (VertexPoint*)dest + (n * 4);
+                std::copy(quads.vertices.begin() + (id * 4), quads.vertices.begin() + (id * 4) + 4, v);
+                v[0].pos.z = depth; v[1].pos.z = depth; v[2].pos.z = depth; v[3].pos.z = depth;
             }
-            depth -= MIN_DEPTH_CHANGE;
         }
 
-        //binds vertex buffer
+        //binds vertex buffer and uploads the data if it wasn't streamed
+        if (upload_mode == UPLOAD_STREAM) {
+            return vertex_stream.unmap();
+        }
         glBindBuffer(GL_ARRAY_BUFFER, vbo_id);
+        glBufferData(GL_ARRAY_BUFFER, bytes, dest, GL_DYNAMIC_DRAW);
+        return 0;
+    }
+
+    void Batch::set_attrib_pointers(uint32 offset) {
+        if (quads.draw_mode == DRAW_INSTANCED) {
+            #if defined(BATCH_INSTANCING_SUPPORTED)
+                //every attrib steps once per instance rather than once per vertex
+                glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(InstancePoint), (void*)(size_t)(offset));
+                glVertexAttribPointer(1, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(InstancePoint), (void*)(size_t)(offset + 32));
+                glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(InstancePoint), (void*)(size_t)(offset + 40));
+                glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(InstancePoint), (void*)(size_t)(offset + 8));
+                glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, sizeof(InstancePoint), (void*)(size_t)(offset + 24));
+                glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(InstancePoint), (void*)(size_t)(offset + 44));
+            #endif
+        }else {
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexPoint), (void*)(size_t)(offset));
+            glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(VertexPoint), (void*)(size_t)(offset + 12));
+            glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(VertexPoint), (void*)(size_t)(offset + 16));
+        }
+    }
+
+    void Batch::draw_vbo() {
+        //the index buffer binding and attrib pointers below are stored in the batch's vertex array
+        bind_vertex_array(vao_id);
+        uint32 data_offset = upload_sorted(sort_quads());
 
         //enable vertex attrib pointers when rendering
         glEnableVertexAttribArray(0);
         glEnableVertexAttribArray(1);
         glEnableVertexAttribArray(2);
 
-        //set vertex shader attrib pointers
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexPoint), (void*)0);
-        glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(VertexPoint), (void*)12);
-        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(VertexPoint), (void*)16);
-
-        glBufferData(GL_ARRAY_BUFFER, total_vertices * sizeof(VertexPoint), &vertices[0], GL_DYNAMIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_id);
-	    glBufferData(GL_ELEMENT_ARRAY_BUFFER, total_indices * sizeof(uint32), &indices[0], GL_DYNAMIC_DRAW);
-
-        v = vertices[0].batch;
-	    vertex_index = 0;
-
-        GLuint prev_id = v->texture_id;
-        glBindTexture(GL_TEXTURE_2D, prev_id);
-        BlendMode prev_blend_mode = v->blend_mode;
-        use_blend_mode(prev_blend_mode);
-        ShaderProgram* prev_shader = v->shader;
-        use_shader(prev_shader);
-
-        for (int n = 0; n <= num_added; ++n) {
-            if (n >= num_added) changed = true;
-            else v = vertices[vertex_index].batch;
-
-            glBindTexture(GL_TEXTURE_2D, prev_id);
-            if (v->texture_id != prev_id) {
-                prev_id = v->texture_id;
-                changed = true;
+        uint32 index_size = 0;
+        if (quads.draw_mode == DRAW_INSTANCED) {
+            #if defined(BATCH_INSTANCING_SUPPORTED)
+                glEnableVertexAttribArray(3);
+                glEnableVertexAttribArray(4);
+                glEnableVertexAttribArray(5);
+                for (int n = 0; n < 6; ++n) glVertexAttribDivisor(n, 1);
+            #endif
+        }else {
+            set_attrib_pointers(data_offset);
+
+            //the index buffer only needs to be rebuilt (and bound) if this render has more quads than it can draw
+            if (uint32(quads.num_added) > index_capacity) {
+                create_index_buffer(quads.num_added);
+            }else {
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_id);
             }
+            index_size = (index_type == GL_UNSIGNED_SHORT) ? sizeof(uint16) : sizeof(uint32);
+        }
 
-            use_shader(prev_shader);
-            if (v->shader != prev_shader) {
-                prev_shader = v->shader;
-                changed = true;
+        //draw each run of quads that share the same texture, shader and blend mode with one draw call
+        int run_start = 0;
+        for (int n = 1; n <= quads.num_added; ++n) {
+            const VertexBatch& prev = quads.batches[sorted_quads[n - 1]];
+            if (n < quads.num_added) {
+                const VertexBatch& v = quads.batches[sorted_quads[n]];
+                if (v.texture_id == prev.texture_id && v.shader == prev.shader && v.blend_mode == prev.blend_mode) continue;
             }
 
-            use_blend_mode(prev_blend_mode);
-            if (v->blend_mode != prev_blend_mode) {
-                prev_blend_mode = v->blend_mode;
-                changed = true;
+            bind_texture(prev.texture_id);
+            use_blend_mode(prev.blend_mode);
+            if (quads.draw_mode == DRAW_INSTANCED) {
+                #if defined(BATCH_INSTANCING_SUPPORTED)
+                    //there's no base instance in gl 3.3, so the attrib pointers are moved to the start of the run
+                    //a user shader can't read instance attribs unless it has an instanced variant
+                    ShaderProgram* instanced_shader = get_instanced_shader(prev.shader);
+                    if (instanced_shader == NULL) {
+                        if (!prev.shader->missing_instanced_reported) {
+                            sys::show_exception("Shader has no instanced variant (see register_instanced_shader), drawing with the default shader",
+                                                ERROR_SHADER_NOT_INSTANCED, sys::EXCEPTION_CONSOLE, false);
+                            prev.shader->missing_instanced_reported = true;
+                        }
+                        instanced_shader = default_instanced_shader;
+                    }
+                    use_shader(instanced_shader);
+                    set_attrib_pointers(data_offset + (run_start * sizeof(InstancePoint)));
+                    glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, n - run_start);
+                #endif
+            }else {
+                use_shader(prev.shader);
+                glDrawElements(GL_TRIANGLES, (n - run_start) * 6, index_type, (void*)(size_t)(run_start * 6 * index_size));
             }
 
-            if (changed) {
-                glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_INT, (void*)(indices_offset * sizeof(uint32)));
+            run_start = n;
+        }
 
-                vertex_offset += num_vertices;
-                indices_offset += num_indices;
-                num_vertices = 0;
-                num_indices = 0;
+        if (quads.draw_mode == DRAW_INSTANCED) {
+            #if defined(BATCH_INSTANCING_SUPPORTED)
+                //reset divisors so that other vertex draws aren't affected
+                for (int n = 0; n < 6; ++n) glVertexAttribDivisor(n, 0);
+                glDisableVertexAttribArray(3);
+                glDisableVertexAttribArray(4);
+                glDisableVertexAttribArray(5);
+            #endif
+        }
 
-                changed = false;
-            }
-            vertex_index += v->num_vertices;
-            num_vertices += v->num_vertices;
-            num_indices += v->num_indices;
+        if (upload_mode == UPLOAD_STREAM) {
+            vertex_stream.fence();
+            upload_stats.sync_waits = vertex_stream.get_sync_waits();
         }
 
-        glDisable(GL_DEPTH_TEST);
+        set_depth_test_enabled(false);
     }
 
     void Batch::free() {
@@ -431,19 +536,30 @@ namespace pxl { namespace graphics {
             glDisableVertexAttribArray(2);
 
             glDeleteBuffers(1, &vbo_id);
+            glDeleteBuffers(1, &ibo_id);
+            #if defined(GL_VERTEX_ARRAY_BINDING)
+                glDeleteVertexArrays(1, &vao_id);
+                forget_vertex_array(vao_id);
+            #endif
+            vertex_stream.free();
+
+            clear_all();
+            quads.free();
+            for (size_t n = 0; n < recorders.size(); ++n) delete recorders[n];
+            std::vector<BatchRecorder*>().swap(recorders);
 
-            total_vertices = 0;
-            int num_vertices = 0;
-            while (total_vertices < vertices.size()) {
-                num_vertices = vertices[total_vertices].batch->num_vertices;
-                delete vertices[total_vertices].batch;
-                total_vertices += num_vertices;
-            }
             //clear and set capacity to 0
-            std::vector<VertexPoint>().swap(vertices);
+            std::vector<VertexPoint>().swap(sorted_vertices);
+            std::vector<InstancePoint>().swap(sorted_instances);
+            std::vector<uint32>().swap(sorted_quads);
+            std::vector<uint64>().swap(sort_keys);
+            std::vector<uint64>().swap(sort_keys_swap);
 
             batch_created = false;
             vbo_id = 0;
+            vao_id = 0;
+            ibo_id = 0;
+            index_capacity = 0;
         }
     }
 
@@ -0,0 +1,312 @@
+#include "graphics/BatchRecorder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "system/Config.h"
+#include "system/Math.h"
+
+namespace pxl { namespace graphics {
+
+    /** Points each field of a QuadTransforms at its own run of count floats in data (8 * count floats)
+    **/
+    static QuadTransforms create_transform_view(float* data, uint32 count) {
+        QuadTransforms t;
+        t.x = data;                 t.y = data + count;
+        t.left = data + count * 2;  t.top = data + count * 3;
+        t.right = data + count * 4; t.bottom = data + count * 5;
+        t.c = data + count * 6;     t.s = data + count * 7;
+        return t;
+    }
+
+    /** Multiplies the rgb of a colour by its alpha, so that tinting a premultiplied texture stays premultiplied
+    **/
+    static inline Colour premultiply_colour(const Colour& colour) {
+        Colour c = colour;
+        c.r *= c.a; c.g *= c.a; c.b *= c.a;
+        return c;
+    }
+
+    /** Expands an instance into the 4 vertices the instanced vertex shader would make from it
+    **/
+    static void instance_to_vertices(const InstancePoint& inst, VertexPoint* v) {
+        float x = inst.pivot.x; float y = inst.pivot.y;
+        float l = inst.bounds.left; float t = inst.bounds.top; float r = inst.bounds.right; float b = inst.bounds.bottom;
+        float c = inst.rotation.c; float s = inst.rotation.s;
+
+        v[0].pos.x = x + ((c * l) - (s * t));   v[0].pos.y = y + ((s * l) + (c * t));
+        v[1].pos.x = x + ((c * r) - (s * t));   v[1].pos.y = y + ((s * r) + (c * t));
+        v[2].pos.x = x + ((c * r) - (s * b));   v[2].pos.y = y + ((s * r) + (c * b));
+        v[3].pos.x = x + ((c * l) - (s * b));   v[3].pos.y = y + ((s * l) + (c * b));
+
+        v[0].uv.x = inst.uv.x;                  v[0].uv.y = inst.uv.y;
+        v[1].uv.x = inst.uv.x + inst.uv.w;      v[1].uv.y = inst.uv.y;
+        v[2].uv.x = inst.uv.x + inst.uv.w;      v[2].uv.y = inst.uv.y + inst.uv.h;
+        v[3].uv.x = inst.uv.x;                  v[3].uv.y = inst.uv.y + inst.uv.h;
+
+        for (int i = 0; i < 4; ++i) {
+            v[i].colour.r = inst.colour.r; v[i].colour.g = inst.colour.g;
+            v[i].colour.b = inst.colour.b; v[i].colour.a = inst.colour.a;
+        }
+    }
+
+    /** Works out an instance that expands to the same 4 vertices. The pivot is put on the first corner and the
+    rotation is taken from the top edge (or the left edge if the quad has no width)
+    **/
+    static void vertices_to_instance(const VertexPoint* v, InstancePoint& inst) {
+        float top_x = v[1].pos.x - v[0].pos.x; float top_y = v[1].pos.y - v[0].pos.y;
+        float left_x = v[3].pos.x - v[0].pos.x; float left_y = v[3].pos.y - v[0].pos.y;
+        float width = std::sqrt((top_x * top_x) + (top_y * top_y));
+        float height = std::sqrt((left_x * left_x) + (left_y * left_y));
+
+        float c = 1, s = 0;
+        if (width != 0) {
+            c = top_x / width; s = top_y / width;
+        }else if (height != 0) {
+            c = left_y / height; s = -left_x / height;
+        }
+
+        inst.pivot.x = v[0].pos.x;              inst.pivot.y = v[0].pos.y;
+        inst.bounds.left = 0;                   inst.bounds.top = 0;
+        inst.bounds.right = width;              inst.bounds.bottom = (c * left_y) - (s * left_x);
+        inst.rotation.c = c;                    inst.rotation.s = s;
+
+        inst.uv.x = v[0].uv.x;                  inst.uv.y = v[0].uv.y;
+        inst.uv.w = v[2].uv.x - v[0].uv.x;      inst.uv.h = v[2].uv.y - v[0].uv.y;
+        inst.colour.r = v[0].colour.r; inst.colour.g = v[0].colour.g;
+        inst.colour.b = v[0].colour.b; inst.colour.a = v[0].colour.a;
+    }
+
+    void BatchRecorder::add(const Texture& texture, Rect* rect, Rect* src_rect, 
+	    float rotation, Vec2* rotation_origin, Vec2* scale_origin, 
+	    int z_depth, Colour colour, ShaderProgram* shader, BlendMode blend_mode) {
+        uint32 id = push_quad(texture, z_depth, colour, shader, blend_mode);
+        if (batches[id].blend_mode == BLEND_PREMULTIPLIED) colour = premultiply_colour(colour);
+
+        //a single quad is transformed with the scalar kernel, add_many transforms groups of quads with simd
+        float data[8];
+        QuadTransforms transform = create_transform_view(data, 1);
+        prepare_transform(texture, *rect, rotation, rotation_origin, scale_origin, transform, 0);
+        set_quad_uvs(id, texture, src_rect);
+
+        if (draw_mode == DRAW_INSTANCED) {
+            set_quad_instance(id, transform, 0, colour);
+        }else {
+            transform_quads(transform, 1, &vertices[id * 4], QUAD_KERNEL_SCALAR);
+            convert_quad_colours(&colour.r, 1, &vertices[id * 4], QUAD_KERNEL_SCALAR);
+        }
+    }
+
+    void BatchRecorder::add_many(const SpriteInstance* sprites, size_t count) {
+        if (count == 0) return;
+        grow_quads(num_added + count);
+
+        if (transform_scratch.size() < count * 8) transform_scratch.resize(count * 8);
+        if (colour_scratch.size() < count * 4) colour_scratch.resize(count * 4);
+        QuadTransforms transforms = create_transform_view(&transform_scratch[0], count);
+
+        uint32 first_id = num_added;
+        for (size_t n = 0; n < count; ++n) {
+            const SpriteInstance& sprite = sprites[n];
+            uint32 id = push_quad(*sprite.texture, sprite.z_depth, sprite.colour, sprite.shader, sprite.blend_mode);
+            Colour colour = batches[id].blend_mode == BLEND_PREMULTIPLIED ? premultiply_colour(sprite.colour) : sprite.colour;
+            prepare_transform(*sprite.texture, sprite.rect, sprite.rotation, &sprite.rotation_origin,
+                              sprite.use_scale_origin ? &sprite.scale_origin : NULL, transforms, n);
+            set_quad_uvs(id, *sprite.texture, sprite.use_src_rect ? &sprite.src_rect : NULL);
+
+            if (draw_mode == DRAW_INSTANCED) {
+                //instances are expanded on the gpu, so only the vertex path needs the kernels
+                set_quad_instance(id, transforms, n, colour);
+            }else {
+                memcpy(&colour_scratch[n * 4], &colour.r, sizeof(float) * 4);
+            }
+        }
+
+        if (draw_mode == DRAW_VERTICES) {
+            transform_quads(transforms, count, &vertices[first_id * 4]);
+            convert_quad_colours(&colour_scratch[0], count, &vertices[first_id * 4]);
+        }
+    }
+
+    void BatchRecorder::grow_quads(uint32 num_quads) {
+        if (num_quads <= batches.size()) return;
+
+        uint32 size = batches.size();
+        while (size < num_quads) size += CONFIG_BATCH_VERTEX_RESIZE / 4;
+
+        batches.resize(size);
+        if (draw_mode == DRAW_INSTANCED) {
+            instances.resize(size);
+        }else {
+            vertices.resize(size * 4);
+        }
+    }
+
+    uint32 BatchRecorder::push_quad(const Texture& texture, int z_depth, const Colour& colour, ShaderProgram* shader, BlendMode blend_mode) {
+        grow_quads(num_added + 1);
+
+        VertexBatch& batch = batches[num_added];
+        batch.texture_id = texture.get_id();
+        batch.shader = shader;
+        batch.z_depth = z_depth;
+        batch.blend_mode = blend_mode;
+        batch.add_id = num_added;
+        if (texture.has_transparency || colour.a != 1.0f) {
+            batch.uses_transparency = true;
+            batch.blend_mode = (texture.is_premultiplied() || blend_mode == BLEND_PREMULTIPLIED) ? BLEND_PREMULTIPLIED : BLEND;
+        }else {
+            batch.uses_transparency = false;
+            batch.blend_mode = NO_BLEND;
+            total_opq_vertices += 4;
+        }
+
+        total_vertices += 4;
+        return num_added++;
+    }
+
+    void BatchRecorder::prepare_transform(const Texture& texture, const Rect& rect, float rotation, const Vec2* rotation_origin,
+                                  const Vec2* scale_origin, QuadTransforms& transforms, uint32 index) {
+        /**
+        ==================================================================================
+                                       Set vertex positions
+        ==================================================================================
+        **/
+	    //copy rect contents into temp rect
+	    Rect r = rect;
+
+        //set rotation origin
+	    Vec2 r_origin;
+	    if (rotation_origin != NULL) r_origin = *rotation_origin;
+	    //set scale origin
+	    Vec2 s_origin;
+	    if (scale_origin != NULL) {
+		    s_origin = *scale_origin;
+		    //apply scale origin offset
+		    s_origin.x -= rect.x;
+		    s_origin.y -= rect.y;
+		    if (s_origin.x != 0 && s_origin.y != 0) {
+			    r.x += ((texture.get_width() - rect.w) / (texture.get_width() / s_origin.x));
+			    r.y += ((texture.get_height() - rect.h) / (texture.get_height() / s_origin.y));
+		    }
+	    }
+
+        //apply rotation
+        float c = 1; float s = 0;
+        if (rotation != 0) {
+            //set rotation to degrees rather than radians
+            rotation = rotation / PXL_RADIANS;
+		    c = math::fast_cos(rotation); s = math::fast_sin(rotation);
+
+		    r_origin.x -= r.x; r_origin.y -= r.y;
+		    r.x += r_origin.x; r.y += r_origin.y;
+		    r.w -= r_origin.x; r.h -= r_origin.y;
+        }else {
+            r_origin.x = 0; r_origin.y = 0;
+        }
+
+        //corners are bounds around the rotation origin, rotated by (c, s) and offset by the origin
+        transforms.x[index] = r.x;                  transforms.y[index] = r.y;
+        transforms.left[index] = -r_origin.x;       transforms.top[index] = -r_origin.y;
+        transforms.right[index] = r.w;              transforms.bottom[index] = r.h;
+        transforms.c[index] = c;                    transforms.s[index] = s;
+    }
+
+    void BatchRecorder::set_quad_uvs(uint32 id, const Texture& texture, const Rect* src_rect) {
+        /**
+        ==================================================================================
+                                       Set UV vertex coords
+        ==================================================================================
+        **/
+        //default un-normalised uv coords
+        uint16 uv_x = 0; uint16 uv_y = 0; uint16 uv_w = USHRT_MAX; uint16 uv_h = USHRT_MAX;
+        if (src_rect != NULL) {
+            //calculate uv x, y, w, h by the src rect
+            uv_x = (src_rect->x / texture.get_width()) * USHRT_MAX; uv_y = (src_rect->y / texture.get_height()) * USHRT_MAX;
+            uv_w = (src_rect->w / texture.get_width()) * USHRT_MAX; uv_h = (src_rect->h / texture.get_height()) * USHRT_MAX;
+        }
+
+        if (draw_mode == DRAW_INSTANCED) {
+            InstancePoint& inst = instances[id];
+            inst.uv.x = uv_x; inst.uv.y = uv_y; inst.uv.w = uv_w; inst.uv.h = uv_h;
+            return;
+        }
+
+        //set uv coordinates
+        VertexPoint* v = &vertices[id * 4];
+        v[0].uv.x = uv_x;										v[0].uv.y = uv_y;
+        v[1].uv.x = uv_x + uv_w;								v[1].uv.y = uv_y;
+        v[2].uv.x = uv_x + uv_w;								v[2].uv.y = uv_y + uv_h;
+        v[3].uv.x = uv_x;										v[3].uv.y = uv_y + uv_h;
+    }
+
+    void BatchRecorder::set_quad_instance(uint32 id, const QuadTransforms& transforms, uint32 index, const Colour& colour) {
+        //the vertex shader expands the instance to the same 4 corners the transform kernels write
+        InstancePoint& inst = instances[id];
+        inst.pivot.x = transforms.x[index];             inst.pivot.y = transforms.y[index];
+        inst.bounds.left = transforms.left[index];      inst.bounds.top = transforms.top[index];
+        inst.bounds.right = transforms.right[index];    inst.bounds.bottom = transforms.bottom[index];
+        inst.rotation.c = transforms.c[index];          inst.rotation.s = transforms.s[index];
+        inst.colour.r = int(colour.r * 255); inst.colour.g = int(colour.g * 255);
+        inst.colour.b = int(colour.b * 255); inst.colour.a = int(colour.a * 255);
+    }
+
+    void BatchRecorder::clear() {
+        num_added = 0;
+        total_vertices = 0;
+        total_opq_vertices = 0;
+    }
+
+    void BatchRecorder::append(const BatchRecorder& recorder) {
+        if (recorder.num_added == 0) return;
+
+        uint32 first_id = num_added;
+        grow_quads(num_added + recorder.num_added);
+
+        //add ids carry on from this recorder so the appended quads sort after quads at the same z depth
+        for (int n = 0; n < recorder.num_added; ++n) {
+            batches[first_id + n] = recorder.batches[n];
+            batches[first_id + n].add_id = first_id + n;
+        }
+        //quads recorded in the other mode (by a recorder whose mode was set on its own) are converted as they're copied
+        if (recorder.draw_mode != draw_mode) {
+            for (int n = 0; n < recorder.num_added; ++n) {
+                if (draw_mode == DRAW_INSTANCED) {
+                    vertices_to_instance(&recorder.vertices[n * 4], instances[first_id + n]);
+                }else {
+                    instance_to_vertices(recorder.instances[n], &vertices[(first_id + n) * 4]);
+                }
+            }
+        }else if (draw_mode == DRAW_INSTANCED) {
+            std::copy(recorder.instances.begin(), recorder.instances.begin() + recorder.num_added, instances.begin() + first_id);
+        }else {
+            std::copy(recorder.vertices.begin(), recorder.vertices.begin() + (recorder.num_added * 4), vertices.begin() + (first_id * 4));
+        }
+
+        num_added += recorder.num_added;
+        total_vertices += recorder.total_vertices;
+        total_opq_vertices += recorder.total_opq_vertices;
+    }
+
+    void BatchRecorder::set_draw_mode(BatchDrawMode mode) {
+        if (draw_mode != mode) {
+            //quads recorded so far were only written out for the old mode
+            clear();
+            draw_mode = mode;
+            if (draw_mode == DRAW_INSTANCED) {
+                instances.resize(batches.size());
+            }else {
+                vertices.resize(batches.size() * 4);
+            }
+        }
+    }
+
+    void BatchRecorder::free() {
+        clear();
+
+        //clear and set capacity to 0
+        std::vector<VertexPoint>().swap(vertices);
+        std::vector<InstancePoint>().swap(instances);
+        std::vector<VertexBatch>().swap(batches);
+        std::vector<float>().swap(transform_scratch);
+        std::vector<float>().swap(colour_scratch);
+    }
+}};
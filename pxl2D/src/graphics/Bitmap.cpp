@@ -1,4 +1,9 @@
 #include "graphics/Bitmap.h"
+#include "graphics/PixelPool.h"
+#include "graphics/PixelKernels.h"
+#include "graphics/PixelConvert.h"
+#include <vector>
+#include <cstring>
 #include "system/ImageIO.h"
 #include "system/Debug.h"
 
@@ -6,16 +11,23 @@ namespace pxl { namespace graphics {
 
     Bitmap::Bitmap() {
 	    buffer_loaded = false;
+	    pixels = NULL;
+	    pooled_pixels = false;
     }
 
     bool Bitmap::create_bitmap(std::string path) {
 	    free();
 
-	    buffer_loaded = sys::load_png(path, this);
+	    //load_png works out the transparency as it decodes
+	    buffer_loaded = sys::load_png(path, this) != NULL;
 
-	    check_has_transparency();
+	    return buffer_loaded;
+    }
 
-	    //fill(COLOUR_BLACK);
+    bool Bitmap::create_bitmap(std::string path, Channel pixel_channel) {
+	    free();
+
+	    buffer_loaded = sys::load_png(path, this, &pixel_channel) != NULL;
 
 	    return buffer_loaded;
     }
@@ -23,25 +35,34 @@ namespace pxl { namespace graphics {
     void Bitmap::create_bitmap(int bitmap_width, int bitmap_height, Colour fill_colour, Channel pixel_channel) {
 	    free();
 	    set_attribs(bitmap_width, bitmap_height, pixel_channel);
-	    pixels = new uint8[buffer_size];
+	    pixels = alloc_pixels(buffer_size);
+	    pooled_pixels = true;
 
 	    fill(fill_colour);
-	    check_has_transparency();
     }
 
     void Bitmap::create_bitmap(int bitmap_width, int bitmap_height, Gradient gradient_fill, Channel pixel_channel) {
 	    free();
 	    set_attribs(bitmap_width, bitmap_height, pixel_channel);
-	    pixels = new uint8[buffer_size];
+	    pixels = alloc_pixels(buffer_size);
+	    pooled_pixels = true;
 
 	    fill(gradient_fill);
-	    check_has_transparency();
+    }
+
+    void Bitmap::create_bitmap(int bitmap_width, int bitmap_height, Channel pixel_channel) {
+	    free();
+	    set_attribs(bitmap_width, bitmap_height, pixel_channel);
+	    pixels = alloc_pixels(buffer_size);
+	    pooled_pixels = true;
+	    has_transparency = false;
     }
 
     void Bitmap::create_bitmap(int bitmap_width, int bitmap_height, uint8* pixel_buffer, Channel pixel_channel) {
 	    free();
 	    set_attribs(bitmap_width, bitmap_height, pixel_channel);
 	    pixels = pixel_buffer;
+	    pooled_pixels = false;
 
 	    check_has_transparency();
     }
@@ -52,26 +73,32 @@ namespace pxl { namespace graphics {
 	    height = bitmap_height;
 
 	    channel = pixel_channel;
-	    row_size = width * channel.num_channels;
+	    row_size = width * channel.bytes_per_pixel;
 	    buffer_size = row_size * height;
     }
 
+    /** Returns whether an 8 bit alpha is below the most opaque value the channel can store
+    **/
+    static inline bool is_transparent(uint8 alpha, const Channel& channel) {
+	    if (channel.channel_index.a == -1) return false;
+	    if (channel.gl_pixel_type == GL_UNSIGNED_SHORT_4_4_4_4) return (alpha >> 4) != 15;
+	    return alpha != 255;
+    }
+
     void Bitmap::fill(Colour colour) {
 	    if (pixels == NULL) return;
 
 	    //multiplies the input colour by 255 (as it's a 0-1 range float)
-	    Colour rgba = colour * 255;
-
-	    for (size_t y = 0; y < height; ++y) {
-		    int row_y = y * row_size;
-		    for (size_t x = 0; x < row_size; x += channel.num_channels) {
-			    if (channel.channel_index.r != -1) pixels[x + row_y + channel.channel_index.r] = rgba.r;
-			    if (channel.channel_index.g != -1) pixels[x + row_y + channel.channel_index.g] = rgba.g;
-			    if (channel.channel_index.b != -1) pixels[x + row_y + channel.channel_index.b] = rgba.b;
-			    if (channel.channel_index.a != -1) pixels[x + row_y + channel.channel_index.a] = rgba.a;
-			    //todo: check for pixel transparency here to remove the need for 2 pixel loops
-		    }
-	    }
+	    Colour c = colour * 255;
+	    uint8 rgba[4] = { (uint8)c.r, (uint8)c.g, (uint8)c.b, (uint8)c.a };
+
+	    //build one pixel in the bitmap's layout, then let the fill kernel repeat it
+	    uint8 pixel[4];
+	    convert_pixels(rgba, CHANNEL_RGBA, pixel, channel, 1);
+	    fill_pixels(pixels, width * height, pixel, channel.bytes_per_pixel);
+
+	    //every pixel is the same, so the transparency is known without scanning
+	    has_transparency = is_transparent(rgba[3], channel);
     }
 
     void Bitmap::fill(Gradient gradient) {
@@ -84,53 +111,80 @@ namespace pxl { namespace graphics {
 	    Colour c2 = gradient.g2 * 255;
 
 	    //calculate the rate it takes to interpolate between c1 and c2 for r, g, b a
-	    uint32 row_width = row_size / channel.num_channels;
-	    float r_rate = (c1.r - c2.r) / row_width;
-	    float g_rate = (c1.g - c2.g) / row_width;
-	    float b_rate = (c1.b - c2.b) / row_width;
-	    float a_rate = (c1.a - c2.a) / row_width;
-
-	    for (size_t y = 0; y < height; ++y) {
-		    int row_y = y * row_size;
-		    for (size_t x = 0; x < row_size; x += channel.num_channels) {
-			    //decrease/increase r, g, b, a depending on the difference between c1 and c2
-			    c1.r -= r_rate;
-			    c1.g -= g_rate;
-			    c1.b -= b_rate;
-			    c1.a -= a_rate;
-			    if (channel.channel_index.r != -1) pixels[x + row_y + channel.channel_index.r] = c1.r;
-			    if (channel.channel_index.g != -1) pixels[x + row_y + channel.channel_index.g] = c1.g;
-			    if (channel.channel_index.b != -1) pixels[x + row_y + channel.channel_index.b] = c1.b;
-			    if (channel.channel_index.a != -1) pixels[x + row_y + channel.channel_index.a] = c1.a;
-			    //todo: check for pixel transparency here to remove the need for 2 pixel loops
-		    }
-		    //calculate back to the original c1 values
-		    c1.r += r_rate * row_width;
-		    c1.g += g_rate * row_width;
-		    c1.b += b_rate * row_width;
-		    c1.a += a_rate * row_width;
+	    float r_rate = (c1.r - c2.r) / width;
+	    float g_rate = (c1.g - c2.g) / width;
+	    float b_rate = (c1.b - c2.b) / width;
+	    float a_rate = (c1.a - c2.a) / width;
+
+	    //the gradient is horizontal, so only the first row is worked out, in rgba and then converted to the bitmap's layout
+	    std::vector<uint8> row(width * 4);
+	    bool transparent = false;
+	    for (size_t x = 0; x < width; ++x) {
+		    //decrease/increase r, g, b, a depending on the difference between c1 and c2
+		    c1.r -= r_rate;
+		    c1.g -= g_rate;
+		    c1.b -= b_rate;
+		    c1.a -= a_rate;
+		    row[(x * 4)] = c1.r;
+		    row[(x * 4) + 1] = c1.g;
+		    row[(x * 4) + 2] = c1.b;
+		    row[(x * 4) + 3] = c1.a;
+		    transparent = transparent || is_transparent(row[(x * 4) + 3], channel);
 	    }
+	    if (width != 0) convert_pixels(&row[0], CHANNEL_RGBA, pixels, channel, width);
+
+	    //every other row is a copy of the first
+	    for (size_t y = 1; y < height; ++y) memcpy(pixels + (y * row_size), pixels, row_size);
+
+	    has_transparency = transparent && height != 0;
+    }
+
+    bool Bitmap::convert(Channel new_channel) {
+	    if (pixels == NULL) return false;
+	    if (new_channel == channel) return true;
+
+	    const uint32 num_pixels = width * height;
+	    const Channel old_channel = channel;
+	    if (new_channel.bytes_per_pixel <= channel.bytes_per_pixel) {
+		    //the new layout fits in the old buffer, so convert in place
+		    convert_pixels(pixels, old_channel, pixels, new_channel, num_pixels);
+	    }else {
+		    uint8* new_pixels = alloc_pixels(num_pixels * new_channel.bytes_per_pixel);
+		    convert_pixels(pixels, old_channel, new_pixels, new_channel, num_pixels);
+		    if (pooled_pixels) free_pixels(pixels);
+		    else delete[] pixels;
+		    pixels = new_pixels;
+		    pooled_pixels = true;
+	    }
+	    set_attribs(width, height, new_channel);
+
+	    //dropping the alpha or packing it into 4 bits can change the transparency
+	    if (new_channel.channel_index.a == -1) has_transparency = false;
+	    else if (old_channel.channel_index.a == -1) has_transparency = false;
+	    else check_has_transparency();
+	    return true;
     }
 
     bool Bitmap::check_has_transparency() {
 	    //checks whether the specified pixels contain any transparency
 	    if (pixels == NULL || channel.channel_index.a == -1) {
-		    return false;
+		    has_transparency = false;
+	    }else if (channel.gl_pixel_type == GL_UNSIGNED_SHORT_4_4_4_4) {
+		    has_transparency = false;
+		    const uint16* packed = (const uint16*)pixels;
+		    for (size_t n = 0; n < width * height && !has_transparency; ++n) has_transparency = (packed[n] & 15) != 15;
 	    }else {
-		    for (size_t n = 0; n < buffer_size; n += channel.num_channels) {
-			    if (pixels[n + channel.channel_index.a] != 255) {
-				    has_transparency = true;
-				    return true;
-			    }
-		    }
+		    has_transparency = scan_transparency(pixels, width * height, channel.bytes_per_pixel, channel.channel_index.a);
 	    }
+	    return has_transparency;
     }
 
     void Bitmap::free() {
 	    if (buffer_loaded) {
 		    buffer_loaded = false;
 		    if (pixels != NULL) {
-			    delete[] pixels;
+			    if (pooled_pixels) free_pixels(pixels);
+			    else delete[] pixels;
 			    pixels = NULL;
 		    }
 	    }
@@ -0,0 +1,113 @@
+#include "graphics/DistanceField.h"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include "system/ThreadPool.h"
+
+namespace pxl { namespace graphics {
+
+    //cpp constants (hidden from public)
+    #define FAR_DISTANCE 1e20f                                              //squared distance of pixels with nothing to measure to yet
+
+    /** One dimensional squared distance transform (Felzenszwalb and Huttenlocher), finding for each q the smallest
+    (q - p)^2 + f[p] over every p by walking the lower envelope of the parabolas rooted at each p
+    **/
+    static void transform_line(const float* f, int32 n, float* d, int32* v, float* z) {
+        int32 k = 0;
+        v[0] = 0;
+        z[0] = -FAR_DISTANCE;
+        z[1] = FAR_DISTANCE;
+        for (int32 q = 1; q < n; ++q) {
+            float s = ((f[q] + float(q) * q) - (f[v[k]] + float(v[k]) * v[k])) / float(2 * q - 2 * v[k]);
+            while (s <= z[k]) {
+                --k;
+                s = ((f[q] + float(q) * q) - (f[v[k]] + float(v[k]) * v[k])) / float(2 * q - 2 * v[k]);
+            }
+            ++k;
+            v[k] = q;
+            z[k] = s;
+            z[k + 1] = FAR_DISTANCE;
+        }
+
+        k = 0;
+        for (int32 q = 0; q < n; ++q) {
+            while (z[k + 1] < q) ++k;
+            d[q] = float(q - v[k]) * (q - v[k]) + f[v[k]];
+        }
+    }
+
+    /** Turns a grid of 0 (a pixel to measure to) and FAR_DISTANCE into the squared distance to the nearest 0, with a
+    pass down every column and then along every row
+    **/
+    static void transform_grid(std::vector<float>& grid, int32 width, int32 height) {
+        int32 n = std::max(width, height);
+        std::vector<float> f(n), d(n), z(n + 1);
+        std::vector<int32> v(n);
+
+        for (int32 x = 0; x < width; ++x) {
+            for (int32 y = 0; y < height; ++y) f[y] = grid[y * width + x];
+            transform_line(&f[0], height, &d[0], &v[0], &z[0]);
+            for (int32 y = 0; y < height; ++y) grid[y * width + x] = d[y];
+        }
+        for (int32 y = 0; y < height; ++y) {
+            float* row = &grid[y * width];
+            std::copy(row, row + width, f.begin());
+            transform_line(&f[0], width, row, &v[0], &z[0]);
+        }
+    }
+
+    void generate_distance_field(const uint8* coverage, uint32 width, uint32 height, uint32 spread, uint8* dest) {
+        int32 field_width = width + spread * 2, field_height = height + spread * 2;
+        int32 num_pixels = field_width * field_height;
+        if (num_pixels == 0) return;
+
+        //to_inside measures outside pixels to the nearest inside pixel, to_outside the other way around
+        std::vector<uint8> inside(num_pixels, 0);
+        for (uint32 y = 0; y < height; ++y) {
+            for (uint32 x = 0; x < width; ++x) {
+                inside[(y + spread) * field_width + (x + spread)] = coverage[y * width + x] >= 128;
+            }
+        }
+        std::vector<float> to_inside(num_pixels), to_outside(num_pixels);
+        for (int32 n = 0; n < num_pixels; ++n) {
+            to_inside[n] = inside[n] ? 0 : FAR_DISTANCE;
+            to_outside[n] = inside[n] ? FAR_DISTANCE : 0;
+        }
+        transform_grid(to_inside, field_width, field_height);
+        transform_grid(to_outside, field_width, field_height);
+
+        //the edge lies half way between an inside pixel and its outside neighbour
+        float scale = .5f / float(std::max(spread, uint32(1)));
+        for (int32 n = 0; n < num_pixels; ++n) {
+            float distance = inside[n] ? -(std::sqrt(to_outside[n]) - .5f) : std::sqrt(to_inside[n]) - .5f;
+            float value = std::min(std::max(.5f - (distance * scale), 0.0f), 1.0f);
+            dest[n] = uint8((value * 255.0f) + .5f);
+        }
+    }
+
+    void generate_distance_fields(const std::vector<DistanceFieldJob>& jobs, uint32 spread) {
+        sys::ThreadPool* pool = sys::get_thread_pool();
+        uint32 num_workers = std::min(uint32(jobs.size()), pool->get_num_threads());
+        //waiting on jobs queued behind the one we're running in would deadlock once every worker does the same, so
+        //the fields are generated inline when called from a worker
+        if (num_workers <= 1 || pool->is_worker_thread()) {
+            for (size_t n = 0; n < jobs.size(); ++n) {
+                generate_distance_field(jobs[n].coverage, jobs[n].width, jobs[n].height, spread, jobs[n].dest);
+            }
+            return;
+        }
+
+        //each worker takes every num_workers'th job, so big and small glyphs are spread evenly
+        std::vector<std::future<void>> workers;
+        workers.reserve(num_workers);
+        for (uint32 w = 0; w < num_workers; ++w) {
+            workers.push_back(pool->submit([&jobs, spread, w, num_workers]() {
+                for (size_t n = w; n < jobs.size(); n += num_workers) {
+                    generate_distance_field(jobs[n].coverage, jobs[n].width, jobs[n].height, spread, jobs[n].dest);
+                }
+            }));
+        }
+        for (size_t n = 0; n < workers.size(); ++n) workers[n].get();
+    }
+}};
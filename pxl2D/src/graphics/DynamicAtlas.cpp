@@ -0,0 +1,241 @@
+#include "graphics/DynamicAtlas.h"
+
+#include <algorithm>
+#include "graphics/PixelConvert.h"
+#include "graphics/PixelKernels.h"
+
+namespace pxl { namespace graphics {
+
+    DynamicAtlas::DynamicAtlas(uint32 width, uint32 height, Channel page_channel, uint32 padding, uint32 page_limit) {
+        page_width = width;
+        page_height = height;
+        channel = page_channel;
+        settings.padding = padding;
+        max_pages = page_limit;
+    }
+
+    DynamicAtlas::Page* DynamicAtlas::create_page() {
+        //only the cpu side is created here, the texture is created by whoever needs it uploaded
+        Page* page = new Page();
+        page->texture = NULL;
+        page->pixels.create_bitmap(page_width, page_height, COLOUR_TRANSPARENT_BLACK, channel);
+        page->packer.init(page_width, page_height, settings);
+        page->num_entries = 0;
+        return page;
+    }
+
+    void DynamicAtlas::free_page(Page* page) {
+        if (page->texture != NULL) {
+            page->texture->free();
+            delete page->texture;
+        }
+        delete page;
+    }
+
+    void DynamicAtlas::write_pixels(Page* page, const PackedRect& rect, const uint8* src, uint32 src_row_size) {
+        const uint32 bpp = channel.bytes_per_pixel;
+        for (uint32 y = 0; y < rect.h; ++y) {
+            copy_pixels(page->pixels.get_pixels() + (((rect.y + y) * page_width + rect.x) * bpp), src + (y * src_row_size), rect.w * bpp);
+        }
+    }
+
+    AtlasHandle DynamicAtlas::add(const Bitmap* bitmap) {
+        if (bitmap == NULL || bitmap->get_pixels() == NULL) {
+            sys::show_exception("Could not add to atlas, the bitmap has no pixels", ERROR_ATLAS_ADD_FAILED);
+            return ATLAS_INVALID_HANDLE;
+        }
+        return add(bitmap->get_width(), bitmap->get_height(), bitmap->get_pixels(), bitmap->get_channel());
+    }
+
+    AtlasHandle DynamicAtlas::add(uint32 w, uint32 h, const uint8* pixels, Channel pixel_channel) {
+        if (w == 0 || h == 0 || w > page_width || h > page_height) {
+            sys::show_exception("Could not add to atlas, the image is empty or bigger than a page", ERROR_ATLAS_ADD_FAILED);
+            return ATLAS_INVALID_HANDLE;
+        }
+
+        //the first page with room wins, so older pages fill up before newer ones are touched
+        PackedRect rect;
+        uint32 page_index = 0;
+        while (page_index < pages.size() && !pages[page_index]->packer.insert(w, h, rect)) ++page_index;
+        if (page_index == pages.size()) {
+            if (pages.size() >= max_pages) {
+                sys::show_exception("Could not add to atlas, every page is full", ERROR_ATLAS_ADD_FAILED);
+                return ATLAS_INVALID_HANDLE;
+            }
+            Page* page = create_page();
+            page->texture = new Texture();
+            page->texture->create_texture(&page->pixels);
+            pages.push_back(page);
+            page->packer.insert(w, h, rect);
+        }
+        Page* page = pages[page_index];
+
+        std::vector<uint8> converted;
+        if (pixel_channel != channel) {
+            converted.resize(w * h * channel.bytes_per_pixel);
+            convert_pixels(pixels, pixel_channel, &converted[0], channel, w * h);
+            pixels = &converted[0];
+        }
+        write_pixels(page, rect, pixels, w * channel.bytes_per_pixel);
+        page->texture->update_sub_data(rect.x, rect.y, w, h, pixels);
+        ++page->num_entries;
+
+        Entry entry;
+        entry.live = true;
+        entry.page = page_index;
+        entry.rect = rect;
+        if (!free_handles.empty()) {
+            AtlasHandle handle = free_handles.back();
+            free_handles.pop_back();
+            entries[handle - 1] = entry;
+            return handle;
+        }
+        entries.push_back(entry);
+        return entries.size();
+    }
+
+    void DynamicAtlas::remove(AtlasHandle handle) {
+        if (!is_valid(handle)) return;
+
+        Entry& entry = entries[handle - 1];
+        Page* page = pages[entry.page];
+        page->packer.remove(entry.rect);
+        --page->num_entries;
+        entry.live = false;
+        free_handles.push_back(handle);
+    }
+
+    void DynamicAtlas::remove(const std::vector<AtlasHandle>& handles) {
+        //rects are gathered per page so each packer only rebuilds its free areas once
+        std::vector<std::vector<PackedRect>> page_rects(pages.size());
+        for (size_t n = 0; n < handles.size(); ++n) {
+            if (!is_valid(handles[n])) continue;
+
+            Entry& entry = entries[handles[n] - 1];
+            page_rects[entry.page].push_back(entry.rect);
+            --pages[entry.page]->num_entries;
+            entry.live = false;
+            free_handles.push_back(handles[n]);
+        }
+        for (size_t n = 0; n < pages.size(); ++n) {
+            if (!page_rects[n].empty()) pages[n]->packer.remove(page_rects[n]);
+        }
+    }
+
+    bool DynamicAtlas::has_room(uint32 w, uint32 h) const {
+        if (w == 0 || h == 0 || w > page_width || h > page_height) return false;
+        if (pages.size() < max_pages) return true;
+        for (size_t n = 0; n < pages.size(); ++n) {
+            if (pages[n]->packer.can_insert(w, h)) return true;
+        }
+        return false;
+    }
+
+    Texture* DynamicAtlas::get_texture(AtlasHandle handle) const {
+        return is_valid(handle) ? pages[entries[handle - 1].page]->texture : NULL;
+    }
+
+    Rect DynamicAtlas::get_rect(AtlasHandle handle) const {
+        return is_valid(handle) ? entries[handle - 1].rect.to_rect() : Rect();
+    }
+
+    /** Orders entries by their longest side then their shortest, biggest first
+    **/
+    struct AtlasOrder {
+
+        const std::vector<PackedRect>* rects;
+
+        bool operator()(uint32 a, uint32 b) const {
+            const PackedRect& ra = (*rects)[a];
+            const PackedRect& rb = (*rects)[b];
+            uint32 long_a = std::max(ra.w, ra.h), long_b = std::max(rb.w, rb.h);
+            if (long_a != long_b) return long_a > long_b;
+            return std::min(ra.w, ra.h) > std::min(rb.w, rb.h);
+        }
+    };
+
+    uint32 DynamicAtlas::compact() {
+        std::vector<uint32> order;
+        std::vector<PackedRect> rects(entries.size());
+        for (size_t n = 0; n < entries.size(); ++n) {
+            rects[n] = entries[n].rect;
+            if (entries[n].live) order.push_back(n);
+        }
+        AtlasOrder atlas_order = { &rects };
+        std::stable_sort(order.begin(), order.end(), atlas_order);
+
+        //entries are repacked into fresh pages on the cpu, then the pages are uploaded into the textures already made.
+        //where each entry goes is kept to the side until the repack is known to be worth keeping
+        const uint32 bpp = channel.bytes_per_pixel;
+        std::vector<Page*> packed_pages;
+        std::vector<Entry> packed_entries(entries);
+        for (size_t n = 0; n < order.size(); ++n) {
+            const Entry& entry = entries[order[n]];
+            PackedRect rect;
+            size_t page_index = 0;
+            while (page_index < packed_pages.size() && !packed_pages[page_index]->packer.insert(entry.rect.w, entry.rect.h, rect)) ++page_index;
+            if (page_index == packed_pages.size()) {
+                //biggest first can still come out worse than the order entries were added in, which isn't a compaction
+                if (packed_pages.size() == pages.size()) {
+                    for (size_t p = 0; p < packed_pages.size(); ++p) free_page(packed_pages[p]);
+                    return 0;
+                }
+                packed_pages.push_back(create_page());
+                packed_pages.back()->packer.insert(entry.rect.w, entry.rect.h, rect);
+            }
+
+            const Page* old_page = pages[entry.page];
+            const uint8* src = old_page->pixels.get_pixels() + ((entry.rect.y * page_width + entry.rect.x) * bpp);
+            write_pixels(packed_pages[page_index], rect, src, page_width * bpp);
+            ++packed_pages[page_index]->num_entries;
+            packed_entries[order[n]].page = page_index;
+            packed_entries[order[n]].rect = rect;
+        }
+        entries.swap(packed_entries);
+
+        //textures move to the new pages in order, any left over belonged to pages that are no longer needed
+        for (size_t n = 0; n < pages.size(); ++n) {
+            if (n < packed_pages.size()) {
+                packed_pages[n]->texture = pages[n]->texture;
+                pages[n]->texture = NULL;
+                packed_pages[n]->texture->update_data(packed_pages[n]->pixels.get_pixels());
+            }
+            free_page(pages[n]);
+        }
+        uint32 num_freed = pages.size() - packed_pages.size();
+        pages.swap(packed_pages);
+        return num_freed;
+    }
+
+    void DynamicAtlas::clear() {
+        for (size_t n = 0; n < pages.size(); ++n) free_page(pages[n]);
+        pages.clear();
+        entries.clear();
+        free_handles.clear();
+    }
+
+    DynamicAtlasStats DynamicAtlas::get_stats() const {
+        DynamicAtlasStats stats;
+        stats.num_entries = entries.size() - free_handles.size();
+        stats.pages_allocated = pages.size();
+
+        uint64 free_area = 0, largest_free_area = 0;
+        for (size_t n = 0; n < pages.size(); ++n) {
+            const Page* page = pages[n];
+            if (page->num_entries != 0) ++stats.pages_in_use;
+
+            uint64 page_area = uint64(page_width) * page_height;
+            stats.used_area += page->packer.get_used_area();
+            stats.total_area += page_area;
+            free_area += page_area - page->packer.get_used_area();
+            largest_free_area += std::min(page->packer.get_largest_free_area(), page_area - page->packer.get_used_area());
+        }
+        if (stats.total_area != 0) stats.occupancy = float(stats.used_area) / float(stats.total_area);
+        if (free_area != 0) stats.fragmentation = 1.0f - (float(largest_free_area) / float(free_area));
+        return stats;
+    }
+
+    DynamicAtlas::~DynamicAtlas() {
+        clear();
+    }
+}};
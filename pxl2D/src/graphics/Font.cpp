@@ -1,76 +1,199 @@
 #include "graphics/Font.h"
 
+#include <algorithm>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
+#include "graphics/DistanceField.h"
 #include "system/Debug.h"
+#include "system/Exception.h"
 
 namespace pxl { namespace graphics {
 
-    Font::Font(std::string path, int c_max_font_size) {
-        FT_Face a;
+    Font::Font(std::string path, int c_max_font_size, FontRenderMode c_render_mode) {
 	    max_font_size = c_max_font_size;
+	    render_mode = c_render_mode;
         sys::print << "attempting to load font...\n";
-	    if (!FT_New_Face(FT_lib, path.c_str(), 0, &a)) {
+	    if (!FT_New_Face(FT_lib, path.c_str(), 0, &f)) {
 		    FT_Set_Pixel_Sizes(f, max_font_size, 0);
 
 		    name = f->family_name;
 		    num_glyphs = f->num_glyphs;
 		    width = f->max_advance_width;
 		    height = f->max_advance_height;
-
-		    glyph_sheet = new TextureSheet();
-		    Rect rect;
-		    glyph_rects = new Rect[f->num_glyphs];
 		    f->style_flags = FT_STYLE_FLAG_BOLD;
-		    int glyphs_loaded = 0;
-		    for (int n = 0; n < f->num_glyphs; ++n) {
-			    FT_Load_Glyph(f, n, FT_LOAD_RENDER);
-			    if (f->glyph->bitmap.width == 0 || f->glyph->bitmap.rows == 0) { continue; }
-
-			    int size = f->glyph->bitmap.width * f->glyph->bitmap.rows;
-			    uint8* pixels = new uint8[size];
-			    memcpy(pixels, f->glyph->bitmap.buffer, size);
-			    Bitmap bitmap;
-			    bitmap.create_bitmap(f->glyph->bitmap.width, f->glyph->bitmap.rows, pixels, CHANNEL_ALPHA);
-
-			    max_char_width = math::max(max_char_width, bitmap.get_width());
-			    max_char_height = math::max(max_char_height, bitmap.get_height());
-
-			    rect.w = bitmap.get_width();
-			    rect.h = bitmap.get_height();
-			    Texture* t = new Texture();
-			    t->create_texture(&bitmap);
-			    glyph_sheet->add(t, &rect);
-			    glyph_rects[n] = rect;
-
-			    rect.x += bitmap.get_width();
-			    if (rect.x >= 1024) {
-				    rect.x = 0;
-				    rect.y = glyph_sheet->get_height();
+
+		    //glyphs are rasterised when they're first drawn, so the biggest glyph is taken from the face's metrics
+		    max_char_width = f->size->metrics.max_advance >> 6;
+		    max_char_height = (f->size->metrics.ascender - f->size->metrics.descender) >> 6;
+
+		    glyph_atlas = new DynamicAtlas(CONFIG_FONT_GLYPH_PAGE_SIZE, CONFIG_FONT_GLYPH_PAGE_SIZE, CHANNEL_ALPHA, 1, CONFIG_FONT_GLYPH_MAX_PAGES);
+		    font_loaded = true;
+
+		    sys::print << "loaded font (" << path << ") with " << num_glyphs << " glyphs\n";
+	    }
+    }
+
+    int Font::get_glyph_index(int char_code) {
+	    return font_loaded ? FT_Get_Char_Index(f, char_code) : 0;
+    }
+
+    const Glyph& Font::get_glyph(int glyph_index) {
+	    static const Glyph empty_glyph;
+	    auto it = glyphs.find(glyph_index);
+	    if (it == glyphs.end()) {
+		    CachedGlyph& cached = glyphs[glyph_index];
+		    if (!load_glyph(glyph_index, cached)) {
+			    //left uncached so it's loaded again once the glyphs of this frame can be evicted
+			    glyphs.erase(glyph_index);
+			    return empty_glyph;
+		    }
+		    cached.last_used_frame = int64(get_frame_index());
+		    return cached.glyph;
+	    }
+
+	    //move to the back of the lru list, glyphs with nothing to draw aren't in it as they never need evicting
+	    CachedGlyph& cached = it->second;
+	    if (cached.handle != ATLAS_INVALID_HANDLE) lru_list.splice(lru_list.end(), lru_list, cached.lru_pos);
+	    cached.last_used_frame = int64(get_frame_index());
+	    return cached.glyph;
+    }
+
+    bool Font::load_glyph(int glyph_index, CachedGlyph& cached) {
+	    cached.handle = ATLAS_INVALID_HANDLE;
+	    uint32 w, h;
+	    std::vector<uint8> pixels;
+	    if (!rasterise_glyph(glyph_index, w, h, pixels)) return true;
+
+	    if (render_mode == FONT_RENDER_SDF) {
+		    const uint32 spread = CONFIG_FONT_SDF_SPREAD;
+		    std::vector<uint8> field((w + spread * 2) * (h + spread * 2));
+		    generate_distance_field(&pixels[0], w, h, spread, &field[0]);
+		    return cache_glyph(glyph_index, cached, w + spread * 2, h + spread * 2, &field[0], spread);
+	    }
+	    return cache_glyph(glyph_index, cached, w, h, &pixels[0], 0);
+    }
+
+    void Font::preload(const std::string& chars) {
+	    if (!font_loaded) return;
+
+	    //rasterising stays on this thread as a face can't be used from more than one thread at a time
+	    std::vector<int> indices;
+	    std::vector<uint32> widths, heights;
+	    std::vector<std::vector<uint8>> coverage;
+	    for (size_t n = 0; n < chars.length(); ++n) {
+		    int glyph_index = get_glyph_index((uint8)chars[n]);
+		    if (glyphs.find(glyph_index) != glyphs.end() || std::find(indices.begin(), indices.end(), glyph_index) != indices.end()) continue;
+
+		    uint32 w = 0, h = 0;
+		    std::vector<uint8> pixels;
+		    if (!rasterise_glyph(glyph_index, w, h, pixels)) {
+			    //cached with nothing to draw, so it isn't rasterised again
+			    glyphs[glyph_index].handle = ATLAS_INVALID_HANDLE;
+			    continue;
+		    }
+		    indices.push_back(glyph_index);
+		    widths.push_back(w);
+		    heights.push_back(h);
+		    coverage.push_back(std::move(pixels));
+	    }
+
+	    if (render_mode == FONT_RENDER_SDF) {
+		    const uint32 spread = CONFIG_FONT_SDF_SPREAD;
+		    std::vector<std::vector<uint8>> fields(indices.size());
+		    std::vector<DistanceFieldJob> jobs(indices.size());
+		    for (size_t n = 0; n < indices.size(); ++n) {
+			    fields[n].resize((widths[n] + spread * 2) * (heights[n] + spread * 2));
+			    jobs[n].coverage = &coverage[n][0];
+			    jobs[n].width = widths[n];
+			    jobs[n].height = heights[n];
+			    jobs[n].dest = &fields[n][0];
+		    }
+		    generate_distance_fields(jobs, spread);
+		    for (size_t n = 0; n < indices.size(); ++n) {
+			    if (!cache_glyph(indices[n], glyphs[indices[n]], widths[n] + spread * 2, heights[n] + spread * 2, &fields[n][0], spread)) {
+				    glyphs.erase(indices[n]);
 			    }
-			    ++glyphs_loaded;
 		    }
-		    //create sheet from all textures added and then clear and dispose the textures
-            glyph_sheet->create_sheet(CHANNEL_ALPHA, true, true, true);
+	    }else {
+		    for (size_t n = 0; n < indices.size(); ++n) {
+			    if (!cache_glyph(indices[n], glyphs[indices[n]], widths[n], heights[n], &coverage[n][0], 0)) glyphs.erase(indices[n]);
+		    }
+	    }
+    }
+
+    bool Font::rasterise_glyph(int glyph_index, uint32& w, uint32& h, std::vector<uint8>& pixels) {
+	    if (!font_loaded || FT_Load_Glyph(f, glyph_index, FT_LOAD_RENDER)) return false;
 
-		    sys::print << "loaded font (" << path << ") with " << glyphs_loaded << " glyphs loaded\n";
+	    const FT_Bitmap& bitmap = f->glyph->bitmap;
+	    w = bitmap.width;
+	    h = bitmap.rows;
+	    if (w == 0 || h == 0) return false;
+
+	    //rows can be padded past the width, they're copied tightly packed
+	    pixels.resize(w * h);
+	    for (uint32 y = 0; y < h; ++y) {
+		    const uint8* row = bitmap.pitch >= 0 ? bitmap.buffer + (y * bitmap.pitch) : bitmap.buffer + ((h - 1 - y) * -bitmap.pitch);
+		    memcpy(&pixels[y * w], row, w);
 	    }
+	    return true;
     }
 
-    int Font::get_glyph_index(int char_code) {
-	    return FT_Get_Char_Index(f, char_code);
+    bool Font::cache_glyph(int glyph_index, CachedGlyph& cached, uint32 w, uint32 h, const uint8* pixels, uint32 padding) {
+	    cached.handle = ATLAS_INVALID_HANDLE;
+	    if (w > glyph_atlas->get_page_width() || h > glyph_atlas->get_page_height()) {
+		    sys::show_exception("Glyph is bigger than a page of the glyph atlas", ERROR_ATLAS_ADD_FAILED);
+		    return true;
+	    }
+
+	    //the lru list is in order of use, so once the front glyph was used this frame every glyph after it was too
+	    const int64 frame = int64(get_frame_index());
+	    auto can_evict = [&]() { return !lru_list.empty() && glyphs.find(lru_list.front())->second.last_used_frame != frame; };
+
+	    //evict the least recently used glyphs in batches until there's room. Removing rebuilds a page's free space, so
+	    //each batch frees at least the glyph's area and twice as much as the last, keeping the rebuilds to a few
+	    uint64 batch_area = uint64(w) * h;
+	    std::vector<AtlasHandle> evicted_handles;
+	    while (!glyph_atlas->has_room(w, h) && can_evict()) {
+		    uint64 freed_area = 0;
+		    evicted_handles.clear();
+		    while (freed_area < batch_area && can_evict()) {
+			    auto evicted = glyphs.find(lru_list.front());
+			    Rect rect = glyph_atlas->get_rect(evicted->second.handle);
+			    freed_area += uint64(rect.w) * uint64(rect.h);
+			    evicted_handles.push_back(evicted->second.handle);
+			    glyphs.erase(evicted);
+			    lru_list.pop_front();
+		    }
+		    glyph_atlas->remove(evicted_handles);
+		    batch_area *= 2;
+	    }
+
+	    cached.handle = glyph_atlas->add(w, h, pixels, CHANNEL_ALPHA);
+	    if (cached.handle == ATLAS_INVALID_HANDLE) {
+		    sys::show_exception("Every page of the glyph atlas is full of glyphs used this frame. Call end_frame() once "
+		                        "every batch has rendered", ERROR_ATLAS_ADD_FAILED);
+		    return false;
+	    }
+	    cached.glyph.texture = glyph_atlas->get_texture(cached.handle);
+	    cached.glyph.rect = glyph_atlas->get_rect(cached.handle);
+	    cached.glyph.padding = padding;
+	    cached.lru_pos = lru_list.insert(lru_list.end(), glyph_index);
+	    return true;
     }
 
-    Font* create_font(std::string path, int c_max_font_size) {
-	    return new Font(path, c_max_font_size);
+    Font* create_font(std::string path, int c_max_font_size, FontRenderMode c_render_mode) {
+	    return new Font(path, c_max_font_size, c_render_mode);
     }
 
     void Font::free() {
 	    if (font_loaded) {
 		    font_loaded = false;
-		    delete[] glyph_rects;
-		    delete glyph_sheet;
+		    glyphs.clear();
+		    lru_list.clear();
+		    delete glyph_atlas;
+		    glyph_atlas = NULL;
+		    FT_Done_Face(f);
 	    }
     }
 
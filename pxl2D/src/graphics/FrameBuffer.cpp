@@ -1,4 +1,5 @@
 #include "graphics/FrameBuffer.h"
+#include "graphics/GLState.h"
 #include "system/Window.h"
 #include "system/Debug.h"
 
@@ -50,11 +51,11 @@ namespace pxl { namespace graphics {
 	    frame_buffer_created = true;
 
 	    //bind to default frame buffer
-	    glBindFramebuffer(GL_FRAMEBUFFER_WRITE, 0);
+	    bind_framebuffer(GL_FRAMEBUFFER_WRITE, 0);
     }
 
     void FrameBuffer::clear(float r, float g, float b, float a) {
-	    glBindFramebuffer(GL_FRAMEBUFFER_WRITE, id);
+	    bind(GL_FRAMEBUFFER_WRITE);
 	    glClearColor(r, g, b, a);
 	    glClear(GL_COLOR_BUFFER_BIT);
 	    //todo: error code 1282 occurs here
@@ -85,7 +86,7 @@ namespace pxl { namespace graphics {
 		    frame_src_rect = *src_rect;
 	    }
 
-	    glBindTexture(GL_TEXTURE_2D, dest_frame_buffer->get_texture_id());
+	    graphics::bind_texture(dest_frame_buffer->get_texture_id());
 	    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, dest_frame_buffer->get_pixels());
         sys::print << "pixels: " << dest_frame_buffer->get_pixels() << "\n";
 
@@ -107,7 +108,7 @@ namespace pxl { namespace graphics {
     }
 
     void FrameBuffer::bind(FrameBufferAction action) {
-	    glBindFramebuffer(action, id);
+	    bind_framebuffer(action, id);
     }
 
     void FrameBuffer::bind_texture() {
@@ -120,6 +121,7 @@ namespace pxl { namespace graphics {
 
     void FrameBuffer::free() {
 	    if (frame_buffer_created) {
+		    forget_framebuffer(id);
 		    glDeleteFramebuffers(1, &id);
 		    if (depth_id != -1) { glDeleteRenderbuffers(1, &depth_id); }
 		    delete texture;
@@ -0,0 +1,130 @@
+#include "graphics/GLState.h"
+#include "graphics/FrameBuffer.h"
+
+namespace pxl { namespace graphics {
+
+    //cpp constants (hidden from public)
+    #define STATE_UNKNOWN -1                                                //the cached value when the real GL state isn't known
+
+    struct GLStateCache {
+
+        int64 texture = STATE_UNKNOWN;
+        int64 program = STATE_UNKNOWN;
+        int64 read_framebuffer = STATE_UNKNOWN;
+        int64 draw_framebuffer = STATE_UNKNOWN;
+        int64 vertex_array = STATE_UNKNOWN;
+        int blend = STATE_UNKNOWN;
+        int64 blend_src = STATE_UNKNOWN;
+        int64 blend_dest = STATE_UNKNOWN;
+        int depth_test = STATE_UNKNOWN;
+        int64 depth_func = STATE_UNKNOWN;
+        int depth_mask = STATE_UNKNOWN;
+    };
+
+    static GLStateCache state;
+    static GLStateStats state_stats;
+
+    /** Updates a cached value and returns true if GL needs to be called
+    **/
+    template <typename T> static inline bool change_state(T& cached, T value) {
+        if (cached == value) {
+            ++state_stats.elided;
+            return false;
+        }
+        cached = value;
+        ++state_stats.issued;
+        return true;
+    }
+
+    void bind_texture(GLuint id) {
+        if (change_state(state.texture, int64(id))) glBindTexture(GL_TEXTURE_2D, id);
+    }
+
+    void use_program(GLuint id) {
+        if (change_state(state.program, int64(id))) glUseProgram(id);
+    }
+
+    void bind_framebuffer(GLenum target, GLuint id) {
+        //when read and write are the same target, gl only has one framebuffer binding
+        if (GL_FRAMEBUFFER_READ == GL_FRAMEBUFFER_WRITE || target == GL_FRAMEBUFFER) {
+            if (state.read_framebuffer == int64(id) && state.draw_framebuffer == int64(id)) {
+                ++state_stats.elided;
+                return;
+            }
+            state.read_framebuffer = id;
+            state.draw_framebuffer = id;
+            ++state_stats.issued;
+            glBindFramebuffer(target, id);
+        }else if (target == GL_FRAMEBUFFER_READ) {
+            if (change_state(state.read_framebuffer, int64(id))) glBindFramebuffer(target, id);
+        }else {
+            if (change_state(state.draw_framebuffer, int64(id))) glBindFramebuffer(target, id);
+        }
+    }
+
+    void bind_vertex_array(GLuint id) {
+        #if defined(GL_VERTEX_ARRAY_BINDING)
+            if (change_state(state.vertex_array, int64(id))) glBindVertexArray(id);
+        #endif
+    }
+
+    void set_blend_enabled(bool enabled) {
+        if (change_state(state.blend, int(enabled))) {
+            if (enabled) glEnable(GL_BLEND); else glDisable(GL_BLEND);
+        }
+    }
+
+    void set_blend_func(GLenum src_factor, GLenum dest_factor) {
+        if (state.blend_src == int64(src_factor) && state.blend_dest == int64(dest_factor)) {
+            ++state_stats.elided;
+            return;
+        }
+        state.blend_src = src_factor;
+        state.blend_dest = dest_factor;
+        ++state_stats.issued;
+        glBlendFunc(src_factor, dest_factor);
+    }
+
+    void set_depth_test_enabled(bool enabled) {
+        if (change_state(state.depth_test, int(enabled))) {
+            if (enabled) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
+        }
+    }
+
+    void set_depth_func(GLenum func) {
+        if (change_state(state.depth_func, int64(func))) glDepthFunc(func);
+    }
+
+    void set_depth_mask(bool enabled) {
+        if (change_state(state.depth_mask, int(enabled))) glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+    }
+
+    void forget_texture(GLuint id) {
+        if (state.texture == int64(id)) state.texture = 0;
+    }
+
+    void forget_program(GLuint id) {
+        if (state.program == int64(id)) state.program = 0;
+    }
+
+    void forget_framebuffer(GLuint id) {
+        if (state.read_framebuffer == int64(id)) state.read_framebuffer = 0;
+        if (state.draw_framebuffer == int64(id)) state.draw_framebuffer = 0;
+    }
+
+    void forget_vertex_array(GLuint id) {
+        if (state.vertex_array == int64(id)) state.vertex_array = 0;
+    }
+
+    void invalidate_gl_state() {
+        state = GLStateCache();
+    }
+
+    const GLStateStats& get_gl_state_stats() {
+        return state_stats;
+    }
+
+    void reset_gl_state_stats() {
+        state_stats = GLStateStats();
+    }
+}};
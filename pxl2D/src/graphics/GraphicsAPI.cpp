@@ -5,6 +5,8 @@
 
 namespace pxl { namespace graphics {
 
+    static uint64 frame_index = 0;
+
     extern void glew_init() {
 	    #if defined(PLATFORM_WIN32)
 		    glewExperimental = true;
@@ -35,4 +37,12 @@ namespace pxl { namespace graphics {
     extern void clear() {
 	    glClear(GL_COLOR_BUFFER_BIT);
     }
+
+    void end_frame() {
+        ++frame_index;
+    }
+
+    uint64 get_frame_index() {
+        return frame_index;
+    }
 }};
\ No newline at end of file
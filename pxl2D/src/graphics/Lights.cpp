@@ -2,6 +2,7 @@
 #include <fstream>
 #include <algorithm>
 #include "graphics/Batch.h"
+#include "graphics/GLState.h"
 #include "system/Exception.h"
 #include "system/Window.h"
 
@@ -14,7 +15,7 @@ namespace pxl { namespace graphics {
     const void lights_init() {
 	    screen_texture->create_texture(1024, 768, NULL, CHANNEL_RGBA);
 
-	    glUseProgram(point_light_shader->get_program_id());
+	    point_light_shader->bind();
 	    point_light_shader->add_uniform_location("points");
 	    point_light_shader->add_uniform_location("points_length");
 	    point_light_shader->add_uniform_location("max_alpha");
@@ -38,9 +39,9 @@ namespace pxl { namespace graphics {
 		    point_lights_arr.push_back(light->g);
 		    point_lights_arr.push_back(light->b);
 
-		    glUseProgram(point_light_shader->get_program_id());
+		    point_light_shader->bind();
 		    glUniform1i(point_light_shader->get_uniform_location(1), point_lights.size() * 7);
-		    glUseProgram(0);
+		    use_program(0);
 
             int a = math::wrap(40, 0, 10);
 		    int b = math::wrap(-20, 0, 100);
@@ -68,7 +69,7 @@ namespace pxl { namespace graphics {
 		    index += 7;
 	    }
 
-	    glUseProgram(point_light_shader->get_program_id());
+	    point_light_shader->bind();
 	    glUniform1fv(point_light_shader->get_uniform_location(0), point_lights.size() * 7, &point_lights_arr[0]);
 
 	    Rect rect;
@@ -82,17 +83,17 @@ namespace pxl { namespace graphics {
 	    //todo: vector erasing maybe not supported by android port
 	    //point_lights.erase(remove(point_lights.begin(), point_lights.end(), light), point_lights.end());
 
-	    glUseProgram(point_light_shader->get_program_id());
+	    point_light_shader->bind();
 	    glUniform1i(point_light_shader->get_uniform_location(1), point_lights.size() * 7);
-	    glUseProgram(0);
+	    use_program(0);
 
 	    if (delete_pointer) { delete light; }
     }
 
     const void set_point_light_config(float max_alpha) {
-	    glUseProgram(point_light_shader->get_program_id());
+	    point_light_shader->bind();
 	    glUniform1f(point_light_shader->get_uniform_location(2), max_alpha);
-	    glUseProgram(0);
+	    use_program(0);
     }
 
 }};
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "graphics/Matrix4.h"
+#include <cmath>
 #include <string>
 
 namespace pxl { namespace graphics {
@@ -193,7 +194,7 @@ namespace pxl { namespace graphics {
         update_transform_vectors();
     }
 
-    Matrix4& Matrix4::mul(const Matrix4& b) {
+    Matrix4 Matrix4::mul(const Matrix4& b) {
         Matrix4 n(*this);
 	    float sum = 0;
 	    for (int y = 0; y < 16; ++y) {
@@ -205,57 +206,57 @@ namespace pxl { namespace graphics {
 	    }
         n.update_transform_vectors();
 
-        return Matrix4(n);
+        return n;
     }
 
-    Matrix4& Matrix4::mul(float b) {
+    Matrix4 Matrix4::mul(float b) {
         Matrix4 n(*this);
         for (int y = 0; y < 16; ++y) {
             n.mat[y] *= b;
         }
         n.update_transform_vectors();
 
-        return Matrix4(n);
+        return n;
     }
 
-    Matrix4& Matrix4::add(const Matrix4& b) {
+    Matrix4 Matrix4::add(const Matrix4& b) {
         Matrix4 n(*this);
         for (int y = 0; y < 16; ++y) {
             n.mat[y] += b.mat[y];
         }
         n.update_transform_vectors();
 
-        return Matrix4(n);
+        return n;
     }
 
-    Matrix4& Matrix4::add(float b) {
+    Matrix4 Matrix4::add(float b) {
         Matrix4 n(*this);
         for (int y = 0; y < 16; ++y) {
             n.mat[y] += b;
         }
         n.update_transform_vectors();
 
-        return Matrix4(n);
+        return n;
     }
 
-    Matrix4& Matrix4::sub(const Matrix4& b) {
+    Matrix4 Matrix4::sub(const Matrix4& b) {
         Matrix4 n(*this);
         for (int y = 0; y < 16; ++y) {
             n.mat[y] -= b.mat[y];
         }
         n.update_transform_vectors();
 
-        return Matrix4(n);
+        return n;
     }
 
-    Matrix4& Matrix4::sub(float b) {
+    Matrix4 Matrix4::sub(float b) {
         Matrix4 n(*this);
         for (int y = 0; y < 16; ++y) {
             n.mat[y] -= b;
         }
         n.update_transform_vectors();
 
-        return Matrix4(n);
+        return n;
     }
 
     void Matrix4::update_transform_vectors() {
@@ -268,8 +269,10 @@ namespace pxl { namespace graphics {
         return Matrix4(*this);
     }
 
-    Matrix4& Matrix4::operator=(Matrix4& b) {
-        set_raw_matrix(b.get_raw_matrix());
+    Matrix4& Matrix4::operator=(const Matrix4& b) {
+        for (int n = 0; n < 16; ++n) {
+            mat[n] = b.mat[n];
+        }
         update_transform_vectors();
         return *this;
     }
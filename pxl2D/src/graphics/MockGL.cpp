@@ -0,0 +1,368 @@
+#include "PXLAPI.h"
+
+#if defined(PXL_MOCK_GL)
+
+#include <map>
+#include <cstring>
+
+namespace pxl { namespace graphics {
+
+    //cpp constants (hidden from public)
+    #define MOCK_FIRST_ID 1                                                 //ids handed out start here as 0 means no object in gl
+
+    struct MockGLState {
+
+        std::vector<MockGLCommand> log;
+        MockGLStats stats;
+        bool logging = true;
+
+        GLuint next_id = MOCK_FIRST_ID;
+        GLuint array_buffer = 0;
+        GLuint element_buffer = 0;
+        std::map<GLuint, std::vector<uint8>> buffers;
+        GLuint texture = 0;
+        GLint unpack_alignment = 4;
+        std::map<GLuint, MockGLTexture> textures;
+    };
+
+    static MockGLState mock_state;
+
+    namespace mock {
+
+        MockGLCaps caps;
+    };
+
+    const std::vector<MockGLCommand>& get_mock_gl_log() {
+        return mock_state.log;
+    }
+
+    const MockGLStats& get_mock_gl_stats() {
+        return mock_state.stats;
+    }
+
+    void reset_mock_gl() {
+        mock_state.log.clear();
+        mock_state.stats = MockGLStats();
+    }
+
+    void set_mock_gl_logging(bool enabled) {
+        mock_state.logging = enabled;
+    }
+
+    void set_mock_gl_caps(const MockGLCaps& caps) {
+        mock::caps = caps;
+    }
+
+    const std::vector<uint8>* get_mock_gl_buffer(GLuint id) {
+        std::map<GLuint, std::vector<uint8>>::iterator it = mock_state.buffers.find(id);
+        return it == mock_state.buffers.end() ? NULL : &it->second;
+    }
+
+    const MockGLTexture* get_mock_gl_texture(GLuint id) {
+        std::map<GLuint, MockGLTexture>::iterator it = mock_state.textures.find(id);
+        return it == mock_state.textures.end() ? NULL : &it->second;
+    }
+
+    /** Adds a call to the stats and, if logging is on, to the command log
+    **/
+    static void record(const char* name, int64 a0 = 0, int64 a1 = 0, int64 a2 = 0, int64 a3 = 0, uint32 bytes = 0) {
+        ++mock_state.stats.calls;
+        mock_state.stats.bytes_uploaded += bytes;
+        if (!mock_state.logging) return;
+
+        MockGLCommand command;
+        command.name = name;
+        command.args[0] = a0;
+        command.args[1] = a1;
+        command.args[2] = a2;
+        command.args[3] = a3;
+        command.bytes = bytes;
+        mock_state.log.push_back(command);
+    }
+
+    static void record_state(const char* name, int64 a0 = 0, int64 a1 = 0) {
+        ++mock_state.stats.state_changes;
+        record(name, a0, a1);
+    }
+
+    static GLuint& bound_buffer(GLenum target) {
+        return target == GL_ELEMENT_ARRAY_BUFFER ? mock_state.element_buffer : mock_state.array_buffer;
+    }
+
+    /** Resizes the storage of the buffer bound to target and copies data into it if it isn't NULL
+    **/
+    static uint32 store_buffer(GLenum target, GLintptr offset, GLsizeiptr size, const void* data, bool resize) {
+        std::vector<uint8>& storage = mock_state.buffers[bound_buffer(target)];
+        if (resize) storage.assign(size, 0);
+        else if (storage.size() < size_t(offset + size)) storage.resize(offset + size);
+        if (data == NULL) return 0;
+        memcpy(&storage[offset], data, size);
+        return size;
+    }
+
+    static void gen_ids(GLsizei n, GLuint* ids) {
+        for (GLsizei i = 0; i < n; ++i) ids[i] = mock_state.next_id++;
+    }
+
+    /** Gets the amount of bytes of a width by height image of the specified format and type
+    **/
+    static uint32 image_size(GLsizei width, GLsizei height, GLenum format, GLenum type) {
+        uint32 channels = 4;
+        if (format == GL_RGB) channels = 3;
+        else if (format == GL_ALPHA || format == GL_LUMINANCE || format == GL_RED) channels = 1;
+        else if (format == GL_LUMINANCE_ALPHA || format == GL_RG) channels = 2;
+
+        uint32 bytes_per_pixel = channels;
+        if (type == GL_UNSIGNED_SHORT_5_6_5 || type == GL_UNSIGNED_SHORT_4_4_4_4 || type == GL_UNSIGNED_SHORT_5_5_5_1) bytes_per_pixel = 2;
+        else if (type == GL_UNSIGNED_SHORT) bytes_per_pixel = channels * 2;
+        else if (type == GL_FLOAT) bytes_per_pixel = channels * 4;
+        return width * height * bytes_per_pixel;
+    }
+
+    /** Copies a rect of pixels into the base level of the bound texture, reading rows with the unpack alignment
+    **/
+    static void store_texture_rect(GLint x, GLint y, GLsizei width, GLsizei height, const void* pixels) {
+        std::map<GLuint, MockGLTexture>::iterator it = mock_state.textures.find(mock_state.texture);
+        if (it == mock_state.textures.end() || pixels == NULL) return;
+
+        MockGLTexture& texture = it->second;
+        uint32 row_size = width * texture.bytes_per_pixel;
+        uint32 src_stride = (row_size + mock_state.unpack_alignment - 1) & ~uint32(mock_state.unpack_alignment - 1);
+        for (GLsizei row = 0; row < height; ++row) {
+            if (y + row < 0 || y + row >= texture.height || x < 0 || x + width > texture.width) continue;
+            memcpy(&texture.pixels[((y + row) * texture.width + x) * texture.bytes_per_pixel], (const uint8*)pixels + (row * src_stride), row_size);
+        }
+    }
+
+    namespace mock {
+
+        GLenum GlewInit() {
+            return GLEW_OK;
+        }
+
+        void ActiveTexture(GLenum texture) { record_state("glActiveTexture", texture); }
+        void AttachShader(GLuint program, GLuint shader) { record("glAttachShader", program, shader); }
+        void BindAttribLocation(GLuint program, GLuint index, const GLchar*) { record("glBindAttribLocation", program, index); }
+
+        void BindBuffer(GLenum target, GLuint buffer) {
+            bound_buffer(target) = buffer;
+            record_state("glBindBuffer", target, buffer);
+        }
+
+        void BindFramebuffer(GLenum target, GLuint framebuffer) { record_state("glBindFramebuffer", target, framebuffer); }
+        void BindTexture(GLenum target, GLuint texture) {
+            mock_state.texture = texture;
+            record_state("glBindTexture", target, texture);
+        }
+        void BindVertexArray(GLuint array) { record_state("glBindVertexArray", array); }
+        void BlendFunc(GLenum sfactor, GLenum dfactor) { record_state("glBlendFunc", sfactor, dfactor); }
+
+        void BufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+            record("glBufferData", target, size, usage, 0, store_buffer(target, 0, size, data, true));
+        }
+
+        void BufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags) {
+            record("glBufferStorage", target, size, flags, 0, store_buffer(target, 0, size, data, true));
+        }
+
+        void BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+            record("glBufferSubData", target, offset, size, 0, store_buffer(target, offset, size, data, false));
+        }
+
+        GLenum CheckFramebufferStatus(GLenum target) {
+            record("glCheckFramebufferStatus", target);
+            return GL_FRAMEBUFFER_COMPLETE;
+        }
+
+        void Clear(GLbitfield mask) { record("glClear", mask); }
+        void ClearColor(GLfloat, GLfloat, GLfloat, GLfloat) { record("glClearColor"); }
+        void ClearDepthf(GLfloat) { record("glClearDepthf"); }
+
+        GLenum ClientWaitSync(GLsync, GLbitfield flags, GLuint64 timeout) {
+            record("glClientWaitSync", flags, timeout);
+            return GL_ALREADY_SIGNALED;
+        }
+
+        void CompileShader(GLuint shader) { record("glCompileShader", shader); }
+
+        void CopyTexSubImage2D(GLenum target, GLint level, GLint, GLint, GLint, GLint, GLsizei width, GLsizei height) {
+            record("glCopyTexSubImage2D", target, level, width, height);
+        }
+
+        GLuint CreateProgram() {
+            GLuint id = mock_state.next_id++;
+            record("glCreateProgram", id);
+            return id;
+        }
+
+        GLuint CreateShader(GLenum type) {
+            GLuint id = mock_state.next_id++;
+            record("glCreateShader", type, id);
+            return id;
+        }
+
+        void DeleteBuffers(GLsizei n, const GLuint* buffers) {
+            for (GLsizei i = 0; i < n; ++i) {
+                mock_state.buffers.erase(buffers[i]);
+                if (mock_state.array_buffer == buffers[i]) mock_state.array_buffer = 0;
+                if (mock_state.element_buffer == buffers[i]) mock_state.element_buffer = 0;
+            }
+            record("glDeleteBuffers", n);
+        }
+
+        void DeleteFramebuffers(GLsizei n, const GLuint*) { record("glDeleteFramebuffers", n); }
+        void DeleteProgram(GLuint program) { record("glDeleteProgram", program); }
+        void DeleteRenderbuffers(GLsizei n, const GLuint*) { record("glDeleteRenderbuffers", n); }
+        void DeleteShader(GLuint shader) { record("glDeleteShader", shader); }
+        void DeleteSync(GLsync) { record("glDeleteSync"); }
+        void DeleteTextures(GLsizei n, const GLuint* textures) {
+            for (GLsizei i = 0; i < n; ++i) {
+                mock_state.textures.erase(textures[i]);
+                if (mock_state.texture == textures[i]) mock_state.texture = 0;
+            }
+            record("glDeleteTextures", n);
+        }
+        void DeleteVertexArrays(GLsizei n, const GLuint*) { record("glDeleteVertexArrays", n); }
+        void DepthFunc(GLenum func) { record_state("glDepthFunc", func); }
+        void DepthMask(GLboolean flag) { record_state("glDepthMask", flag); }
+        void DetachShader(GLuint program, GLuint shader) { record("glDetachShader", program, shader); }
+        void Disable(GLenum cap) { record_state("glDisable", cap); }
+        void DisableVertexAttribArray(GLuint index) { record_state("glDisableVertexAttribArray", index); }
+
+        void DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instancecount) {
+            ++mock_state.stats.draw_calls;
+            mock_state.stats.vertices_drawn += count * instancecount;
+            mock_state.stats.instances_drawn += instancecount;
+            record("glDrawArraysInstanced", mode, first, count, instancecount);
+        }
+
+        void DrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+            ++mock_state.stats.draw_calls;
+            mock_state.stats.vertices_drawn += count;
+            record("glDrawElements", mode, count, type, (int64)(size_t)indices);
+        }
+
+        void Enable(GLenum cap) { record_state("glEnable", cap); }
+        void EnableVertexAttribArray(GLuint index) { record_state("glEnableVertexAttribArray", index); }
+
+        GLsync FenceSync(GLenum condition, GLbitfield flags) {
+            //fences are never waited on for real, so any non null handle will do
+            static int fence;
+            record("glFenceSync", condition, flags);
+            return (GLsync)&fence;
+        }
+
+        void FramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint) {
+            record("glFramebufferTexture2D", target, attachment, textarget, texture);
+        }
+
+        void GenBuffers(GLsizei n, GLuint* buffers) { gen_ids(n, buffers); record("glGenBuffers", n); }
+        void GenFramebuffers(GLsizei n, GLuint* framebuffers) { gen_ids(n, framebuffers); record("glGenFramebuffers", n); }
+        void GenTextures(GLsizei n, GLuint* textures) { gen_ids(n, textures); record("glGenTextures", n); }
+        void GenVertexArrays(GLsizei n, GLuint* arrays) { gen_ids(n, arrays); record("glGenVertexArrays", n); }
+
+        void GetIntegerv(GLenum pname, GLint* data) {
+            memset(data, 0, sizeof(GLint) * (pname == GL_VIEWPORT ? 4 : 1));
+            record("glGetIntegerv", pname);
+        }
+
+        void GetProgramInfoLog(GLuint program, GLsizei buf_size, GLsizei* length, GLchar* info_log) {
+            if (length != NULL) *length = 0;
+            if (info_log != NULL && buf_size > 0) info_log[0] = '\0';
+            record("glGetProgramInfoLog", program);
+        }
+
+        void GetProgramiv(GLuint program, GLenum pname, GLint* params) {
+            *params = (pname == GL_LINK_STATUS || pname == GL_VALIDATE_STATUS) ? GL_TRUE : 0;
+            record("glGetProgramiv", program, pname);
+        }
+
+        void GetShaderInfoLog(GLuint shader, GLsizei buf_size, GLsizei* length, GLchar* info_log) {
+            if (length != NULL) *length = 0;
+            if (info_log != NULL && buf_size > 0) info_log[0] = '\0';
+            record("glGetShaderInfoLog", shader);
+        }
+
+        void GetShaderiv(GLuint shader, GLenum pname, GLint* params) {
+            *params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+            record("glGetShaderiv", shader, pname);
+        }
+
+        const GLubyte* GetString(GLenum name) {
+            record("glGetString", name);
+            return (const GLubyte*)"pxl mock gl";
+        }
+
+        GLint GetUniformLocation(GLuint program, const GLchar*) {
+            GLint location = mock_state.next_id++;
+            record("glGetUniformLocation", program, location);
+            return location;
+        }
+
+        void LinkProgram(GLuint program) { record("glLinkProgram", program); }
+
+        void* MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+            //everything written to a mapping is counted as uploaded when it's mapped, as persistent mappings are never unmapped
+            std::vector<uint8>& storage = mock_state.buffers[bound_buffer(target)];
+            if (storage.size() < size_t(offset + length)) storage.resize(offset + length);
+            record("glMapBufferRange", target, offset, length, access, length);
+            return &storage[offset];
+        }
+
+        void PixelStorei(GLenum pname, GLint param) {
+            if (pname == GL_UNPACK_ALIGNMENT) mock_state.unpack_alignment = param;
+            record("glPixelStorei", pname, param);
+        }
+        void ProvokingVertex(GLenum mode) { record_state("glProvokingVertex", mode); }
+
+        void ReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels) {
+            memset(pixels, 0, image_size(width, height, format, type));
+            record("glReadPixels", x, y, width, height);
+        }
+
+        void ShaderSource(GLuint shader, GLsizei count, const GLchar* const*, const GLint*) { record("glShaderSource", shader, count); }
+
+        void TexImage2D(GLenum target, GLint level, GLint, GLsizei width, GLsizei height, GLint, GLenum format, GLenum type, const void* pixels) {
+            if (level == 0) {
+                MockGLTexture& texture = mock_state.textures[mock_state.texture];
+                texture.width = width;
+                texture.height = height;
+                texture.bytes_per_pixel = image_size(1, 1, format, type);
+                texture.pixels.assign(width * height * texture.bytes_per_pixel, 0);
+                store_texture_rect(0, 0, width, height, pixels);
+            }
+            record("glTexImage2D", target, level, width, height, pixels == NULL ? 0 : image_size(width, height, format, type));
+        }
+
+        void TexParameteri(GLenum target, GLenum pname, GLint param) { record("glTexParameteri", target, pname, param); }
+
+        void TexSubImage2D(GLenum, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels) {
+            if (level == 0) store_texture_rect(xoffset, yoffset, width, height, pixels);
+            record("glTexSubImage2D", xoffset, yoffset, width, height, pixels == NULL ? 0 : image_size(width, height, format, type));
+        }
+
+        void Uniform1f(GLint location, GLfloat) { record("glUniform1f", location); }
+        void Uniform1fv(GLint location, GLsizei count, const GLfloat*) { record("glUniform1fv", location, count); }
+        void Uniform1i(GLint location, GLint v0) { record("glUniform1i", location, v0); }
+        void Uniform2f(GLint location, GLfloat, GLfloat) { record("glUniform2f", location); }
+        void Uniform3f(GLint location, GLfloat, GLfloat, GLfloat) { record("glUniform3f", location); }
+        void Uniform4f(GLint location, GLfloat, GLfloat, GLfloat, GLfloat) { record("glUniform4f", location); }
+        void UniformMatrix4fv(GLint location, GLsizei count, GLboolean, const GLfloat*) { record("glUniformMatrix4fv", location, count); }
+
+        GLboolean UnmapBuffer(GLenum target) {
+            record("glUnmapBuffer", target);
+            return GL_TRUE;
+        }
+
+        void UseProgram(GLuint program) { record_state("glUseProgram", program); }
+        void VertexAttribDivisor(GLuint index, GLuint divisor) { record_state("glVertexAttribDivisor", index, divisor); }
+
+        void VertexAttribPointer(GLuint index, GLint size, GLenum, GLboolean, GLsizei, const void*) {
+            record_state("glVertexAttribPointer", index, size);
+        }
+
+        void Viewport(GLint x, GLint y, GLsizei width, GLsizei height) { record("glViewport", x, y, width, height); }
+    };
+}};
+
+#endif
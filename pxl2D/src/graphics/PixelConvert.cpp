@@ -0,0 +1,135 @@
+#include "graphics/PixelConvert.h"
+#include <cstring>
+#include "graphics/PixelKernels.h"
+
+namespace pxl { namespace graphics {
+
+    //cpp constants (hidden from public)
+    #define CONVERT_BLOCK_SIZE 256                                          //pixels converted through the rgba scratch block at a time (1kb, stays in l1)
+
+    /** Returns whether a layout is 4 bytes of r, g, b, a in order
+    **/
+    static inline bool is_rgba8(const Channel& channel) {
+        return channel.gl_pixel_type == GL_UNSIGNED_BYTE && channel.bytes_per_pixel == 4 &&
+            channel.channel_index.r == 0 && channel.channel_index.g == 1 && channel.channel_index.b == 2 && channel.channel_index.a == 3;
+    }
+
+    static inline uint16 read_packed(const uint8* src, uint32 n) {
+        uint16 v;
+        memcpy(&v, src + (n * 2), sizeof(uint16));
+        return v;
+    }
+
+    /** Writes num_pixels pixels from src into rgba as 8 bit r, g, b, a
+    **/
+    static void decode_block(const uint8* src, const Channel& channel, uint8* rgba, uint32 num_pixels) {
+        if (channel.gl_pixel_type == GL_UNSIGNED_SHORT_5_6_5) {
+            for (uint32 n = 0; n < num_pixels; ++n) {
+                uint16 v = read_packed(src, n);
+                uint32 r = (v >> 11) & 31; uint32 g = (v >> 5) & 63; uint32 b = v & 31;
+                uint8* p = rgba + (n * 4);
+                p[0] = (r << 3) | (r >> 2);
+                p[1] = (g << 2) | (g >> 4);
+                p[2] = (b << 3) | (b >> 2);
+                p[3] = 255;
+            }
+        }else if (channel.gl_pixel_type == GL_UNSIGNED_SHORT_4_4_4_4) {
+            for (uint32 n = 0; n < num_pixels; ++n) {
+                uint16 v = read_packed(src, n);
+                uint8* p = rgba + (n * 4);
+                p[0] = (v >> 12) * 17;
+                p[1] = ((v >> 8) & 15) * 17;
+                p[2] = ((v >> 4) & 15) * 17;
+                p[3] = (v & 15) * 17;
+            }
+        }else if (is_rgba8(channel)) {
+            memcpy(rgba, src, num_pixels * 4);
+        }else {
+            const Channel::ChannelIndex& index = channel.channel_index;
+            const uint32 bpp = channel.bytes_per_pixel;
+            for (uint32 n = 0; n < num_pixels; ++n) {
+                const uint8* s = src + (n * bpp);
+                uint8* p = rgba + (n * 4);
+                p[0] = index.r != -1 ? s[index.r] : 255;
+                p[1] = index.g != -1 ? s[index.g] : 255;
+                p[2] = index.b != -1 ? s[index.b] : 255;
+                p[3] = index.a != -1 ? s[index.a] : 255;
+            }
+        }
+    }
+
+    /** Divides the colour of every rgba pixel by its alpha
+    **/
+    static void unpremultiply_block(uint8* rgba, uint32 num_pixels) {
+        for (uint32 n = 0; n < num_pixels; ++n) {
+            uint8* p = rgba + (n * 4);
+            uint32 a = p[3];
+            if (a == 0 || a == 255) continue;
+            for (int i = 0; i < 3; ++i) {
+                uint32 c = ((p[i] * 255) + (a / 2)) / a;
+                p[i] = c > 255 ? 255 : c;
+            }
+        }
+    }
+
+    /** Writes num_pixels 8 bit rgba pixels into dest
+    **/
+    static void encode_block(const uint8* rgba, uint8* dest, const Channel& channel, uint32 num_pixels) {
+        if (channel.gl_pixel_type == GL_UNSIGNED_SHORT_5_6_5) {
+            pack_rgb565(rgba, num_pixels, (uint16*)dest);
+        }else if (channel.gl_pixel_type == GL_UNSIGNED_SHORT_4_4_4_4) {
+            pack_rgba4444(rgba, num_pixels, (uint16*)dest);
+        }else if (is_rgba8(channel)) {
+            memcpy(dest, rgba, num_pixels * 4);
+        }else {
+            const Channel::ChannelIndex& index = channel.channel_index;
+            const uint32 bpp = channel.bytes_per_pixel;
+            //layouts that store r, g and b in the same byte are gray
+            const bool gray = index.r != -1 && index.r == index.g && index.g == index.b;
+            for (uint32 n = 0; n < num_pixels; ++n) {
+                const uint8* p = rgba + (n * 4);
+                uint8* d = dest + (n * bpp);
+                if (gray) {
+                    d[index.r] = ((p[0] * 77) + (p[1] * 150) + (p[2] * 29) + 128) >> 8;
+                }else {
+                    if (index.r != -1) d[index.r] = p[0];
+                    if (index.g != -1) d[index.g] = p[1];
+                    if (index.b != -1) d[index.b] = p[2];
+                }
+                if (index.a != -1) d[index.a] = p[3];
+            }
+        }
+    }
+
+    void convert_pixels(const uint8* src, const Channel& src_channel, uint8* dest, const Channel& dest_channel, uint32 num_pixels) {
+        if (src_channel == dest_channel) {
+            if (src != dest) memmove(dest, src, num_pixels * src_channel.bytes_per_pixel);
+            return;
+        }
+
+        //straight rgba has kernels for each of its common conversions, so it skips the scratch block
+        if (is_rgba8(src_channel) && !src_channel.premultiplied) {
+            if (is_rgba8(dest_channel) && dest_channel.premultiplied) {
+                if (src != dest) memmove(dest, src, num_pixels * 4);
+                premultiply_pixels(dest, num_pixels);
+                return;
+            }
+            if (dest_channel.gl_pixel_type == GL_UNSIGNED_SHORT_5_6_5) { pack_rgb565(src, num_pixels, (uint16*)dest); return; }
+            if (dest_channel.gl_pixel_type == GL_UNSIGNED_SHORT_4_4_4_4) { pack_rgba4444(src, num_pixels, (uint16*)dest); return; }
+        }
+
+        //each block is read in full before any of it is written, so converting in place to a layout that isn't
+        //bigger never overwrites pixels that haven't been read
+        uint8 block[CONVERT_BLOCK_SIZE * 4];
+        const uint32 src_bpp = src_channel.bytes_per_pixel;
+        const uint32 dest_bpp = dest_channel.bytes_per_pixel;
+        for (uint32 start = 0; start < num_pixels; start += CONVERT_BLOCK_SIZE) {
+            uint32 count = num_pixels - start < CONVERT_BLOCK_SIZE ? num_pixels - start : CONVERT_BLOCK_SIZE;
+
+            decode_block(src + (start * src_bpp), src_channel, block, count);
+            if (src_channel.premultiplied && !dest_channel.premultiplied) unpremultiply_block(block, count);
+            else if (!src_channel.premultiplied && dest_channel.premultiplied) premultiply_pixels(block, count);
+            encode_block(block, dest + (start * dest_bpp), dest_channel, count);
+        }
+    }
+}};
@@ -0,0 +1,536 @@
+#include "graphics/PixelKernels.h"
+#include <cstring>
+#include "graphics/QuadTransform.h"
+
+//sse2 is always available on x64 and on x86 builds that target it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define PIXEL_KERNEL_SSE_SUPPORTED
+    #include <emmintrin.h>
+
+    //avx2 is only compiled in where single functions can target it, so the rest of the file still runs on any cpu
+    #if defined(_MSC_VER) && _MSC_VER >= 1700
+        #define PIXEL_KERNEL_AVX2_SUPPORTED
+        #define PIXEL_TARGET_AVX2
+        #include <immintrin.h>
+    #elif defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+        #define PIXEL_KERNEL_AVX2_SUPPORTED
+        #define PIXEL_TARGET_AVX2 __attribute__((target("avx2")))
+        #include <immintrin.h>
+    #endif
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    #define PIXEL_KERNEL_NEON_SUPPORTED
+    #include <arm_neon.h>
+#endif
+
+namespace pxl { namespace graphics {
+
+    //cpp constants (hidden from public)
+    #define MAX_PATTERN_SIZE 128                                            //32 pixels of 4 channels, enough for one avx2 store per channel
+
+    /** Repeats a pixel num_pixels times into pattern. Patterns of 16 or 32 pixels are a whole number of 16 or 32
+    byte vectors for any amount of channels, so the simd kernels can store or compare them in a loop
+    **/
+    static void build_pattern(uint8* pattern, uint32 num_pixels, const uint8* pixel, uint32 num_channels) {
+        for (uint32 n = 0; n < num_pixels; ++n) memcpy(pattern + (n * num_channels), pixel, num_channels);
+    }
+
+    /**
+    ==================================================================================
+                                       Scalar kernels
+    ==================================================================================
+    **/
+    static void fill_pixels_scalar(uint8* dest, uint32 start, uint32 num_bytes, const uint8* pixel, uint32 num_channels) {
+        for (uint32 n = start; n < num_bytes; n += num_channels) {
+            for (uint32 i = 0; i < num_channels; ++i) dest[n + i] = pixel[i];
+        }
+    }
+
+    static bool scan_transparency_scalar(const uint8* pixels, uint32 start, uint32 num_bytes, uint32 num_channels, uint32 alpha_index) {
+        for (uint32 n = start + alpha_index; n < num_bytes; n += num_channels) {
+            if (pixels[n] != 255) return true;
+        }
+        return false;
+    }
+
+    /** Gets c * a / 255 rounded to the nearest integer, exact for every 8 bit c and a
+    **/
+    static inline uint8 multiply_alpha(uint32 c, uint32 a) {
+        uint32 t = (c * a) + 128;
+        return (t + (t >> 8)) >> 8;
+    }
+
+    static void premultiply_pixels_scalar(uint8* pixels, uint32 start, uint32 num_pixels) {
+        for (uint32 n = start; n < num_pixels; ++n) {
+            uint8* p = pixels + (n * 4);
+            p[0] = multiply_alpha(p[0], p[3]);
+            p[1] = multiply_alpha(p[1], p[3]);
+            p[2] = multiply_alpha(p[2], p[3]);
+        }
+    }
+
+    static void pack_rgba4444_scalar(const uint8* pixels, uint32 start, uint32 num_pixels, uint16* dest) {
+        for (uint32 n = start; n < num_pixels; ++n) {
+            const uint8* p = pixels + (n * 4);
+            dest[n] = ((p[0] >> 4) << 12) | ((p[1] >> 4) << 8) | ((p[2] >> 4) << 4) | (p[3] >> 4);
+        }
+    }
+
+    static void copy_pixels_scalar(uint8* dest, const uint8* src, uint32 start, uint32 num_bytes) {
+        if (start < num_bytes) memcpy(dest + start, src + start, num_bytes - start);
+    }
+
+    static void pack_rgb565_scalar(const uint8* pixels, uint32 start, uint32 num_pixels, uint16* dest) {
+        for (uint32 n = start; n < num_pixels; ++n) {
+            const uint8* p = pixels + (n * 4);
+            dest[n] = ((p[0] >> 3) << 11) | ((p[1] >> 2) << 5) | (p[2] >> 3);
+        }
+    }
+
+    /**
+    ==================================================================================
+                                        SSE kernels
+    ==================================================================================
+    **/
+    #if defined(PIXEL_KERNEL_SSE_SUPPORTED)
+        static uint32 fill_pixels_sse(uint8* dest, uint32 num_bytes, const uint8* pattern, uint32 num_channels) {
+            __m128i v[4];
+            for (uint32 i = 0; i < num_channels; ++i) v[i] = _mm_loadu_si128((const __m128i*)(pattern + (i * 16)));
+
+            //every step is 16 whole pixels
+            const uint32 step = num_channels * 16;
+            uint32 n = 0;
+            for (; n + step <= num_bytes; n += step) {
+                for (uint32 i = 0; i < num_channels; ++i) _mm_storeu_si128((__m128i*)(dest + n + (i * 16)), v[i]);
+            }
+            return n;
+        }
+
+        /** Ors the non alpha bytes to 255 so that every byte is 255 only if every alpha is 255
+        **/
+        static uint32 scan_transparency_sse(const uint8* pixels, uint32 num_bytes, const uint8* mask_pattern, uint32 num_channels, bool& transparent) {
+            __m128i mask[4];
+            for (uint32 i = 0; i < num_channels; ++i) mask[i] = _mm_loadu_si128((const __m128i*)(mask_pattern + (i * 16)));
+            const __m128i opaque = _mm_set1_epi8((char)0xff);
+
+            const uint32 step = num_channels * 16;
+            uint32 n = 0;
+            for (; n + step <= num_bytes; n += step) {
+                __m128i all = opaque;
+                for (uint32 i = 0; i < num_channels; ++i) {
+                    all = _mm_and_si128(all, _mm_or_si128(_mm_loadu_si128((const __m128i*)(pixels + n + (i * 16))), mask[i]));
+                }
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(all, opaque)) != 0xffff) {
+                    transparent = true;
+                    return n;
+                }
+            }
+            transparent = false;
+            return n;
+        }
+
+        /** Multiplies 8 16 bit channels by 8 16 bit alphas and divides by 255 with the same rounding as multiply_alpha
+        **/
+        static inline __m128i multiply_alpha_sse(__m128i c, __m128i a) {
+            __m128i t = _mm_add_epi16(_mm_mullo_epi16(c, a), _mm_set1_epi16(128));
+            return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+        }
+
+        static uint32 premultiply_pixels_sse(uint8* pixels, uint32 num_pixels) {
+            const __m128i zero = _mm_setzero_si128();
+            //the alpha of each pixel is multiplied by 255 so that it stays the same
+            const __m128i rgb_mask = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+            const __m128i alpha_255 = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+
+            uint32 n = 0;
+            for (; n + 4 <= num_pixels; n += 4) {
+                __m128i v = _mm_loadu_si128((const __m128i*)(pixels + (n * 4)));
+                __m128i lo = _mm_unpacklo_epi8(v, zero);
+                __m128i hi = _mm_unpackhi_epi8(v, zero);
+
+                __m128i lo_a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+                __m128i hi_a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+                lo_a = _mm_or_si128(_mm_and_si128(lo_a, rgb_mask), alpha_255);
+                hi_a = _mm_or_si128(_mm_and_si128(hi_a, rgb_mask), alpha_255);
+
+                _mm_storeu_si128((__m128i*)(pixels + (n * 4)), _mm_packus_epi16(multiply_alpha_sse(lo, lo_a), multiply_alpha_sse(hi, hi_a)));
+            }
+            return n;
+        }
+
+        /** Packs the low 16 bits of 8 32 bit values. _mm_packs_epi32 saturates signed values, so the values are
+        moved into the signed range and back
+        **/
+        static inline __m128i pack_u16_sse(__m128i a, __m128i b) {
+            const __m128i bias = _mm_set1_epi32(0x8000);
+            __m128i packed = _mm_packs_epi32(_mm_sub_epi32(a, bias), _mm_sub_epi32(b, bias));
+            return _mm_xor_si128(packed, _mm_set1_epi16((short)0x8000));
+        }
+
+        static inline __m128i pack_rgba4444_sse_4(__m128i v) {
+            const __m128i nibble = _mm_set1_epi32(0xf0);
+            __m128i r = _mm_slli_epi32(_mm_and_si128(v, nibble), 8);
+            __m128i g = _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(v, 8), nibble), 4);
+            __m128i b = _mm_and_si128(_mm_srli_epi32(v, 16), nibble);
+            __m128i a = _mm_srli_epi32(v, 28);
+            return _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a));
+        }
+
+        static inline __m128i pack_rgb565_sse_4(__m128i v) {
+            __m128i r = _mm_slli_epi32(_mm_and_si128(v, _mm_set1_epi32(0xf8)), 8);
+            __m128i g = _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(v, 8), _mm_set1_epi32(0xfc)), 3);
+            __m128i b = _mm_srli_epi32(_mm_and_si128(_mm_srli_epi32(v, 16), _mm_set1_epi32(0xf8)), 3);
+            return _mm_or_si128(_mm_or_si128(r, g), b);
+        }
+
+        static uint32 pack_rgba4444_sse(const uint8* pixels, uint32 num_pixels, uint16* dest) {
+            uint32 n = 0;
+            for (; n + 8 <= num_pixels; n += 8) {
+                //both loads happen before the store, so packing in place is safe
+                __m128i a = _mm_loadu_si128((const __m128i*)(pixels + (n * 4)));
+                __m128i b = _mm_loadu_si128((const __m128i*)(pixels + (n * 4) + 16));
+                _mm_storeu_si128((__m128i*)(dest + n), pack_u16_sse(pack_rgba4444_sse_4(a), pack_rgba4444_sse_4(b)));
+            }
+            return n;
+        }
+
+        static uint32 pack_rgb565_sse(const uint8* pixels, uint32 num_pixels, uint16* dest) {
+            uint32 n = 0;
+            for (; n + 8 <= num_pixels; n += 8) {
+                __m128i a = _mm_loadu_si128((const __m128i*)(pixels + (n * 4)));
+                __m128i b = _mm_loadu_si128((const __m128i*)(pixels + (n * 4) + 16));
+                _mm_storeu_si128((__m128i*)(dest + n), pack_u16_sse(pack_rgb565_sse_4(a), pack_rgb565_sse_4(b)));
+            }
+            return n;
+        }
+
+        /** Copies 64 bytes a step, with all the loads of a step issued before its stores
+        **/
+        static uint32 copy_pixels_sse(uint8* dest, const uint8* src, uint32 num_bytes) {
+            uint32 n = 0;
+            for (; n + 64 <= num_bytes; n += 64) {
+                __m128i a = _mm_loadu_si128((const __m128i*)(src + n));
+                __m128i b = _mm_loadu_si128((const __m128i*)(src + n + 16));
+                __m128i c = _mm_loadu_si128((const __m128i*)(src + n + 32));
+                __m128i d = _mm_loadu_si128((const __m128i*)(src + n + 48));
+                _mm_storeu_si128((__m128i*)(dest + n), a);
+                _mm_storeu_si128((__m128i*)(dest + n + 16), b);
+                _mm_storeu_si128((__m128i*)(dest + n + 32), c);
+                _mm_storeu_si128((__m128i*)(dest + n + 48), d);
+            }
+            return n;
+        }
+    #endif
+
+    /**
+    ==================================================================================
+                                        AVX2 kernels
+    ==================================================================================
+    **/
+    #if defined(PIXEL_KERNEL_AVX2_SUPPORTED)
+        PIXEL_TARGET_AVX2 static uint32 fill_pixels_avx2(uint8* dest, uint32 num_bytes, const uint8* pattern, uint32 num_channels) {
+            __m256i v[4];
+            for (uint32 i = 0; i < num_channels; ++i) v[i] = _mm256_loadu_si256((const __m256i*)(pattern + (i * 32)));
+
+            //every step is 32 whole pixels
+            const uint32 step = num_channels * 32;
+            uint32 n = 0;
+            for (; n + step <= num_bytes; n += step) {
+                for (uint32 i = 0; i < num_channels; ++i) _mm256_storeu_si256((__m256i*)(dest + n + (i * 32)), v[i]);
+            }
+            _mm256_zeroupper();
+            return n;
+        }
+
+        PIXEL_TARGET_AVX2 static uint32 scan_transparency_avx2(const uint8* pixels, uint32 num_bytes, const uint8* mask_pattern, uint32 num_channels, bool& transparent) {
+            __m256i mask[4];
+            for (uint32 i = 0; i < num_channels; ++i) mask[i] = _mm256_loadu_si256((const __m256i*)(mask_pattern + (i * 32)));
+            const __m256i opaque = _mm256_set1_epi8((char)0xff);
+
+            const uint32 step = num_channels * 32;
+            uint32 n = 0;
+            transparent = false;
+            for (; n + step <= num_bytes; n += step) {
+                __m256i all = opaque;
+                for (uint32 i = 0; i < num_channels; ++i) {
+                    all = _mm256_and_si256(all, _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(pixels + n + (i * 32))), mask[i]));
+                }
+                if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(all, opaque)) != -1) {
+                    transparent = true;
+                    break;
+                }
+            }
+            _mm256_zeroupper();
+            return n;
+        }
+
+        PIXEL_TARGET_AVX2 static uint32 copy_pixels_avx2(uint8* dest, const uint8* src, uint32 num_bytes) {
+            uint32 n = 0;
+            for (; n + 128 <= num_bytes; n += 128) {
+                __m256i a = _mm256_loadu_si256((const __m256i*)(src + n));
+                __m256i b = _mm256_loadu_si256((const __m256i*)(src + n + 32));
+                __m256i c = _mm256_loadu_si256((const __m256i*)(src + n + 64));
+                __m256i d = _mm256_loadu_si256((const __m256i*)(src + n + 96));
+                _mm256_storeu_si256((__m256i*)(dest + n), a);
+                _mm256_storeu_si256((__m256i*)(dest + n + 32), b);
+                _mm256_storeu_si256((__m256i*)(dest + n + 64), c);
+                _mm256_storeu_si256((__m256i*)(dest + n + 96), d);
+            }
+            _mm256_zeroupper();
+            return n;
+        }
+    #endif
+
+    /**
+    ==================================================================================
+                                        NEON kernels
+    ==================================================================================
+    **/
+    #if defined(PIXEL_KERNEL_NEON_SUPPORTED)
+        static uint32 fill_pixels_neon(uint8* dest, uint32 num_bytes, const uint8* pattern, uint32 num_channels) {
+            uint8x16_t v[4];
+            for (uint32 i = 0; i < num_channels; ++i) v[i] = vld1q_u8(pattern + (i * 16));
+
+            const uint32 step = num_channels * 16;
+            uint32 n = 0;
+            for (; n + step <= num_bytes; n += step) {
+                for (uint32 i = 0; i < num_channels; ++i) vst1q_u8(dest + n + (i * 16), v[i]);
+            }
+            return n;
+        }
+
+        static uint32 scan_transparency_neon(const uint8* pixels, uint32 num_bytes, const uint8* mask_pattern, uint32 num_channels, bool& transparent) {
+            uint8x16_t mask[4];
+            for (uint32 i = 0; i < num_channels; ++i) mask[i] = vld1q_u8(mask_pattern + (i * 16));
+
+            const uint32 step = num_channels * 16;
+            uint32 n = 0;
+            for (; n + step <= num_bytes; n += step) {
+                uint8x16_t all = vdupq_n_u8(0xff);
+                for (uint32 i = 0; i < num_channels; ++i) all = vandq_u8(all, vorrq_u8(vld1q_u8(pixels + n + (i * 16)), mask[i]));
+
+                uint64x2_t halves = vreinterpretq_u64_u8(all);
+                if ((vgetq_lane_u64(halves, 0) & vgetq_lane_u64(halves, 1)) != ~0ULL) {
+                    transparent = true;
+                    return n;
+                }
+            }
+            transparent = false;
+            return n;
+        }
+
+        static inline uint8x8_t multiply_alpha_neon(uint8x8_t c, uint8x8_t a) {
+            uint16x8_t t = vaddq_u16(vmull_u8(c, a), vdupq_n_u16(128));
+            return vshrn_n_u16(vaddq_u16(t, vshrq_n_u16(t, 8)), 8);
+        }
+
+        static uint32 premultiply_pixels_neon(uint8* pixels, uint32 num_pixels) {
+            uint32 n = 0;
+            for (; n + 8 <= num_pixels; n += 8) {
+                uint8x8x4_t v = vld4_u8(pixels + (n * 4));
+                v.val[0] = multiply_alpha_neon(v.val[0], v.val[3]);
+                v.val[1] = multiply_alpha_neon(v.val[1], v.val[3]);
+                v.val[2] = multiply_alpha_neon(v.val[2], v.val[3]);
+                vst4_u8(pixels + (n * 4), v);
+            }
+            return n;
+        }
+
+        static uint32 copy_pixels_neon(uint8* dest, const uint8* src, uint32 num_bytes) {
+            uint32 n = 0;
+            for (; n + 64 <= num_bytes; n += 64) {
+                uint8x16x4_t v = { { vld1q_u8(src + n), vld1q_u8(src + n + 16), vld1q_u8(src + n + 32), vld1q_u8(src + n + 48) } };
+                vst1q_u8(dest + n, v.val[0]);
+                vst1q_u8(dest + n + 16, v.val[1]);
+                vst1q_u8(dest + n + 32, v.val[2]);
+                vst1q_u8(dest + n + 48, v.val[3]);
+            }
+            return n;
+        }
+    #endif
+
+    /**
+    ==================================================================================
+                                          Dispatch
+    ==================================================================================
+    **/
+    static PixelKernel detect_pixel_kernel() {
+        if (is_pixel_kernel_supported(PIXEL_KERNEL_AVX2)) return PIXEL_KERNEL_AVX2;
+        if (is_pixel_kernel_supported(PIXEL_KERNEL_SSE)) return PIXEL_KERNEL_SSE;
+        if (is_pixel_kernel_supported(PIXEL_KERNEL_NEON)) return PIXEL_KERNEL_NEON;
+        return PIXEL_KERNEL_SCALAR;
+    }
+
+    static PixelKernel current_kernel = detect_pixel_kernel();
+
+    bool is_pixel_kernel_supported(PixelKernel kernel) {
+        switch (kernel) {
+            case PIXEL_KERNEL_SCALAR:
+                return true;
+            #if defined(PIXEL_KERNEL_SSE_SUPPORTED)
+                case PIXEL_KERNEL_SSE:
+                    return true;
+            #endif
+            #if defined(PIXEL_KERNEL_AVX2_SUPPORTED)
+                case PIXEL_KERNEL_AVX2:
+                    //the quad kernels already detect avx2 with the same compile conditions
+                    return is_quad_kernel_supported(QUAD_KERNEL_AVX2);
+            #endif
+            #if defined(PIXEL_KERNEL_NEON_SUPPORTED)
+                case PIXEL_KERNEL_NEON:
+                    return true;
+            #endif
+            default:
+                return false;
+        }
+    }
+
+    PixelKernel get_pixel_kernel() {
+        return current_kernel;
+    }
+
+    void set_pixel_kernel(PixelKernel kernel) {
+        if (is_pixel_kernel_supported(kernel)) current_kernel = kernel;
+    }
+
+    void fill_pixels(uint8* dest, uint32 num_pixels, const uint8* pixel, uint32 num_channels, PixelKernel kernel) {
+        if (num_channels == 0 || num_channels > 4) return;
+        if (!is_pixel_kernel_supported(kernel)) kernel = PIXEL_KERNEL_SCALAR;
+
+        const uint32 num_bytes = num_pixels * num_channels;
+        uint8 pattern[MAX_PATTERN_SIZE];
+
+        //the simd kernels fill whole patterns and leave the remainder to the scalar kernel
+        uint32 done = 0;
+        switch (kernel) {
+            #if defined(PIXEL_KERNEL_SSE_SUPPORTED)
+                case PIXEL_KERNEL_SSE: build_pattern(pattern, 16, pixel, num_channels); done = fill_pixels_sse(dest, num_bytes, pattern, num_channels); break;
+            #endif
+            #if defined(PIXEL_KERNEL_AVX2_SUPPORTED)
+                case PIXEL_KERNEL_AVX2: build_pattern(pattern, 32, pixel, num_channels); done = fill_pixels_avx2(dest, num_bytes, pattern, num_channels); break;
+            #endif
+            #if defined(PIXEL_KERNEL_NEON_SUPPORTED)
+                case PIXEL_KERNEL_NEON: build_pattern(pattern, 16, pixel, num_channels); done = fill_pixels_neon(dest, num_bytes, pattern, num_channels); break;
+            #endif
+            default: break;
+        }
+        fill_pixels_scalar(dest, done, num_bytes, pixel, num_channels);
+    }
+
+    void fill_pixels(uint8* dest, uint32 num_pixels, const uint8* pixel, uint32 num_channels) {
+        fill_pixels(dest, num_pixels, pixel, num_channels, current_kernel);
+    }
+
+    bool scan_transparency(const uint8* pixels, uint32 num_pixels, uint32 num_channels, uint32 alpha_index, PixelKernel kernel) {
+        if (num_channels == 0 || num_channels > 4 || alpha_index >= num_channels) return false;
+        if (!is_pixel_kernel_supported(kernel)) kernel = PIXEL_KERNEL_SCALAR;
+
+        const uint32 num_bytes = num_pixels * num_channels;
+
+        //the mask is 255 for every colour byte and 0 for the alpha byte
+        uint8 mask_pixel[4] = { 0xff, 0xff, 0xff, 0xff };
+        mask_pixel[alpha_index] = 0;
+        uint8 mask_pattern[MAX_PATTERN_SIZE];
+
+        bool transparent = false;
+        uint32 done = 0;
+        switch (kernel) {
+            #if defined(PIXEL_KERNEL_SSE_SUPPORTED)
+                case PIXEL_KERNEL_SSE: build_pattern(mask_pattern, 16, mask_pixel, num_channels); done = scan_transparency_sse(pixels, num_bytes, mask_pattern, num_channels, transparent); break;
+            #endif
+            #if defined(PIXEL_KERNEL_AVX2_SUPPORTED)
+                case PIXEL_KERNEL_AVX2: build_pattern(mask_pattern, 32, mask_pixel, num_channels); done = scan_transparency_avx2(pixels, num_bytes, mask_pattern, num_channels, transparent); break;
+            #endif
+            #if defined(PIXEL_KERNEL_NEON_SUPPORTED)
+                case PIXEL_KERNEL_NEON: build_pattern(mask_pattern, 16, mask_pixel, num_channels); done = scan_transparency_neon(pixels, num_bytes, mask_pattern, num_channels, transparent); break;
+            #endif
+            default: break;
+        }
+        return transparent || scan_transparency_scalar(pixels, done, num_bytes, num_channels, alpha_index);
+    }
+
+    bool scan_transparency(const uint8* pixels, uint32 num_pixels, uint32 num_channels, uint32 alpha_index) {
+        return scan_transparency(pixels, num_pixels, num_channels, alpha_index, current_kernel);
+    }
+
+    void premultiply_pixels(uint8* pixels, uint32 num_pixels, PixelKernel kernel) {
+        if (!is_pixel_kernel_supported(kernel)) kernel = PIXEL_KERNEL_SCALAR;
+
+        uint32 done = 0;
+        switch (kernel) {
+            #if defined(PIXEL_KERNEL_SSE_SUPPORTED)
+                case PIXEL_KERNEL_SSE:
+                case PIXEL_KERNEL_AVX2: done = premultiply_pixels_sse(pixels, num_pixels); break;
+            #endif
+            #if defined(PIXEL_KERNEL_NEON_SUPPORTED)
+                case PIXEL_KERNEL_NEON: done = premultiply_pixels_neon(pixels, num_pixels); break;
+            #endif
+            default: break;
+        }
+        premultiply_pixels_scalar(pixels, done, num_pixels);
+    }
+
+    void premultiply_pixels(uint8* pixels, uint32 num_pixels) {
+        premultiply_pixels(pixels, num_pixels, current_kernel);
+    }
+
+    void pack_rgba4444(const uint8* pixels, uint32 num_pixels, uint16* dest, PixelKernel kernel) {
+        if (!is_pixel_kernel_supported(kernel)) kernel = PIXEL_KERNEL_SCALAR;
+
+        uint32 done = 0;
+        switch (kernel) {
+            #if defined(PIXEL_KERNEL_SSE_SUPPORTED)
+                case PIXEL_KERNEL_SSE:
+                case PIXEL_KERNEL_AVX2: done = pack_rgba4444_sse(pixels, num_pixels, dest); break;
+            #endif
+            default: break;
+        }
+        pack_rgba4444_scalar(pixels, done, num_pixels, dest);
+    }
+
+    void pack_rgba4444(const uint8* pixels, uint32 num_pixels, uint16* dest) {
+        pack_rgba4444(pixels, num_pixels, dest, current_kernel);
+    }
+
+    void pack_rgb565(const uint8* pixels, uint32 num_pixels, uint16* dest, PixelKernel kernel) {
+        if (!is_pixel_kernel_supported(kernel)) kernel = PIXEL_KERNEL_SCALAR;
+
+        uint32 done = 0;
+        switch (kernel) {
+            #if defined(PIXEL_KERNEL_SSE_SUPPORTED)
+                case PIXEL_KERNEL_SSE:
+                case PIXEL_KERNEL_AVX2: done = pack_rgb565_sse(pixels, num_pixels, dest); break;
+            #endif
+            default: break;
+        }
+        pack_rgb565_scalar(pixels, done, num_pixels, dest);
+    }
+
+    void pack_rgb565(const uint8* pixels, uint32 num_pixels, uint16* dest) {
+        pack_rgb565(pixels, num_pixels, dest, current_kernel);
+    }
+
+    void copy_pixels(uint8* dest, const uint8* src, uint32 num_bytes, PixelKernel kernel) {
+        if (!is_pixel_kernel_supported(kernel)) kernel = PIXEL_KERNEL_SCALAR;
+
+        uint32 done = 0;
+        switch (kernel) {
+            #if defined(PIXEL_KERNEL_SSE_SUPPORTED)
+                case PIXEL_KERNEL_SSE: done = copy_pixels_sse(dest, src, num_bytes); break;
+            #endif
+            #if defined(PIXEL_KERNEL_AVX2_SUPPORTED)
+                case PIXEL_KERNEL_AVX2: done = copy_pixels_avx2(dest, src, num_bytes); break;
+            #endif
+            #if defined(PIXEL_KERNEL_NEON_SUPPORTED)
+                case PIXEL_KERNEL_NEON: done = copy_pixels_neon(dest, src, num_bytes); break;
+            #endif
+            default: break;
+        }
+        copy_pixels_scalar(dest, src, done, num_bytes);
+    }
+
+    void copy_pixels(uint8* dest, const uint8* src, uint32 num_bytes) {
+        copy_pixels(dest, src, num_bytes, current_kernel);
+    }
+}};
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include "graphics/PixelPool.h"
+
+#include <cstdlib>
+
+namespace pxl { namespace graphics {
+
+    //cpp constants (hidden from public)
+    #define PIXEL_ALIGNMENT 64                                              //alignment of every buffer, the size of a cache line
+    #define PIXEL_HEADER_SIZE PIXEL_ALIGNMENT                               //bytes kept in front of each buffer for its header, so the buffer stays aligned
+    #define NUM_LINEAR_CLASSES 4                                            //classes of 64, 128, 192 and 256 bytes
+    #define NUM_SIZE_CLASSES 68                                             //enough classes to reach the 16mb max class size
+    #define ARENA_CLASS 0xffffffff                                          //size class stored for buffers from an arena
+    #define DIRECT_CLASS 0xfffffffe                                         //size class stored for buffers too big to pool
+
+    /** Stored in the 64 bytes in front of every buffer
+    **/
+    struct PixelBlockHeader {
+
+        uint8* allocation; /**> The pointer malloc returned **/
+        PixelArena* arena; /**> The arena the buffer came from, or NULL **/
+        uint32 size; /**> The size of the buffer after rounding up to its class **/
+        uint32 size_class;
+    };
+
+    struct PixelPool {
+
+        std::mutex pool_mutex;
+        std::vector<uint8*> free_lists[NUM_SIZE_CLASSES];
+        PixelPoolStats stats;
+        PixelArena* arena = NULL;
+    };
+
+    static PixelPool pool;
+
+    /** Gets the size class of a buffer size and the size rounded up to that class
+    **/
+    static uint32 get_size_class(uint32 size, uint32& class_size) {
+        if (size == 0) size = 1;
+        if (size <= NUM_LINEAR_CLASSES * PIXEL_ALIGNMENT) {
+            uint32 size_class = (size - 1) / PIXEL_ALIGNMENT;
+            class_size = (size_class + 1) * PIXEL_ALIGNMENT;
+            return size_class;
+        }
+
+        //above 256 bytes there are 4 classes for each power of 2, each a quarter of the power apart
+        uint32 power = 0;
+        for (uint32 v = size - 1; v > 1; v >>= 1) ++power;
+        uint32 quarter = power - 2;
+        uint32 steps = (size - 1) >> quarter;
+        class_size = (steps + 1) << quarter;
+        return NUM_LINEAR_CLASSES + (power - 8) * 4 + (steps - 4);
+    }
+
+    static inline PixelBlockHeader* get_header(uint8* pixels) {
+        return (PixelBlockHeader*)(pixels - PIXEL_HEADER_SIZE);
+    }
+
+    /** Allocates an aligned buffer from the heap with space for the header in front of it
+    **/
+    static uint8* alloc_block(uint32 size, uint32 size_class) {
+        uint8* allocation = (uint8*)malloc(size + PIXEL_HEADER_SIZE + PIXEL_ALIGNMENT - 1);
+        if (allocation == NULL) return NULL;
+
+        uint8* pixels = (uint8*)(((size_t)allocation + PIXEL_HEADER_SIZE + PIXEL_ALIGNMENT - 1) & ~(size_t)(PIXEL_ALIGNMENT - 1));
+        PixelBlockHeader* header = get_header(pixels);
+        header->allocation = allocation;
+        header->arena = NULL;
+        header->size = size;
+        header->size_class = size_class;
+        return pixels;
+    }
+
+    /** Adds size bytes to the outstanding bytes and raises the peak if needed. The pool mutex has to be locked
+    **/
+    static void add_outstanding(uint32 size) {
+        pool.stats.outstanding_bytes += size;
+        ++pool.stats.allocations;
+        if (pool.stats.outstanding_bytes > pool.stats.peak_bytes) pool.stats.peak_bytes = pool.stats.outstanding_bytes;
+    }
+
+    uint8* alloc_pixels(uint32 size) {
+        PixelArena* arena;
+        {
+            std::lock_guard<std::mutex> lock(pool.pool_mutex);
+            arena = pool.arena;
+        }
+        if (arena != NULL) return arena->alloc(size);
+
+        uint32 class_size;
+        uint32 size_class = get_size_class(size, class_size);
+        if (class_size > CONFIG_PIXEL_POOL_MAX_CLASS_SIZE) {
+            //too big to pool, only rounded up to the alignment
+            class_size = (size + PIXEL_ALIGNMENT - 1) & ~(PIXEL_ALIGNMENT - 1);
+            size_class = DIRECT_CLASS;
+        }else {
+            std::lock_guard<std::mutex> lock(pool.pool_mutex);
+            std::vector<uint8*>& free_list = pool.free_lists[size_class];
+            if (!free_list.empty()) {
+                uint8* pixels = free_list.back();
+                free_list.pop_back();
+                pool.stats.pooled_bytes -= class_size;
+                ++pool.stats.reuses;
+                add_outstanding(class_size);
+                return pixels;
+            }
+        }
+
+        uint8* pixels = alloc_block(class_size, size_class);
+        if (pixels != NULL) {
+            std::lock_guard<std::mutex> lock(pool.pool_mutex);
+            add_outstanding(class_size);
+        }
+        return pixels;
+    }
+
+    void free_pixels(uint8* pixels) {
+        if (pixels == NULL) return;
+
+        PixelBlockHeader* header = get_header(pixels);
+        std::lock_guard<std::mutex> lock(pool.pool_mutex);
+        pool.stats.outstanding_bytes -= header->size;
+
+        if (header->size_class == ARENA_CLASS) {
+            header->arena->outstanding_bytes -= header->size;
+            return;
+        }
+        if (header->size_class == DIRECT_CLASS || pool.stats.pooled_bytes + header->size > CONFIG_PIXEL_POOL_MAX_POOLED_BYTES) {
+            free(header->allocation);
+            return;
+        }
+        pool.free_lists[header->size_class].push_back(pixels);
+        pool.stats.pooled_bytes += header->size;
+    }
+
+    void set_pixel_arena(PixelArena* arena) {
+        std::lock_guard<std::mutex> lock(pool.pool_mutex);
+        pool.arena = arena;
+    }
+
+    PixelArena* get_pixel_arena() {
+        std::lock_guard<std::mutex> lock(pool.pool_mutex);
+        return pool.arena;
+    }
+
+    void trim_pixel_pool() {
+        std::lock_guard<std::mutex> lock(pool.pool_mutex);
+        for (uint32 n = 0; n < NUM_SIZE_CLASSES; ++n) {
+            std::vector<uint8*>& free_list = pool.free_lists[n];
+            for (size_t i = 0; i < free_list.size(); ++i) free(get_header(free_list[i])->allocation);
+            free_list.clear();
+        }
+        pool.stats.pooled_bytes = 0;
+    }
+
+    PixelPoolStats get_pixel_pool_stats() {
+        std::lock_guard<std::mutex> lock(pool.pool_mutex);
+        return pool.stats;
+    }
+
+    void reset_pixel_pool_stats() {
+        std::lock_guard<std::mutex> lock(pool.pool_mutex);
+        pool.stats.peak_bytes = pool.stats.outstanding_bytes;
+        pool.stats.allocations = 0;
+        pool.stats.reuses = 0;
+    }
+
+    PixelArena::PixelArena(uint32 arena_block_size) {
+        block_size = arena_block_size;
+        block_offset = 0;
+        current_block_size = 0;
+    }
+
+    uint8* PixelArena::alloc(uint32 size) {
+        uint32 class_size = (size + PIXEL_ALIGNMENT - 1) & ~(PIXEL_ALIGNMENT - 1);
+        uint32 needed = class_size + PIXEL_HEADER_SIZE;
+
+        uint8* pixels;
+        {
+            std::lock_guard<std::mutex> lock(arena_mutex);
+            if (blocks.empty() || block_offset + needed > current_block_size) {
+                //start a new block, or give a buffer bigger than a block its own block
+                current_block_size = needed > block_size ? needed : block_size;
+                uint8* block = alloc_block(current_block_size, ARENA_CLASS);
+                if (block == NULL) return NULL;
+
+                blocks.push_back(block);
+                block_offset = 0;
+                reserved_bytes += current_block_size;
+            }
+            pixels = blocks.back() + block_offset + PIXEL_HEADER_SIZE;
+            block_offset += needed;
+            used_bytes += class_size;
+        }
+
+        PixelBlockHeader* header = get_header(pixels);
+        header->allocation = NULL;
+        header->arena = this;
+        header->size = class_size;
+        header->size_class = ARENA_CLASS;
+
+        std::lock_guard<std::mutex> lock(pool.pool_mutex);
+        add_outstanding(class_size);
+        outstanding_bytes += class_size;
+        return pixels;
+    }
+
+    void PixelArena::release() {
+        std::lock_guard<std::mutex> lock(arena_mutex);
+        {
+            //buffers still handed out go with their blocks
+            std::lock_guard<std::mutex> pool_lock(pool.pool_mutex);
+            pool.stats.outstanding_bytes -= outstanding_bytes;
+            outstanding_bytes = 0;
+        }
+        for (size_t n = 0; n < blocks.size(); ++n) free(get_header(blocks[n])->allocation);
+        blocks.clear();
+        block_offset = 0;
+        current_block_size = 0;
+        used_bytes = 0;
+        reserved_bytes = 0;
+    }
+
+    PixelArena::~PixelArena() {
+        release();
+    }
+}};
@@ -0,0 +1,370 @@
+#include "graphics/QuadTransform.h"
+#include "graphics/Batch.h"
+
+//sse2 is always available on x64 and on x86 builds that target it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define QUAD_KERNEL_SSE_SUPPORTED
+    #include <emmintrin.h>
+
+    //avx2 is only compiled in where single functions can target it, so the rest of the file still runs on any cpu
+    #if defined(_MSC_VER) && _MSC_VER >= 1700
+        #define QUAD_KERNEL_AVX2_SUPPORTED
+        #define QUAD_TARGET_AVX2
+        #include <immintrin.h>
+        #include <intrin.h>
+    #elif defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+        #define QUAD_KERNEL_AVX2_SUPPORTED
+        #define QUAD_TARGET_AVX2 __attribute__((target("avx2")))
+        #include <immintrin.h>
+    #endif
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    #define QUAD_KERNEL_NEON_SUPPORTED
+    #include <arm_neon.h>
+#endif
+
+namespace pxl { namespace graphics {
+
+    /**
+    ==================================================================================
+                                       Scalar kernels
+    ==================================================================================
+    **/
+    static void transform_quads_scalar(const QuadTransforms& q, uint32 start, uint32 count, VertexPoint* dest) {
+        for (uint32 n = start; n < count; ++n) {
+            VertexPoint* v = dest + (n * 4);
+            float x = q.x[n]; float y = q.y[n];
+            float l = q.left[n]; float t = q.top[n]; float r = q.right[n]; float b = q.bottom[n];
+            float c = q.c[n]; float s = q.s[n];
+
+            v[0].pos.x = x + ((c * l) - (s * t));
+            v[0].pos.y = y + ((s * l) + (c * t));
+
+            v[1].pos.x = x + ((c * r) - (s * t));
+            v[1].pos.y = y + ((s * r) + (c * t));
+
+            v[2].pos.x = x + ((c * r) - (s * b));
+            v[2].pos.y = y + ((s * r) + (c * b));
+
+            v[3].pos.x = x + ((c * l) - (s * b));
+            v[3].pos.y = y + ((s * l) + (c * b));
+        }
+    }
+
+    static void convert_quad_colours_scalar(const float* colours, uint32 start, uint32 count, VertexPoint* dest) {
+        for (uint32 n = start; n < count; ++n) {
+            const float* colour = colours + (n * 4);
+            int i_r = colour[0] * 255; int i_g = colour[1] * 255; int i_b = colour[2] * 255; int i_a = colour[3] * 255;
+
+            VertexPoint* v = dest + (n * 4);
+            for (int i = 0; i < 4; ++i) {
+                v[i].colour.r = i_r;
+                v[i].colour.g = i_g;
+                v[i].colour.b = i_b;
+                v[i].colour.a = i_a;
+            }
+        }
+    }
+
+    /** Copies one packed rgba colour per quad into all 4 vertices of num_quads quads
+    **/
+    static inline void store_quad_colours(const uint32* rgba, uint32 num_quads, VertexPoint* dest) {
+        for (uint32 n = 0; n < num_quads; ++n) {
+            VertexPoint* v = dest + (n * 4);
+            const uint8* colour = (const uint8*)&rgba[n];
+            for (int i = 0; i < 4; ++i) {
+                v[i].colour.r = colour[0];
+                v[i].colour.g = colour[1];
+                v[i].colour.b = colour[2];
+                v[i].colour.a = colour[3];
+            }
+        }
+    }
+
+    /**
+    ==================================================================================
+                                        SSE kernels
+    ==================================================================================
+    **/
+    #if defined(QUAD_KERNEL_SSE_SUPPORTED)
+        /** Stores the position of the same corner of 4 quads. v points to that corner of the first quad
+        **/
+        static inline void store_corners_sse(__m128 px, __m128 py, VertexPoint* v) {
+            __m128 lo = _mm_unpacklo_ps(px, py);
+            __m128 hi = _mm_unpackhi_ps(px, py);
+            _mm_storel_pi((__m64*)&v[0].pos.x, lo);
+            _mm_storeh_pi((__m64*)&v[4].pos.x, lo);
+            _mm_storel_pi((__m64*)&v[8].pos.x, hi);
+            _mm_storeh_pi((__m64*)&v[12].pos.x, hi);
+        }
+
+        static uint32 transform_quads_sse(const QuadTransforms& q, uint32 count, VertexPoint* dest) {
+            uint32 n = 0;
+            for (; n + 4 <= count; n += 4) {
+                __m128 x = _mm_loadu_ps(q.x + n); __m128 y = _mm_loadu_ps(q.y + n);
+                __m128 c = _mm_loadu_ps(q.c + n); __m128 s = _mm_loadu_ps(q.s + n);
+                __m128 l = _mm_loadu_ps(q.left + n); __m128 t = _mm_loadu_ps(q.top + n);
+                __m128 r = _mm_loadu_ps(q.right + n); __m128 b = _mm_loadu_ps(q.bottom + n);
+
+                __m128 cl = _mm_mul_ps(c, l); __m128 ct = _mm_mul_ps(c, t); __m128 cr = _mm_mul_ps(c, r); __m128 cb = _mm_mul_ps(c, b);
+                __m128 sl = _mm_mul_ps(s, l); __m128 st = _mm_mul_ps(s, t); __m128 sr = _mm_mul_ps(s, r); __m128 sb = _mm_mul_ps(s, b);
+
+                VertexPoint* v = dest + (n * 4);
+                store_corners_sse(_mm_add_ps(x, _mm_sub_ps(cl, st)), _mm_add_ps(y, _mm_add_ps(sl, ct)), v);
+                store_corners_sse(_mm_add_ps(x, _mm_sub_ps(cr, st)), _mm_add_ps(y, _mm_add_ps(sr, ct)), v + 1);
+                store_corners_sse(_mm_add_ps(x, _mm_sub_ps(cr, sb)), _mm_add_ps(y, _mm_add_ps(sr, cb)), v + 2);
+                store_corners_sse(_mm_add_ps(x, _mm_sub_ps(cl, sb)), _mm_add_ps(y, _mm_add_ps(sl, cb)), v + 3);
+            }
+            return n;
+        }
+
+        static uint32 convert_quad_colours_sse(const float* colours, uint32 count, VertexPoint* dest) {
+            const __m128 scale = _mm_set1_ps(255.0f);
+            //channels wrap like the int to uint8 conversion of the scalar kernel rather than saturating
+            const __m128i mask = _mm_set1_epi32(0xff);
+
+            uint32 n = 0;
+            for (; n + 4 <= count; n += 4) {
+                const float* colour = colours + (n * 4);
+                __m128i c0 = _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(colour), scale)), mask);
+                __m128i c1 = _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(colour + 4), scale)), mask);
+                __m128i c2 = _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(colour + 8), scale)), mask);
+                __m128i c3 = _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(colour + 12), scale)), mask);
+
+                uint32 rgba[4];
+                _mm_storeu_si128((__m128i*)rgba, _mm_packus_epi16(_mm_packs_epi32(c0, c1), _mm_packs_epi32(c2, c3)));
+                store_quad_colours(rgba, 4, dest + (n * 4));
+            }
+            return n;
+        }
+    #endif
+
+    /**
+    ==================================================================================
+                                        AVX2 kernels
+    ==================================================================================
+    **/
+    #if defined(QUAD_KERNEL_AVX2_SUPPORTED)
+        QUAD_TARGET_AVX2 static uint32 transform_quads_avx2(const QuadTransforms& q, uint32 count, VertexPoint* dest) {
+            uint32 n = 0;
+            for (; n + 8 <= count; n += 8) {
+                __m256 x = _mm256_loadu_ps(q.x + n); __m256 y = _mm256_loadu_ps(q.y + n);
+                __m256 c = _mm256_loadu_ps(q.c + n); __m256 s = _mm256_loadu_ps(q.s + n);
+                __m256 l = _mm256_loadu_ps(q.left + n); __m256 t = _mm256_loadu_ps(q.top + n);
+                __m256 r = _mm256_loadu_ps(q.right + n); __m256 b = _mm256_loadu_ps(q.bottom + n);
+
+                __m256 cl = _mm256_mul_ps(c, l); __m256 ct = _mm256_mul_ps(c, t); __m256 cr = _mm256_mul_ps(c, r); __m256 cb = _mm256_mul_ps(c, b);
+                __m256 sl = _mm256_mul_ps(s, l); __m256 st = _mm256_mul_ps(s, t); __m256 sr = _mm256_mul_ps(s, r); __m256 sb = _mm256_mul_ps(s, b);
+
+                __m256 px[4]; __m256 py[4];
+                px[0] = _mm256_add_ps(x, _mm256_sub_ps(cl, st)); py[0] = _mm256_add_ps(y, _mm256_add_ps(sl, ct));
+                px[1] = _mm256_add_ps(x, _mm256_sub_ps(cr, st)); py[1] = _mm256_add_ps(y, _mm256_add_ps(sr, ct));
+                px[2] = _mm256_add_ps(x, _mm256_sub_ps(cr, sb)); py[2] = _mm256_add_ps(y, _mm256_add_ps(sr, cb));
+                px[3] = _mm256_add_ps(x, _mm256_sub_ps(cl, sb)); py[3] = _mm256_add_ps(y, _mm256_add_ps(sl, cb));
+
+                //store the low 4 quads then the high 4 quads
+                VertexPoint* v = dest + (n * 4);
+                for (int i = 0; i < 4; ++i) {
+                    store_corners_sse(_mm256_castps256_ps128(px[i]), _mm256_castps256_ps128(py[i]), v + i);
+                    store_corners_sse(_mm256_extractf128_ps(px[i], 1), _mm256_extractf128_ps(py[i], 1), v + 16 + i);
+                }
+            }
+            _mm256_zeroupper();
+            return n;
+        }
+
+        QUAD_TARGET_AVX2 static uint32 convert_quad_colours_avx2(const float* colours, uint32 count, VertexPoint* dest) {
+            const __m256 scale = _mm256_set1_ps(255.0f);
+            const __m256i mask = _mm256_set1_epi32(0xff);
+            //the packs below work within each 128 bit lane, leaving quads in 0, 2, 4, 6, 1, 3, 5, 7 order
+            const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+            uint32 n = 0;
+            for (; n + 8 <= count; n += 8) {
+                const float* colour = colours + (n * 4);
+                __m256i c0 = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(colour), scale)), mask);
+                __m256i c1 = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(colour + 8), scale)), mask);
+                __m256i c2 = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(colour + 16), scale)), mask);
+                __m256i c3 = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(colour + 24), scale)), mask);
+
+                __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(c0, c1), _mm256_packs_epi32(c2, c3));
+
+                uint32 rgba[8];
+                _mm256_storeu_si256((__m256i*)rgba, _mm256_permutevar8x32_epi32(packed, order));
+                store_quad_colours(rgba, 8, dest + (n * 4));
+            }
+            _mm256_zeroupper();
+            return n;
+        }
+
+        static bool cpu_supports_avx2() {
+            #if defined(_MSC_VER)
+                int info[4];
+                __cpuid(info, 0);
+                if (info[0] < 7) return false;
+
+                //avx needs osxsave so that the os saves the ymm registers
+                __cpuid(info, 1);
+                if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+                if ((_xgetbv(0) & 6) != 6) return false;
+
+                __cpuidex(info, 7, 0);
+                return (info[1] & (1 << 5)) != 0;
+            #else
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx2") != 0;
+            #endif
+        }
+    #endif
+
+    /**
+    ==================================================================================
+                                        NEON kernels
+    ==================================================================================
+    **/
+    #if defined(QUAD_KERNEL_NEON_SUPPORTED)
+        static inline void store_corners_neon(float32x4_t px, float32x4_t py, VertexPoint* v) {
+            float32x4x2_t xy = vzipq_f32(px, py);
+            vst1_f32(&v[0].pos.x, vget_low_f32(xy.val[0]));
+            vst1_f32(&v[4].pos.x, vget_high_f32(xy.val[0]));
+            vst1_f32(&v[8].pos.x, vget_low_f32(xy.val[1]));
+            vst1_f32(&v[12].pos.x, vget_high_f32(xy.val[1]));
+        }
+
+        //note: armv7 neon flushes denormals to zero, so results only differ from the scalar kernel for denormals
+        static uint32 transform_quads_neon(const QuadTransforms& q, uint32 count, VertexPoint* dest) {
+            uint32 n = 0;
+            for (; n + 4 <= count; n += 4) {
+                float32x4_t x = vld1q_f32(q.x + n); float32x4_t y = vld1q_f32(q.y + n);
+                float32x4_t c = vld1q_f32(q.c + n); float32x4_t s = vld1q_f32(q.s + n);
+                float32x4_t l = vld1q_f32(q.left + n); float32x4_t t = vld1q_f32(q.top + n);
+                float32x4_t r = vld1q_f32(q.right + n); float32x4_t b = vld1q_f32(q.bottom + n);
+
+                float32x4_t cl = vmulq_f32(c, l); float32x4_t ct = vmulq_f32(c, t); float32x4_t cr = vmulq_f32(c, r); float32x4_t cb = vmulq_f32(c, b);
+                float32x4_t sl = vmulq_f32(s, l); float32x4_t st = vmulq_f32(s, t); float32x4_t sr = vmulq_f32(s, r); float32x4_t sb = vmulq_f32(s, b);
+
+                VertexPoint* v = dest + (n * 4);
+                store_corners_neon(vaddq_f32(x, vsubq_f32(cl, st)), vaddq_f32(y, vaddq_f32(sl, ct)), v);
+                store_corners_neon(vaddq_f32(x, vsubq_f32(cr, st)), vaddq_f32(y, vaddq_f32(sr, ct)), v + 1);
+                store_corners_neon(vaddq_f32(x, vsubq_f32(cr, sb)), vaddq_f32(y, vaddq_f32(sr, cb)), v + 2);
+                store_corners_neon(vaddq_f32(x, vsubq_f32(cl, sb)), vaddq_f32(y, vaddq_f32(sl, cb)), v + 3);
+            }
+            return n;
+        }
+
+        static uint32 convert_quad_colours_neon(const float* colours, uint32 count, VertexPoint* dest) {
+            const float32x4_t scale = vdupq_n_f32(255.0f);
+            const int32x4_t mask = vdupq_n_s32(0xff);
+
+            uint32 n = 0;
+            for (; n + 4 <= count; n += 4) {
+                const float* colour = colours + (n * 4);
+                int32x4_t c0 = vandq_s32(vcvtq_s32_f32(vmulq_f32(vld1q_f32(colour), scale)), mask);
+                int32x4_t c1 = vandq_s32(vcvtq_s32_f32(vmulq_f32(vld1q_f32(colour + 4), scale)), mask);
+                int32x4_t c2 = vandq_s32(vcvtq_s32_f32(vmulq_f32(vld1q_f32(colour + 8), scale)), mask);
+                int32x4_t c3 = vandq_s32(vcvtq_s32_f32(vmulq_f32(vld1q_f32(colour + 12), scale)), mask);
+
+                uint16x8_t lo = vreinterpretq_u16_s16(vcombine_s16(vmovn_s32(c0), vmovn_s32(c1)));
+                uint16x8_t hi = vreinterpretq_u16_s16(vcombine_s16(vmovn_s32(c2), vmovn_s32(c3)));
+
+                uint32 rgba[4];
+                vst1q_u8((uint8_t*)rgba, vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+                store_quad_colours(rgba, 4, dest + (n * 4));
+            }
+            return n;
+        }
+    #endif
+
+    /**
+    ==================================================================================
+                                          Dispatch
+    ==================================================================================
+    **/
+    static QuadKernel detect_quad_kernel() {
+        //avx2 isn't picked by default, as the wider stores didn't make add_many any faster than sse
+        if (is_quad_kernel_supported(QUAD_KERNEL_SSE)) return QUAD_KERNEL_SSE;
+        if (is_quad_kernel_supported(QUAD_KERNEL_NEON)) return QUAD_KERNEL_NEON;
+        return QUAD_KERNEL_SCALAR;
+    }
+
+    static QuadKernel current_kernel = detect_quad_kernel();
+
+    bool is_quad_kernel_supported(QuadKernel kernel) {
+        switch (kernel) {
+            case QUAD_KERNEL_SCALAR:
+                return true;
+            #if defined(QUAD_KERNEL_SSE_SUPPORTED)
+                case QUAD_KERNEL_SSE:
+                    return true;
+            #endif
+            #if defined(QUAD_KERNEL_AVX2_SUPPORTED)
+                case QUAD_KERNEL_AVX2: {
+                    static bool avx2 = cpu_supports_avx2();
+                    return avx2;
+                }
+            #endif
+            #if defined(QUAD_KERNEL_NEON_SUPPORTED)
+                case QUAD_KERNEL_NEON:
+                    return true;
+            #endif
+            default:
+                return false;
+        }
+    }
+
+    QuadKernel get_quad_kernel() {
+        return current_kernel;
+    }
+
+    void set_quad_kernel(QuadKernel kernel) {
+        if (is_quad_kernel_supported(kernel)) current_kernel = kernel;
+    }
+
+    void transform_quads(const QuadTransforms& quads, uint32 count, VertexPoint* dest, QuadKernel kernel) {
+        if (!is_quad_kernel_supported(kernel)) kernel = QUAD_KERNEL_SCALAR;
+
+        //the simd kernels handle whole groups of quads and leave the remainder to the scalar kernel
+        uint32 done = 0;
+        switch (kernel) {
+            #if defined(QUAD_KERNEL_SSE_SUPPORTED)
+                case QUAD_KERNEL_SSE: done = transform_quads_sse(quads, count, dest); break;
+            #endif
+            #if defined(QUAD_KERNEL_AVX2_SUPPORTED)
+                case QUAD_KERNEL_AVX2: done = transform_quads_avx2(quads, count, dest); break;
+            #endif
+            #if defined(QUAD_KERNEL_NEON_SUPPORTED)
+                case QUAD_KERNEL_NEON: done = transform_quads_neon(quads, count, dest); break;
+            #endif
+            default: break;
+        }
+        transform_quads_scalar(quads, done, count, dest);
+    }
+
+    void transform_quads(const QuadTransforms& quads, uint32 count, VertexPoint* dest) {
+        transform_quads(quads, count, dest, current_kernel);
+    }
+
+    void convert_quad_colours(const float* colours, uint32 count, VertexPoint* dest, QuadKernel kernel) {
+        if (!is_quad_kernel_supported(kernel)) kernel = QUAD_KERNEL_SCALAR;
+
+        uint32 done = 0;
+        switch (kernel) {
+            #if defined(QUAD_KERNEL_SSE_SUPPORTED)
+                case QUAD_KERNEL_SSE: done = convert_quad_colours_sse(colours, count, dest); break;
+            #endif
+            #if defined(QUAD_KERNEL_AVX2_SUPPORTED)
+                case QUAD_KERNEL_AVX2: done = convert_quad_colours_avx2(colours, count, dest); break;
+            #endif
+            #if defined(QUAD_KERNEL_NEON_SUPPORTED)
+                case QUAD_KERNEL_NEON: done = convert_quad_colours_neon(colours, count, dest); break;
+            #endif
+            default: break;
+        }
+        convert_quad_colours_scalar(colours, done, count, dest);
+    }
+
+    void convert_quad_colours(const float* colours, uint32 count, VertexPoint* dest) {
+        convert_quad_colours(colours, count, dest, current_kernel);
+    }
+}};
@@ -0,0 +1,455 @@
+#include "graphics/RectPacker.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace pxl { namespace graphics {
+
+    //cpp constants (hidden from public)
+    #define MIN_SHEET_GROWTH 16                                             //fewest pixels a sheet grows by when the rects don't fit
+
+    RectPacker::RectPacker() {
+        width = 0;
+        height = 0;
+        bin_width = 0;
+        bin_height = 0;
+        used_area = 0;
+    }
+
+    void RectPacker::init(uint32 sheet_width, uint32 sheet_height, const PackSettings& pack_settings) {
+        settings = pack_settings;
+        width = sheet_width;
+        height = sheet_height;
+        used_area = 0;
+
+        //every rect is padded on its right and bottom, padding the bin to match means rects can touch the far edges
+        bin_width = sheet_width + settings.padding;
+        bin_height = sheet_height + settings.padding;
+
+        free_areas.clear();
+        used_areas.clear();
+        skyline.clear();
+        if (settings.method == PACK_MAX_RECTS) {
+            Area area = { 0, 0, bin_width, bin_height };
+            free_areas.push_back(area);
+        }else {
+            SkylineNode node = { 0, 0, bin_width };
+            skyline.push_back(node);
+        }
+    }
+
+    bool RectPacker::insert(uint32 w, uint32 h, PackedRect& rect) {
+        rect.packed = false;
+        rect.rotated = false;
+        rect.w = w;
+        rect.h = h;
+        if (w == 0 || h == 0) {
+            rect.x = rect.y = 0;
+            rect.packed = true;
+            return true;
+        }
+
+        int32 padded_w = w + settings.padding, padded_h = h + settings.padding;
+        Area area;
+        bool rotated;
+        if (settings.method == PACK_MAX_RECTS) {
+            if (!find_max_rects(padded_w, padded_h, area, rotated)) return false;
+            place_max_rects(area);
+        }else {
+            size_t node_index;
+            if (!find_skyline(padded_w, padded_h, area, rotated, node_index)) return false;
+            place_skyline(node_index, area);
+        }
+
+        rect.x = area.x;
+        rect.y = area.y;
+        rect.rotated = rotated;
+        if (rotated) std::swap(rect.w, rect.h);
+        rect.packed = true;
+        used_area += uint64(w) * h;
+        return true;
+    }
+
+    bool RectPacker::can_insert(uint32 w, uint32 h) const {
+        if (w == 0 || h == 0) return true;
+
+        int32 padded_w = w + settings.padding, padded_h = h + settings.padding;
+        Area area;
+        bool rotated;
+        if (settings.method == PACK_MAX_RECTS) return find_max_rects(padded_w, padded_h, area, rotated);
+        size_t node_index;
+        return find_skyline(padded_w, padded_h, area, rotated, node_index);
+    }
+
+    // ------------------------------------------------------------------------------------------------
+    // max rects
+    // ------------------------------------------------------------------------------------------------
+
+    bool RectPacker::find_max_rects(int32 w, int32 h, Area& area, bool& rotated) const {
+        //best short side fit, ties broken by the long side
+        int32 best_short = INT_MAX, best_long = INT_MAX;
+        for (size_t n = 0; n < free_areas.size(); ++n) {
+            const Area& free_area = free_areas[n];
+            for (int turn = 0; turn < (settings.allow_rotation ? 2 : 1); ++turn) {
+                int32 rw = turn ? h : w, rh = turn ? w : h;
+                if (rw > free_area.w || rh > free_area.h) continue;
+
+                int32 left_w = free_area.w - rw, left_h = free_area.h - rh;
+                int32 short_side = std::min(left_w, left_h), long_side = std::max(left_w, left_h);
+                if (short_side < best_short || (short_side == best_short && long_side < best_long)) {
+                    best_short = short_side;
+                    best_long = long_side;
+                    area.x = free_area.x;
+                    area.y = free_area.y;
+                    area.w = rw;
+                    area.h = rh;
+                    rotated = turn != 0;
+                }
+            }
+        }
+        return best_short != INT_MAX;
+    }
+
+    void RectPacker::place_max_rects(const Area& used) {
+        used_areas.push_back(used);
+        split_free_areas(used);
+    }
+
+    void RectPacker::split_free_areas(const Area& used) {
+        //split every free area the placed rect overlaps into the (up to 4) areas around it
+        size_t num_areas = free_areas.size();
+        for (size_t n = 0; n < num_areas;) {
+            Area free_area = free_areas[n];
+            if (used.x >= free_area.x + free_area.w || used.x + used.w <= free_area.x ||
+                used.y >= free_area.y + free_area.h || used.y + used.h <= free_area.y) {
+                ++n;
+                continue;
+            }
+
+            if (used.x > free_area.x) {
+                Area left = { free_area.x, free_area.y, used.x - free_area.x, free_area.h };
+                free_areas.push_back(left);
+            }
+            if (used.x + used.w < free_area.x + free_area.w) {
+                Area right = { used.x + used.w, free_area.y, free_area.x + free_area.w - (used.x + used.w), free_area.h };
+                free_areas.push_back(right);
+            }
+            if (used.y > free_area.y) {
+                Area top = { free_area.x, free_area.y, free_area.w, used.y - free_area.y };
+                free_areas.push_back(top);
+            }
+            if (used.y + used.h < free_area.y + free_area.h) {
+                Area bottom = { free_area.x, used.y + used.h, free_area.w, free_area.y + free_area.h - (used.y + used.h) };
+                free_areas.push_back(bottom);
+            }
+
+            //the split area is swapped with the last of the areas that were there before the split
+            free_areas[n] = free_areas[num_areas - 1];
+            free_areas.erase(free_areas.begin() + (num_areas - 1));
+            --num_areas;
+        }
+
+        prune_free_areas();
+    }
+
+    void RectPacker::prune_free_areas() {
+        //drop any free area that's inside another, they'd only ever give worse fits
+        for (size_t i = 0; i < free_areas.size(); ++i) {
+            for (size_t j = i + 1; j < free_areas.size(); ++j) {
+                const Area& a = free_areas[i];
+                const Area& b = free_areas[j];
+                if (a.x >= b.x && a.y >= b.y && a.x + a.w <= b.x + b.w && a.y + a.h <= b.y + b.h) {
+                    free_areas.erase(free_areas.begin() + i);
+                    --i;
+                    break;
+                }
+                if (b.x >= a.x && b.y >= a.y && b.x + b.w <= a.x + a.w && b.y + b.h <= a.y + a.h) {
+                    free_areas.erase(free_areas.begin() + j);
+                    --j;
+                }
+            }
+        }
+    }
+
+    bool RectPacker::remove(const PackedRect& rect) {
+        Area freed;
+        if (!remove_used_area(rect, freed)) return false;
+        join_free_area(freed);
+        return true;
+    }
+
+    uint32 RectPacker::remove(const std::vector<PackedRect>& rects) {
+        uint32 num_removed = 0;
+        Area freed;
+        for (size_t n = 0; n < rects.size(); ++n) {
+            if (remove_used_area(rects[n], freed)) ++num_removed;
+        }
+        if (num_removed != 0) rebuild_free_areas();
+        return num_removed;
+    }
+
+    bool RectPacker::remove_used_area(const PackedRect& rect, Area& freed) {
+        if (settings.method != PACK_MAX_RECTS || !rect.packed || rect.w == 0 || rect.h == 0) return false;
+
+        size_t index = 0;
+        while (index < used_areas.size() && (used_areas[index].x != int32(rect.x) || used_areas[index].y != int32(rect.y))) ++index;
+        if (index == used_areas.size()) return false;
+        freed = used_areas[index];
+        used_areas[index] = used_areas.back();
+        used_areas.pop_back();
+        used_area -= uint64(rect.w) * rect.h;
+        return true;
+    }
+
+    void RectPacker::join_free_area(const Area& freed) {
+        //two free areas that touch leave free the area spanning both across the rows (or columns) they share. joining
+        //the freed area with every area it touches, and each area that makes with every other, until nothing new
+        //comes out grows it into every biggest free area it's part of. areas that were there already don't need
+        //joining with each other, as they were already as big as they could be
+        join_queue.clear();
+        join_queue.push_back(freed);
+        while (!join_queue.empty()) {
+            Area area = join_queue.back();
+            join_queue.pop_back();
+            if (is_inside_free_area(area)) continue;
+
+            size_t num_areas = free_areas.size();
+            free_areas.push_back(area);
+            for (size_t n = 0; n < num_areas; ++n) {
+                const Area& other = free_areas[n];
+                int32 x0 = std::max(area.x, other.x), x1 = std::min(area.x + area.w, other.x + other.w);
+                int32 y0 = std::max(area.y, other.y), y1 = std::min(area.y + area.h, other.y + other.h);
+                if (x0 > x1 || y0 > y1) continue;
+
+                if (y0 < y1) {
+                    int32 left = std::min(area.x, other.x);
+                    Area joined = { left, y0, std::max(area.x + area.w, other.x + other.w) - left, y1 - y0 };
+                    join_queue.push_back(joined);
+                }
+                if (x0 < x1) {
+                    int32 top = std::min(area.y, other.y);
+                    Area joined = { x0, top, x1 - x0, std::max(area.y + area.h, other.y + other.h) - top };
+                    join_queue.push_back(joined);
+                }
+            }
+        }
+
+        prune_free_areas();
+        sort_free_areas();
+    }
+
+    bool RectPacker::is_inside_free_area(const Area& area) const {
+        for (size_t n = 0; n < free_areas.size(); ++n) {
+            const Area& b = free_areas[n];
+            if (area.x >= b.x && area.y >= b.y && area.x + area.w <= b.x + b.w && area.y + area.h <= b.y + b.h) return true;
+        }
+        return false;
+    }
+
+    void RectPacker::sort_free_areas() {
+        //fits are searched in list order with ties going to the first, so however the areas were found they're
+        //put in the same order to place rects the same way
+        std::sort(free_areas.begin(), free_areas.end(), [](const Area& a, const Area& b) {
+            if (a.y != b.y) return a.y < b.y;
+            if (a.x != b.x) return a.x < b.x;
+            if (a.w != b.w) return a.w < b.w;
+            return a.h < b.h;
+        });
+    }
+
+    void RectPacker::rebuild_free_areas() {
+        //free areas overlap each other, so freed rects can't just be joined back in. splitting the whole bin
+        //around every rect that's left gives the same free areas as if the removed rects were never placed
+        free_areas.clear();
+        Area bin = { 0, 0, bin_width, bin_height };
+        free_areas.push_back(bin);
+        for (size_t n = 0; n < used_areas.size(); ++n) split_free_areas(used_areas[n]);
+        sort_free_areas();
+    }
+
+    uint64 RectPacker::get_largest_free_area() const {
+        uint64 largest = 0;
+        for (size_t n = 0; n < free_areas.size(); ++n) {
+            //free areas are padded on their right and bottom like the rects that fill them
+            uint64 w = std::max(free_areas[n].w - int32(settings.padding), 0);
+            uint64 h = std::max(free_areas[n].h - int32(settings.padding), 0);
+            largest = std::max(largest, w * h);
+        }
+        return largest;
+    }
+
+    // ------------------------------------------------------------------------------------------------
+    // skyline
+    // ------------------------------------------------------------------------------------------------
+
+    bool RectPacker::fit_skyline(size_t node_index, int32 w, int32 h, int32& y) const {
+        //a rect at this node rests on the highest node it spans
+        int32 x = skyline[node_index].x;
+        if (x + w > bin_width) return false;
+
+        y = 0;
+        int32 width_left = w;
+        for (size_t n = node_index; width_left > 0; ++n) {
+            y = std::max(y, skyline[n].y);
+            if (y + h > bin_height) return false;
+            width_left -= skyline[n].w;
+        }
+        return true;
+    }
+
+    bool RectPacker::find_skyline(int32 w, int32 h, Area& area, bool& rotated, size_t& node_index) const {
+        //bottom left, the lowest top edge wins and ties go to the narrowest node
+        int32 best_top = INT_MAX, best_width = INT_MAX;
+        for (size_t n = 0; n < skyline.size(); ++n) {
+            for (int turn = 0; turn < (settings.allow_rotation ? 2 : 1); ++turn) {
+                int32 rw = turn ? h : w, rh = turn ? w : h;
+                int32 y;
+                if (!fit_skyline(n, rw, rh, y)) continue;
+
+                if (y + rh < best_top || (y + rh == best_top && skyline[n].w < best_width)) {
+                    best_top = y + rh;
+                    best_width = skyline[n].w;
+                    area.x = skyline[n].x;
+                    area.y = y;
+                    area.w = rw;
+                    area.h = rh;
+                    rotated = turn != 0;
+                    node_index = n;
+                }
+            }
+        }
+        return best_top != INT_MAX;
+    }
+
+    void RectPacker::place_skyline(size_t node_index, const Area& area) {
+        SkylineNode node = { area.x, area.y + area.h, area.w };
+        skyline.insert(skyline.begin() + node_index, node);
+
+        //shrink or remove the nodes the new one now covers
+        for (size_t n = node_index + 1; n < skyline.size();) {
+            SkylineNode& prev = skyline[n - 1];
+            int32 overlap = prev.x + prev.w - skyline[n].x;
+            if (overlap <= 0) break;
+            if (skyline[n].w > overlap) {
+                skyline[n].x += overlap;
+                skyline[n].w -= overlap;
+                break;
+            }
+            skyline.erase(skyline.begin() + n);
+        }
+
+        //join neighbours at the same height
+        for (size_t n = 1; n < skyline.size();) {
+            if (skyline[n - 1].y == skyline[n].y) {
+                skyline[n - 1].w += skyline[n].w;
+                skyline.erase(skyline.begin() + n);
+            }else {
+                ++n;
+            }
+        }
+    }
+
+    // ------------------------------------------------------------------------------------------------
+    // packing whole sets
+    // ------------------------------------------------------------------------------------------------
+
+    static uint32 next_power_of_two(uint32 v) {
+        uint32 p = 1;
+        while (p < v && p < 0x80000000u) p <<= 1;
+        return p;
+    }
+
+    /** Orders rects by their longest side then their shortest, biggest first
+    **/
+    struct PackOrder {
+
+        const std::vector<PackedRect>* rects;
+
+        bool operator()(uint32 a, uint32 b) const {
+            const PackedRect& ra = (*rects)[a];
+            const PackedRect& rb = (*rects)[b];
+            uint32 long_a = std::max(ra.w, ra.h), long_b = std::max(rb.w, rb.h);
+            if (long_a != long_b) return long_a > long_b;
+            return std::min(ra.w, ra.h) > std::min(rb.w, rb.h);
+        }
+    };
+
+    bool RectPacker::pack(std::vector<PackedRect>& rects, const PackSettings& pack_settings) {
+        //rotated rects from an earlier pack are put back to the size they were given
+        uint64 total_area = 0;
+        uint32 min_width = 1, min_height = 1;
+        std::vector<uint32> order(rects.size());
+        for (size_t n = 0; n < rects.size(); ++n) {
+            PackedRect& rect = rects[n];
+            if (rect.rotated) std::swap(rect.w, rect.h);
+            rect.rotated = false;
+            rect.packed = false;
+            order[n] = n;
+
+            uint32 w = rect.w + pack_settings.padding, h = rect.h + pack_settings.padding;
+            total_area += uint64(w) * h;
+            uint32 fit_w = pack_settings.allow_rotation ? std::min(rect.w, rect.h) : rect.w;
+            uint32 fit_h = pack_settings.allow_rotation ? std::min(rect.w, rect.h) : rect.h;
+            min_width = std::max(min_width, fit_w);
+            min_height = std::max(min_height, fit_h);
+        }
+        PackOrder pack_order = { &rects };
+        std::stable_sort(order.begin(), order.end(), pack_order);
+
+        //start from a square of the total area and grow the shorter side until everything fits
+        uint32 side = uint32(std::ceil(std::sqrt(double(total_area))));
+        uint32 w = std::min(std::max(side, min_width), pack_settings.max_width);
+        uint32 h = std::min(std::max(side, min_height), pack_settings.max_height);
+        if (pack_settings.power_of_two) {
+            w = std::min(next_power_of_two(w), pack_settings.max_width);
+            h = std::min(next_power_of_two(h), pack_settings.max_height);
+        }
+
+        //sizes as given, since a failed attempt can leave rects rotated
+        std::vector<PackedRect> sizes(rects);
+        bool all_packed;
+        while (true) {
+            init(w, h, pack_settings);
+            all_packed = true;
+            for (size_t n = 0; n < order.size(); ++n) {
+                const PackedRect& size = sizes[order[n]];
+                if (!insert(size.w, size.h, rects[order[n]])) all_packed = false;
+            }
+            if (all_packed || (w >= pack_settings.max_width && h >= pack_settings.max_height)) break;
+
+            bool grow_width = (w <= h && w < pack_settings.max_width) || h >= pack_settings.max_height;
+            uint32& grow = grow_width ? w : h;
+            uint32 grow_max = grow_width ? pack_settings.max_width : pack_settings.max_height;
+            grow = std::min(pack_settings.power_of_two ? grow * 2 : grow + std::max(grow / 8, uint32(MIN_SHEET_GROWTH)), grow_max);
+        }
+
+        //crop the sheet to the rects that were placed
+        uint32 used_w = 0, used_h = 0;
+        for (size_t n = 0; n < rects.size(); ++n) {
+            if (!rects[n].packed) continue;
+            used_w = std::max(used_w, rects[n].x + rects[n].w);
+            used_h = std::max(used_h, rects[n].y + rects[n].h);
+        }
+        if (pack_settings.power_of_two) {
+            used_w = next_power_of_two(used_w);
+            used_h = next_power_of_two(used_h);
+        }
+        width = std::min(width, std::max(used_w, uint32(1)));
+        height = std::min(height, std::max(used_h, uint32(1)));
+
+        //clip what's left free to the cropped sheet, so rects inserted afterwards stay inside it
+        bin_width = width + settings.padding;
+        bin_height = height + settings.padding;
+        for (size_t n = 0; n < free_areas.size();) {
+            Area& area = free_areas[n];
+            area.w = std::min(area.w, bin_width - area.x);
+            area.h = std::min(area.h, bin_height - area.y);
+            if (area.w <= 0 || area.h <= 0) free_areas.erase(free_areas.begin() + n);
+            else ++n;
+        }
+        while (!skyline.empty() && skyline.back().x >= bin_width) skyline.pop_back();
+        if (!skyline.empty()) skyline.back().w = bin_width - skyline.back().x;
+        return all_packed;
+    }
+}};
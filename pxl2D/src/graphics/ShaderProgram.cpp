@@ -1,4 +1,5 @@
 #include "graphics/ShaderProgram.h"
+#include "graphics/GLState.h"
 #include "system/Debug.h"
 #include "system/Exception.h"
 
@@ -33,6 +34,10 @@ namespace pxl { namespace graphics {
             glBindAttribLocation(program_id, 0, "a_position");
             glBindAttribLocation(program_id, 1, "a_tex_coord");
             glBindAttribLocation(program_id, 2, "a_colour");
+            //per instance attribs used by instanced vertex shaders
+            glBindAttribLocation(program_id, 3, "a_bounds");
+            glBindAttribLocation(program_id, 4, "a_rotation");
+            glBindAttribLocation(program_id, 5, "a_depth");
 
             glLinkProgram(program_id);
 
@@ -56,6 +61,10 @@ namespace pxl { namespace graphics {
 	    glDeleteShader(fragment_id);
     }
 
+    void ShaderProgram::bind() {
+	    use_program(program_id);
+    }
+
     bool ShaderProgram::compile(GLuint shader_id, int shader_type, std::string shader_name) {
 	    GLint compiled;
 	    glGetShaderiv(shader_id, GL_COMPILE_STATUS, &compiled);
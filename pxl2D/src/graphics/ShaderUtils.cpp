@@ -1,5 +1,8 @@
 #include "graphics/ShaderUtils.h"
+#include <cstring>
 #include <fstream>
+#include <limits>
+#include <map>
 #include "graphics/Batch.h"
 #include "graphics/PrebuiltShaders.h"
 #include "system/Debug.h"
@@ -20,7 +23,11 @@ namespace pxl { namespace graphics {
     ShaderProgram* outline_shader;
     ShaderProgram* glow_shader;
     ShaderProgram* text_shader;
+    ShaderProgram* sdf_text_shader;
     ShaderProgram* point_light_shader;
+    ShaderProgram* default_instanced_shader;
+
+    std::map<ShaderProgram*, ShaderProgram*> instanced_shaders;
 
     const void init_shader() {
 	    //setup premade pxl glsl shaders
@@ -32,51 +39,94 @@ namespace pxl { namespace graphics {
 	    outline_shader = create_shader(basic_vertex_shader_str, outline_shader_str, "default_vert", "outline_frag");
 	    glow_shader = create_shader(basic_vertex_shader_str, glow_shader_str, "default_vert", "glow_frag");
         text_shader = create_shader(basic_vertex_shader_str, text_shader_str, "default_vert", "text_frag");
+        sdf_text_shader = create_shader(basic_vertex_shader_str, sdf_text_shader_str, "default_vert", "sdf_text_frag");
         //point_light_shader = create_shader(basic_vertex_shader_str, point_light_shader_str, "default_vert", "point_light_frag");
+
+        //setup instanced variants, which share the fragment shaders
+        default_instanced_shader = create_shader(instanced_vertex_shader_str, default_shader_str, "instanced_vert", "default_frag");
+        register_instanced_shader(default_shader, default_instanced_shader);
+        register_instanced_shader(bloom_shader, create_shader(instanced_vertex_shader_str, bloom_shader_str, "instanced_vert", "bloom_frag"));
+        register_instanced_shader(repeat_shader, create_shader(instanced_vertex_shader_str, repeat_shader_str, "instanced_vert", "repeat_frag"));
+        register_instanced_shader(grayscale_shader, create_shader(instanced_vertex_shader_str, grayscale_shader_str, "instanced_vert", "grayscale_frag"));
+        register_instanced_shader(blur_shader, create_shader(instanced_vertex_shader_str, blur_shader_str, "instanced_vert", "blur_frag"));
+        register_instanced_shader(outline_shader, create_shader(instanced_vertex_shader_str, outline_shader_str, "instanced_vert", "outline_frag"));
+        register_instanced_shader(glow_shader, create_shader(instanced_vertex_shader_str, glow_shader_str, "instanced_vert", "glow_frag"));
+        register_instanced_shader(text_shader, create_shader(instanced_vertex_shader_str, text_shader_str, "instanced_vert", "text_frag"));
+        register_instanced_shader(sdf_text_shader, create_shader(instanced_vertex_shader_str, sdf_text_shader_str, "instanced_vert", "sdf_text_frag"));
+    }
+
+    ShaderProgram* get_instanced_shader(ShaderProgram* shader) {
+        if (shader == NULL) return default_instanced_shader;
+
+        std::map<ShaderProgram*, ShaderProgram*>::iterator it = instanced_shaders.find(shader);
+        return it != instanced_shaders.end() ? it->second : NULL;
+    }
+
+    void register_instanced_shader(ShaderProgram* shader, ShaderProgram* instanced_shader) {
+        instanced_shaders[shader] = instanced_shader;
+    }
+
+    /** Binds the instanced variant of a shader and then the shader itself, calling set with each program id so that
+    uniforms are the same whichever way a batch draws. The shader is left bound
+    **/
+    template <typename F> static void set_uniforms(ShaderProgram* shader, F set) {
+        ShaderProgram* instanced = get_instanced_shader(shader);
+        if (instanced != NULL) {
+            instanced->bind();
+            set(instanced->get_program_id());
+        }
+        shader->bind();
+        set(shader->get_program_id());
     }
 
     const void set_default_shader(Batch* batch) {
-	    glUseProgram(default_shader->get_program_id());
+	    default_shader->bind();
     }
 
     const void set_bloom_shader(Batch* batch, float spread, float intensity) {
-	    glUseProgram(bloom_shader->get_program_id());
-	    glUniform1f(glGetUniformLocation(bloom_shader->get_program_id(), "outline_spread"), spread);
-	    glUniform1f(glGetUniformLocation(bloom_shader->get_program_id(), "outline_intensity"), intensity);
+        set_uniforms(bloom_shader, [=](GLuint id) {
+	        glUniform1f(glGetUniformLocation(id, "outline_spread"), spread);
+	        glUniform1f(glGetUniformLocation(id, "outline_intensity"), intensity);
+        });
     }
 
     const void set_repeat_shader(Batch* batch, float repeat_x, float repeat_y) {
-	    glUseProgram(repeat_shader->get_program_id());
-	    glUniform2f(glGetUniformLocation(repeat_shader->get_program_id(), "repeat"), repeat_x, repeat_y);
+        set_uniforms(repeat_shader, [=](GLuint id) {
+	        glUniform2f(glGetUniformLocation(id, "repeat"), repeat_x, repeat_y);
+        });
     }
 
     const void set_grayscale_shader(Batch* batch) {
-	    glUseProgram(grayscale_shader->get_program_id());
+	    grayscale_shader->bind();
     }
 
     const void set_blur_shader(Batch* batch, float spread_x, float spread_y) {
-	    glUseProgram(blur_shader->get_program_id());
-	    glUniform2f(glGetUniformLocation(blur_shader->get_program_id(), "blur_size"), spread_x, spread_y);
+        set_uniforms(blur_shader, [=](GLuint id) {
+	        glUniform2f(glGetUniformLocation(id, "blur_size"), spread_x, spread_y);
+        });
     }
 
     const void set_outline_shader(Batch* batch, float thickness, float r, float g, float b, float a, float threshold) {
-	    glUseProgram(outline_shader->get_program_id());
-	    glUniform1f(glGetUniformLocation(outline_shader->get_program_id(), "outline_thickness"), thickness);
-	    glUniform4f(glGetUniformLocation(outline_shader->get_program_id(), "outline_colour"), r / 255.0f, g / 255.0f, b / 255.0f, a / 255.0f);
-	    glUniform1f(glGetUniformLocation(outline_shader->get_program_id(), "outline_threshold"), threshold);
+        set_uniforms(outline_shader, [=](GLuint id) {
+	        glUniform1f(glGetUniformLocation(id, "outline_thickness"), thickness);
+	        glUniform4f(glGetUniformLocation(id, "outline_colour"), r / 255.0f, g / 255.0f, b / 255.0f, a / 255.0f);
+	        glUniform1f(glGetUniformLocation(id, "outline_threshold"), threshold);
+        });
     }
 
     const void set_glow_shader(Batch* batch, float size, float r, float g, float b, float intensity, float threshold) {
-	    glUseProgram(glow_shader->get_program_id());
-	    glUniform1f(glGetUniformLocation(outline_shader->get_program_id(), "outline_size"), size);
-	    glUniform3f(glGetUniformLocation(outline_shader->get_program_id(), "outline_colour"), r / 255.0f, g / 255.0f, b / 255.0f);
-	    glUniform1f(glGetUniformLocation(outline_shader->get_program_id(), "outline_threshold"), threshold);
-	    glUniform1f(glGetUniformLocation(outline_shader->get_program_id(), "outline_intensity"), intensity);
+        set_uniforms(glow_shader, [=](GLuint id) {
+	        glUniform1f(glGetUniformLocation(id, "outline_size"), size);
+	        glUniform3f(glGetUniformLocation(id, "outline_colour"), r / 255.0f, g / 255.0f, b / 255.0f);
+	        glUniform1f(glGetUniformLocation(id, "outline_threshold"), threshold);
+	        glUniform1f(glGetUniformLocation(id, "outline_intensity"), intensity);
+        });
     }
 
     const void set_text_shader(Batch* batch, float r, float g, float b, float a) {
-	    glUseProgram(text_shader->get_program_id());
-	    glUniform3f(glGetUniformLocation(text_shader->get_program_id(), "text_colour"), r / 255.0f, g / 255.0f, b / 255.0f);
+        set_uniforms(text_shader, [=](GLuint id) {
+	        glUniform3f(glGetUniformLocation(id, "text_colour"), r / 255.0f, g / 255.0f, b / 255.0f);
+        });
     }
 
     ShaderProgram* create_shader(std::string vertex_file, std::string fragment_file) {
@@ -0,0 +1,153 @@
+#include "graphics/StreamBuffer.h"
+#include "system/Debug.h"
+
+namespace pxl { namespace graphics {
+
+    StreamBuffer::StreamBuffer() {
+        #if defined(STREAM_BUFFER_SUPPORTED)
+            for (int n = 0; n < STREAM_BUFFER_NUM_SEGMENTS; ++n) fences[n] = NULL;
+        #endif
+    }
+
+    void StreamBuffer::create(GLenum buffer_target, uint32 buffer_segment_size) {
+        free();
+
+        target = buffer_target;
+        segment_size = buffer_segment_size > 0 ? buffer_segment_size : 1;
+        segment = 0;
+
+        #if defined(STREAM_BUFFER_SUPPORTED)
+            streaming = GLEW_ARB_sync && GLEW_ARB_map_buffer_range;
+            #if defined(GL_MAP_PERSISTENT_BIT)
+                persistent = streaming && GLEW_ARB_buffer_storage;
+            #endif
+        #endif
+
+        glGenBuffers(1, &id);
+        create_storage();
+
+        buffer_created = true;
+    }
+
+    void StreamBuffer::create_storage() {
+        glBindBuffer(target, id);
+
+        #if defined(STREAM_BUFFER_SUPPORTED)
+            if (persistent) {
+                #if defined(GL_MAP_PERSISTENT_BIT)
+                    //buffer storage is immutable, so growing the ring means creating a new buffer
+                    if (persistent_ptr != NULL) {
+                        glUnmapBuffer(target);
+                        glDeleteBuffers(1, &id);
+                        glGenBuffers(1, &id);
+                        glBindBuffer(target, id);
+                    }
+
+                    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+                    glBufferStorage(target, segment_size * STREAM_BUFFER_NUM_SEGMENTS, NULL, flags);
+                    persistent_ptr = (uint8*)glMapBufferRange(target, 0, segment_size * STREAM_BUFFER_NUM_SEGMENTS, flags);
+                #endif
+            }else if (streaming) {
+                glBufferData(target, segment_size * STREAM_BUFFER_NUM_SEGMENTS, NULL, GL_STREAM_DRAW);
+            }
+        #endif
+    }
+
+    void StreamBuffer::wait_fence(uint32 index) {
+        #if defined(STREAM_BUFFER_SUPPORTED)
+            if (fences[index] == NULL) return;
+
+            GLenum result = glClientWaitSync(fences[index], 0, 0);
+            if (result == GL_TIMEOUT_EXPIRED) {
+                //the gpu is still reading from this segment, so block until it has finished
+                ++sync_waits;
+                while (result == GL_TIMEOUT_EXPIRED) {
+                    result = glClientWaitSync(fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+                }
+            }
+            glDeleteSync(fences[index]);
+            fences[index] = NULL;
+        #endif
+    }
+
+    uint8* StreamBuffer::map(uint32 size) {
+        if (!buffer_created) return NULL;
+
+        map_size = size;
+        bytes_uploaded += size;
+
+        if (!streaming) {
+            if (staging.size() < size) staging.resize(size);
+            return &staging[0];
+        }
+
+        if (size > segment_size) {
+            //wait for every segment as the whole ring is recreated, then grow it geometrically
+            for (uint32 n = 0; n < STREAM_BUFFER_NUM_SEGMENTS; ++n) wait_fence(n);
+            while (segment_size < size) segment_size *= 2;
+            segment = 0;
+            create_storage();
+        }
+
+        wait_fence(segment);
+        glBindBuffer(target, id);
+
+        #if defined(STREAM_BUFFER_SUPPORTED)
+            if (persistent) {
+                return persistent_ptr + (segment * segment_size);
+            }
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+            return (uint8*)glMapBufferRange(target, segment * segment_size, size, flags);
+        #else
+            return NULL;
+        #endif
+    }
+
+    uint32 StreamBuffer::unmap() {
+        glBindBuffer(target, id);
+
+        if (!streaming) {
+            glBufferData(target, map_size, &staging[0], GL_DYNAMIC_DRAW);
+            return 0;
+        }
+        if (!persistent) glUnmapBuffer(target);
+
+        return segment * segment_size;
+    }
+
+    void StreamBuffer::fence() {
+        if (!streaming) return;
+
+        #if defined(STREAM_BUFFER_SUPPORTED)
+            fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        #endif
+        segment = (segment + 1) % STREAM_BUFFER_NUM_SEGMENTS;
+    }
+
+    void StreamBuffer::free() {
+        if (buffer_created) {
+            #if defined(STREAM_BUFFER_SUPPORTED)
+                for (int n = 0; n < STREAM_BUFFER_NUM_SEGMENTS; ++n) {
+                    if (fences[n] != NULL) {
+                        glDeleteSync(fences[n]);
+                        fences[n] = NULL;
+                    }
+                }
+            #endif
+            if (persistent_ptr != NULL) {
+                glBindBuffer(target, id);
+                glUnmapBuffer(target);
+                persistent_ptr = NULL;
+            }
+            glDeleteBuffers(1, &id);
+            std::vector<uint8>().swap(staging);
+
+            id = 0;
+            buffer_created = false;
+        }
+    }
+
+    StreamBuffer::~StreamBuffer() {
+        free();
+    }
+}};
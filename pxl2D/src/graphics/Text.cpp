@@ -1,4 +1,5 @@
 #include "graphics/Text.h"
+#include <cmath>
 #include "system/Debug.h"
 
 namespace pxl { namespace graphics {
@@ -25,7 +26,14 @@ namespace pxl { namespace graphics {
     }
 
     bool Text::set_char_pos(int8 symbol, int start_x) {
-	    src_rect = font->get_glyph_rects()[font->get_glyph_index(symbol)];
+	    const Glyph& glyph = font->get_glyph(font->get_glyph_index(symbol));
+	    src_rect = glyph.rect;
+	    glyph_texture = glyph.texture;
+	    glyph_padding = glyph.padding;
+	    if (glyph_padding != 0) {
+		    src_rect.x += glyph_padding; src_rect.y += glyph_padding;
+		    src_rect.w -= glyph_padding * 2; src_rect.h -= glyph_padding * 2;
+	    }
 	    rect.w = src_rect.w * font_scale.x;
 	    rect.h = src_rect.h * font_scale.y;
 	    if (symbol == ' ') {
@@ -35,7 +43,7 @@ namespace pxl { namespace graphics {
 		    rect.x = start_x;
 		    rect.y += (font->get_max_char_height() * font_scale.y) + vertical_kerning;
 		    return true;
-	    }else if (src_rect.w <= 1 && src_rect.h <= 1) {
+	    }else if (glyph_texture == NULL || (src_rect.w <= 1 && src_rect.h <= 1)) {
 		    return true;
 	    }
 
@@ -46,6 +54,7 @@ namespace pxl { namespace graphics {
 	    scaled_max.x = max_width; scaled_max.y = max_height;
 	    if (scale_max_size) { scaled_max.x = max_width * font_scale.x; scaled_max.y = max_height * font_scale.y; }
 
+	    ShaderProgram* shader = font->get_render_mode() == FONT_RENDER_SDF ? sdf_text_shader : text_shader;
 	    rect.x = x; rect.y = y;
 	    float pos_x = 0; float pos_y = 0;
 	    for (size_t n = 0; n < text.length(); ++n) {
@@ -72,8 +81,15 @@ namespace pxl { namespace graphics {
 			    }
 		    }
 
+		    //distance field glyphs are drawn with the field around them, then put back for the layout
+		    float pad_x = glyph_padding * font_scale.x; float pad_y = glyph_padding * font_scale.y;
+		    src_rect.x -= glyph_padding; src_rect.y -= glyph_padding;
+		    src_rect.w += glyph_padding * 2; src_rect.h += glyph_padding * 2;
+		    rect.x -= pad_x; rect.y -= pad_y; rect.w += pad_x * 2; rect.h += pad_y * 2;
+
 		    temp_origin.x = (x + origin.x) - rect.x; temp_origin.y = (y + origin.y) - rect.y;
-		    batch->add(*font->get_glyph_sheet(), &rect, &src_rect, rotation, &temp_origin, NULL, z_depth, colour, text_shader);
+		    batch->add(*glyph_texture, &rect, &src_rect, rotation, &temp_origin, NULL, z_depth, colour, shader);
+		    rect.x += pad_x; rect.y += pad_y;
 		    rect.x += offset_x;
 	    }
     }
@@ -1,21 +1,40 @@
 #include "graphics/Texture.h"
+#include "graphics/GLState.h"
 #include "system/Debug.h"
 
 namespace pxl { namespace graphics {
 
+    /** Gets the largest unpack alignment that every row of a layout keeps to, as rows are packed with no padding
+    **/
+    static inline int get_unpack_alignment(const Channel& channel) {
+	    if (channel.bytes_per_pixel % 4 == 0) return 4;
+	    if (channel.bytes_per_pixel % 2 == 0) return 2;
+	    return 1;
+    }
+
     Texture::Texture() {
 	    texture_created = false;
+	    channel = CHANNEL_RGBA;
     }
 
-    bool Texture::create_texture(std::string file_path) {
+    bool Texture::create_texture(std::string file_path, bool premultiply_alpha) {
         bool success = false;
 
-	    //creates a bitmap from the specified file path and checks if it is valid
-        Bitmap* bitmap = new Bitmap();
-	    if (bitmap->create_bitmap(file_path)) {
-		    success = create_texture(bitmap);
+	    //pxt containers hold pixels ready to upload, so they skip the bitmap entirely
+	    const std::string extension = TEXTURE_CONTAINER_EXTENSION;
+	    if (file_path.size() >= extension.size() && file_path.compare(file_path.size() - extension.size(), extension.size(), extension) == 0) {
+		    sys::TextureContainer container;
+		    if (container.open(file_path)) success = create_texture(container);
+		    return success;
+	    }
+
+	    //creates a bitmap from the specified file path and checks if it is valid. its pixels go back to the pixel pool
+	    //when it goes out of scope, ready for the next load
+        Bitmap bitmap;
+	    bool loaded = premultiply_alpha ? bitmap.create_bitmap(file_path, CHANNEL_RGBA_PREMULTIPLIED) : bitmap.create_bitmap(file_path);
+	    if (loaded) {
+		    success = create_texture(&bitmap);
 	    }
-        delete bitmap;
 
         return success;
     }
@@ -32,6 +51,31 @@ namespace pxl { namespace graphics {
 	    return texture_created;
     }
 
+    bool Texture::create_texture(sys::TextureContainer& container) {
+	    texture_created = false;
+	    const uint8* pixels = container.get_mip_pixels(0);
+	    if (pixels == NULL) {
+            sys::show_exception("Could not create texture, the texture container has no pixels", ERROR_TEXTURE_CREATION_FAILED);
+		    return false;
+	    }
+
+	    has_transparency = container.has_transparency();
+	    create_texture(container.get_width(), container.get_height(), (uint8*)pixels, container.get_channel());
+
+	    //gles2 can only sample with mipmaps if every level down to 1x1 is there, so partial chains only upload the base
+	    if (container.get_num_mips() > 1 && container.has_full_mip_chain()) {
+		    for (uint32 level = 1; level < container.get_num_mips(); ++level) {
+			    pixels = container.get_mip_pixels(level);
+			    if (pixels == NULL) return texture_created;
+
+			    glTexImage2D(GL_TEXTURE_2D, level, channel.gl_pixel_mode, container.get_mip_width(level), container.get_mip_height(level), 0,
+						     channel.gl_pixel_mode, channel.gl_pixel_type, pixels);
+		    }
+		    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	    }
+	    return texture_created;
+    }
+
     bool Texture::create_texture(int w, int h, uint8* pixels, Channel pixel_channel) {
 	    if (w <= 0 || h <= 0) {
             sys::show_exception("Could not create texture, width/height are less than 0", ERROR_TEXTURE_CREATION_FAILED);
@@ -42,12 +86,12 @@ namespace pxl { namespace graphics {
 	    height = h;
 	    channel = pixel_channel;
 
-	    glPixelStorei(GL_UNPACK_ALIGNMENT, channel.num_channels);
+	    glPixelStorei(GL_UNPACK_ALIGNMENT, get_unpack_alignment(channel));
 
 	    if (!texture_created) { glGenTextures(1, &id); }
 
 	    bind();
-	    glTexImage2D(GL_TEXTURE_2D, 0, channel.gl_pixel_mode, width, height, 0, channel.gl_pixel_mode, GL_UNSIGNED_BYTE, pixels);
+	    glTexImage2D(GL_TEXTURE_2D, 0, channel.gl_pixel_mode, width, height, 0, channel.gl_pixel_mode, channel.gl_pixel_type, pixels);
 	    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
@@ -60,22 +104,28 @@ namespace pxl { namespace graphics {
 
     void Texture::update_data(uint8* pixels) {
 	    bind();
-	    glPixelStorei(GL_UNPACK_ALIGNMENT, channel.num_channels);
-	    glTexImage2D(GL_TEXTURE_2D, 0, channel.gl_pixel_mode, width, height, 0, channel.gl_pixel_mode, GL_UNSIGNED_BYTE, pixels);
+	    glPixelStorei(GL_UNPACK_ALIGNMENT, get_unpack_alignment(channel));
+	    glTexImage2D(GL_TEXTURE_2D, 0, channel.gl_pixel_mode, width, height, 0, channel.gl_pixel_mode, channel.gl_pixel_type, pixels);
+    }
+
+    void Texture::update_sub_data(int x, int y, int w, int h, const uint8* pixels) {
+	    bind();
+	    glPixelStorei(GL_UNPACK_ALIGNMENT, get_unpack_alignment(channel));
+	    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, channel.gl_pixel_mode, channel.gl_pixel_type, pixels);
     }
 
     void Texture::bind() {
-	    glBindTexture(GL_TEXTURE_2D, id);
+	    bind_texture(id);
     }
 
     uint8* Texture::get_vram_pixels() {
 	    if (texture_created) {
             bind();
             //todo: potential memory leak, must fix
-		    uint8* pixels = new uint8[(width * height) * channel.num_channels];
-		    glReadPixels(0, 0, width, height, channel.gl_pixel_mode, GL_UNSIGNED_BYTE, pixels);
+		    uint8* pixels = new uint8[(width * height) * channel.bytes_per_pixel];
+		    glReadPixels(0, 0, width, height, channel.gl_pixel_mode, channel.gl_pixel_type, pixels);
 		    //todo: glgetteximage not supported by gles2
-		    //glGetTexImage(GL_TEXTURE_2D, 0, channel.gl_pixel_mode, GL_UNSIGNED_BYTE, pixels);
+		    //glGetTexImage(GL_TEXTURE_2D, 0, channel.gl_pixel_mode, channel.gl_pixel_type, pixels);
 		    return pixels;
 	    }
 	    return NULL;
@@ -107,6 +157,7 @@ namespace pxl { namespace graphics {
 
     void Texture::free() {
 	    if (texture_created) {
+		    forget_texture(id);
 		    glDeleteTextures(1, &id);
 		    texture_created = false;
 	    }
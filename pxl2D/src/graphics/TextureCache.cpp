@@ -0,0 +1,138 @@
+#include "graphics/TextureCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include "system/IO.h"
+
+namespace pxl { namespace graphics {
+
+    //cpp constants (hidden from public)
+    #define FNV_OFFSET_BASIS 14695981039346656037ULL                         //64 bit fnv-1a starting hash
+    #define FNV_PRIME 1099511628211ULL
+
+    TextureCache::TextureCache(uint64 byte_budget) {
+        budget = byte_budget;
+    }
+
+    /** Hashes a file's contents with 64 bit fnv-1a, 8 bytes at a time
+    **/
+    static uint64 hash_contents(const uint8* data, size_t size) {
+        uint64 hash = FNV_OFFSET_BASIS;
+        size_t n = 0;
+        for (; n + 8 <= size; n += 8) {
+            uint64 v;
+            memcpy(&v, data + n, sizeof(uint64));
+            hash = (hash ^ v) * FNV_PRIME;
+        }
+        for (; n < size; ++n) hash = (hash ^ data[n]) * FNV_PRIME;
+        return hash ^ size;
+    }
+
+    Texture* TextureCache::acquire(std::string file_path, bool premultiply_alpha) {
+        return acquire_key((premultiply_alpha ? "path:p:" : "path:s:") + file_path, file_path, premultiply_alpha);
+    }
+
+    Texture* TextureCache::acquire_by_content(std::string file_path, bool premultiply_alpha) {
+        sys::MappedFile file;
+        if (!file.open(file_path)) {
+            sys::show_exception("Could not create texture, (" + file_path + ") could not be read", ERROR_TEXTURE_CREATION_FAILED);
+            return NULL;
+        }
+
+        char hash[17];
+        snprintf(hash, sizeof(hash), "%016llx", hash_contents(file.get_data(), file.get_size()));
+        file.close();
+
+        return acquire_key(std::string(premultiply_alpha ? "hash:p:" : "hash:s:") + hash, file_path, premultiply_alpha);
+    }
+
+    Texture* TextureCache::acquire_key(const std::string& key, const std::string& file_path, bool premultiply_alpha) {
+        std::unordered_map<std::string, Entry>::iterator it = entries.find(key);
+        if (it != entries.end()) {
+            Entry& entry = it->second;
+            if (entry.refs++ == 0) unused_list.erase(entry.lru_pos);
+            ++stats.hits;
+            return entry.texture;
+        }
+
+        ++stats.misses;
+        Texture* texture = new Texture();
+        if (!texture->create_texture(file_path, premultiply_alpha)) {
+            delete texture;
+            return NULL;
+        }
+
+        const Channel channel = texture->get_channel();
+        Entry& entry = entries[key];
+        entry.texture = texture;
+        entry.refs = 1;
+        entry.bytes = uint64(texture->get_width()) * texture->get_height() * channel.bytes_per_pixel;
+        texture_keys[texture] = key;
+        stats.bytes_resident += entry.bytes;
+        ++stats.textures_resident;
+
+        evict_to(budget);
+        return texture;
+    }
+
+    void TextureCache::release(Texture* texture) {
+        std::unordered_map<Texture*, std::string>::iterator key = texture_keys.find(texture);
+        if (key == texture_keys.end()) return;
+
+        Entry& entry = entries[key->second];
+        if (entry.refs == 0) return;
+        if (--entry.refs == 0) {
+            //most recently released textures go to the back, so the front is evicted first
+            entry.lru_pos = unused_list.insert(unused_list.end(), key->second);
+            evict_to(budget);
+        }
+    }
+
+    void TextureCache::set_byte_budget(uint64 byte_budget) {
+        budget = byte_budget;
+        evict_to(budget);
+    }
+
+    void TextureCache::evict_unused() {
+        evict_to(0);
+    }
+
+    void TextureCache::evict_to(uint64 max_bytes) {
+        while (stats.bytes_resident > max_bytes && !unused_list.empty()) {
+            evict(entries.find(unused_list.front()));
+            ++stats.evictions;
+        }
+    }
+
+    void TextureCache::evict(std::unordered_map<std::string, Entry>::iterator it) {
+        Entry& entry = it->second;
+        if (entry.refs == 0) unused_list.erase(entry.lru_pos);
+        stats.bytes_resident -= entry.bytes;
+        --stats.textures_resident;
+
+        texture_keys.erase(entry.texture);
+        entry.texture->free();
+        delete entry.texture;
+        entries.erase(it);
+    }
+
+    void TextureCache::clear() {
+        while (!entries.empty()) evict(entries.begin());
+    }
+
+    void TextureCache::reset_stats() {
+        stats.hits = 0;
+        stats.misses = 0;
+        stats.evictions = 0;
+    }
+
+    TextureCache::~TextureCache() {
+        clear();
+    }
+
+    TextureCache* get_texture_cache() {
+        //never destroyed, a static's destructor would free its textures after the gl context is gone at exit
+        static TextureCache* cache = new TextureCache();
+        return cache;
+    }
+}};
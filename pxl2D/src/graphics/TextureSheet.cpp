@@ -1,4 +1,11 @@
 #include "graphics/TextureSheet.h"
+
+#include <algorithm>
+#include <cstring>
+#include "graphics/GLState.h"
+#include "graphics/PixelConvert.h"
+#include "graphics/PixelKernels.h"
+#include "system/ThreadPool.h"
 #include "system/Debug.h"
 
 namespace pxl { namespace graphics {
@@ -15,6 +22,18 @@ namespace pxl { namespace graphics {
     }
 
     void TextureSheet::create_sheet(Channel sheet_channel, bool dispose_batch, bool dispose_list, bool clear_list) {
+	    if (!packed_bitmaps.empty() || !placed_bitmaps.empty()) {
+		    //sheets of bitmaps are built on the cpu and uploaded once, without going through the frame buffer
+		    Bitmap sheet_bitmap;
+		    if (!composite(sheet_bitmap, sheet_channel)) {
+			    sys::show_exception("Could not create texture sheet, the packed bitmaps have not been placed by pack or there is nothing to copy", ERROR_TEXTURE_SHEET_CREATION_FAILED);
+			    return;
+		    }
+		    create_texture(&sheet_bitmap);
+		    finish_sheet(dispose_batch, dispose_list, clear_list);
+		    return;
+	    }
+
 	    if (!batch->is_created()) {
             sys::show_exception("Could not create texture sheet, batch has been disposed", ERROR_TEXTURE_SHEET_CREATION_FAILED);
             return;
@@ -58,6 +77,10 @@ namespace pxl { namespace graphics {
 	    //todo: glreadbuffer not supported in gles2
 	    //glReadBuffer(GL_BACK);
 
+	    finish_sheet(dispose_batch, dispose_list, clear_list);
+    }
+
+    void TextureSheet::finish_sheet(bool dispose_batch, bool dispose_list, bool clear_list) {
 	    texture_created = true;
 
 	    if (dispose_batch) {
@@ -68,6 +91,12 @@ namespace pxl { namespace graphics {
 		    for (size_t n = 0; n < texture_list.size(); ++n) {
 			    delete texture_list[n];
 		    }
+		    for (size_t n = 0; n < packed_bitmaps.size(); ++n) {
+			    delete packed_bitmaps[n];
+		    }
+		    for (size_t n = 0; n < placed_bitmaps.size(); ++n) {
+			    delete placed_bitmaps[n];
+		    }
 	    }
 
         if (clear_list) clear();
@@ -77,6 +106,143 @@ namespace pxl { namespace graphics {
 
     void TextureSheet::clear() {
 	    texture_list.clear();
+
+	    //packed rects are kept so where each bitmap went can still be looked up after the sheet is created
+	    packed_bitmaps.clear();
+	    placed_bitmaps.clear();
+	    placed_rects.clear();
+    }
+
+    uint32 TextureSheet::add_packed(Bitmap* bitmap) {
+	    PackedRect rect;
+	    rect.w = bitmap->get_width();
+	    rect.h = bitmap->get_height();
+
+	    //anything added since the last pack hasn't been placed
+	    if (packed_bitmaps.empty()) packed_rects.clear();
+	    packed_bitmaps.push_back(bitmap);
+	    packed_rects.push_back(rect);
+	    packed = false;
+	    return packed_rects.size() - 1;
+    }
+
+    bool TextureSheet::pack(const PackSettings& settings) {
+	    RectPacker packer;
+	    packed = packer.pack(packed_rects, settings);
+	    width = packer.get_width();
+	    height = packer.get_height();
+	    if (!packed) {
+		    sys::show_exception("Could not pack texture sheet, the bitmaps do not fit within the max size", ERROR_TEXTURE_SHEET_CREATION_FAILED);
+	    }
+	    return packed;
+    }
+
+    /** A bitmap and where it goes in the sheet
+    **/
+    struct SheetBlit {
+
+	    const Bitmap* bitmap;
+	    PackedRect rect;
+    };
+
+    /** Copies the rows of every blit that fall between sheet rows y0 and y1, in the order given so later blits land
+    over earlier ones. Bands never share rows, so each one can be copied on a different thread
+    **/
+    static void composite_rows(const std::vector<SheetBlit>& blits, uint8* sheet_pixels, uint32 sheet_width,
+							   const Channel& sheet_channel, uint32 y0, uint32 y1) {
+	    const uint32 bpp = sheet_channel.bytes_per_pixel;
+	    std::vector<uint8> column;
+
+	    for (size_t n = 0; n < blits.size(); ++n) {
+		    const Bitmap* bitmap = blits[n].bitmap;
+		    const PackedRect& rect = blits[n].rect;
+		    uint32 start = std::max(y0, rect.y), end = std::min(y1, rect.y + rect.h);
+		    if (start >= end || rect.x >= sheet_width) continue;
+
+		    const Channel src_channel = bitmap->get_channel();
+		    const uint32 src_bpp = src_channel.bytes_per_pixel;
+		    const uint32 src_w = bitmap->get_width(), src_h = bitmap->get_height();
+		    const uint32 w = std::min(rect.w, sheet_width - rect.x);
+		    if (rect.rotated) column.resize(src_h * src_bpp);
+
+		    for (uint32 y = start; y < end; ++y) {
+			    const uint8* row;
+			    if (!rect.rotated) {
+				    row = bitmap->get_pixels() + ((y - rect.y) * src_w * src_bpp);
+			    }else {
+				    //a row of a rect turned clockwise is a source column read from the bottom up
+				    const uint8* src = bitmap->get_pixels() + ((y - rect.y) * src_bpp);
+				    for (uint32 i = 0; i < src_h; ++i) memcpy(&column[i * src_bpp], src + ((src_h - 1 - i) * src_w * src_bpp), src_bpp);
+				    row = &column[0];
+			    }
+
+			    uint8* dest = sheet_pixels + ((y * sheet_width + rect.x) * bpp);
+			    if (src_channel == sheet_channel) copy_pixels(dest, row, w * bpp);
+			    else convert_pixels(row, src_channel, dest, sheet_channel, w);
+		    }
+	    }
+    }
+
+    bool TextureSheet::composite(Bitmap& sheet_bitmap, Channel sheet_channel) {
+	    if ((!packed && !packed_bitmaps.empty()) || width <= 0 || height <= 0) return false;
+
+	    //bitmaps placed by hand go first, then packed ones
+	    std::vector<SheetBlit> blits;
+	    bool transparent = false;
+	    for (int list = 0; list < 2; ++list) {
+		    const std::vector<Bitmap*>& bitmaps = list == 0 ? placed_bitmaps : packed_bitmaps;
+		    const std::vector<PackedRect>& rects = list == 0 ? placed_rects : packed_rects;
+		    for (size_t n = 0; n < bitmaps.size(); ++n) {
+			    if (bitmaps[n]->get_pixels() == NULL || rects[n].w == 0 || rects[n].h == 0) continue;
+			    SheetBlit blit = { bitmaps[n], rects[n] };
+			    blits.push_back(blit);
+			    if (bitmaps[n]->has_transparency) transparent = true;
+		    }
+	    }
+	    if (blits.empty()) return false;
+
+	    sheet_bitmap.create_bitmap(width, height, bg_colour, sheet_channel);
+	    uint8* sheet_pixels = sheet_bitmap.get_pixels();
+	    const uint32 sheet_width = width, sheet_height = height;
+
+	    //the sheet is split into bands of rows that are copied on the worker threads. A pool job can't wait on the
+	    //pool, so the bands are copied inline when composite is already running on a worker
+	    sys::ThreadPool* pool = sys::get_thread_pool();
+	    const uint32 num_bands = (sheet_height + CONFIG_TEXTURE_SHEET_BAND_ROWS - 1) / CONFIG_TEXTURE_SHEET_BAND_ROWS;
+	    if (num_bands <= 1 || pool->is_worker_thread()) {
+		    composite_rows(blits, sheet_pixels, sheet_width, sheet_channel, 0, sheet_height);
+	    }else {
+		    std::vector<std::future<void>> bands;
+		    bands.reserve(num_bands);
+		    for (uint32 n = 0; n < num_bands; ++n) {
+			    uint32 y0 = n * CONFIG_TEXTURE_SHEET_BAND_ROWS;
+			    uint32 y1 = std::min(y0 + CONFIG_TEXTURE_SHEET_BAND_ROWS, sheet_height);
+			    bands.push_back(pool->submit([&blits, sheet_pixels, sheet_width, &sheet_channel, y0, y1]() {
+				    composite_rows(blits, sheet_pixels, sheet_width, sheet_channel, y0, y1);
+			    }));
+		    }
+		    for (size_t n = 0; n < bands.size(); ++n) bands[n].get();
+	    }
+
+	    if (transparent) sheet_bitmap.has_transparency = true;
+	    if (sheet_channel.channel_index.a == -1) sheet_bitmap.has_transparency = false;
+	    return true;
+    }
+
+    void TextureSheet::add(Bitmap* bitmap, uint32 x, uint32 y) {
+	    PackedRect rect;
+	    rect.x = x;
+	    rect.y = y;
+	    rect.w = bitmap->get_width();
+	    rect.h = bitmap->get_height();
+	    rect.packed = true;
+	    placed_bitmaps.push_back(bitmap);
+	    placed_rects.push_back(rect);
+
+	    int w = x + rect.w;
+	    int h = y + rect.h;
+	    if (w > width) { width = w; }
+	    if (h > height) { height = h; }
     }
 
     void TextureSheet::add(Texture* texture, Rect* rect, Rect* src_rect, 
@@ -98,6 +264,7 @@ namespace pxl { namespace graphics {
 
     void TextureSheet::free() {
 	    if (texture_created) {
+		    forget_texture(id);
 		    glDeleteTextures(1, &id);
 
 		    batch->free();
@@ -0,0 +1,69 @@
+#include "graphics/TextureStream.h"
+
+#include <chrono>
+#include "graphics/PixelPool.h"
+
+namespace pxl { namespace graphics {
+
+    TextureStream::TextureStream() {
+        texture = NULL;
+        strip = NULL;
+        strip_rows = 0;
+        rows_uploaded = 0;
+        finished = true;
+    }
+
+    bool TextureStream::open(std::string file_name, Texture* stream_texture, const Channel* channel, uint32 num_strip_rows) {
+        close();
+        if (stream_texture == NULL || !png.open(file_name, channel)) return false;
+
+        texture = stream_texture;
+        strip_rows = num_strip_rows > 0 ? num_strip_rows : 1;
+        if (strip_rows > png.get_height()) strip_rows = png.get_height();
+        rows_uploaded = 0;
+        finished = false;
+
+        //the texture is allocated at full size without any pixels, each strip is uploaded into it as it's decoded
+        const Channel upload_channel = png.get_channel();
+        texture->create_texture(png.get_width(), png.get_height(), NULL, upload_channel);
+        texture->has_transparency = upload_channel.channel_index.a != -1;
+        strip = alloc_pixels(png.get_width() * strip_rows * upload_channel.bytes_per_pixel);
+        return true;
+    }
+
+    bool TextureStream::update(uint32 budget) {
+        if (finished) return true;
+
+        typedef std::chrono::steady_clock clock;
+        const clock::time_point start = clock::now();
+        do {
+            uint32 num_rows = png.read_rows(strip, strip_rows);
+            if (num_rows == 0) break;
+
+            texture->update_sub_data(0, rows_uploaded, png.get_width(), num_rows, strip);
+            rows_uploaded += num_rows;
+        }while (!png.is_finished() && std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count() < budget);
+
+        if (png.is_finished() || png.has_error()) {
+            //transparency is only known for sure once every row has been scanned
+            if (png.is_finished()) texture->has_transparency = png.has_transparency();
+            finished = true;
+            free_pixels(strip);
+            strip = NULL;
+        }
+        return finished;
+    }
+
+    void TextureStream::close() {
+        png.close();
+        free_pixels(strip);
+        strip = NULL;
+        texture = NULL;
+        rows_uploaded = 0;
+        finished = true;
+    }
+
+    TextureStream::~TextureStream() {
+        close();
+    }
+}};
@@ -1,9 +1,12 @@
 #include "system/Exception.h"
+#include "PXLAPI.h"
 
-#define NOMINMAX //macro to not have the windows header define min/max so it doesn't interfere
-#include <Windows.h>
-#undef ABSOLUTE
-#undef RELATIVE
+#if defined(PLATFORM_WIN32)
+    #define NOMINMAX //macro to not have the windows header define min/max so it doesn't interfere
+    #include <Windows.h>
+    #undef ABSOLUTE
+    #undef RELATIVE
+#endif
 #include <string>
 
 #include "system/Config.h"
@@ -0,0 +1,369 @@
+#include "system/FileSystem.h"
+
+#include <cstring>
+#include <fstream>
+#include <zlib.h>
+
+#if defined(PLATFORM_WIN32)
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(PLATFORM_ANDROID)
+#include <android/asset_manager.h>
+#endif
+
+#include "system/Exception.h"
+
+namespace pxl { namespace sys {
+
+    //cpp constants (hidden from public)
+    #define ZIP_LOCAL_HEADER_SIG 0x04034b50
+    #define ZIP_CENTRAL_HEADER_SIG 0x02014b50
+    #define ZIP_END_SIG 0x06054b50
+    #define ZIP_LOCAL_HEADER_SIZE 30
+    #define ZIP_CENTRAL_HEADER_SIZE 46
+    #define ZIP_END_SIZE 22
+    #define ZIP_MAX_COMMENT 0xffff                                          //the end record can be followed by a comment up to this long
+    #define ZIP_STORED 0
+    #define ZIP_DEFLATED 8
+
+    void FileSystem::set_view(MappedFile& file, const uint8* data, size_t size, bool mapped,
+                              MappedFile::ReleaseFunc release, void* handle) {
+        file.data = data;
+        file.size = size;
+        file.mapped = mapped;
+        file.release = release;
+        file.handle = handle;
+    }
+
+    static void release_heap(const uint8* data, size_t, void*) {
+        delete[] data;
+    }
+
+    #if defined(PLATFORM_WIN32)
+        static void release_mapping(const uint8* data, size_t, void*) {
+            UnmapViewOfFile(data);
+        }
+    #else
+        static void release_mapping(const uint8* data, size_t size, void*) {
+            munmap((void*)data, size);
+        }
+    #endif
+
+    // ------------------------------------------------------------------------------------------------
+    // directory file system
+    // ------------------------------------------------------------------------------------------------
+
+    DirectoryFileSystem::DirectoryFileSystem(std::string root_dir) {
+        root = root_dir;
+        if (!root.empty() && root[root.size() - 1] != '/' && root[root.size() - 1] != '\\') root += '/';
+    }
+
+    std::string DirectoryFileSystem::get_path(const std::string& file_name) const {
+        return root + file_name;
+    }
+
+    bool DirectoryFileSystem::open(const std::string& file_name, MappedFile& file) {
+        std::string path = get_path(file_name);
+        size_t size = 0;
+        const uint8* data = NULL;
+
+        #if defined(PLATFORM_WIN32)
+            HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+            if (handle == INVALID_HANDLE_VALUE) return false;
+
+            LARGE_INTEGER file_size;
+            GetFileSizeEx(handle, &file_size);
+            size = (size_t)file_size.QuadPart;
+
+            //empty files can't be mapped, but are still valid files
+            if (size != 0) {
+                //the view keeps its own reference to the mapping, so both handles can be closed straight away
+                HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+                if (mapping != NULL) {
+                    data = (const uint8*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                    CloseHandle(mapping);
+                }
+            }
+            CloseHandle(handle);
+        #else
+            int handle = ::open(path.c_str(), O_RDONLY);
+            if (handle == -1) return false;
+
+            struct stat file_stat;
+            fstat(handle, &file_stat);
+            size = (size_t)file_stat.st_size;
+
+            if (size != 0) {
+                void* view = mmap(NULL, size, PROT_READ, MAP_PRIVATE, handle, 0);
+                if (view != MAP_FAILED) data = (const uint8*)view;
+            }
+            ::close(handle);
+        #endif
+
+        if (data != NULL) {
+            set_view(file, data, size, true, release_mapping, NULL);
+            return true;
+        }
+
+        //fall back to reading the file into memory if it couldn't be mapped
+        if (size != 0) {
+            std::ifstream stream(path.c_str(), std::ios::binary);
+            uint8* buffer = new uint8[size];
+            if (!stream.read((char*)buffer, size)) {
+                delete[] buffer;
+                return false;
+            }
+            set_view(file, buffer, size, false, release_heap, NULL);
+        }
+        return true;
+    }
+
+    bool DirectoryFileSystem::exists(const std::string& file_name) {
+        std::string path = get_path(file_name);
+        #if defined(PLATFORM_WIN32)
+            DWORD attribs = GetFileAttributesA(path.c_str());
+            return attribs != INVALID_FILE_ATTRIBUTES && !(attribs & FILE_ATTRIBUTE_DIRECTORY);
+        #else
+            struct stat file_stat;
+            return stat(path.c_str(), &file_stat) == 0 && S_ISREG(file_stat.st_mode);
+        #endif
+    }
+
+    // ------------------------------------------------------------------------------------------------
+    // zip file system
+    // ------------------------------------------------------------------------------------------------
+
+    //zip fields are little endian and unaligned
+    static inline uint16 read_u16(const uint8* p) { return p[0] | (p[1] << 8); }
+    static inline uint32 read_u32(const uint8* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32(p[3]) << 24); }
+
+    ZipFileSystem::ZipFileSystem() {
+    }
+
+    bool ZipFileSystem::open_archive(std::string archive_name, std::string prefix) {
+        close_archive();
+
+        //the archive is always read from disk, so a zip can be set as the current file system without opening itself
+        DirectoryFileSystem directory;
+        if (!archive.open(archive_name, &directory)) {
+            show_exception("Could not open archive (" + archive_name + "). It may not exist", ERROR_INVALID_FILE);
+            return false;
+        }
+        const uint8* data = archive.get_data();
+        size_t size = archive.get_size();
+
+        //the end record is the last thing in the archive apart from its comment
+        const uint8* end = NULL;
+        if (size >= ZIP_END_SIZE) {
+            size_t min_pos = size - ZIP_END_SIZE > ZIP_MAX_COMMENT ? size - ZIP_END_SIZE - ZIP_MAX_COMMENT : 0;
+            for (size_t pos = size - ZIP_END_SIZE + 1; pos-- > min_pos;) {
+                if (read_u32(data + pos) == ZIP_END_SIG) {
+                    end = data + pos;
+                    break;
+                }
+            }
+        }
+        if (end == NULL) {
+            show_exception("(" + archive_name + ") is not a zip archive", ERROR_INVALID_FILE);
+            close_archive();
+            return false;
+        }
+
+        uint32 num_entries = read_u16(end + 10);
+        uint32 directory_size = read_u32(end + 12);
+        uint32 directory_offset = read_u32(end + 16);
+        if (directory_offset > size || directory_size > size - directory_offset) {
+            show_exception("(" + archive_name + ") has an invalid central directory", ERROR_INVALID_FILE);
+            close_archive();
+            return false;
+        }
+
+        const uint8* p = data + directory_offset;
+        const uint8* directory_end = p + directory_size;
+        for (uint32 n = 0; n < num_entries; ++n) {
+            if (directory_end - p < ZIP_CENTRAL_HEADER_SIZE || read_u32(p) != ZIP_CENTRAL_HEADER_SIG) break;
+            uint32 name_length = read_u16(p + 28);
+            uint32 header_length = ZIP_CENTRAL_HEADER_SIZE + name_length + read_u16(p + 30) + read_u16(p + 32);
+            if (size_t(directory_end - p) < header_length) break;
+
+            std::string name((const char*)p + ZIP_CENTRAL_HEADER_SIZE, name_length);
+            if (name.compare(0, prefix.size(), prefix) == 0 && name.size() > prefix.size() && name[name.size() - 1] != '/') {
+                Entry& entry = entries[name.substr(prefix.size())];
+                entry.method = read_u16(p + 10);
+                entry.stored_size = read_u32(p + 20);
+                entry.size = read_u32(p + 24);
+                entry.header_offset = read_u32(p + 42);
+            }
+            p += header_length;
+        }
+        return true;
+    }
+
+    void ZipFileSystem::close_archive() {
+        entries.clear();
+        archive.close();
+    }
+
+    bool ZipFileSystem::open(const std::string& file_name, MappedFile& file) {
+        std::unordered_map<std::string, Entry>::const_iterator it = entries.find(file_name);
+        if (it == entries.end()) return false;
+        const Entry& entry = it->second;
+
+        //the local header's name and extra field can differ in length from the central directory's
+        const uint8* data = archive.get_data();
+        size_t size = archive.get_size();
+        if (entry.header_offset > size || size - entry.header_offset < ZIP_LOCAL_HEADER_SIZE) return false;
+        const uint8* header = data + entry.header_offset;
+        if (read_u32(header) != ZIP_LOCAL_HEADER_SIG) return false;
+
+        uint64 payload_offset = uint64(entry.header_offset) + ZIP_LOCAL_HEADER_SIZE + read_u16(header + 26) + read_u16(header + 28);
+        if (payload_offset > size || entry.stored_size > size - payload_offset) return false;
+        const uint8* payload = data + payload_offset;
+
+        if (entry.method == ZIP_STORED) {
+            if (entry.stored_size != entry.size) return false;
+            set_view(file, payload, entry.size, archive.is_mapped(), NULL, NULL);
+            return true;
+        }
+        if (entry.method != ZIP_DEFLATED) {
+            show_exception("(" + file_name + ") is compressed with an unsupported zip method", ERROR_INVALID_FILE);
+            return false;
+        }
+        if (entry.size == 0) return true;
+
+        uint8* buffer = new uint8[entry.size];
+        z_stream stream;
+        memset(&stream, 0, sizeof(z_stream));
+        stream.next_in = (Bytef*)payload;
+        stream.avail_in = entry.stored_size;
+        stream.next_out = buffer;
+        stream.avail_out = entry.size;
+
+        //zip entries are raw deflate streams without a zlib header
+        bool inflated = inflateInit2(&stream, -MAX_WBITS) == Z_OK;
+        if (inflated) {
+            inflated = inflate(&stream, Z_FINISH) == Z_STREAM_END && stream.total_out == entry.size;
+            inflateEnd(&stream);
+        }
+        if (!inflated) {
+            delete[] buffer;
+            show_exception("(" + file_name + ") is corrupt in its archive", ERROR_INVALID_FILE);
+            return false;
+        }
+        set_view(file, buffer, entry.size, false, release_heap, NULL);
+        return true;
+    }
+
+    bool ZipFileSystem::exists(const std::string& file_name) {
+        return entries.find(file_name) != entries.end();
+    }
+
+    ZipFileSystem::~ZipFileSystem() {
+        close_archive();
+    }
+
+    // ------------------------------------------------------------------------------------------------
+    // android asset file system
+    // ------------------------------------------------------------------------------------------------
+
+    #if defined(PLATFORM_ANDROID)
+    /** A mapping made from an asset's file descriptor. The asset starts part way into the apk, so the mapping
+    starts on the page before it
+    **/
+    struct AssetMapping {
+
+        void* base;
+        size_t length;
+    };
+
+    static void release_asset(const uint8* data, size_t size, void* handle) {
+        AAsset_close((AAsset*)handle);
+    }
+
+    static void release_asset_mapping(const uint8* data, size_t size, void* handle) {
+        AssetMapping* mapping = (AssetMapping*)handle;
+        munmap(mapping->base, mapping->length);
+        delete mapping;
+    }
+
+    AndroidAssetFileSystem::AndroidAssetFileSystem(AAssetManager* manager) {
+        asset_manager = manager;
+    }
+
+    bool AndroidAssetFileSystem::open(const std::string& file_name, MappedFile& file) {
+        AAsset* asset = AAssetManager_open(asset_manager, file_name.c_str(), AASSET_MODE_BUFFER);
+        if (asset == NULL) return false;
+
+        size_t size = (size_t)AAsset_getLength(asset);
+        if (size == 0) {
+            AAsset_close(asset);
+            return true;
+        }
+
+        //uncompressed assets are mapped straight out of the apk, compressed ones are inflated into a buffer the
+        //asset owns. either way the asset stays open for as long as the view is used
+        const void* buffer = AAsset_getBuffer(asset);
+        if (buffer != NULL) {
+            set_view(file, (const uint8*)buffer, size, true, release_asset, asset);
+            return true;
+        }
+
+        //if the asset manager couldn't give a buffer, map uncompressed assets from the apk ourselves
+        off_t start, length;
+        int fd = AAsset_openFileDescriptor(asset, &start, &length);
+        if (fd >= 0) {
+            off_t page_start = start - (start % sysconf(_SC_PAGESIZE));
+            size_t map_length = (size_t)(start - page_start) + size;
+            void* view = mmap(NULL, map_length, PROT_READ, MAP_PRIVATE, fd, page_start);
+            ::close(fd);
+            if (view != MAP_FAILED) {
+                AAsset_close(asset);
+                AssetMapping* mapping = new AssetMapping();
+                mapping->base = view;
+                mapping->length = map_length;
+                set_view(file, (const uint8*)view + (start - page_start), size, true, release_asset_mapping, mapping);
+                return true;
+            }
+        }
+
+        //last resort, read the asset into a heap buffer
+        uint8* data = new uint8[size];
+        bool read = AAsset_read(asset, data, size) == (int)size;
+        AAsset_close(asset);
+        if (!read) {
+            delete[] data;
+            return false;
+        }
+        set_view(file, data, size, false, release_heap, NULL);
+        return true;
+    }
+
+    bool AndroidAssetFileSystem::exists(const std::string& file_name) {
+        AAsset* asset = AAssetManager_open(asset_manager, file_name.c_str(), AASSET_MODE_UNKNOWN);
+        if (asset == NULL) return false;
+        AAsset_close(asset);
+        return true;
+    }
+    #endif
+
+    // ------------------------------------------------------------------------------------------------
+    // current file system
+    // ------------------------------------------------------------------------------------------------
+
+    static FileSystem* current_file_system = NULL;
+
+    void set_file_system(FileSystem* file_system) {
+        current_file_system = file_system;
+    }
+
+    FileSystem* get_file_system() {
+        static DirectoryFileSystem working_dir;
+        return current_file_system != NULL ? current_file_system : &working_dir;
+    }
+}};
@@ -1,175 +1,364 @@
 #include "system/ImageIO.h"
 
-#include <fstream>
+#include <cstring>
 #include <png.h>
 #include <string>
+#include <vector>
 
 #if defined(PLATFORM_ANDROID)
-#include <jni.h>
-#include <android/asset_manager.h>
 #include <android_native_app_glue.h>
-#include <unistd.h>
-#include <sys/stat.h>
-#include <errno.h>
 #endif
 
 #include "system/Exception.h"
 #include "system/Debug.h"
 #include "system/android/AndroidWindow.h"
 #include "system/IO.h"
+#include "system/FileSystem.h"
+#include "graphics/PixelKernels.h"
+#include "graphics/PixelConvert.h"
 
 namespace pxl { namespace sys {
     
-    const char* cache_dir;
-
-    #if defined(PLATFORM_ANDROID)
-    void write_asset_dir(std::string dir_name) {
-	    //write files to cache
-	    AAssetDir* asset_dir = AAssetManager_openDir(android_state->activity->assetManager, dir_name.c_str());
-	    const char* file_name;
-	    while ((file_name = AAssetDir_getNextFileName(asset_dir)) != NULL) {
-		    AAsset* asset = AAssetManager_open(android_state->activity->assetManager, file_name, AASSET_MODE_STREAMING);
-
-		    FILE* file = fopen(file_name, "w");
-		    off_t size = AAsset_getLength(asset);
-		    char* buffer = new char[size];
-
-		    AAsset_read(asset, buffer, size);
-		    fwrite(buffer, size, 1, file);
-
-		    fclose(file);
-		    AAsset_close(asset);
-
-		    print << "wrote " << file_name << " to asset dir (" << size << " bytes)\n";
-	    }
-	    AAssetDir_close(asset_dir);
-    }
-    #endif
-
     void init_assets() {
 	    #if defined(PLATFORM_ANDROID)
-		    JNIEnv* env = android_state->activity->env;
-		    JavaVM* vm = android_state->activity->vm;
-		    vm->AttachCurrentThread(&env, NULL);
-
-		    jclass activity_class = env->GetObjectClass(android_state->activity->clazz);
-
-		    //get path to cache dir
-		    jmethodID cache_dir_func = env->GetMethodID(activity_class, "getCacheDir", "()Ljava/io/File;");
-		    jobject f = env->CallObjectMethod(android_state->activity->clazz, cache_dir_func);
-		    jclass f_class = env->FindClass("java/io/File");
-		    jmethodID full_path_func = env->GetMethodID(f_class, "getAbsolutePath", "()Ljava/lang/String;");
-		    jstring j_cache_path = (jstring)env->CallObjectMethod(f, full_path_func);
-
-		    //get full cache dir and print it
-		    cache_dir = env->GetStringUTFChars(j_cache_path, NULL);
-		    print << "cache assets dir: " << cache_dir << "\n";
-
-		    //free jcachepath
-		    //todo: delete j_cache_path properly without breaking cache_dir
-		    //delete j_cache_path;
-
-		    chdir(cache_dir);
-		    std::string temp = cache_dir;
-		    temp += "/assets";
-		    rmdir(temp.c_str());
-		    if (mkdir(temp.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) != 0) {
-			    print << "could not create dir in (" << cache_dir << "/assets) error: " << strerror(errno) << "\n";
-		    }
-		    chdir(temp.c_str());
-
-		    write_asset_dir("");
-
-		    cache_dir = append_char(cache_dir, "/");
-
-		    chdir(cache_dir);
+		    //assets are read straight out of the apk rather than copied anywhere first
+		    static AndroidAssetFileSystem asset_file_system(android_state->activity->assetManager);
+		    set_file_system(&asset_file_system);
 	    #endif
     }
 
     #define PNG_SIG_SIZE 8
 
-    bool png_validate(std::ifstream& file);
-    void read_png(png_structp read, png_bytep data, png_size_t length);
+    /** The position libpng has read up to in a png held in memory
+    **/
+    struct PNGMemoryReader {
 
-    std::ifstream file;
+	    const uint8* data;
+	    size_t size;
+	    size_t offset;
+    };
 
-    graphics::Bitmap* load_png(std::string file_name, graphics::Bitmap* bitmap) {
-	    if (bitmap == NULL) return NULL;
+    static bool png_validate(const uint8* data, size_t size);
+    static void read_png(png_structp png_pointer, png_bytep data, png_size_t length);
 
-	    #if defined(PLATFORM_ANDROID)
-		    chdir(cache_dir);
-	    #endif
+    /** Reads the png header and sets up libpng to decode every png as 8 bits per channel. libpng has to have its
+    read function set and its setjmp in place before this is called
+    @param num_passes Set to the amount of passes png_read_row needs over each row, more than 1 if the png is interlaced
+    \return The layout libpng decodes rows in
+    **/
+    static graphics::Channel read_png_layout(png_structp png_pointer, png_infop info_pointer, int& num_passes) {
+	    //set amount of bytes already read
+	    png_set_sig_bytes(png_pointer, PNG_SIG_SIZE);
 
-	    file.open(file_name.c_str(), std::ios::binary);
+	    //read png header info into libpng
+	    png_read_info(png_pointer, info_pointer);
 
-	    if (!png_validate(file)) {
+	    png_uint_32 bit_depth = png_get_bit_depth(png_pointer, info_pointer);
+	    png_uint_32 colour_type = png_get_color_type(png_pointer, info_pointer);
+
+	    //let libpng expand palettes, low bit depth gray and tRNS transparency, and reduce 16 bit channels to 8 bits
+	    //as it decodes, so every png arrives as 8 bits per channel
+	    if (colour_type == PNG_COLOR_TYPE_PALETTE) png_set_palette_to_rgb(png_pointer);
+	    if (colour_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8) png_set_expand_gray_1_2_4_to_8(png_pointer);
+	    if (png_get_valid(png_pointer, info_pointer, PNG_INFO_tRNS)) png_set_tRNS_to_alpha(png_pointer);
+	    if (bit_depth == 16) {
+		    #if defined(PNG_READ_SCALE_16_TO_8_SUPPORTED)
+			    png_set_scale_16(png_pointer);
+		    #else
+			    png_set_strip_16(png_pointer);
+		    #endif
+	    }
+	    num_passes = png_set_interlace_handling(png_pointer);
+	    png_read_update_info(png_pointer, info_pointer);
+
+	    colour_type = png_get_color_type(png_pointer, info_pointer);
+	    graphics::Channel png_channel;
+	    if (colour_type == PNG_COLOR_TYPE_GRAY) png_channel = graphics::CHANNEL_ALPHA;
+	    if (colour_type == PNG_COLOR_TYPE_RGB) png_channel = graphics::CHANNEL_RGB;
+	    if (colour_type == PNG_COLOR_TYPE_GRAY_ALPHA) png_channel = graphics::CHANNEL_GRAY_ALPHA;
+	    if (colour_type == PNG_COLOR_TYPE_RGB_ALPHA) png_channel = graphics::CHANNEL_RGBA;
+	    return png_channel;
+    }
+
+    graphics::Bitmap* load_png(std::string file_name, graphics::Bitmap* bitmap, const graphics::Channel* channel) {
+	    //the file is mapped so libpng reads straight from the page cache instead of through stream copies
+	    MappedFile file;
+	    if (!file.open(file_name)) {
 		    show_exception("(" + file_name + ") is not a valid png (or it may not exist)", ERROR_INVALID_PNG);
 		    return NULL;
 	    }
 
+	    return load_png_from_memory(file.get_data(), file.get_size(), bitmap, file_name, channel);
+    }
+
+    graphics::Bitmap* load_png_from_memory(const uint8* data, size_t size, graphics::Bitmap* bitmap, std::string name, const graphics::Channel* channel) {
+	    if (!png_validate(data, size)) {
+		    show_exception("(" + name + ") is not a valid png (or it may not exist)", ERROR_INVALID_PNG);
+		    return NULL;
+	    }
+
+	    //each call has its own reader which libpng passes to read_png, so multiple pngs can load at once
+	    PNGMemoryReader reader;
+	    reader.data = data;
+	    reader.size = size;
+	    reader.offset = PNG_SIG_SIZE;
+
 	    png_structp png_pointer = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
 	    if (!png_pointer) {
-		    show_exception("Could not initialise png read struct for (" + file_name + ")", ERROR_INVALID_PNG);
+		    show_exception("Could not initialise png read struct for (" + name + ")", ERROR_INVALID_PNG);
+		    return NULL;
 	    }
 
 	    png_infop info_pointer = png_create_info_struct(png_pointer);
 	    if (!info_pointer) {
-		    show_exception("Could not initialise png info struct for (" + file_name + ")", ERROR_INVALID_PNG);
+		    show_exception("Could not initialise png info struct for (" + name + ")", ERROR_INVALID_PNG);
 		    png_destroy_read_struct(&png_pointer, (png_infopp)0, (png_infopp)0);
+		    return NULL;
 	    }
 
-	    png_set_read_fn(png_pointer, (png_voidp)&file, read_png);
+	    graphics::Bitmap* result = bitmap != NULL ? bitmap : new graphics::Bitmap();
+	    std::vector<png_bytep> row_pointers;
+	    std::vector<uint8> scratch;
 
-	    //set amount of bytes already read
-	    png_set_sig_bytes(png_pointer, PNG_SIG_SIZE);
+	    //libpng jumps back here if the png is corrupt
+	    if (setjmp(png_jmpbuf(png_pointer))) {
+		    png_destroy_read_struct(&png_pointer, &info_pointer, (png_infopp)0);
+		    if (bitmap == NULL) delete result;
+		    show_exception("(" + name + ") could not be decoded", ERROR_INVALID_PNG);
+		    return NULL;
+	    }
 
-	    //read png header info into libpng
-	    png_read_info(png_pointer, info_pointer);
+	    png_set_read_fn(png_pointer, (png_voidp)&reader, read_png);
 
+	    int num_passes;
+	    const graphics::Channel png_channel = read_png_layout(png_pointer, info_pointer, num_passes);
 	    png_uint_32 png_width = png_get_image_width(png_pointer, info_pointer);
 	    png_uint_32 png_height = png_get_image_height(png_pointer, info_pointer);
+	    const graphics::Channel target = channel != NULL ? *channel : png_channel;
+
+	    //every pixel is written by the decode, so the bitmap isn't filled first
+	    result->create_bitmap(png_width, png_height, target);
+
+	    //scan each row for transparency straight after it's decoded while it's still in cache, rather than scanning
+	    //the whole bitmap again afterwards. the scan is done on the png's own layout so packed targets don't need decoding
+	    const short alpha_index = target.channel_index.a != -1 ? png_channel.channel_index.a : -1;
+	    const uint32 png_row_length = png_width * png_channel.bytes_per_pixel;
+	    bool transparent = false;
+	    if (target == png_channel) {
+		    row_pointers.resize(png_height);
+		    for (size_t y = 0; y < png_height; ++y) {
+			    row_pointers[y] = (png_bytep)(result->get_pixels() + (y * png_row_length));
+		    }
+	    }
 
-	    png_uint_32 bit_depth = png_get_bit_depth(png_pointer, info_pointer);
-	    png_uint_32 channels = png_get_channels(png_pointer, info_pointer);
-	    png_uint_32 colour_type = png_get_color_type(png_pointer, info_pointer);
+	    if (num_passes == 1) {
+		    //rows are converted to the target layout one at a time from a single row of scratch, so the whole png
+		    //is never held in its own layout
+		    if (target != png_channel) scratch.resize(png_row_length);
+		    for (size_t y = 0; y < png_height; ++y) {
+			    png_bytep row = target == png_channel ? row_pointers[y] : &scratch[0];
+			    png_read_row(png_pointer, row, NULL);
+			    if (!transparent && alpha_index != -1) {
+				    transparent = graphics::scan_transparency(row, png_width, png_channel.bytes_per_pixel, alpha_index);
+			    }
+			    if (target != png_channel) {
+				    graphics::convert_pixels(row, png_channel, result->get_pixels() + (y * png_width * target.bytes_per_pixel), target, png_width);
+			    }
+		    }
+	    }else {
+		    //interlaced pngs only have whole rows after the last pass, so converting needs the whole png decoded first
+		    if (target != png_channel) scratch.resize(png_row_length * png_height);
+		    uint8* png_pixels = target == png_channel ? result->get_pixels() : &scratch[0];
+		    if (target != png_channel) {
+			    row_pointers.resize(png_height);
+			    for (size_t y = 0; y < png_height; ++y) row_pointers[y] = (png_bytep)(png_pixels + (y * png_row_length));
+		    }
+		    png_read_image(png_pointer, &row_pointers[0]);
+		    transparent = alpha_index != -1 && graphics::scan_transparency(png_pixels, png_width * png_height, png_channel.bytes_per_pixel, alpha_index);
+		    if (target != png_channel) graphics::convert_pixels(png_pixels, png_channel, result->get_pixels(), target, png_width * png_height);
+	    }
+	    result->has_transparency = transparent;
 
-	    graphics::Channel channel;
-	    if (colour_type == 0) channel = graphics::CHANNEL_ALPHA;
-	    if (colour_type == 2) channel = graphics::CHANNEL_RGB;
-	    if (colour_type == 3) show_exception("This colour type is not yet supported (palette index)", ERROR_INVALID_PNG);
-	    if (colour_type == 4) channel = graphics::CHANNEL_GRAY_ALPHA;
-	    if (colour_type == 6) channel = graphics::CHANNEL_RGBA;
+	    png_destroy_read_struct(&png_pointer, &info_pointer, (png_infopp)0);
 
-	    bitmap->create_bitmap(png_width, png_height, graphics::COLOR_BLACK, channel);
+	    return result;
+    }
 
-	    const uint32 row_length = bitmap->get_width() * ((bit_depth * channels) / 8);
-	    png_bytep* row_pointers = new png_bytep[bitmap->get_height()];
-	    for (size_t y = 0; y < bitmap->get_height(); ++y) {
-		    row_pointers[y] = (png_bytep)(bitmap->get_pixels() + (y * row_length));
+    /** Everything a PNGStream keeps between calls, hidden here so that png.h stays out of the header
+    **/
+    struct PNGStreamState {
+
+	    MappedFile file;
+	    PNGMemoryReader reader;
+	    std::string name;
+	    png_structp png_pointer = NULL;
+	    png_infop info_pointer = NULL;
+
+	    graphics::Channel png_channel;
+	    graphics::Channel target;
+	    int num_passes = 1;
+	    uint32 width = 0;
+	    uint32 height = 0;
+	    uint32 next_row = 0;
+	    bool transparent = false;
+	    bool failed = false;
+
+	    std::vector<uint8> scratch; /**> One png row when converting, or the whole png if it's interlaced **/
+	    std::vector<png_bytep> row_pointers;
+    };
+
+    PNGStream::PNGStream() {
+	    state = NULL;
+    }
+
+    bool PNGStream::open(std::string file_name, const graphics::Channel* channel) {
+	    close();
+
+	    state = new PNGStreamState();
+	    state->name = file_name;
+	    if (!state->file.open(file_name) || !png_validate(state->file.get_data(), state->file.get_size())) {
+		    show_exception("(" + file_name + ") is not a valid png (or it may not exist)", ERROR_INVALID_PNG);
+		    close();
+		    return false;
+	    }
+	    state->reader.data = state->file.get_data();
+	    state->reader.size = state->file.get_size();
+	    state->reader.offset = PNG_SIG_SIZE;
+
+	    state->png_pointer = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	    if (state->png_pointer) state->info_pointer = png_create_info_struct(state->png_pointer);
+	    if (!state->png_pointer || !state->info_pointer) {
+		    show_exception("Could not initialise png read structs for (" + file_name + ")", ERROR_INVALID_PNG);
+		    close();
+		    return false;
 	    }
 
-	    png_read_image(png_pointer, row_pointers);
+	    //libpng jumps back here if the header is corrupt
+	    if (setjmp(png_jmpbuf(state->png_pointer))) {
+		    show_exception("(" + state->name + ") could not be decoded", ERROR_INVALID_PNG);
+		    close();
+		    return false;
+	    }
+	    png_set_read_fn(state->png_pointer, (png_voidp)&state->reader, read_png);
 
-	    delete[] row_pointers;
-	    png_destroy_read_struct(&png_pointer, &info_pointer, (png_infopp)0);
+	    state->png_channel = read_png_layout(state->png_pointer, state->info_pointer, state->num_passes);
+	    state->target = channel != NULL ? *channel : state->png_channel;
+	    state->width = png_get_image_width(state->png_pointer, state->info_pointer);
+	    state->height = png_get_image_height(state->png_pointer, state->info_pointer);
+	    return true;
+    }
 
-	    file.close();
+    uint32 PNGStream::read_rows(uint8* dest, uint32 num_rows) {
+	    if (state == NULL || state->failed || state->next_row >= state->height) return 0;
+
+	    PNGStreamState& s = *state;
+	    if (num_rows > s.height - s.next_row) num_rows = s.height - s.next_row;
+	    const uint32 png_row_length = s.width * s.png_channel.bytes_per_pixel;
+	    const uint32 row_length = s.width * s.target.bytes_per_pixel;
+	    const short alpha_index = s.target.channel_index.a != -1 ? s.png_channel.channel_index.a : -1;
+	    const bool convert = s.target != s.png_channel;
+
+	    //libpng jumps back here if a row is corrupt. nothing in this frame needs destructing
+	    if (setjmp(png_jmpbuf(s.png_pointer))) {
+		    show_exception("(" + s.name + ") could not be decoded", ERROR_INVALID_PNG);
+		    s.failed = true;
+		    return 0;
+	    }
 
-	    return bitmap;
+	    if (s.num_passes > 1) {
+		    //interlaced pngs are decoded whole the first time, then handed out a strip at a time
+		    if (s.next_row == 0) {
+			    s.scratch.resize(png_row_length * s.height);
+			    s.row_pointers.resize(s.height);
+			    for (uint32 y = 0; y < s.height; ++y) s.row_pointers[y] = &s.scratch[y * png_row_length];
+			    png_read_image(s.png_pointer, &s.row_pointers[0]);
+		    }
+		    const uint8* rows = &s.scratch[s.next_row * png_row_length];
+		    if (!s.transparent && alpha_index != -1) {
+			    s.transparent = graphics::scan_transparency(rows, s.width * num_rows, s.png_channel.bytes_per_pixel, alpha_index);
+		    }
+		    if (convert) graphics::convert_pixels(rows, s.png_channel, dest, s.target, s.width * num_rows);
+		    else memcpy(dest, rows, png_row_length * num_rows);
+	    }else if (!convert) {
+		    //rows are already in the target layout, so the whole strip is decoded straight into dest
+		    s.row_pointers.resize(num_rows);
+		    for (uint32 y = 0; y < num_rows; ++y) s.row_pointers[y] = dest + (y * row_length);
+		    png_read_rows(s.png_pointer, &s.row_pointers[0], NULL, num_rows);
+		    if (!s.transparent && alpha_index != -1) {
+			    s.transparent = graphics::scan_transparency(dest, s.width * num_rows, s.png_channel.bytes_per_pixel, alpha_index);
+		    }
+	    }else {
+		    s.scratch.resize(png_row_length);
+		    for (uint32 y = 0; y < num_rows; ++y) {
+			    png_read_row(s.png_pointer, &s.scratch[0], NULL);
+			    if (!s.transparent && alpha_index != -1) {
+				    s.transparent = graphics::scan_transparency(&s.scratch[0], s.width, s.png_channel.bytes_per_pixel, alpha_index);
+			    }
+			    graphics::convert_pixels(&s.scratch[0], s.png_channel, dest + (y * row_length), s.target, s.width);
+		    }
+	    }
+
+	    s.next_row += num_rows;
+
+	    //the interlaced copy and the png file aren't needed once the last row has been handed out
+	    if (s.next_row == s.height) {
+		    std::vector<uint8>().swap(s.scratch);
+		    png_destroy_read_struct(&s.png_pointer, &s.info_pointer, (png_infopp)0);
+		    s.png_pointer = NULL;
+		    s.info_pointer = NULL;
+		    s.file.close();
+	    }
+	    return num_rows;
+    }
+
+    void PNGStream::close() {
+	    if (state != NULL) {
+		    if (state->png_pointer) png_destroy_read_struct(&state->png_pointer, state->info_pointer ? &state->info_pointer : (png_infopp)0, (png_infopp)0);
+		    delete state;
+		    state = NULL;
+	    }
     }
 
-    void read_png(png_structp png_pointer, png_bytep data, png_size_t length) {
-	    file.read((int8*)data, length);
+    uint32 PNGStream::get_width() const { return state != NULL ? state->width : 0; }
+    uint32 PNGStream::get_height() const { return state != NULL ? state->height : 0; }
+    uint32 PNGStream::get_next_row() const { return state != NULL ? state->next_row : 0; }
+    graphics::Channel PNGStream::get_channel() const { return state != NULL ? state->target : graphics::CHANNEL_RGBA; }
+    bool PNGStream::is_finished() const { return state != NULL && state->next_row >= state->height; }
+    bool PNGStream::has_error() const { return state != NULL && state->failed; }
+    bool PNGStream::has_transparency() const { return state != NULL && state->transparent; }
+
+    PNGStream::~PNGStream() {
+	    close();
     }
 
-    bool png_validate(std::ifstream& file) {
-	    //allocate a buffer of 8 constant bytes
-	    png_byte png_sig[PNG_SIG_SIZE];
+    std::vector<std::future<graphics::Bitmap*>> load_png_batch(const std::vector<std::string>& file_names, ThreadPool* pool) {
+	    if (pool == NULL) pool = get_thread_pool();
 
-	    //read 8 byte sig from stream into buffer
-	    file.read((char*)png_sig, PNG_SIG_SIZE);
+	    std::vector<std::future<graphics::Bitmap*>> bitmaps;
+	    bitmaps.reserve(file_names.size());
+	    for (size_t n = 0; n < file_names.size(); ++n) {
+		    std::string file_name = file_names[n];
+		    bitmaps.push_back(pool->submit([file_name]() -> graphics::Bitmap* {
+			    graphics::Bitmap* bitmap = new graphics::Bitmap();
+			    if (bitmap->create_bitmap(file_name)) return bitmap;
+
+			    delete bitmap;
+			    return NULL;
+		    }));
+	    }
+	    return bitmaps;
+    }
+
+    static void read_png(png_structp png_pointer, png_bytep data, png_size_t length) {
+	    PNGMemoryReader* reader = (PNGMemoryReader*)png_get_io_ptr(png_pointer);
+	    if (length > reader->size - reader->offset) png_error(png_pointer, "unexpected end of file");
+
+	    memcpy(data, reader->data + reader->offset, length);
+	    reader->offset += length;
+    }
 
-	    //return valid/invalid sig
-	    return (png_sig_cmp(png_sig, 0, PNG_SIG_SIZE) == 0);
+    static bool png_validate(const uint8* data, size_t size) {
+	    //return valid/invalid 8 byte sig
+	    return data != NULL && size >= PNG_SIG_SIZE && png_sig_cmp((png_const_bytep)data, 0, PNG_SIG_SIZE) == 0;
     }
 }};
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "system/LZ4.h"
+
+#include <cstring>
+#include <vector>
+
+namespace pxl { namespace sys {
+
+    //cpp constants (hidden from public)
+    #define LZ4_MIN_MATCH 4                                                 //the shortest match a sequence can hold
+    #define LZ4_LAST_LITERALS 5                                             //the last bytes of a block are always literals
+    #define LZ4_MATCH_START_LIMIT 12                                        //the last match has to start at least this many bytes before the end
+    #define LZ4_MAX_OFFSET 65535                                            //matches are at most this far back, as offsets are 16 bit
+    #define LZ4_HASH_LOG 16                                                 //the match finder hashes 4 bytes into 2^16 slots
+
+    static inline uint32 read32(const uint8* p) {
+        uint32 v;
+        memcpy(&v, p, sizeof(uint32));
+        return v;
+    }
+
+    static inline uint32 hash_sequence(uint32 sequence) {
+        return (sequence * 2654435761u) >> (32 - LZ4_HASH_LOG);
+    }
+
+    /** Writes the 255 byte run that extends a literal or match length past the 4 bits it has in the token
+    **/
+    static inline uint8* write_length(uint8* op, size_t length) {
+        for (; length >= 255; length -= 255) *op++ = 255;
+        *op++ = uint8(length);
+        return op;
+    }
+
+    /** Writes a token, its literals and, if match_length isn't 0, the match offset and length
+    **/
+    static uint8* write_sequence(uint8* op, const uint8* literals, size_t num_literals, size_t offset, size_t match_length) {
+        size_t extra_match = match_length != 0 ? match_length - LZ4_MIN_MATCH : 0;
+        *op++ = uint8(((num_literals < 15 ? num_literals : 15) << 4) | (extra_match < 15 ? extra_match : 15));
+        if (num_literals >= 15) op = write_length(op, num_literals - 15);
+        memcpy(op, literals, num_literals);
+        op += num_literals;
+
+        if (match_length != 0) {
+            *op++ = uint8(offset & 255);
+            *op++ = uint8(offset >> 8);
+            if (extra_match >= 15) op = write_length(op, extra_match - 15);
+        }
+        return op;
+    }
+
+    size_t lz4_compress_bound(size_t src_size) {
+        return src_size + (src_size / 255) + 16;
+    }
+
+    size_t lz4_compress(const uint8* src, size_t src_size, uint8* dest, size_t dest_capacity) {
+        if (dest_capacity < lz4_compress_bound(src_size)) return 0;
+
+        uint8* op = dest;
+        size_t anchor = 0;
+        if (src_size > LZ4_MATCH_START_LIMIT) {
+            //positions are stored + 1 so that 0 means the slot is empty
+            std::vector<uint32> table(1 << LZ4_HASH_LOG, 0);
+            const size_t match_start_end = src_size - LZ4_MATCH_START_LIMIT;
+            const size_t match_end = src_size - LZ4_LAST_LITERALS;
+
+            size_t pos = 0;
+            while (pos < match_start_end) {
+                uint32 sequence = read32(src + pos);
+                uint32& slot = table[hash_sequence(sequence)];
+                size_t candidate = slot;
+                slot = uint32(pos + 1);
+
+                if (candidate != 0 && pos - (candidate - 1) <= LZ4_MAX_OFFSET && read32(src + candidate - 1) == sequence) {
+                    size_t match = candidate - 1;
+
+                    //extend the match forwards, then backwards over literals that also match
+                    size_t length = LZ4_MIN_MATCH;
+                    while (pos + length < match_end && src[match + length] == src[pos + length]) ++length;
+                    while (pos > anchor && match > 0 && src[match - 1] == src[pos - 1]) { --pos; --match; ++length; }
+
+                    op = write_sequence(op, src + anchor, pos - anchor, pos - match, length);
+                    pos += length;
+                    anchor = pos;
+                    continue;
+                }
+                ++pos;
+            }
+        }
+
+        //everything after the last match is written as literals
+        op = write_sequence(op, src + anchor, src_size - anchor, 0, 0);
+        return op - dest;
+    }
+
+    /** Reads the 255 byte run that extends a length, returning false if it runs past the end of the block
+    **/
+    static inline bool read_length(const uint8*& ip, const uint8* iend, size_t& length) {
+        uint8 b;
+        do {
+            if (ip >= iend) return false;
+            b = *ip++;
+            length += b;
+        }while (b == 255);
+        return true;
+    }
+
+    bool lz4_decompress(const uint8* src, size_t src_size, uint8* dest, size_t dest_size) {
+        const uint8* ip = src;
+        const uint8* iend = src + src_size;
+        uint8* op = dest;
+        uint8* oend = dest + dest_size;
+
+        while (ip < iend) {
+            uint8 token = *ip++;
+
+            size_t num_literals = token >> 4;
+            if (num_literals == 15 && !read_length(ip, iend, num_literals)) return false;
+            if (num_literals > size_t(iend - ip) || num_literals > size_t(oend - op)) return false;
+            memcpy(op, ip, num_literals);
+            op += num_literals;
+            ip += num_literals;
+
+            //the last sequence has no match
+            if (ip == iend) break;
+
+            if (iend - ip < 2) return false;
+            size_t offset = ip[0] | (ip[1] << 8);
+            ip += 2;
+            if (offset == 0 || offset > size_t(op - dest)) return false;
+
+            size_t length = token & 15;
+            if (length == 15 && !read_length(ip, iend, length)) return false;
+            length += LZ4_MIN_MATCH;
+            if (length > size_t(oend - op)) return false;
+
+            //matches can overlap the bytes they write (a run), so those are copied a byte at a time
+            const uint8* match = op - offset;
+            if (offset >= length) {
+                memcpy(op, match, length);
+            }else {
+                for (size_t n = 0; n < length; ++n) op[n] = match[n];
+            }
+            op += length;
+        }
+        return op == oend;
+    }
+}};
@@ -1,4 +1,5 @@
 #include "system/Math.h"
+#include <cmath>
 #include <iostream>
 
 namespace pxl { namespace math {
@@ -0,0 +1,268 @@
+#include "system/TextureContainer.h"
+
+#include <cstring>
+#include <fstream>
+
+#include "system/Exception.h"
+#include "system/ImageIO.h"
+#include "system/LZ4.h"
+#include "graphics/PixelPool.h"
+#include "graphics/PixelConvert.h"
+
+namespace pxl { namespace sys {
+
+    //cpp constants (hidden from public)
+    #define PAYLOAD_ALIGNMENT 64                                            //payloads start on a cache line so raw pixels are uploaded from aligned memory
+    #define MAX_MIPS 32                                                     //enough levels for any 32 bit width or height
+
+    TextureContainer::TextureContainer() {
+        data = NULL;
+        size = 0;
+        opened = false;
+        scratch = NULL;
+        scratch_size = 0;
+        memset(&header, 0, sizeof(TextureContainerHeader));
+    }
+
+    bool TextureContainer::open(std::string file_name) {
+        close();
+
+        if (!file.open(file_name)) {
+            show_exception("(" + file_name + ") is not a valid texture container (or it may not exist)", ERROR_INVALID_TEXTURE_CONTAINER);
+            return false;
+        }
+
+        data = file.get_data();
+        size = file.get_size();
+        name = file_name;
+        if (!validate()) {
+            close();
+            return false;
+        }
+        opened = true;
+        return true;
+    }
+
+    bool TextureContainer::open_from_memory(const uint8* container_data, size_t container_size, std::string container_name) {
+        close();
+
+        data = container_data;
+        size = container_size;
+        name = container_name;
+        if (!validate()) {
+            close();
+            return false;
+        }
+        opened = true;
+        return true;
+    }
+
+    bool TextureContainer::validate() {
+        if (data == NULL || size < sizeof(TextureContainerHeader)) {
+            show_exception("(" + name + ") is too small to be a texture container", ERROR_INVALID_TEXTURE_CONTAINER);
+            return false;
+        }
+        memcpy(&header, data, sizeof(TextureContainerHeader));
+        if (header.magic != TEXTURE_CONTAINER_MAGIC || header.version != TEXTURE_CONTAINER_VERSION) {
+            show_exception("(" + name + ") is not a texture container or was written by a different version", ERROR_INVALID_TEXTURE_CONTAINER);
+            return false;
+        }
+
+        channel.num_channels = header.num_channels;
+        channel.gl_pixel_mode = header.gl_pixel_mode;
+        channel.gl_pixel_type = header.gl_pixel_type;
+        channel.bytes_per_pixel = header.bytes_per_pixel;
+        channel.premultiplied = header.premultiplied != 0;
+        channel.channel_index.r = header.channel_index[0];
+        channel.channel_index.g = header.channel_index[1];
+        channel.channel_index.b = header.channel_index[2];
+        channel.channel_index.a = header.channel_index[3];
+
+        if (header.width == 0 || header.height == 0 || header.bytes_per_pixel == 0 || header.bytes_per_pixel > 4 ||
+            header.num_mips == 0 || header.num_mips > MAX_MIPS ||
+            size - sizeof(TextureContainerHeader) < header.num_mips * sizeof(TextureContainerMip)) {
+            show_exception("(" + name + ") has an invalid header", ERROR_INVALID_TEXTURE_CONTAINER);
+            return false;
+        }
+
+        mips.resize(header.num_mips);
+        memcpy(&mips[0], data + sizeof(TextureContainerHeader), header.num_mips * sizeof(TextureContainerMip));
+
+        //every level has to be half the size of the last and its payload has to be inside the file
+        uint32 w = header.width, h = header.height;
+        for (uint32 n = 0; n < header.num_mips; ++n) {
+            const TextureContainerMip& mip = mips[n];
+            bool valid = mip.width == w && mip.height == h && mip.size == uint64(w) * h * header.bytes_per_pixel &&
+                         mip.offset <= size && mip.stored_size <= size - mip.offset && mip.size <= UINT_MAX &&
+                         (is_compressed() || mip.stored_size == mip.size);
+            if (!valid) {
+                show_exception("(" + name + ") has an invalid mip table", ERROR_INVALID_TEXTURE_CONTAINER);
+                return false;
+            }
+            w = w > 1 ? w / 2 : 1;
+            h = h > 1 ? h / 2 : 1;
+        }
+        return true;
+    }
+
+    const uint8* TextureContainer::get_mip_pixels(uint32 level) {
+        if (!opened || level >= mips.size()) return NULL;
+
+        const TextureContainerMip& mip = mips[level];
+        const uint8* payload = data + mip.offset;
+        if (!is_compressed()) return payload;
+
+        if (scratch_size < mip.size) {
+            graphics::free_pixels(scratch);
+            scratch = graphics::alloc_pixels(mip.size);
+            scratch_size = scratch != NULL ? mip.size : 0;
+            if (scratch == NULL) return NULL;
+        }
+        if (!lz4_decompress(payload, mip.stored_size, scratch, mip.size)) {
+            show_exception("(" + name + ") has a corrupt payload", ERROR_INVALID_TEXTURE_CONTAINER);
+            return NULL;
+        }
+        return scratch;
+    }
+
+    bool TextureContainer::has_full_mip_chain() const {
+        return !mips.empty() && mips.back().width == 1 && mips.back().height == 1;
+    }
+
+    void TextureContainer::close() {
+        file.close();
+        data = NULL;
+        size = 0;
+        opened = false;
+        mips.clear();
+        memset(&header, 0, sizeof(TextureContainerHeader));
+
+        graphics::free_pixels(scratch);
+        scratch = NULL;
+        scratch_size = 0;
+    }
+
+    TextureContainer::~TextureContainer() {
+        close();
+    }
+
+    /** Halves an rgba image with a 2x2 box filter. Odd edges reuse their last row or column
+    **/
+    static void downsample_rgba(const uint8* src, uint32 src_width, uint32 src_height, uint8* dest, uint32 dest_width, uint32 dest_height) {
+        for (uint32 y = 0; y < dest_height; ++y) {
+            const uint8* row0 = src + ((y * 2 < src_height ? y * 2 : src_height - 1) * src_width * 4);
+            const uint8* row1 = src + ((y * 2 + 1 < src_height ? y * 2 + 1 : src_height - 1) * src_width * 4);
+            for (uint32 x = 0; x < dest_width; ++x) {
+                uint32 x0 = (x * 2 < src_width ? x * 2 : src_width - 1) * 4;
+                uint32 x1 = (x * 2 + 1 < src_width ? x * 2 + 1 : src_width - 1) * 4;
+                uint8* d = dest + ((y * dest_width + x) * 4);
+                for (int c = 0; c < 4; ++c) d[c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2;
+            }
+        }
+    }
+
+    /** Appends a payload to the file, compressing it if asked, and fills in its mip entry
+    **/
+    static void write_payload(std::vector<uint8>& payloads, const uint8* pixels, uint32 num_bytes, bool compress, TextureContainerMip& mip) {
+        mip.size = num_bytes;
+        mip.offset = payloads.size();
+        if (compress) {
+            payloads.resize(mip.offset + lz4_compress_bound(num_bytes));
+            mip.stored_size = lz4_compress(pixels, num_bytes, &payloads[mip.offset], payloads.size() - mip.offset);
+        }else {
+            payloads.resize(mip.offset + num_bytes);
+            memcpy(&payloads[mip.offset], pixels, num_bytes);
+            mip.stored_size = num_bytes;
+        }
+
+        //pad so the next payload starts on the alignment
+        payloads.resize((mip.offset + mip.stored_size + PAYLOAD_ALIGNMENT - 1) & ~uint64(PAYLOAD_ALIGNMENT - 1));
+    }
+
+    bool save_texture_container(std::string file_name, graphics::Bitmap* bitmap, bool compress, bool generate_mips) {
+        if (bitmap == NULL || bitmap->get_pixels() == NULL) {
+            show_exception("Could not write (" + file_name + "), the bitmap has no pixels", ERROR_INVALID_TEXTURE_CONTAINER);
+            return false;
+        }
+
+        const graphics::Channel channel = bitmap->get_channel();
+        TextureContainerHeader header;
+        memset(&header, 0, sizeof(TextureContainerHeader));
+        header.magic = TEXTURE_CONTAINER_MAGIC;
+        header.version = TEXTURE_CONTAINER_VERSION;
+        header.width = bitmap->get_width();
+        header.height = bitmap->get_height();
+        header.num_channels = channel.num_channels;
+        header.gl_pixel_mode = channel.gl_pixel_mode;
+        header.gl_pixel_type = channel.gl_pixel_type;
+        header.bytes_per_pixel = channel.bytes_per_pixel;
+        header.channel_index[0] = channel.channel_index.r;
+        header.channel_index[1] = channel.channel_index.g;
+        header.channel_index[2] = channel.channel_index.b;
+        header.channel_index[3] = channel.channel_index.a;
+        header.premultiplied = channel.premultiplied;
+        header.flags = (bitmap->has_transparency ? TEXTURE_CONTAINER_TRANSPARENT : 0) | (compress ? TEXTURE_CONTAINER_LZ4 : 0);
+
+        std::vector<TextureContainerMip> mips(1);
+        std::vector<uint8> payloads;
+        mips[0].width = header.width;
+        mips[0].height = header.height;
+        write_payload(payloads, bitmap->get_pixels(), header.width * header.height * channel.bytes_per_pixel, compress, mips[0]);
+
+        if (generate_mips) {
+            //levels are filtered in rgba (keeping the premultiply of the channel) and converted back for each level
+            const graphics::Channel rgba = channel.premultiplied ? graphics::CHANNEL_RGBA_PREMULTIPLIED : graphics::CHANNEL_RGBA;
+            uint32 w = header.width, h = header.height;
+            std::vector<uint8> level(w * h * 4), next, converted;
+            graphics::convert_pixels(bitmap->get_pixels(), channel, &level[0], rgba, w * h);
+
+            while (w > 1 || h > 1) {
+                uint32 next_w = w > 1 ? w / 2 : 1, next_h = h > 1 ? h / 2 : 1;
+                next.resize(next_w * next_h * 4);
+                downsample_rgba(&level[0], w, h, &next[0], next_w, next_h);
+                level.swap(next);
+                w = next_w;
+                h = next_h;
+
+                converted.resize(w * h * channel.bytes_per_pixel);
+                graphics::convert_pixels(&level[0], rgba, &converted[0], channel, w * h);
+
+                TextureContainerMip mip;
+                mip.width = w;
+                mip.height = h;
+                write_payload(payloads, &converted[0], converted.size(), compress, mip);
+                mips.push_back(mip);
+            }
+        }
+        header.num_mips = mips.size();
+
+        //payload offsets were relative to the first payload, which starts after the mip table
+        uint64 table_end = sizeof(TextureContainerHeader) + (mips.size() * sizeof(TextureContainerMip));
+        uint64 payload_start = (table_end + PAYLOAD_ALIGNMENT - 1) & ~uint64(PAYLOAD_ALIGNMENT - 1);
+        for (size_t n = 0; n < mips.size(); ++n) mips[n].offset += payload_start;
+
+        std::ofstream file(file_name.c_str(), std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+        if (!file) {
+            show_exception("Could not open (" + file_name + ") for writing", ERROR_INVALID_FILE);
+            return false;
+        }
+        const char padding[PAYLOAD_ALIGNMENT] = {};
+        file.write((const char*)&header, sizeof(TextureContainerHeader));
+        file.write((const char*)&mips[0], mips.size() * sizeof(TextureContainerMip));
+        file.write(padding, payload_start - table_end);
+        file.write((const char*)&payloads[0], payloads.size());
+        if (!file) {
+            show_exception("Could not write (" + file_name + ")", ERROR_INVALID_FILE);
+            return false;
+        }
+        return true;
+    }
+
+    bool convert_png_to_container(std::string png_file_name, std::string file_name, const graphics::Channel* channel,
+                                  bool compress, bool generate_mips) {
+        graphics::Bitmap bitmap;
+        if (load_png(png_file_name, &bitmap, channel) == NULL) return false;
+
+        return save_texture_container(file_name, &bitmap, compress, generate_mips);
+    }
+}};
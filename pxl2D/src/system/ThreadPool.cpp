@@ -0,0 +1,53 @@
+#include "system/ThreadPool.h"
+
+namespace pxl { namespace sys {
+
+    //the pool the calling thread works for, or NULL if it isn't a worker
+    static thread_local const ThreadPool* current_pool = NULL;
+
+    ThreadPool::ThreadPool(uint32 num_threads) {
+        if (num_threads == 0) num_threads = std::thread::hardware_concurrency();
+        //hardware_concurrency can return 0 if the amount of threads isn't known
+        if (num_threads == 0) num_threads = 1;
+
+        workers.reserve(num_threads);
+        for (uint32 n = 0; n < num_threads; ++n) {
+            workers.push_back(std::thread(&ThreadPool::run_worker, this));
+        }
+    }
+
+    void ThreadPool::run_worker() {
+        current_pool = this;
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                queue_condition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                if (jobs.empty()) return;
+
+                job = std::move(jobs.front());
+                jobs.pop();
+            }
+            job();
+        }
+    }
+
+    bool ThreadPool::is_worker_thread() const {
+        return current_pool == this;
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            stopping = true;
+        }
+        queue_condition.notify_all();
+        for (size_t n = 0; n < workers.size(); ++n) workers[n].join();
+    }
+
+    ThreadPool* get_thread_pool() {
+        //function static so the workers are only started if something uses the pool
+        static ThreadPool pool;
+        return &pool;
+    }
+}};
@@ -0,0 +1,220 @@
+#include "Test.h"
+
+#include <cstring>
+#include <thread>
+#include "graphics/Batch.h"
+#include "graphics/Texture.h"
+
+using namespace pxl;
+using namespace pxl::graphics;
+
+/** Gets a copy of the last buffer uploaded to GL_ARRAY_BUFFER
+**/
+template <typename T> static std::vector<T> get_uploaded(uint32 num) {
+    GLuint id = 0;
+    const std::vector<MockGLCommand>& log = get_mock_gl_log();
+    for (size_t n = 0; n < log.size(); ++n) {
+        if (strcmp(log[n].name, "glBindBuffer") == 0 && log[n].args[0] == GL_ARRAY_BUFFER) id = GLuint(log[n].args[1]);
+    }
+    std::vector<T> result(num);
+    const std::vector<unsigned char>* buffer = get_mock_gl_buffer(id);
+    if (buffer != NULL && buffer->size() >= num * sizeof(T)) memcpy(&result[0], &(*buffer)[0], num * sizeof(T));
+    return result;
+}
+
+/** Expands an instance into its 4 corners the same way the instanced vertex shader does
+**/
+static void expand_instance(const InstancePoint& inst, VertexPoint* v) {
+    float l = inst.bounds.left, t = inst.bounds.top, r = inst.bounds.right, b = inst.bounds.bottom;
+    float c = inst.rotation.c, s = inst.rotation.s;
+    float corners[4][2] = { { l, t }, { r, t }, { r, b }, { l, b } };
+    for (int i = 0; i < 4; ++i) {
+        v[i].pos.x = inst.pivot.x + (c * corners[i][0]) - (s * corners[i][1]);
+        v[i].pos.y = inst.pivot.y + (s * corners[i][0]) + (c * corners[i][1]);
+        v[i].colour.r = inst.colour.r; v[i].colour.g = inst.colour.g; v[i].colour.b = inst.colour.b; v[i].colour.a = inst.colour.a;
+    }
+    v[0].uv.x = inst.uv.x;              v[0].uv.y = inst.uv.y;
+    v[2].uv.x = inst.uv.x + inst.uv.w;  v[2].uv.y = inst.uv.y + inst.uv.h;
+}
+
+template <typename T> static void add_test_quads(T& target, const Texture& texture) {
+    for (int n = 0; n < 12; ++n) {
+        Rect rect(float(n * 30), float(n * 20), float(8 + n), float(20 - n));
+        Rect src(1, 0, 2, 3);
+        Vec2 origin(rect.x + 4, rect.y + 4);
+        target.add(texture, &rect, n % 2 == 0 ? &src : NULL, float(n * 40), &origin, NULL, 0, Colour(1, 0.5f, 0.25f, 1));
+    }
+}
+
+static void check_vertices_near(const std::vector<VertexPoint>& a, const std::vector<VertexPoint>& b, bool all_uvs) {
+    CHECK_EQ(a.size(), b.size());
+    for (size_t n = 0; n < a.size() && n < b.size(); ++n) {
+        CHECK_NEAR(a[n].pos.x, b[n].pos.x, 0.01);
+        CHECK_NEAR(a[n].pos.y, b[n].pos.y, 0.01);
+        if (all_uvs || n % 4 == 0 || n % 4 == 2) {
+            CHECK_EQ(a[n].uv.x, b[n].uv.x);
+            CHECK_EQ(a[n].uv.y, b[n].uv.y);
+        }
+        CHECK_EQ(int(a[n].colour.r), int(b[n].colour.r));
+        CHECK_EQ(int(a[n].colour.a), int(b[n].colour.a));
+    }
+}
+
+TEST(recorder_instances_merge_into_vertex_batch) {
+    test::init_graphics();
+    uint8 pixels[4 * 4 * 4];
+    memset(pixels, 255, sizeof(pixels));
+    Texture texture;
+    texture.create_texture(4, 4, pixels);
+
+    Batch reference(NULL);
+    add_test_quads(reference, texture);
+    reference.render_all();
+    std::vector<VertexPoint> expected = get_uploaded<VertexPoint>(12 * 4);
+    CHECK(expected[4].pos.x != 0);
+
+    Batch batch(NULL);
+    BatchRecorder* recorder = batch.create_recorder();
+    recorder->set_draw_mode(DRAW_INSTANCED);
+    add_test_quads(*recorder, texture);
+    reset_mock_gl();
+    batch.render_all();
+    CHECK_EQ(get_mock_gl_stats().vertices_drawn, 12u * 6);
+    check_vertices_near(get_uploaded<VertexPoint>(12 * 4), expected, true);
+}
+
+TEST(recorder_vertices_merge_into_instanced_batch) {
+    test::init_graphics();
+    uint8 pixels[4 * 4 * 4];
+    memset(pixels, 255, sizeof(pixels));
+    Texture texture;
+    texture.create_texture(4, 4, pixels);
+
+    Batch reference(NULL);
+    add_test_quads(reference, texture);
+    reference.render_all();
+    std::vector<VertexPoint> expected = get_uploaded<VertexPoint>(12 * 4);
+    CHECK(expected[4].pos.x != 0);
+
+    Batch batch(NULL);
+    batch.set_draw_mode(DRAW_INSTANCED);
+    BatchRecorder* recorder = batch.create_recorder();
+    recorder->set_draw_mode(DRAW_VERTICES);
+    add_test_quads(*recorder, texture);
+    reset_mock_gl();
+    batch.render_all();
+    CHECK_EQ(get_mock_gl_stats().instances_drawn, 12u);
+
+    std::vector<InstancePoint> instances = get_uploaded<InstancePoint>(12);
+    std::vector<VertexPoint> expanded(12 * 4);
+    for (int n = 0; n < 12; ++n) expand_instance(instances[n], &expanded[n * 4]);
+    check_vertices_near(expanded, expected, false);
+}
+
+#define THREADED_RECORDERS 4
+#define THREADED_QUADS 60
+
+/** Adds quad n of a recorder (or of the batch itself as recorder -1) with a z depth, texture and x position
+that only depend on which quad it is, so every quad can be told apart once it's uploaded. Every quad overlaps
+every other, so none can be grouped out of painter order and each depth comes straight from it
+**/
+template <typename T> static void add_numbered_quad(T& target, int recorder, int n, const Texture* textures) {
+    int index = ((recorder + 1) * THREADED_QUADS) + n;
+    Rect rect(index * .25f, 0, 200, 4);
+    target.add(textures[index % 3], &rect, NULL, 0, NULL, NULL, (((recorder + 1) * 5) + (n * 3)) % 4 - 1);
+}
+
+/** Gets the 4 corners and depth of every uploaded quad, expanding instances the same way the shader does
+**/
+static std::vector<VertexPoint> get_uploaded_corners(BatchDrawMode mode, uint32 num_quads) {
+    if (mode == DRAW_VERTICES) return get_uploaded<VertexPoint>(num_quads * 4);
+    std::vector<InstancePoint> instances = get_uploaded<InstancePoint>(num_quads);
+    std::vector<VertexPoint> corners(num_quads * 4);
+    for (uint32 n = 0; n < num_quads; ++n) {
+        expand_instance(instances[n], &corners[n * 4]);
+        for (int i = 0; i < 4; ++i) corners[(n * 4) + i].pos.z = instances[n].z;
+    }
+    return corners;
+}
+
+/** Fills several recorders from their own threads, one of them through a recorder appended to it, and checks the
+merged quads upload the same as adding them all from one thread, with depths in (z, recorder, add) order
+**/
+static void check_threaded_recorders(BatchDrawMode mode) {
+    test::init_graphics();
+    Texture textures[3];
+    uint8 pixels[4 * 4 * 4];
+    memset(pixels, 255, sizeof(pixels));
+    for (int n = 0; n < 3; ++n) {
+        textures[n].create_texture(4, 4, pixels);
+        textures[n].has_transparency = n == 2;
+    }
+    //the batch's own quads, every recorder's and then the appended recorder's
+    const uint32 num_quads = (THREADED_RECORDERS + 2) * THREADED_QUADS;
+
+    Batch reference(NULL);
+    reference.set_draw_mode(mode);
+    for (int r = -1; r <= THREADED_RECORDERS; ++r) {
+        for (int n = 0; n < THREADED_QUADS; ++n) add_numbered_quad(reference, r, n, textures);
+    }
+    reset_mock_gl();
+    reference.render_all();
+    std::vector<VertexPoint> expected = get_uploaded_corners(mode, num_quads);
+    uint32 expected_draws = get_mock_gl_stats().draw_calls;
+
+    Batch batch(NULL);
+    batch.set_draw_mode(mode);
+    for (int n = 0; n < THREADED_QUADS; ++n) add_numbered_quad(batch, -1, n, textures);
+    BatchRecorder* recorders[THREADED_RECORDERS];
+    for (int r = 0; r < THREADED_RECORDERS; ++r) {
+        recorders[r] = batch.create_recorder();
+        recorders[r]->set_draw_mode(r % 2 == 0 ? DRAW_VERTICES : DRAW_INSTANCED);
+    }
+    BatchRecorder appended;
+
+    std::vector<std::thread> threads;
+    for (int r = 0; r <= THREADED_RECORDERS; ++r) {
+        BatchRecorder* recorder = r < THREADED_RECORDERS ? recorders[r] : &appended;
+        threads.push_back(std::thread([recorder, r, &textures]() {
+            for (int n = 0; n < THREADED_QUADS; ++n) add_numbered_quad(*recorder, r, n, textures);
+        }));
+    }
+    for (size_t n = 0; n < threads.size(); ++n) threads[n].join();
+    recorders[THREADED_RECORDERS - 1]->append(appended);
+
+    reset_mock_gl();
+    batch.render_all();
+    CHECK_EQ(get_mock_gl_stats().draw_calls, expected_draws);
+    std::vector<VertexPoint> uploaded = get_uploaded_corners(mode, num_quads);
+    check_vertices_near(uploaded, expected, mode == DRAW_VERTICES);
+    for (size_t n = 0; n < uploaded.size() && n < expected.size(); ++n) CHECK_EQ(uploaded[n].pos.z, expected[n].pos.z);
+
+    //quads are numbered in recorder and add order, so painter order is by z and then by number
+    std::vector<float> depths(num_quads, 0);
+    for (uint32 q = 0; q < num_quads; ++q) {
+        int index = int((uploaded[q * 4].pos.x * 4) + .5f);
+        if (index >= 0 && index < int(num_quads)) depths[index] = uploaded[q * 4].pos.z;
+    }
+    float last_depth = 0;
+    bool first = true, ordered = true;
+    for (int z = -1; z <= 2; ++z) {
+        for (int r = -1; r <= THREADED_RECORDERS; ++r) {
+            for (int n = 0; n < THREADED_QUADS; ++n) {
+                if ((((r + 1) * 5) + (n * 3)) % 4 - 1 != z) continue;
+                float depth = depths[((r + 1) * THREADED_QUADS) + n];
+                if (!first && !(depth < last_depth)) ordered = false;
+                last_depth = depth;
+                first = false;
+            }
+        }
+    }
+    CHECK(ordered);
+}
+
+TEST(recorders_filled_from_threads_vertices) {
+    check_threaded_recorders(DRAW_VERTICES);
+}
+
+TEST(recorders_filled_from_threads_instanced) {
+    check_threaded_recorders(DRAW_INSTANCED);
+}
@@ -0,0 +1,355 @@
+#include "Test.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include "graphics/Batch.h"
+#include "graphics/GLState.h"
+#include "graphics/ShaderUtils.h"
+#include "graphics/Texture.h"
+
+using namespace pxl;
+using namespace pxl::graphics;
+
+/** Creates a 4x4 texture filled with one colour, with or without transparency
+**/
+static void create_solid_texture(Texture& texture, bool transparent) {
+    uint8 pixels[4 * 4 * 4];
+    for (int n = 0; n < 4 * 4; ++n) {
+        pixels[n * 4] = 255; pixels[n * 4 + 1] = 255; pixels[n * 4 + 2] = 255; pixels[n * 4 + 3] = transparent ? 128 : 255;
+    }
+    texture.create_texture(4, 4, pixels);
+    texture.has_transparency = transparent;
+}
+
+TEST(batch_groups_interleaved_opaque_textures) {
+    test::init_graphics();
+    Texture a, b;
+    create_solid_texture(a, false);
+    create_solid_texture(b, false);
+
+    Batch batch(NULL);
+    for (int n = 0; n < 10; ++n) {
+        Rect rect(n * 8, 0, 4, 4);
+        batch.add(n % 2 == 0 ? a : b, &rect);
+    }
+    reset_mock_gl();
+    batch.render_all();
+    CHECK_EQ(get_mock_gl_stats().draw_calls, 2u);
+    CHECK_EQ(get_mock_gl_stats().vertices_drawn, 60u);
+}
+
+TEST(batch_keeps_transparent_order_between_opaque_runs) {
+    test::init_graphics();
+    Texture a, b, t;
+    create_solid_texture(a, false);
+    create_solid_texture(b, false);
+    create_solid_texture(t, true);
+
+    //a b a | t | b a b: the transparent quad splits the opaque quads into two runs that are each grouped into two
+    //draws, and drawn front to back the two runs of b meet (a b b | b a a)
+    Batch batch(NULL);
+    const Texture* order[] = { &a, &b, &a, &t, &b, &a, &b };
+    for (int n = 0; n < 7; ++n) {
+        Rect rect(n * 8, 0, 4, 4);
+        batch.add(*order[n], &rect);
+    }
+    reset_mock_gl();
+    batch.render_all();
+    CHECK_EQ(get_mock_gl_stats().draw_calls, 4u);
+}
+
+/** The state and size of one recorded draw call
+**/
+struct DrawRecord {
+
+    int64 texture, program, blend, num_quads;
+
+    bool operator==(const DrawRecord& d) const {
+        return texture == d.texture && program == d.program && blend == d.blend && num_quads == d.num_quads;
+    }
+};
+
+static std::ostream& operator<<(std::ostream& out, const std::vector<DrawRecord>& draws) {
+    for (size_t n = 0; n < draws.size(); ++n) {
+        out << "(tex " << draws[n].texture << ", prog " << draws[n].program << ", blend " << draws[n].blend << ", quads " << draws[n].num_quads << ") ";
+    }
+    return out;
+}
+
+/** Walks the mock command log and records the bound texture, program and blend state of every draw call.
+Programs are mapped through program_map if they're in it
+**/
+static std::vector<DrawRecord> record_draws(const std::map<int64, int64>& program_map = std::map<int64, int64>()) {
+    std::vector<DrawRecord> draws;
+    DrawRecord state = { -1, -1, -1, 0 };
+    const std::vector<MockGLCommand>& log = get_mock_gl_log();
+    for (size_t n = 0; n < log.size(); ++n) {
+        std::string name = log[n].name;
+        if (name == "glBindTexture") state.texture = log[n].args[1];
+        else if (name == "glUseProgram") state.program = log[n].args[0];
+        else if ((name == "glEnable" || name == "glDisable") && log[n].args[0] == GL_BLEND) state.blend = name == "glEnable";
+        else if (name == "glDrawElements" || name == "glDrawArraysInstanced") {
+            DrawRecord draw = state;
+            draw.num_quads = name == "glDrawElements" ? log[n].args[1] / 6 : log[n].args[3];
+            std::map<int64, int64>::const_iterator it = program_map.find(draw.program);
+            if (it != program_map.end()) draw.program = it->second;
+            draws.push_back(draw);
+        }
+    }
+    return draws;
+}
+
+/** Adds the same mix of textures, shaders, z depths and transparency to a batch
+**/
+static void add_mixed_scene(Batch& batch, const Texture* textures, int num_textures) {
+    ShaderProgram* shaders[] = { NULL, bloom_shader, grayscale_shader };
+    for (int n = 0; n < 60; ++n) {
+        Rect rect(float(n * 7 % 500), float(n * 13 % 400), 16, 16);
+        batch.add(textures[n % num_textures], &rect, NULL, float(n % 4) * 10, NULL, NULL, n % 3, COLOUR_WHITE, shaders[(n / 5) % 3]);
+    }
+}
+
+TEST(batch_instanced_draws_match_vertex_draws) {
+    test::init_graphics();
+    Texture textures[3];
+    create_solid_texture(textures[0], false);
+    create_solid_texture(textures[1], true);
+    create_solid_texture(textures[2], false);
+
+    Batch vertex_batch(NULL);
+    add_mixed_scene(vertex_batch, textures, 3);
+    invalidate_gl_state();
+    reset_mock_gl();
+    vertex_batch.render_all();
+    std::vector<DrawRecord> vertex_draws = record_draws();
+
+    //instanced programs are compared as the program they're the variant of
+    std::map<int64, int64> program_map;
+    ShaderProgram* shaders[] = { default_shader, bloom_shader, grayscale_shader };
+    for (int n = 0; n < 3; ++n) program_map[get_instanced_shader(shaders[n])->get_program_id()] = shaders[n]->get_program_id();
+
+    Batch instanced_batch(NULL);
+    instanced_batch.set_draw_mode(DRAW_INSTANCED);
+    CHECK_EQ(instanced_batch.get_draw_mode(), DRAW_INSTANCED);
+    add_mixed_scene(instanced_batch, textures, 3);
+    invalidate_gl_state();
+    reset_mock_gl();
+    instanced_batch.render_all();
+    std::vector<DrawRecord> instanced_draws = record_draws(program_map);
+
+    CHECK(vertex_draws.size() > 3);
+    CHECK_EQ(vertex_draws, instanced_draws);
+    CHECK_EQ(test::count_gl_calls("glDrawElements"), 0u);
+}
+
+TEST(batch_instanced_draws_unregistered_shader_with_default) {
+    test::init_graphics();
+    Texture texture;
+    create_solid_texture(texture, false);
+    ShaderProgram* custom = create_shader("void main() {}", "void main() {}", "custom_vert", "custom_frag");
+    CHECK(get_instanced_shader(custom) == NULL);
+
+    Batch batch(NULL);
+    batch.set_draw_mode(DRAW_INSTANCED);
+    Rect rect(0, 0, 4, 4);
+    batch.add(texture, &rect, NULL, 0, NULL, NULL, 0, COLOUR_WHITE, custom);
+    invalidate_gl_state();
+    reset_mock_gl();
+    std::ostringstream console;
+    std::streambuf* cout_buf = std::cout.rdbuf(console.rdbuf());
+    batch.render_all();
+
+    std::vector<DrawRecord> draws = record_draws();
+    CHECK_EQ(draws.size(), 1u);
+    if (draws.size() == 1) CHECK_EQ(draws[0].program, int64(default_instanced_shader->get_program_id()));
+
+    //the missing variant is reported on the first frame only
+    for (int n = 0; n < 3; ++n) {
+        batch.add(texture, &rect, NULL, 0, NULL, NULL, 0, COLOUR_WHITE, custom);
+        batch.render_all();
+    }
+    std::cout.rdbuf(cout_buf);
+    std::string output = console.str();
+    size_t first = output.find("no instanced variant");
+    CHECK(first != std::string::npos);
+    CHECK(output.find("no instanced variant", first + 1) == std::string::npos);
+    delete custom;
+}
+
+TEST(shader_uniforms_set_on_instanced_variant) {
+    test::init_graphics();
+    invalidate_gl_state();
+    reset_mock_gl();
+    set_bloom_shader(NULL, 3, 1);
+
+    //both programs get their own uniform locations and values, and the non instanced shader is left bound
+    uint32 normal_lookups = 0, instanced_lookups = 0;
+    const std::vector<MockGLCommand>& log = get_mock_gl_log();
+    for (size_t n = 0; n < log.size(); ++n) {
+        if (std::string(log[n].name) != "glGetUniformLocation") continue;
+        if (log[n].args[0] == int64(bloom_shader->get_program_id())) ++normal_lookups;
+        if (log[n].args[0] == int64(get_instanced_shader(bloom_shader)->get_program_id())) ++instanced_lookups;
+    }
+    CHECK_EQ(normal_lookups, 2u);
+    CHECK_EQ(instanced_lookups, 2u);
+    CHECK_EQ(test::count_gl_calls("glUniform1f"), 4u);
+    int64 bound = -1;
+    for (size_t n = 0; n < log.size(); ++n) if (std::string(log[n].name) == "glUseProgram") bound = log[n].args[0];
+    CHECK_EQ(bound, int64(bloom_shader->get_program_id()));
+}
+
+/** Reads back the last uploaded vertex buffer and finds the add index of each quad in upload order from its x
+position (add index * spacing), and the depth each quad was given
+**/
+static bool read_uploaded_quads(BatchDrawMode mode, int num_quads, float spacing, std::vector<int>& upload_order, std::vector<float>& depths) {
+    GLuint vbo = 0;
+    const std::vector<MockGLCommand>& log = get_mock_gl_log();
+    for (size_t n = 0; n < log.size(); ++n) {
+        if (std::string(log[n].name) == "glBindBuffer" && log[n].args[0] == GL_ARRAY_BUFFER) vbo = GLuint(log[n].args[1]);
+    }
+    const std::vector<unsigned char>* buffer = get_mock_gl_buffer(vbo);
+    if (buffer == NULL) return false;
+
+    upload_order.resize(num_quads);
+    depths.resize(num_quads);
+    for (int n = 0; n < num_quads; ++n) {
+        float x, z;
+        if (mode == DRAW_INSTANCED) {
+            const InstancePoint* inst = (const InstancePoint*)&(*buffer)[0] + n;
+            x = inst->pivot.x; z = inst->z;
+        }else {
+            const VertexPoint* v = (const VertexPoint*)&(*buffer)[0] + (n * 4);
+            x = v->pos.x; z = v->pos.z;
+        }
+        upload_order[n] = int((x / spacing) + .5f);
+        depths[upload_order[n]] = z;
+    }
+    return true;
+}
+
+/** Adds alternating opaque and transparent quads at the given z depths, renders them and checks that every quad is
+nearer than the ones before it in painter order (z depth, then add order), and that opaque quads are drawn first,
+front to back, then transparent quads back to front
+**/
+static void check_depth_order(BatchDrawMode mode, const int* z_depths, int num_quads) {
+    test::init_graphics();
+    Texture opaque, transparent;
+    create_solid_texture(opaque, false);
+    create_solid_texture(transparent, true);
+
+    Batch batch(NULL);
+    batch.set_draw_mode(mode);
+    for (int n = 0; n < num_quads; ++n) {
+        Rect rect(float(n * 10), 0, 4, 4);
+        batch.add(n % 3 == 1 ? transparent : opaque, &rect, NULL, 0, NULL, NULL, z_depths[n]);
+    }
+    reset_mock_gl();
+    batch.render_all();
+
+    std::vector<int> upload_order;
+    std::vector<float> depths;
+    CHECK(read_uploaded_quads(mode, num_quads, 10, upload_order, depths));
+    if (upload_order.empty()) return;
+
+    std::vector<int> painter_order;
+    for (int z = -8; z <= 8; ++z) {
+        for (int n = 0; n < num_quads; ++n) if (z_depths[n] == z) painter_order.push_back(n);
+    }
+    for (int n = 1; n < num_quads; ++n) CHECK(depths[painter_order[n]] < depths[painter_order[n - 1]]);
+
+    std::vector<int> expected_upload;
+    for (int n = num_quads - 1; n >= 0; --n) if (painter_order[n] % 3 != 1) expected_upload.push_back(painter_order[n]);
+    for (int n = 0; n < num_quads; ++n) if (painter_order[n] % 3 == 1) expected_upload.push_back(painter_order[n]);
+    CHECK(upload_order == expected_upload);
+}
+
+/** Adds opaque quads at the same z depth that alternate between two textures and each overlap the next, and checks
+that grouping by texture still leaves every quad nearer than the one added before it
+**/
+static void check_overlapping_interleaved_depth(BatchDrawMode mode) {
+    test::init_graphics();
+    Texture a, b;
+    create_solid_texture(a, false);
+    create_solid_texture(b, false);
+
+    const int num_quads = 12;
+    Batch batch(NULL);
+    batch.set_draw_mode(mode);
+    for (int n = 0; n < num_quads; ++n) {
+        Rect rect(float(n * 3), 0, 4, 4);
+        batch.add(n % 2 == 0 ? a : b, &rect);
+    }
+    //two more pairs far below the rest and each other, which can join the runs of their texture
+    for (int n = num_quads; n < num_quads + 4; ++n) {
+        Rect rect(float(n * 3), float((n - num_quads) * 100 + 100), 4, 4);
+        batch.add(n % 2 == 0 ? a : b, &rect);
+    }
+    reset_mock_gl();
+    batch.render_all();
+
+    std::vector<int> upload_order;
+    std::vector<float> depths;
+    CHECK(read_uploaded_quads(mode, num_quads + 4, 3, upload_order, depths));
+    if (upload_order.empty()) return;
+    for (int n = 1; n < num_quads; ++n) CHECK(depths[n] < depths[n - 1]);
+}
+
+TEST(batch_depth_equal_z_vertices) {
+    int z[12] = {};
+    check_depth_order(DRAW_VERTICES, z, 12);
+}
+
+TEST(batch_depth_equal_z_instanced) {
+    int z[12] = {};
+    check_depth_order(DRAW_INSTANCED, z, 12);
+}
+
+TEST(batch_depth_overlapping_interleaved_vertices) {
+    check_overlapping_interleaved_depth(DRAW_VERTICES);
+}
+
+TEST(batch_depth_overlapping_interleaved_instanced) {
+    check_overlapping_interleaved_depth(DRAW_INSTANCED);
+}
+
+TEST(batch_depth_different_z_vertices) {
+    int z[12] = { 2, 0, -1, 0, 2, 1, -1, 1, 0, 2, -3, 0 };
+    check_depth_order(DRAW_VERTICES, z, 12);
+}
+
+TEST(batch_depth_different_z_instanced) {
+    int z[12] = { 2, 0, -1, 0, 2, 1, -1, 1, 0, 2, -3, 0 };
+    check_depth_order(DRAW_INSTANCED, z, 12);
+}
+
+BENCHMARK(batch_render_quads) {
+    test::init_graphics();
+    set_mock_gl_logging(false);
+
+    const int num_textures = 8;
+    Texture textures[num_textures];
+    for (int n = 0; n < num_textures; ++n) create_solid_texture(textures[n], n % 4 == 0);
+
+    Batch batch(NULL);
+    const int sizes[] = { 1000, 10000, 100000, 500000 };
+    for (int s = 0; s < 4; ++s) {
+        srand(1);
+        int num_quads = sizes[s];
+        double total_ms = 0;
+        const int frames = 5;
+        for (int f = 0; f < frames; ++f) {
+            for (int n = 0; n < num_quads; ++n) {
+                Rect rect(float(rand() % 1000), float(rand() % 700), 16, 16);
+                batch.add(textures[rand() % num_textures], &rect, NULL, 0, NULL, NULL, rand() % 16);
+            }
+            reset_mock_gl();
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            batch.render_all();
+            total_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+        std::cout << "    " << num_quads << " quads: " << total_ms / frames << " ms per render_all, "
+                  << get_mock_gl_stats().draw_calls << " draw calls\n";
+    }
+}
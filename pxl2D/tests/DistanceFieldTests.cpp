@@ -0,0 +1,147 @@
+#include "Test.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "graphics/DistanceField.h"
+#include "system/ThreadPool.h"
+
+using namespace pxl;
+using namespace pxl::graphics;
+
+/** Finds every value by checking every pixel on the other side of the edge, in doubles
+**/
+static std::vector<uint8> reference_distance_field(const uint8* coverage, uint32 width, uint32 height, uint32 spread) {
+    int32 field_width = width + spread * 2, field_height = height + spread * 2;
+    std::vector<uint8> inside(field_width * field_height, 0);
+    for (uint32 y = 0; y < height; ++y) {
+        for (uint32 x = 0; x < width; ++x) inside[(y + spread) * field_width + (x + spread)] = coverage[y * width + x] >= 128;
+    }
+
+    std::vector<uint8> field(inside.size());
+    double scale = .5 / double(std::max(spread, uint32(1)));
+    for (int32 y = 0; y < field_height; ++y) {
+        for (int32 x = 0; x < field_width; ++x) {
+            double nearest = HUGE_VAL;
+            for (int32 oy = 0; oy < field_height; ++oy) {
+                for (int32 ox = 0; ox < field_width; ++ox) {
+                    if (inside[oy * field_width + ox] == inside[y * field_width + x]) continue;
+                    nearest = std::min(nearest, double(ox - x) * (ox - x) + double(oy - y) * (oy - y));
+                }
+            }
+            double distance = std::sqrt(nearest) - .5;
+            if (inside[y * field_width + x]) distance = -distance;
+            double value = std::min(std::max(.5 - (distance * scale), 0.0), 1.0);
+            field[y * field_width + x] = uint8((value * 255.0) + .5);
+        }
+    }
+    return field;
+}
+
+static void check_against_reference(const std::vector<uint8>& coverage, uint32 width, uint32 height, uint32 spread) {
+    std::vector<uint8> field((width + spread * 2) * (height + spread * 2));
+    generate_distance_field(&coverage[0], width, height, spread, &field[0]);
+    std::vector<uint8> expected = reference_distance_field(&coverage[0], width, height, spread);
+
+    //the separable passes are exact, so only float rounding can move a value
+    int worst = 0;
+    for (size_t n = 0; n < field.size(); ++n) worst = std::max(worst, std::abs(int(field[n]) - int(expected[n])));
+    CHECK(worst <= 1);
+}
+
+TEST(distance_field_shapes_match_brute_force) {
+    const uint32 size = 24;
+    std::vector<uint8> disc(size * size), ring(size * size), noise(size * size), dot(size * size, 0);
+    srand(5);
+    for (uint32 y = 0; y < size; ++y) {
+        for (uint32 x = 0; x < size; ++x) {
+            float dx = x - 11.5f, dy = y - 11.5f, r = std::sqrt(dx * dx + dy * dy);
+            disc[y * size + x] = r < 9 ? 255 : 0;
+            ring[y * size + x] = r > 5 && r < 9 ? 200 : 30;
+            noise[y * size + x] = uint8(rand() % 256);
+        }
+    }
+    dot[7 * size + 13] = 255;
+
+    for (uint32 spread = 1; spread <= 8; spread *= 2) {
+        check_against_reference(disc, size, size, spread);
+        check_against_reference(ring, size, size, spread);
+        check_against_reference(noise, size, size, spread);
+        check_against_reference(dot, size, size, spread);
+    }
+
+    //non square, and images with no edge at all
+    check_against_reference(std::vector<uint8>(disc.begin(), disc.begin() + size * 9), size, 9, 3);
+    check_against_reference(std::vector<uint8>(size * size, 0), size, size, 4);
+    check_against_reference(std::vector<uint8>(size * size, 255), size, size, 0);
+}
+
+TEST(distance_field_jobs_match_serial) {
+    std::vector<std::vector<uint8>> coverage(9), serial(9), parallel(9);
+    std::vector<DistanceFieldJob> jobs(9);
+    const uint32 spread = 4;
+    srand(9);
+    for (uint32 n = 0; n < jobs.size(); ++n) {
+        uint32 w = 5 + n * 3, h = 20 - n;
+        coverage[n].resize(w * h);
+        for (size_t p = 0; p < coverage[n].size(); ++p) coverage[n][p] = uint8(rand() % 256);
+        serial[n].resize((w + spread * 2) * (h + spread * 2));
+        parallel[n].resize(serial[n].size(), 0);
+        generate_distance_field(&coverage[n][0], w, h, spread, &serial[n][0]);
+
+        jobs[n].coverage = &coverage[n][0];
+        jobs[n].width = w;
+        jobs[n].height = h;
+        jobs[n].dest = &parallel[n][0];
+    }
+
+    generate_distance_fields(jobs, spread);
+    for (uint32 n = 0; n < jobs.size(); ++n) CHECK(parallel[n] == serial[n]);
+}
+
+TEST(distance_field_jobs_from_pool_job) {
+    const uint32 spread = 3, num_images = 6;
+    std::vector<std::vector<uint8>> coverage(num_images), expected(num_images);
+    srand(11);
+    for (uint32 n = 0; n < num_images; ++n) {
+        uint32 w = 8 + n, h = 12 - n;
+        coverage[n].resize(w * h);
+        for (size_t p = 0; p < coverage[n].size(); ++p) coverage[n][p] = uint8(rand() % 256);
+        expected[n].resize((w + spread * 2) * (h + spread * 2));
+        generate_distance_field(&coverage[n][0], w, h, spread, &expected[n][0]);
+    }
+
+    //every worker is busy with a job that generates fields, which would deadlock if they were queued behind it.
+    //the jobs wait for each other to start, so no worker is left idle to pick up queued fields
+    sys::ThreadPool* pool = sys::get_thread_pool();
+    std::vector<std::vector<std::vector<uint8>>> results(pool->get_num_threads());
+    std::vector<std::future<void>> jobs;
+    std::atomic<uint32> num_started(0);
+    for (size_t r = 0; r < results.size(); ++r) {
+        std::vector<std::vector<uint8>>* result = &results[r];
+        jobs.push_back(pool->submit([&coverage, &expected, &num_started, &results, result, spread, num_images]() {
+            ++num_started;
+            while (num_started < results.size()) std::this_thread::yield();
+            std::vector<DistanceFieldJob> fields(num_images);
+            result->resize(num_images);
+            for (uint32 n = 0; n < num_images; ++n) {
+                (*result)[n].resize(expected[n].size(), 0);
+                fields[n].coverage = &coverage[n][0];
+                fields[n].width = 8 + n;
+                fields[n].height = 12 - n;
+                fields[n].dest = &(*result)[n][0];
+            }
+            generate_distance_fields(fields, spread);
+        }));
+    }
+    for (size_t r = 0; r < jobs.size(); ++r) {
+        bool finished = jobs[r].wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+        CHECK(finished);
+        if (!finished) std::abort();
+        jobs[r].get();
+        for (uint32 n = 0; n < num_images; ++n) CHECK(results[r][n] == expected[n]);
+    }
+}
@@ -0,0 +1,111 @@
+#include "Test.h"
+
+#include "graphics/DynamicAtlas.h"
+
+using namespace pxl;
+using namespace pxl::graphics;
+
+static AtlasHandle add_filled(DynamicAtlas& atlas, uint32 w, uint32 h) {
+    std::vector<uint8> pixels(w * h * 4, 255);
+    return atlas.add(w, h, &pixels[0], CHANNEL_RGBA);
+}
+
+TEST(dynamic_atlas_compact_frees_empty_pages) {
+    DynamicAtlas atlas(8, 8, CHANNEL_RGBA, 0);
+    std::vector<AtlasHandle> handles;
+    for (int n = 0; n < 4; ++n) handles.push_back(add_filled(atlas, 8, 6));
+    CHECK_EQ(atlas.get_num_pages(), 4u);
+
+    //what's left fits in one page after compacting
+    atlas.remove(handles[0]);
+    atlas.remove(handles[2]);
+    atlas.remove(handles[3]);
+    CHECK_EQ(atlas.compact(), 3u);
+    CHECK_EQ(atlas.get_num_pages(), 1u);
+    CHECK(atlas.get_texture(handles[1]) == atlas.get_page(0));
+    CHECK(atlas.is_valid(add_filled(atlas, 8, 2)));
+}
+
+TEST(dynamic_atlas_compact_keeps_pages_when_repack_is_bigger) {
+    //in the order added these fit in 3 pages, but biggest first they need 4
+    const uint32 sizes[5][2] = { { 5, 6 }, { 8, 4 }, { 7, 1 }, { 5, 4 }, { 5, 6 } };
+    DynamicAtlas atlas(8, 8, CHANNEL_RGBA, 0, 3);
+    std::vector<AtlasHandle> handles;
+    for (int n = 0; n < 5; ++n) handles.push_back(add_filled(atlas, sizes[n][0], sizes[n][1]));
+    CHECK_EQ(atlas.get_num_pages(), 3u);
+
+    std::vector<Texture*> textures;
+    std::vector<Rect> rects;
+    for (int n = 0; n < 5; ++n) {
+        textures.push_back(atlas.get_texture(handles[n]));
+        rects.push_back(atlas.get_rect(handles[n]));
+    }
+
+    CHECK_EQ(atlas.compact(), 0u);
+    CHECK_EQ(atlas.get_num_pages(), 3u);
+    for (int n = 0; n < 5; ++n) {
+        CHECK(atlas.get_texture(handles[n]) != NULL);
+        CHECK(atlas.get_texture(handles[n]) == textures[n]);
+        CHECK(atlas.get_rect(handles[n]).x == rects[n].x && atlas.get_rect(handles[n]).y == rects[n].y);
+    }
+
+    //the page limit still holds after the compaction is given up on
+    CHECK(!atlas.has_room(8, 8));
+    CHECK(!atlas.is_valid(add_filled(atlas, 8, 8)));
+}
+
+TEST(dynamic_atlas_batch_remove_matches_single_removes) {
+    DynamicAtlas single(64, 64, CHANNEL_RGBA, 1, 2), batched(64, 64, CHANNEL_RGBA, 1, 2);
+    std::vector<AtlasHandle> handles;
+    for (uint32 n = 0; n < 60; ++n) {
+        AtlasHandle handle = add_filled(single, 4 + (n % 5) * 3, 3 + (n % 7) * 2);
+        CHECK_EQ(add_filled(batched, 4 + (n % 5) * 3, 3 + (n % 7) * 2), handle);
+        handles.push_back(handle);
+    }
+
+    std::vector<AtlasHandle> removed;
+    for (size_t n = 0; n < handles.size(); n += 3) removed.push_back(handles[n]);
+    removed.push_back(handles[0]); //already removed by then, so it's skipped
+    for (size_t n = 0; n < removed.size(); ++n) single.remove(removed[n]);
+    batched.remove(removed);
+
+    DynamicAtlasStats a = single.get_stats(), b = batched.get_stats();
+    CHECK_EQ(a.num_entries, b.num_entries);
+    CHECK_EQ(a.used_area, b.used_area);
+    CHECK_EQ(a.fragmentation, b.fragmentation);
+    for (size_t n = 0; n < handles.size(); ++n) CHECK_EQ(single.is_valid(handles[n]), batched.is_valid(handles[n]));
+
+    //the freed space is reused the same way by both
+    for (uint32 n = 0; n < 20; ++n) {
+        AtlasHandle handle = add_filled(single, 5, 5);
+        CHECK_EQ(add_filled(batched, 5, 5), handle);
+        CHECK(single.get_rect(handle).x == batched.get_rect(handle).x && single.get_rect(handle).y == batched.get_rect(handle).y);
+    }
+}
+
+/** Frees half of a full glyph sized atlas page one entry at a time and in one batch, which is what evicting glyphs
+from a font's atlas does
+**/
+BENCHMARK(dynamic_atlas_evict) {
+    set_mock_gl_logging(false);
+    for (int batch = 0; batch < 2; ++batch) {
+        DynamicAtlas atlas(512, 512, CHANNEL_ALPHA, 1, 1);
+        std::vector<uint8> pixels(24 * 24, 255);
+        std::vector<AtlasHandle> handles;
+        while (true) {
+            AtlasHandle handle = atlas.add(12 + (handles.size() % 13), 24, &pixels[0], CHANNEL_ALPHA);
+            if (handle == ATLAS_INVALID_HANDLE) break;
+            handles.push_back(handle);
+        }
+        handles.resize(handles.size() / 2);
+
+        double start = test::get_time_ms();
+        if (batch) {
+            atlas.remove(handles);
+        }else {
+            for (size_t n = 0; n < handles.size(); ++n) atlas.remove(handles[n]);
+        }
+        std::cout << "    " << (batch ? "batched" : "one at a time") << ": " << handles.size() << " entries freed in " <<
+                     test::get_time_ms() - start << " ms\n";
+    }
+}
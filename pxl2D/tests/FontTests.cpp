@@ -0,0 +1,56 @@
+#include "Test.h"
+
+#include <cstring>
+#include "graphics/Font.h"
+
+using namespace pxl;
+using namespace pxl::graphics;
+
+/** Gets a copy of the pixels a glyph has in its page of the atlas
+**/
+static std::vector<uint8> get_glyph_pixels(const Glyph& glyph) {
+    std::vector<uint8> pixels;
+    const MockGLTexture* page = get_mock_gl_texture(glyph.texture->get_id());
+    if (page == NULL) return pixels;
+    for (int y = int(glyph.rect.y); y < int(glyph.rect.y + glyph.rect.h); ++y) {
+        const uint8* row = &page->pixels[(y * page->width) + int(glyph.rect.x)];
+        pixels.insert(pixels.end(), row, row + int(glyph.rect.w));
+    }
+    return pixels;
+}
+
+TEST(font_never_evicts_glyphs_used_this_frame) {
+    test::init_graphics();
+    init_font();
+    //glyphs this big fill every page of the atlas before the printable ascii characters run out
+    Font font(std::string(PXL_TEST_ASSETS_DIR) + "/square.ttf", 480);
+
+    std::vector<int> used;
+    std::vector<std::vector<uint8>> used_pixels;
+    int failed = -1;
+    for (int c = 33; c < 127 && failed == -1; ++c) {
+        int glyph_index = font.get_glyph_index(c);
+        const Glyph& glyph = font.get_glyph(glyph_index);
+        if (glyph.texture == NULL) {
+            failed = glyph_index;
+            break;
+        }
+        used.push_back(glyph_index);
+        used_pixels.push_back(get_glyph_pixels(glyph));
+    }
+    CHECK(failed != -1);
+    CHECK_EQ(font.get_glyph_atlas()->get_num_pages(), uint32(CONFIG_FONT_GLYPH_MAX_PAGES));
+
+    //the glyph that didn't fit isn't cached, and every glyph used this frame is still where it was drawn from
+    CHECK_EQ(font.get_num_cached_glyphs(), uint32(used.size()));
+    for (size_t n = 0; n < used.size(); ++n) CHECK(get_glyph_pixels(font.get_glyph(used[n])) == used_pixels[n]);
+    CHECK(font.get_glyph(failed).texture == NULL);
+
+    //in the next frame, the glyphs that haven't been used yet can be evicted to make room
+    end_frame();
+    for (size_t n = used.size() / 2; n < used.size(); ++n) font.get_glyph(used[n]);
+    const Glyph& loaded = font.get_glyph(failed);
+    CHECK(loaded.texture != NULL);
+    CHECK(font.get_num_cached_glyphs() <= uint32(used.size()));
+    for (size_t n = used.size() / 2; n < used.size(); ++n) CHECK(get_glyph_pixels(font.get_glyph(used[n])) == used_pixels[n]);
+}
@@ -0,0 +1,68 @@
+#include "Test.h"
+
+#include <cstring>
+#include "graphics/Batch.h"
+#include "graphics/GLState.h"
+#include "graphics/Texture.h"
+
+using namespace pxl;
+using namespace pxl::graphics;
+
+/** Counts the glEnable or glDisable calls for a capability
+**/
+static uint32 count_cap_calls(const char* name, GLenum cap) {
+    uint32 count = 0;
+    const std::vector<MockGLCommand>& log = get_mock_gl_log();
+    for (size_t n = 0; n < log.size(); ++n) {
+        if (strcmp(log[n].name, name) == 0 && log[n].args[0] == cap) ++count;
+    }
+    return count;
+}
+
+TEST(gl_state_binds_once_per_run) {
+    test::init_graphics();
+    uint8 pixels[4 * 4 * 4];
+    memset(pixels, 255, sizeof(pixels));
+    Texture a, b, t;
+    a.create_texture(4, 4, pixels);
+    b.create_texture(4, 4, pixels);
+    t.create_texture(4, 4, pixels);
+    t.has_transparency = true;
+
+    //runs of a, b, a at rising z depths so they aren't grouped, then transparent quads on top
+    Batch batch(NULL);
+    const Texture* textures[] = { &a, &b, &a, &t };
+    for (int run = 0; run < 4; ++run) {
+        for (int n = 0; n < 3; ++n) {
+            Rect rect(float(n * 8), float(run * 8), 4, 4);
+            batch.add(*textures[run], &rect, NULL, 0, NULL, NULL, run);
+        }
+    }
+    invalidate_gl_state();
+    reset_mock_gl();
+    batch.render_all();
+
+    CHECK_EQ(get_mock_gl_stats().draw_calls, 4u);
+    CHECK_EQ(test::count_gl_calls("glBindTexture"), 4u);
+    CHECK_EQ(test::count_gl_calls("glUseProgram"), 1u);
+    CHECK_EQ(test::count_gl_calls("glBindVertexArray"), 1u);
+    CHECK_EQ(count_cap_calls("glEnable", GL_BLEND), 1u);
+    CHECK_EQ(count_cap_calls("glDisable", GL_BLEND), 1u);
+    CHECK_EQ(test::count_gl_calls("glBlendFunc"), 1u);
+
+    //the same frame again only rebinds state that changed since the end of the last one. the last frame ended on
+    //the transparent texture, so every run still binds its texture
+    for (int run = 0; run < 4; ++run) {
+        for (int n = 0; n < 3; ++n) {
+            Rect rect(float(n * 8), float(run * 8), 4, 4);
+            batch.add(*textures[run], &rect, NULL, 0, NULL, NULL, run);
+        }
+    }
+    reset_mock_gl();
+    batch.render_all();
+    CHECK_EQ(get_mock_gl_stats().draw_calls, 4u);
+    CHECK_EQ(test::count_gl_calls("glBindTexture"), 4u);
+    CHECK_EQ(test::count_gl_calls("glUseProgram"), 0u);
+    CHECK_EQ(test::count_gl_calls("glBindVertexArray"), 0u);
+    CHECK_EQ(test::count_gl_calls("glBlendFunc"), 0u);
+}
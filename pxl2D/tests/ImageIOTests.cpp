@@ -0,0 +1,194 @@
+#include "Test.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include "graphics/PixelConvert.h"
+#include "system/ImageIO.h"
+
+using namespace pxl;
+using namespace pxl::graphics;
+
+/** Makes rgba pixels with a gradient and some noise, so they compress like a typical sprite
+**/
+static std::vector<uint8> create_test_pixels(uint32 width, uint32 height, uint32 seed) {
+    std::vector<uint8> pixels(width * height * 4);
+    srand(seed);
+    for (uint32 y = 0; y < height; ++y) {
+        for (uint32 x = 0; x < width; ++x) {
+            uint8* p = &pixels[(y * width + x) * 4];
+            p[0] = uint8(x * 255 / width); p[1] = uint8(y * 255 / height); p[2] = uint8(rand() % 32); p[3] = uint8(255 - (rand() % 4));
+        }
+    }
+    return pixels;
+}
+
+TEST(png_load_matches_written_pixels) {
+    std::vector<uint8> pixels = create_test_pixels(67, 31, 12);
+    std::string path = test::get_temp_dir() + "/load_test.png";
+    CHECK(test::write_png(path, 67, 31, &pixels[0]));
+
+    Bitmap* bitmap = sys::load_png(path);
+    CHECK(bitmap != NULL);
+    if (bitmap == NULL) return;
+    CHECK_EQ(bitmap->get_width(), 67u);
+    CHECK_EQ(bitmap->get_height(), 31u);
+    CHECK_EQ(bitmap->get_channel().num_channels, 4u);
+    CHECK(memcmp(bitmap->get_pixels(), &pixels[0], pixels.size()) == 0);
+    delete bitmap;
+}
+
+TEST(png_batch_load_matches_single_loads) {
+    std::vector<std::string> paths;
+    for (uint32 n = 0; n < 6; ++n) {
+        std::vector<uint8> pixels = create_test_pixels(40 + n, 20 + n, n);
+        paths.push_back(test::get_temp_dir() + "/batch_" + std::to_string(n) + ".png");
+        test::write_png(paths.back(), 40 + n, 20 + n, &pixels[0]);
+    }
+
+    std::vector<std::future<Bitmap*>> futures = sys::load_png_batch(paths);
+    CHECK_EQ(futures.size(), paths.size());
+    for (size_t n = 0; n < futures.size(); ++n) {
+        Bitmap* batched = futures[n].get();
+        Bitmap* single = sys::load_png(paths[n]);
+        CHECK(batched != NULL && single != NULL);
+        if (batched != NULL && single != NULL) {
+            CHECK_EQ(batched->get_width(), single->get_width());
+            CHECK(memcmp(batched->get_pixels(), single->get_pixels(), single->get_width() * single->get_height() * 4) == 0);
+        }
+        delete batched;
+        delete single;
+    }
+}
+
+/** Writes pixels in a png layout, then checks load_png decodes them into each target layout the same as converting
+the original 8 bit rgba pixels would
+**/
+static void check_layout_decodes(test::PNGLayout layout, const std::vector<uint8>& pixels, uint32 width, uint32 height, const char* name) {
+    std::string path = test::get_temp_dir() + "/" + name + ".png";
+    CHECK(test::write_png(path, width, height, &pixels[0], layout));
+
+    const Channel* targets[] = { &CHANNEL_RGBA, &CHANNEL_RGB, &CHANNEL_RGBA_PREMULTIPLIED, &CHANNEL_RGB565, &CHANNEL_RGBA4444 };
+    for (size_t t = 0; t < sizeof(targets) / sizeof(targets[0]); ++t) {
+        const Channel& target = *targets[t];
+        std::vector<uint8> expected(width * height * target.bytes_per_pixel);
+        convert_pixels(&pixels[0], CHANNEL_RGBA, &expected[0], target, width * height);
+
+        Bitmap* bitmap = sys::load_png(path, NULL, &target);
+        CHECK(bitmap != NULL);
+        if (bitmap == NULL) continue;
+        CHECK_EQ(bitmap->get_width(), width);
+        CHECK_EQ(bitmap->get_height(), height);
+        CHECK(bitmap->get_channel() == target);
+        CHECK(memcmp(bitmap->get_pixels(), &expected[0], expected.size()) == 0);
+        delete bitmap;
+    }
+}
+
+TEST(png_palette_decodes_to_target_channel) {
+    //40 colours with a few levels of alpha, all held in the palette and its tRNS chunk
+    std::vector<uint8> pixels(45 * 27 * 4);
+    for (uint32 n = 0; n < 45 * 27; ++n) {
+        uint32 c = (n % 45 + n / 45) % 40;
+        uint8* p = &pixels[n * 4];
+        p[0] = uint8(c * 6); p[1] = uint8(255 - c * 5); p[2] = uint8(c * 37); p[3] = uint8(c % 4 == 0 ? 0 : 255 - c);
+    }
+    check_layout_decodes(test::PNG_PALETTE, pixels, 45, 27, "palette");
+
+    Bitmap* bitmap = sys::load_png(test::get_temp_dir() + "/palette.png");
+    CHECK(bitmap != NULL);
+    if (bitmap == NULL) return;
+    CHECK(bitmap->get_channel() == CHANNEL_RGBA);
+    CHECK(bitmap->has_transparency);
+    CHECK(memcmp(bitmap->get_pixels(), &pixels[0], pixels.size()) == 0);
+    delete bitmap;
+}
+
+TEST(png_16_bit_decodes_to_target_channel) {
+    std::vector<uint8> pixels = create_test_pixels(33, 21, 14);
+    check_layout_decodes(test::PNG_RGBA16, pixels, 33, 21, "rgba16");
+
+    //16 bit gray arrives as a single 8 bit channel
+    std::string path = test::get_temp_dir() + "/gray16.png";
+    CHECK(test::write_png(path, 33, 21, &pixels[0], test::PNG_GRAY16));
+    Bitmap* bitmap = sys::load_png(path);
+    CHECK(bitmap != NULL);
+    if (bitmap == NULL) return;
+    CHECK_EQ(bitmap->get_channel().bytes_per_pixel, 1u);
+    bool matches = true;
+    for (uint32 n = 0; n < 33 * 21; ++n) matches &= bitmap->get_pixels()[n] == pixels[n * 4];
+    CHECK(matches);
+    delete bitmap;
+}
+
+/** Decodes every png in PXL_BENCH_PNG_DIR (or 32 generated 512x512 pngs) by reading each file into memory
+first, by mapping it with load_png and by loading them all on the thread pool with load_png_batch
+**/
+BENCHMARK(png_decode_throughput) {
+    std::string dir = getenv("PXL_BENCH_PNG_DIR") != NULL ? getenv("PXL_BENCH_PNG_DIR") : "";
+    std::vector<std::string> paths;
+    if (!dir.empty()) {
+        DIR* d = opendir(dir.c_str());
+        if (d != NULL) {
+            for (dirent* e = readdir(d); e != NULL; e = readdir(d)) {
+                std::string name = e->d_name;
+                if (name.size() > 4 && name.compare(name.size() - 4, 4, ".png") == 0) paths.push_back(dir + "/" + name);
+            }
+            closedir(d);
+        }
+        std::sort(paths.begin(), paths.end());
+    }else {
+        for (uint32 n = 0; n < 32; ++n) {
+            std::vector<uint8> pixels = create_test_pixels(512, 512, n);
+            paths.push_back(test::get_temp_dir() + "/bench_" + std::to_string(n) + ".png");
+            test::write_png(paths.back(), 512, 512, &pixels[0]);
+        }
+    }
+    if (paths.empty()) {
+        std::cout << "    no pngs found in " << dir << "\n";
+        return;
+    }
+
+    uint64 file_bytes = 0;
+    for (size_t n = 0; n < paths.size(); ++n) {
+        std::ifstream file(paths[n].c_str(), std::ios::binary | std::ios::ate);
+        file_bytes += file.tellg();
+    }
+    std::cout << "    " << paths.size() << " pngs, " << file_bytes / 1024 << " KB\n";
+
+    const int runs = 3;
+    for (int method = 0; method < 3; ++method) {
+        uint64 pixel_bytes = 0;
+        double start = test::get_time_ms();
+        for (int r = 0; r < runs; ++r) {
+            if (method == 2) {
+                std::vector<std::future<Bitmap*>> futures = sys::load_png_batch(paths);
+                for (size_t n = 0; n < futures.size(); ++n) {
+                    Bitmap* bitmap = futures[n].get();
+                    if (bitmap != NULL) pixel_bytes += bitmap->get_width() * bitmap->get_height() * bitmap->get_channel().bytes_per_pixel;
+                    delete bitmap;
+                }
+                continue;
+            }
+            for (size_t n = 0; n < paths.size(); ++n) {
+                Bitmap* bitmap;
+                if (method == 0) {
+                    std::ifstream file(paths[n].c_str(), std::ios::binary);
+                    std::vector<uint8> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+                    bitmap = sys::load_png_from_memory(&data[0], data.size());
+                }else {
+                    bitmap = sys::load_png(paths[n]);
+                }
+                if (bitmap != NULL) pixel_bytes += bitmap->get_width() * bitmap->get_height() * bitmap->get_channel().bytes_per_pixel;
+                delete bitmap;
+            }
+        }
+        double seconds = (test::get_time_ms() - start) / 1000.0;
+        const char* names[] = { "ifstream copy", "load_png (mapped)", "load_png_batch" };
+        std::cout << "    " << names[method] << ": " << (paths.size() * runs) / seconds << " pngs/sec, "
+                  << (file_bytes * runs) / seconds / (1024 * 1024) << " MB/s compressed, "
+                  << pixel_bytes / seconds / (1024 * 1024) << " MB/s decoded\n";
+    }
+}
@@ -0,0 +1,38 @@
+#include "Test.h"
+
+#include "graphics/Batch.h"
+#include "graphics/Texture.h"
+
+using namespace pxl;
+using namespace pxl::graphics;
+
+TEST(mock_gl_records_batch_draws) {
+    test::init_graphics();
+    uint8 pixels[4 * 4 * 4] = {};
+    Texture texture;
+    texture.create_texture(4, 4, pixels);
+
+    Batch batch(NULL);
+    for (int n = 0; n < 100; ++n) {
+        Rect rect(n, n, 4, 4);
+        batch.add(texture, &rect);
+    }
+    reset_mock_gl();
+    batch.render_all();
+
+    CHECK_EQ(get_mock_gl_stats().draw_calls, 1u);
+    CHECK_EQ(get_mock_gl_stats().vertices_drawn, 600u);
+    CHECK_EQ(test::count_gl_calls("glDrawElements"), 1u);
+    CHECK(get_mock_gl_stats().bytes_uploaded >= 400 * sizeof(VertexPoint));
+}
+
+TEST(mock_gl_caps_disable_instancing) {
+    MockGLCaps caps;
+    caps.version_3_3 = false;
+    caps.arb_instanced_arrays = false;
+    set_mock_gl_caps(caps);
+
+    Batch batch(NULL);
+    batch.set_draw_mode(DRAW_INSTANCED);
+    CHECK_EQ(batch.get_draw_mode(), DRAW_VERTICES);
+}
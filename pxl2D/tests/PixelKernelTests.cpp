@@ -0,0 +1,135 @@
+#include "Test.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "graphics/PixelKernels.h"
+
+using namespace pxl;
+using namespace pxl::graphics;
+
+static const PixelKernel pixel_kernels[] = { PIXEL_KERNEL_SSE, PIXEL_KERNEL_AVX2, PIXEL_KERNEL_NEON };
+
+static std::vector<uint8> random_bytes(uint32 size) {
+    std::vector<uint8> bytes(size + 1);
+    for (uint32 n = 0; n < size; ++n) bytes[n] = uint8(rand());
+    return bytes;
+}
+
+TEST(pixel_kernels_fill_like_scalar) {
+    srand(14);
+    const uint8 pixel[4] = { 11, 22, 33, 44 };
+    //sizes around the 16 and 32 byte steps, with a guard byte after the end that must not be written
+    for (uint32 channels = 1; channels <= 4; ++channels) {
+        for (uint32 num_pixels = 0; num_pixels <= 70; ++num_pixels) {
+            std::vector<uint8> expected(num_pixels * channels + 1, 0xcd);
+            fill_pixels(&expected[0], num_pixels, pixel, channels, PIXEL_KERNEL_SCALAR);
+            for (int k = 0; k < 3; ++k) {
+                if (!is_pixel_kernel_supported(pixel_kernels[k])) continue;
+                std::vector<uint8> result(num_pixels * channels + 1, 0xcd);
+                fill_pixels(&result[0], num_pixels, pixel, channels, pixel_kernels[k]);
+                CHECK(result == expected);
+            }
+        }
+    }
+}
+
+TEST(pixel_kernels_scan_transparency_like_scalar) {
+    for (uint32 channels = 1; channels <= 4; ++channels) {
+        for (uint32 alpha_index = 0; alpha_index < channels; ++alpha_index) {
+            for (uint32 num_pixels = 1; num_pixels <= 70; num_pixels += 3) {
+                //fully opaque, then a single transparent pixel at every position
+                std::vector<uint8> pixels(num_pixels * channels, 255);
+                for (int transparent = -1; transparent < int(num_pixels); ++transparent) {
+                    if (transparent >= 0) pixels[transparent * channels + alpha_index] = 254;
+                    bool expected = scan_transparency(&pixels[0], num_pixels, channels, alpha_index, PIXEL_KERNEL_SCALAR);
+                    CHECK_EQ(expected, transparent >= 0);
+                    for (int k = 0; k < 3; ++k) {
+                        if (!is_pixel_kernel_supported(pixel_kernels[k])) continue;
+                        CHECK_EQ(scan_transparency(&pixels[0], num_pixels, channels, alpha_index, pixel_kernels[k]), expected);
+                    }
+                    if (transparent >= 0) pixels[transparent * channels + alpha_index] = 255;
+                }
+
+                //other channels below 255 don't count as transparency
+                std::vector<uint8> coloured(num_pixels * channels, 7);
+                for (uint32 n = 0; n < num_pixels; ++n) coloured[n * channels + alpha_index] = 255;
+                for (int k = 0; k < 3; ++k) {
+                    if (!is_pixel_kernel_supported(pixel_kernels[k])) continue;
+                    CHECK(!scan_transparency(&coloured[0], num_pixels, channels, alpha_index, pixel_kernels[k]));
+                }
+            }
+        }
+    }
+}
+
+TEST(pixel_kernels_premultiply_and_pack_like_scalar) {
+    srand(16);
+    for (uint32 num_pixels = 1; num_pixels <= 70; ++num_pixels) {
+        std::vector<uint8> pixels = random_bytes(num_pixels * 4);
+        std::vector<uint8> expected = pixels;
+        premultiply_pixels(&expected[0], num_pixels, PIXEL_KERNEL_SCALAR);
+        std::vector<uint16> expected_4444(num_pixels), expected_565(num_pixels);
+        pack_rgba4444(&pixels[0], num_pixels, &expected_4444[0], PIXEL_KERNEL_SCALAR);
+        pack_rgb565(&pixels[0], num_pixels, &expected_565[0], PIXEL_KERNEL_SCALAR);
+
+        for (int k = 0; k < 3; ++k) {
+            if (!is_pixel_kernel_supported(pixel_kernels[k])) continue;
+            std::vector<uint8> result = pixels;
+            premultiply_pixels(&result[0], num_pixels, pixel_kernels[k]);
+            CHECK(result == expected);
+
+            std::vector<uint16> packed(num_pixels);
+            pack_rgba4444(&pixels[0], num_pixels, &packed[0], pixel_kernels[k]);
+            CHECK(packed == expected_4444);
+            pack_rgb565(&pixels[0], num_pixels, &packed[0], pixel_kernels[k]);
+            CHECK(packed == expected_565);
+        }
+    }
+}
+
+TEST(pixel_kernels_copy_like_memcpy) {
+    srand(17);
+    for (uint32 num_bytes = 0; num_bytes <= 130; ++num_bytes) {
+        std::vector<uint8> src = random_bytes(num_bytes);
+        for (int k = 0; k < 3; ++k) {
+            if (!is_pixel_kernel_supported(pixel_kernels[k])) continue;
+            std::vector<uint8> dest(num_bytes + 1, 0xcd);
+            copy_pixels(&dest[0], &src[0], num_bytes, pixel_kernels[k]);
+            CHECK(memcmp(&dest[0], &src[0], num_bytes) == 0);
+            CHECK_EQ(int(dest[num_bytes]), 0xcd);
+        }
+    }
+}
+
+/** Fills and scans square rgba bitmaps from 256 to 8192 pixels wide with every supported kernel
+**/
+BENCHMARK(pixel_kernel_fill) {
+    const PixelKernel kernels[] = { PIXEL_KERNEL_SCALAR, PIXEL_KERNEL_SSE, PIXEL_KERNEL_AVX2, PIXEL_KERNEL_NEON };
+    const char* names[] = { "scalar", "sse", "avx2", "neon" };
+    const uint8 pixel[4] = { 10, 20, 30, 255 };
+
+    for (uint32 size = 256; size <= 8192; size *= 2) {
+        std::vector<uint8> pixels(size * size * 4);
+        uint64 bytes = pixels.size();
+        //fewer repeats for big sizes so every size takes a similar time
+        int repeats = std::max(1, int((64ULL * 1024 * 1024) / bytes));
+
+        std::cout << "    " << size << "x" << size << ":";
+        for (int k = 0; k < 4; ++k) {
+            if (!is_pixel_kernel_supported(kernels[k])) continue;
+            double start = test::get_time_ms();
+            for (int r = 0; r < repeats; ++r) fill_pixels(&pixels[0], size * size, pixel, 4, kernels[k]);
+            double fill_ms = test::get_time_ms() - start;
+
+            start = test::get_time_ms();
+            bool transparent = false;
+            for (int r = 0; r < repeats; ++r) transparent |= scan_transparency(&pixels[0], size * size, 4, 3, kernels[k]);
+            double scan_ms = test::get_time_ms() - start;
+
+            std::cout << " " << names[k] << " fill " << int((bytes * repeats) / (fill_ms / 1000.0) / (1024 * 1024)) << " MB/s, scan "
+                      << int((bytes * repeats) / (scan_ms / 1000.0) / (1024 * 1024)) << " MB/s" << (transparent ? "!" : "") << ";";
+        }
+        std::cout << "\n";
+    }
+}
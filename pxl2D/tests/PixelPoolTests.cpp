@@ -0,0 +1,151 @@
+#include "Test.h"
+
+#include <cstring>
+#include "graphics/Bitmap.h"
+#include "graphics/PixelPool.h"
+
+using namespace pxl;
+using namespace pxl::graphics;
+
+static bool is_aligned(const uint8* pixels) {
+    return (size_t)pixels % 64 == 0;
+}
+
+TEST(pixel_pool_buffers_are_aligned) {
+    const uint32 sizes[] = { 0, 1, 63, 64, 65, 255, 257, 1000, 4097, 100000, CONFIG_PIXEL_POOL_MAX_CLASS_SIZE + 1 };
+    std::vector<uint8*> buffers;
+    for (size_t n = 0; n < sizeof(sizes) / sizeof(sizes[0]); ++n) {
+        uint8* pixels = alloc_pixels(sizes[n]);
+        CHECK(pixels != NULL);
+        CHECK(is_aligned(pixels));
+        //the whole buffer is writable, up to a whole vector past the end of the last row
+        memset(pixels, 0xab, (sizes[n] + 63) & ~63u);
+        buffers.push_back(pixels);
+    }
+    for (size_t n = 0; n < buffers.size(); ++n) free_pixels(buffers[n]);
+    free_pixels(NULL);
+
+    PixelArena arena(4096);
+    for (uint32 n = 0; n < 40; ++n) {
+        uint8* pixels = arena.alloc(n * 37 + 1);
+        CHECK(is_aligned(pixels));
+        memset(pixels, n, n * 37 + 1);
+    }
+}
+
+TEST(pixel_pool_reuses_size_classes) {
+    trim_pixel_pool();
+    reset_pixel_pool_stats();
+
+    //1000 and 900 bytes both round up to the 1024 byte class, 800 bytes to the 896 byte class
+    uint8* a = alloc_pixels(1000);
+    free_pixels(a);
+    CHECK_EQ(get_pixel_pool_stats().pooled_bytes, 1024u);
+    uint8* b = alloc_pixels(800);
+    CHECK(b != a);
+    CHECK_EQ(get_pixel_pool_stats().reuses, 0u);
+    uint8* c = alloc_pixels(900);
+    CHECK(c == a);
+    CHECK_EQ(get_pixel_pool_stats().reuses, 1u);
+    CHECK_EQ(get_pixel_pool_stats().pooled_bytes, 0u);
+
+    //the linear classes are 64 bytes apart
+    uint8* small = alloc_pixels(64);
+    free_pixels(small);
+    uint8* bigger = alloc_pixels(65);
+    CHECK(bigger != small);
+    uint8* same = alloc_pixels(1);
+    CHECK(same == small);
+    CHECK_EQ(get_pixel_pool_stats().reuses, 2u);
+
+    //buffers too big to pool go straight back to the heap
+    uint8* huge = alloc_pixels(CONFIG_PIXEL_POOL_MAX_CLASS_SIZE + 1);
+    free_pixels(huge);
+    CHECK_EQ(get_pixel_pool_stats().pooled_bytes, 0u);
+
+    free_pixels(b);
+    free_pixels(c);
+    free_pixels(bigger);
+    free_pixels(same);
+    CHECK_EQ(get_pixel_pool_stats().pooled_bytes, uint64(896 + 1024 + 128 + 64));
+    trim_pixel_pool();
+    CHECK_EQ(get_pixel_pool_stats().pooled_bytes, 0u);
+    CHECK_EQ(get_pixel_pool_stats().allocations, 7u);
+}
+
+TEST(pixel_pool_tracks_outstanding_and_peak) {
+    reset_pixel_pool_stats();
+    const uint64 start = get_pixel_pool_stats().outstanding_bytes;
+    CHECK_EQ(get_pixel_pool_stats().peak_bytes, start);
+
+    uint8* a = alloc_pixels(100);
+    uint8* b = alloc_pixels(5000);
+    CHECK_EQ(get_pixel_pool_stats().outstanding_bytes, start + 128 + 5120);
+    free_pixels(a);
+    CHECK_EQ(get_pixel_pool_stats().outstanding_bytes, start + 5120);
+    CHECK_EQ(get_pixel_pool_stats().peak_bytes, start + 128 + 5120);
+
+    //the peak starts again from what's outstanding
+    reset_pixel_pool_stats();
+    CHECK_EQ(get_pixel_pool_stats().peak_bytes, start + 5120);
+    free_pixels(b);
+    CHECK_EQ(get_pixel_pool_stats().outstanding_bytes, start);
+    CHECK_EQ(get_pixel_pool_stats().peak_bytes, start + 5120);
+
+    //bitmaps take their pixels from the pool and give them back when they're deleted
+    Bitmap* bitmap = new Bitmap();
+    bitmap->create_bitmap(30, 20, CHANNEL_RGBA);
+    CHECK(is_aligned(bitmap->get_pixels()));
+    CHECK(get_pixel_pool_stats().outstanding_bytes >= start + (30 * 20 * 4));
+    delete bitmap;
+    CHECK_EQ(get_pixel_pool_stats().outstanding_bytes, start);
+}
+
+TEST(pixel_arena_releases_in_bulk) {
+    trim_pixel_pool();
+    const uint64 start = get_pixel_pool_stats().outstanding_bytes;
+    PixelArena arena(4096);
+    set_pixel_arena(&arena);
+    CHECK(get_pixel_arena() == &arena);
+
+    //allocations come from the current arena, packed into its blocks
+    uint8* a = alloc_pixels(1000);
+    uint8* b = alloc_pixels(1000);
+    CHECK(b > a && b < a + 4096);
+    CHECK_EQ(arena.get_used_bytes(), 2048u);
+    CHECK_EQ(arena.get_reserved_bytes(), 4096u);
+    CHECK_EQ(get_pixel_pool_stats().outstanding_bytes, start + 2048);
+
+    //a buffer bigger than a block gets its own block
+    uint8* big = alloc_pixels(10000);
+    CHECK(big != NULL);
+    CHECK(arena.get_reserved_bytes() > 4096u + 10000u);
+
+    Bitmap* bitmaps[8];
+    for (int n = 0; n < 8; ++n) {
+        bitmaps[n] = new Bitmap();
+        bitmaps[n]->create_bitmap(16, 16, CHANNEL_RGBA);
+    }
+    set_pixel_arena(NULL);
+    CHECK(get_pixel_arena() == NULL);
+
+    //freeing an arena buffer leaves it to the arena rather than pooling it
+    free_pixels(a);
+    CHECK_EQ(get_pixel_pool_stats().pooled_bytes, 0u);
+    CHECK_EQ(get_pixel_pool_stats().outstanding_bytes, start + 1024 + 10048 + (8 * 1024));
+    for (int n = 0; n < 8; ++n) delete bitmaps[n];
+
+    //everything else goes at once, whether it was freed or not
+    arena.release();
+    CHECK_EQ(arena.get_used_bytes(), 0u);
+    CHECK_EQ(arena.get_reserved_bytes(), 0u);
+    CHECK_EQ(get_pixel_pool_stats().outstanding_bytes, start);
+    CHECK_EQ(get_pixel_pool_stats().pooled_bytes, 0u);
+
+    //the arena can be used again after it's released
+    uint8* again = arena.alloc(64);
+    CHECK(again != NULL && is_aligned(again));
+    CHECK_EQ(get_pixel_pool_stats().outstanding_bytes, start + 64);
+    arena.release();
+    CHECK_EQ(get_pixel_pool_stats().outstanding_bytes, start);
+}
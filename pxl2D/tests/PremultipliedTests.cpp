@@ -0,0 +1,142 @@
+#include "Test.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "graphics/Batch.h"
+#include "graphics/GLState.h"
+#include "graphics/Texture.h"
+#include "system/ImageIO.h"
+
+using namespace pxl;
+using namespace pxl::graphics;
+
+/** A source image with every alpha from fully transparent to opaque, and an opaque background to draw it over
+**/
+static const uint32 image_size = 16;
+
+static std::vector<uint8> create_source() {
+    std::vector<uint8> pixels(image_size * image_size * 4);
+    for (uint32 n = 0; n < image_size * image_size; ++n) {
+        pixels[n * 4] = uint8(n * 37); pixels[n * 4 + 1] = uint8(255 - n); pixels[n * 4 + 2] = uint8(n * 11); pixels[n * 4 + 3] = uint8(n);
+    }
+    return pixels;
+}
+
+static std::vector<uint8> create_background() {
+    std::vector<uint8> pixels(image_size * image_size * 4);
+    for (uint32 n = 0; n < image_size * image_size; ++n) {
+        pixels[n * 4] = uint8(n * 3); pixels[n * 4 + 1] = 200; pixels[n * 4 + 2] = uint8(255 - n * 5); pixels[n * 4 + 3] = 255;
+    }
+    return pixels;
+}
+
+/** The reference image: straight alpha "over" compositing of a tinted source in floating point
+**/
+static std::vector<uint8> create_reference(const std::vector<uint8>& src, const std::vector<uint8>& dest, const Colour& tint) {
+    std::vector<uint8> result(dest.size());
+    const float t[4] = { tint.r, tint.g, tint.b, tint.a };
+    for (size_t n = 0; n < dest.size(); n += 4) {
+        float a = (src[n + 3] / 255.0f) * t[3];
+        for (int c = 0; c < 3; ++c) {
+            float s = (src[n + c] / 255.0f) * t[c];
+            result[n + c] = uint8(std::floor(((s * a) + ((dest[n + c] / 255.0f) * (1 - a))) * 255.0f + 0.5f));
+        }
+        result[n + 3] = 255;
+    }
+    return result;
+}
+
+static float blend_factor(int64 factor, float src_alpha) {
+    switch (factor) {
+        case GL_ONE: return 1;
+        case GL_SRC_ALPHA: return src_alpha;
+        case GL_ONE_MINUS_SRC_ALPHA: return 1 - src_alpha;
+        default: return 0;
+    }
+}
+
+/** Draws the texture over the background through a batch, then composites it on the cpu the way GL would with the
+blend func the batch set and the vertex colour it uploaded (the default fragment shader multiplies the two)
+**/
+static std::vector<uint8> draw_over(const Texture& texture, const std::vector<uint8>& texels, const std::vector<uint8>& dest, const Colour& tint) {
+    test::init_graphics();
+    Batch batch(NULL);
+    Rect rect(0, 0, image_size, image_size);
+    batch.add(texture, &rect, NULL, 0, NULL, NULL, 0, tint);
+    invalidate_gl_state();
+    reset_mock_gl();
+    batch.render_all();
+
+    int64 src_factor = -1, dest_factor = -1;
+    GLuint vbo = 0;
+    const std::vector<MockGLCommand>& log = get_mock_gl_log();
+    for (size_t n = 0; n < log.size(); ++n) {
+        if (strcmp(log[n].name, "glBlendFunc") == 0) { src_factor = log[n].args[0]; dest_factor = log[n].args[1]; }
+        if (strcmp(log[n].name, "glBindBuffer") == 0 && log[n].args[0] == GL_ARRAY_BUFFER) vbo = GLuint(log[n].args[1]);
+    }
+    const VertexPoint* v = (const VertexPoint*)&(*get_mock_gl_buffer(vbo))[0];
+    const float colour[4] = { v->colour.r / 255.0f, v->colour.g / 255.0f, v->colour.b / 255.0f, v->colour.a / 255.0f };
+
+    std::vector<uint8> result(dest.size());
+    for (size_t n = 0; n < dest.size(); n += 4) {
+        float src_alpha = (texels[n + 3] / 255.0f) * colour[3];
+        for (int c = 0; c < 3; ++c) {
+            float s = (texels[n + c] / 255.0f) * colour[c];
+            float d = dest[n + c] / 255.0f;
+            float out = (s * blend_factor(src_factor, src_alpha)) + (d * blend_factor(dest_factor, src_alpha));
+            result[n + c] = uint8(std::floor(std::min(out, 1.0f) * 255.0f + 0.5f));
+        }
+        result[n + 3] = 255;
+    }
+    return result;
+}
+
+static void check_images_near(const std::vector<uint8>& a, const std::vector<uint8>& b, int tolerance) {
+    CHECK_EQ(a.size(), b.size());
+    int worst = 0;
+    for (size_t n = 0; n < a.size() && n < b.size(); ++n) worst = std::max(worst, std::abs(int(a[n]) - int(b[n])));
+    CHECK(worst <= tolerance);
+    if (worst > tolerance) std::cerr << "    largest difference " << worst << "\n";
+}
+
+TEST(premultiplied_png_loads_premultiplied) {
+    std::vector<uint8> src = create_source();
+    std::string path = test::get_temp_dir() + "/premultiplied.png";
+    test::write_png(path, image_size, image_size, &src[0]);
+
+    Bitmap* bitmap = sys::load_png(path, NULL, &CHANNEL_RGBA_PREMULTIPLIED);
+    CHECK(bitmap != NULL && bitmap->get_channel().premultiplied);
+    if (bitmap == NULL) return;
+    const uint8* p = bitmap->get_pixels();
+    for (size_t n = 0; n < src.size(); n += 4) {
+        for (int c = 0; c < 3; ++c) CHECK_EQ(int(p[n + c]), int((src[n + c] * src[n + 3] + 127) / 255));
+        CHECK_EQ(int(p[n + 3]), int(src[n + 3]));
+    }
+    delete bitmap;
+}
+
+TEST(premultiplied_blending_matches_reference) {
+    std::vector<uint8> src = create_source();
+    std::vector<uint8> dest = create_background();
+    std::string path = test::get_temp_dir() + "/blend.png";
+    test::write_png(path, image_size, image_size, &src[0]);
+
+    const Colour tints[] = { Colour(1, 1, 1, 1), Colour(1, 0.5f, 0.25f, 1), Colour(1, 1, 1, 0.5f), Colour(0.5f, 1, 0.75f, 0.25f) };
+    for (int t = 0; t < 4; ++t) {
+        std::vector<uint8> reference = create_reference(src, dest, tints[t]);
+
+        Texture straight;
+        CHECK(straight.create_texture(path));
+        check_images_near(draw_over(straight, src, dest, tints[t]), reference, 2);
+
+        //premultiplied texels go through the same batch with the premultiplied blend func and tint
+        Bitmap* bitmap = sys::load_png(path, NULL, &CHANNEL_RGBA_PREMULTIPLIED);
+        std::vector<uint8> texels(bitmap->get_pixels(), bitmap->get_pixels() + src.size());
+        delete bitmap;
+        Texture premultiplied;
+        CHECK(premultiplied.create_texture(path, true));
+        CHECK(premultiplied.is_premultiplied());
+        check_images_near(draw_over(premultiplied, texels, dest, tints[t]), reference, 2);
+    }
+}
@@ -0,0 +1,125 @@
+#include "Test.h"
+
+#include <chrono>
+#include <cstdlib>
+#include "graphics/Batch.h"
+#include "graphics/QuadTransform.h"
+#include "graphics/Texture.h"
+
+using namespace pxl;
+using namespace pxl::graphics;
+
+static const QuadKernel quad_kernels[] = { QUAD_KERNEL_SSE, QUAD_KERNEL_AVX2, QUAD_KERNEL_NEON };
+
+static float random_float(float min, float max) {
+    return min + (max - min) * (float(rand()) / float(RAND_MAX));
+}
+
+/** Random transforms for count quads, stored in data (8 * count floats)
+**/
+static QuadTransforms create_random_transforms(std::vector<float>& data, uint32 count) {
+    data.resize(count * 8);
+    for (size_t n = 0; n < data.size(); ++n) data[n] = random_float(-1000, 1000);
+    QuadTransforms t;
+    t.x = &data[0];             t.y = &data[count];
+    t.left = &data[count * 2];  t.top = &data[count * 3];
+    t.right = &data[count * 4]; t.bottom = &data[count * 5];
+    t.c = &data[count * 6];     t.s = &data[count * 7];
+    for (uint32 n = 0; n < count; ++n) {
+        float angle = random_float(0, 6.283f);
+        t.c[n] = std::cos(angle);
+        t.s[n] = std::sin(angle);
+    }
+    return t;
+}
+
+TEST(quad_kernels_transform_like_scalar) {
+    srand(6);
+    //odd counts check the scalar tails after the 4 and 8 wide loops
+    for (uint32 count = 1; count <= 37; ++count) {
+        std::vector<float> data;
+        QuadTransforms transforms = create_random_transforms(data, count);
+        std::vector<VertexPoint> expected(count * 4);
+        transform_quads(transforms, count, &expected[0], QUAD_KERNEL_SCALAR);
+
+        for (int k = 0; k < 3; ++k) {
+            if (!is_quad_kernel_supported(quad_kernels[k])) continue;
+            std::vector<VertexPoint> result(count * 4);
+            transform_quads(transforms, count, &result[0], quad_kernels[k]);
+            for (uint32 n = 0; n < count * 4; ++n) {
+                CHECK_EQ(result[n].pos.x, expected[n].pos.x);
+                CHECK_EQ(result[n].pos.y, expected[n].pos.y);
+            }
+        }
+    }
+}
+
+TEST(quad_kernels_convert_colours_like_scalar) {
+    srand(7);
+    for (uint32 count = 1; count <= 37; ++count) {
+        std::vector<float> colours(count * 4);
+        for (size_t n = 0; n < colours.size(); ++n) colours[n] = random_float(0, 1);
+        colours[0] = 0; colours[colours.size() - 1] = 1;
+        std::vector<VertexPoint> expected(count * 4);
+        convert_quad_colours(&colours[0], count, &expected[0], QUAD_KERNEL_SCALAR);
+
+        for (int k = 0; k < 3; ++k) {
+            if (!is_quad_kernel_supported(quad_kernels[k])) continue;
+            std::vector<VertexPoint> result(count * 4);
+            convert_quad_colours(&colours[0], count, &result[0], quad_kernels[k]);
+            for (uint32 n = 0; n < count * 4; ++n) {
+                CHECK_EQ(int(result[n].colour.r), int(expected[n].colour.r));
+                CHECK_EQ(int(result[n].colour.g), int(expected[n].colour.g));
+                CHECK_EQ(int(result[n].colour.b), int(expected[n].colour.b));
+                CHECK_EQ(int(result[n].colour.a), int(expected[n].colour.a));
+            }
+        }
+    }
+}
+
+BENCHMARK(quad_kernel_add_many) {
+    uint8 pixels[4 * 4 * 4] = {};
+    Texture texture;
+    texture.create_texture(4, 4, pixels);
+
+    const uint32 num_quads = 100000;
+    std::vector<SpriteInstance> sprites(num_quads);
+    srand(6);
+    for (uint32 n = 0; n < num_quads; ++n) {
+        sprites[n].texture = &texture;
+        sprites[n].rect = Rect(random_float(0, 1000), random_float(0, 700), 16, 16);
+        sprites[n].rotation = random_float(0, 360);
+        sprites[n].colour = Colour(1, 1, 1, 1);
+    }
+
+    const QuadKernel kernels[] = { QUAD_KERNEL_SCALAR, QUAD_KERNEL_SSE, QUAD_KERNEL_AVX2, QUAD_KERNEL_NEON };
+    const char* names[] = { "scalar", "sse", "avx2", "neon" };
+    QuadKernel default_kernel = get_quad_kernel();
+    graphics::Batch batch(NULL);
+    for (int k = 0; k < 4; ++k) {
+        if (!is_quad_kernel_supported(kernels[k])) continue;
+        set_quad_kernel(kernels[k]);
+
+        const int frames = 20;
+        double total_ms = 0;
+        for (int f = 0; f < frames; ++f) {
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            batch.add_many(&sprites[0], num_quads);
+            total_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            batch.clear_all();
+        }
+        std::cout << "    " << names[k] << ": " << (double(num_quads) * frames) / (total_ms / 1000.0) / 1e6 << "M quads/sec\n";
+    }
+    set_quad_kernel(default_kernel);
+
+    //single adds always use the scalar kernel
+    const int frames = 20;
+    double total_ms = 0;
+    for (int f = 0; f < frames; ++f) {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        for (uint32 n = 0; n < num_quads; ++n) batch.add(texture, &sprites[n].rect, NULL, sprites[n].rotation);
+        total_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        batch.clear_all();
+    }
+    std::cout << "    add(): " << (double(num_quads) * frames) / (total_ms / 1000.0) / 1e6 << "M quads/sec\n";
+}
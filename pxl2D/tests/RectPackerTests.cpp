@@ -0,0 +1,180 @@
+#include "Test.h"
+
+#include <cstdlib>
+#include "graphics/RectPacker.h"
+
+using namespace pxl;
+using namespace pxl::graphics;
+
+static bool is_power_of_two(uint32 v) {
+    return v != 0 && (v & (v - 1)) == 0;
+}
+
+/** Checks that no two placed rects come within padding of each other on their right and bottom, and that every rect
+is inside the sheet. The bin is padded to match the rects, so the padding of a rect on the right or bottom edge is
+the edge of the sheet
+**/
+static void check_placement(const std::vector<PackedRect>& rects, uint32 padding, uint32 width, uint32 height) {
+    for (size_t i = 0; i < rects.size(); ++i) {
+        const PackedRect& a = rects[i];
+        if (!a.packed) continue;
+        CHECK(a.x + a.w <= width && a.y + a.h <= height);
+        for (size_t j = i + 1; j < rects.size(); ++j) {
+            const PackedRect& b = rects[j];
+            if (!b.packed) continue;
+            bool apart = a.x + a.w + padding <= b.x || b.x + b.w + padding <= a.x ||
+                         a.y + a.h + padding <= b.y || b.y + b.h + padding <= a.y;
+            CHECK(apart);
+            if (!apart) return;
+        }
+    }
+}
+
+TEST(rect_packer_pack_every_setting) {
+    for (int setting = 0; setting < 16; ++setting) {
+        PackSettings settings;
+        settings.method = (setting & 1) ? PACK_SKYLINE : PACK_MAX_RECTS;
+        settings.allow_rotation = (setting & 2) != 0;
+        settings.padding = (setting & 4) ? 2 : 0;
+        settings.power_of_two = (setting & 8) != 0;
+
+        srand(setting + 1);
+        std::vector<PackedRect> given(150);
+        for (size_t n = 0; n < given.size(); ++n) {
+            //mostly long thin rects, so turning them is worth it when it's allowed
+            given[n].w = 4 + rand() % 60;
+            given[n].h = 4 + rand() % 12;
+            if (n % 3 == 0) std::swap(given[n].w, given[n].h);
+        }
+
+        std::vector<PackedRect> rects(given);
+        RectPacker packer;
+        CHECK(packer.pack(rects, settings));
+        check_placement(rects, settings.padding, packer.get_width(), packer.get_height());
+        if (settings.power_of_two) CHECK(is_power_of_two(packer.get_width()) && is_power_of_two(packer.get_height()));
+
+        uint32 num_rotated = 0;
+        uint64 area = 0;
+        for (size_t n = 0; n < rects.size(); ++n) {
+            CHECK(rects[n].packed);
+            area += uint64(rects[n].w) * rects[n].h;
+            if (rects[n].rotated) {
+                ++num_rotated;
+                CHECK(rects[n].w == given[n].h && rects[n].h == given[n].w);
+            }else {
+                CHECK(rects[n].w == given[n].w && rects[n].h == given[n].h);
+            }
+        }
+        CHECK_EQ(packer.get_used_area(), area);
+        if (!settings.allow_rotation) CHECK_EQ(num_rotated, 0u);
+    }
+}
+
+TEST(rect_packer_pack_fails_past_max_size) {
+    PackSettings settings;
+    settings.max_width = 64;
+    settings.max_height = 64;
+    std::vector<PackedRect> rects(5);
+    for (size_t n = 0; n < rects.size(); ++n) rects[n].w = rects[n].h = 32;
+
+    RectPacker packer;
+    CHECK(!packer.pack(rects, settings));
+    uint32 num_packed = 0;
+    for (size_t n = 0; n < rects.size(); ++n) num_packed += rects[n].packed;
+    CHECK_EQ(num_packed, 4u);
+    check_placement(rects, 0, 64, 64);
+}
+
+TEST(rect_packer_insert_and_remove) {
+    for (uint32 padding = 0; padding <= 1; ++padding) {
+        PackSettings settings;
+        settings.padding = padding;
+        RectPacker packer;
+        packer.init(128, 128, settings);
+
+        srand(3);
+        std::vector<PackedRect> rects;
+        PackedRect rect;
+        while (packer.insert(4 + rand() % 20, 4 + rand() % 20, rect)) rects.push_back(rect);
+        check_placement(rects, padding, 128, 128);
+        CHECK(!packer.can_insert(128, 128));
+
+        //free every other rect, one at a time and then the rest in one go, and fill the space again
+        std::vector<PackedRect> batch, kept;
+        for (size_t n = 0; n < rects.size(); ++n) {
+            if (n % 2 == 0) kept.push_back(rects[n]);
+            else if (n % 4 == 1) CHECK(packer.remove(rects[n]));
+            else batch.push_back(rects[n]);
+        }
+        CHECK_EQ(packer.remove(batch), uint32(batch.size()));
+        CHECK(!packer.remove(rects[1]));
+
+        uint64 area = 0;
+        for (size_t n = 0; n < kept.size(); ++n) area += uint64(kept[n].w) * kept[n].h;
+        CHECK_EQ(packer.get_used_area(), area);
+
+        size_t num_kept = kept.size();
+        while (packer.insert(4 + rand() % 20, 4 + rand() % 20, rect)) kept.push_back(rect);
+        CHECK(kept.size() > num_kept);
+        check_placement(kept, padding, 128, 128);
+    }
+}
+
+TEST(rect_packer_skyline_cant_remove) {
+    PackSettings settings;
+    settings.method = PACK_SKYLINE;
+    RectPacker packer;
+    packer.init(64, 64, settings);
+    PackedRect rect;
+    CHECK(packer.insert(10, 10, rect));
+    CHECK(!packer.remove(rect));
+}
+
+TEST(rect_packer_single_removes_match_rebuild) {
+    for (int setting = 0; setting < 4; ++setting) {
+        PackSettings settings;
+        settings.padding = setting & 1;
+        settings.allow_rotation = (setting & 2) != 0;
+        RectPacker single, batched;
+        single.init(200, 150, settings);
+        batched.init(200, 150, settings);
+
+        srand(11 + setting);
+        std::vector<PackedRect> rects;
+        PackedRect rect, other;
+        while (true) {
+            uint32 w = 3 + rand() % 25, h = 3 + rand() % 25;
+            if (!single.insert(w, h, rect)) break;
+            CHECK(batched.insert(w, h, other));
+            rects.push_back(rect);
+        }
+
+        //each rect freed on its own is joined into the free areas around it, which has to leave the same free areas
+        //as rebuilding them from the rects that are left, so both place the next rects the same way
+        std::vector<PackedRect> removed, kept;
+        for (size_t n = 0; n < rects.size(); ++n) {
+            if (rand() % 3 == 0) kept.push_back(rects[n]);
+            else removed.push_back(rects[n]);
+        }
+        for (size_t n = 0; n < removed.size(); ++n) {
+            CHECK(single.remove(removed[n]));
+            std::vector<PackedRect> one(1, removed[n]);
+            CHECK_EQ(batched.remove(one), 1u);
+            CHECK_EQ(single.get_largest_free_area(), batched.get_largest_free_area());
+        }
+        while (true) {
+            uint32 w = 2 + rand() % 30, h = 2 + rand() % 30;
+            bool inserted = single.insert(w, h, rect);
+            CHECK_EQ(batched.insert(w, h, other), inserted);
+            if (!inserted) break;
+            CHECK(rect.x == other.x && rect.y == other.y && rect.rotated == other.rotated);
+            kept.push_back(rect);
+        }
+        check_placement(kept, settings.padding, 200, 150);
+
+        //freeing everything joins the whole sheet back into one area
+        for (size_t n = 0; n < kept.size(); ++n) CHECK(single.remove(kept[n]));
+        CHECK_EQ(single.get_used_area(), 0u);
+        CHECK_EQ(single.get_largest_free_area(), uint64(200 * 150));
+    }
+}
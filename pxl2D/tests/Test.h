@@ -0,0 +1,93 @@
+#ifndef _PXL_TEST_H
+#define _PXL_TEST_H
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "PXLAPI.h"
+
+/** ------------------------------------------------------------------------------------------------
+A minimal test and benchmark registry. TEST bodies run on every `pxl2d_tests` run and fail through
+the CHECK macros, BENCHMARK bodies only run with `pxl2d_tests --bench [name]` and print their own
+timings. Everything runs headless against the mock GL backend (PXL_MOCK_GL).
+------------------------------------------------------------------------------------------------ **/
+
+namespace pxl { namespace test {
+
+    typedef void (*TestFunc)();
+
+    struct TestCase {
+
+        const char* name;
+        TestFunc func;
+        bool benchmark;
+    };
+
+    extern std::vector<TestCase>& get_tests();
+    extern void fail(const char* file, int line, const char* expr);
+
+    /** Creates the prebuilt shaders the first time it's called, as pxl::init would with a real context
+    **/
+    extern void init_graphics();
+
+    /** Counts the calls to a GL function in the mock command log, such as "glDrawElements"
+    **/
+    extern uint32 count_gl_calls(const char* name);
+
+    /** Gets a directory for files written by tests, created the first time it's called
+    **/
+    extern std::string get_temp_dir();
+
+    /** The layouts write_png can store 8 bit rgba pixels in
+    **/
+    enum PNGLayout {
+
+        PNG_RGBA8,              /**> 8 bit rgba **/
+        PNG_RGBA8_INTERLACED,   /**> 8 bit rgba with adam7 interlacing **/
+        PNG_PALETTE,            /**> An 8 bit palette of every colour with a tRNS chunk for alpha, at most 256 colours **/
+        PNG_RGBA16,             /**> 16 bit rgba, every 8 bit value v stored as v * 257 **/
+        PNG_GRAY16              /**> 16 bit gray, the red of every pixel stored as r * 257 **/
+    };
+
+    /** Writes 8 bit rgba pixels to a png, for tests that need image files
+    **/
+    extern bool write_png(const std::string& path, uint32 width, uint32 height, const uint8* rgba, PNGLayout layout = PNG_RGBA8);
+
+    /** Gets a monotonic time in milliseconds, for benchmarks
+    **/
+    extern double get_time_ms();
+
+    struct TestRegistrar {
+
+        TestRegistrar(const char* name, TestFunc func, bool benchmark) {
+            TestCase test = { name, func, benchmark };
+            get_tests().push_back(test);
+        }
+    };
+}};
+
+#define PXL_TEST_CASE(name, benchmark) \
+    static void name(); \
+    static pxl::test::TestRegistrar name##_registrar(#name, name, benchmark); \
+    static void name()
+
+#define TEST(name) PXL_TEST_CASE(name, false)
+#define BENCHMARK(name) PXL_TEST_CASE(name, true)
+
+#define CHECK(expr) \
+    do { if (!(expr)) pxl::test::fail(__FILE__, __LINE__, #expr); } while (0)
+
+#define CHECK_EQ(a, b) \
+    do { if (!((a) == (b))) { \
+        std::cerr << "    " << #a << " = " << (a) << ", " << #b << " = " << (b) << "\n"; \
+        pxl::test::fail(__FILE__, __LINE__, #a " == " #b); \
+    } } while (0)
+
+#define CHECK_NEAR(a, b, tolerance) \
+    do { if (!(std::abs(double(a) - double(b)) <= double(tolerance))) { \
+        std::cerr << "    " << #a << " = " << (a) << ", " << #b << " = " << (b) << "\n"; \
+        pxl::test::fail(__FILE__, __LINE__, #a " ~= " #b); \
+    } } while (0)
+
+#endif
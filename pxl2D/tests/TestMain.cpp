@@ -0,0 +1,179 @@
+#include "Test.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <png.h>
+#include <unistd.h>
+#include "PXLAPI.h"
+#include "graphics/ShaderUtils.h"
+#include "system/Math.h"
+
+namespace pxl { namespace test {
+
+    static int num_failures;
+    static std::string temp_dir;
+
+    std::vector<TestCase>& get_tests() {
+        static std::vector<TestCase> tests;
+        return tests;
+    }
+
+    void fail(const char* file, int line, const char* expr) {
+        std::cerr << "    " << file << ":" << line << ": CHECK(" << expr << ") failed\n";
+        ++num_failures;
+    }
+
+    void init_graphics() {
+        static bool initialised = false;
+        if (!initialised) {
+            graphics::init_shader();
+            initialised = true;
+        }
+    }
+
+    uint32 count_gl_calls(const char* name) {
+        const std::vector<graphics::MockGLCommand>& log = graphics::get_mock_gl_log();
+        uint32 count = 0;
+        for (size_t n = 0; n < log.size(); ++n) {
+            if (strcmp(log[n].name, name) == 0) ++count;
+        }
+        return count;
+    }
+
+    std::string get_temp_dir() {
+        if (temp_dir.empty()) {
+            char path[] = "/tmp/pxl2d_tests_XXXXXX";
+            if (mkdtemp(path) != NULL) temp_dir = path;
+        }
+        return temp_dir;
+    }
+
+    /** Deletes the temp dir and the files tests wrote to it
+    **/
+    static void remove_temp_dir() {
+        if (temp_dir.empty()) return;
+        DIR* dir = opendir(temp_dir.c_str());
+        if (dir != NULL) {
+            for (dirent* e = readdir(dir); e != NULL; e = readdir(dir)) {
+                if (strcmp(e->d_name, ".") != 0 && strcmp(e->d_name, "..") != 0) unlink((temp_dir + "/" + e->d_name).c_str());
+            }
+            closedir(dir);
+        }
+        rmdir(temp_dir.c_str());
+    }
+
+    bool write_png(const std::string& path, uint32 width, uint32 height, const uint8* rgba, PNGLayout layout) {
+        //encode the rows in the png's layout first
+        std::vector<png_color> palette;
+        std::vector<png_byte> palette_alpha;
+        std::vector<png_byte> rows;
+        int colour_type = PNG_COLOR_TYPE_RGBA;
+        int bit_depth = 8;
+        uint32 bytes_per_pixel = 4;
+        if (layout == PNG_PALETTE) {
+            colour_type = PNG_COLOR_TYPE_PALETTE;
+            bytes_per_pixel = 1;
+        }else if (layout == PNG_RGBA16) {
+            bit_depth = 16;
+            bytes_per_pixel = 8;
+        }else if (layout == PNG_GRAY16) {
+            colour_type = PNG_COLOR_TYPE_GRAY;
+            bit_depth = 16;
+            bytes_per_pixel = 2;
+        }
+        rows.resize(width * height * bytes_per_pixel);
+        for (uint32 n = 0; n < width * height; ++n) {
+            const uint8* p = rgba + (n * 4);
+            png_byte* d = &rows[n * bytes_per_pixel];
+            if (layout == PNG_PALETTE) {
+                size_t index = 0;
+                while (index < palette.size() && (palette[index].red != p[0] || palette[index].green != p[1] ||
+                       palette[index].blue != p[2] || palette_alpha[index] != p[3])) ++index;
+                if (index == palette.size()) {
+                    if (index == 256) return false;
+                    png_color c = { p[0], p[1], p[2] };
+                    palette.push_back(c);
+                    palette_alpha.push_back(p[3]);
+                }
+                d[0] = png_byte(index);
+            }else if (layout == PNG_RGBA16) {
+                //v * 257 is v in both bytes
+                for (int i = 0; i < 4; ++i) d[i * 2] = d[(i * 2) + 1] = p[i];
+            }else if (layout == PNG_GRAY16) {
+                d[0] = d[1] = p[0];
+            }else {
+                memcpy(d, p, 4);
+            }
+        }
+
+        FILE* file = fopen(path.c_str(), "wb");
+        if (file == NULL) return false;
+
+        png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+        png_infop info = png_create_info_struct(png);
+        if (setjmp(png_jmpbuf(png))) {
+            png_destroy_write_struct(&png, &info);
+            fclose(file);
+            return false;
+        }
+        png_init_io(png, file);
+        png_set_IHDR(png, info, width, height, bit_depth, colour_type, layout == PNG_RGBA8_INTERLACED ? PNG_INTERLACE_ADAM7 : PNG_INTERLACE_NONE,
+                     PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+        if (layout == PNG_PALETTE) {
+            png_set_PLTE(png, info, &palette[0], int(palette.size()));
+            png_set_tRNS(png, info, &palette_alpha[0], int(palette_alpha.size()), NULL);
+        }
+        png_write_info(png, info);
+        std::vector<png_bytep> row_pointers(height);
+        for (uint32 y = 0; y < height; ++y) row_pointers[y] = &rows[y * width * bytes_per_pixel];
+        png_write_image(png, &row_pointers[0]);
+        png_write_end(png, NULL);
+        png_destroy_write_struct(&png, &info);
+        fclose(file);
+        return true;
+    }
+
+    double get_time_ms() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}};
+
+using namespace pxl;
+
+/** Usage: pxl2d_tests [test name], or pxl2d_tests --bench [benchmark name]
+**/
+int main(int argc, char** argv) {
+    bool benchmarks = argc > 1 && strcmp(argv[1], "--bench") == 0;
+    const char* filter = argc > (benchmarks ? 2 : 1) ? argv[benchmarks ? 2 : 1] : NULL;
+
+    //the parts of pxl::init that don't need a window
+    math::init();
+
+    int num_run = 0, num_failed = 0;
+    std::vector<test::TestCase>& tests = test::get_tests();
+    for (size_t n = 0; n < tests.size(); ++n) {
+        if (tests[n].benchmark != benchmarks) continue;
+        if (filter != NULL && strstr(tests[n].name, filter) == NULL) continue;
+
+        //every case starts with an empty command log and the default caps
+        graphics::reset_mock_gl();
+        graphics::set_mock_gl_caps(graphics::MockGLCaps());
+        graphics::set_mock_gl_logging(true);
+
+        int failures_before = test::num_failures;
+        std::cout << "[ RUN  ] " << tests[n].name << "\n";
+        tests[n].func();
+        bool passed = test::num_failures == failures_before;
+        std::cout << (passed ? "[  OK  ] " : "[ FAIL ] ") << tests[n].name << "\n";
+        ++num_run;
+        if (!passed) ++num_failed;
+    }
+
+    test::remove_temp_dir();
+
+    std::cout << num_run - num_failed << "/" << num_run << (benchmarks ? " benchmarks" : " tests") << " passed\n";
+    return num_failed == 0 ? 0 : 1;
+}
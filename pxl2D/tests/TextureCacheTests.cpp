@@ -0,0 +1,128 @@
+#include "Test.h"
+
+#include "graphics/TextureCache.h"
+
+using namespace pxl;
+using namespace pxl::graphics;
+
+#define CACHE_TEXTURE_SIZE 16
+#define CACHE_TEXTURE_BYTES (CACHE_TEXTURE_SIZE * CACHE_TEXTURE_SIZE * 4)
+
+/** Writes a 16x16 png filled with one colour to the temp dir and gets its path
+**/
+static std::string write_cache_png(const char* name, uint8 colour) {
+    std::vector<uint8> pixels(CACHE_TEXTURE_BYTES, colour);
+    std::string path = test::get_temp_dir() + "/" + name + ".png";
+    test::write_png(path, CACHE_TEXTURE_SIZE, CACHE_TEXTURE_SIZE, &pixels[0]);
+    return path;
+}
+
+TEST(texture_cache_hits_and_refcounts) {
+    test::init_graphics();
+    std::string path = write_cache_png("cache_a", 10);
+    TextureCache cache;
+
+    Texture* a = cache.acquire(path);
+    CHECK(a != NULL);
+    CHECK(cache.acquire(path) == a);
+    CHECK_EQ(cache.get_stats().misses, 1u);
+    CHECK_EQ(cache.get_stats().hits, 1u);
+    CHECK_EQ(cache.get_stats().textures_resident, 1u);
+    CHECK_EQ(cache.get_stats().bytes_resident, uint64(CACHE_TEXTURE_BYTES));
+
+    //premultiplied textures are cached apart from straight ones
+    Texture* premultiplied = cache.acquire(path, true);
+    CHECK(premultiplied != NULL && premultiplied != a);
+    CHECK_EQ(cache.get_stats().misses, 2u);
+    cache.release(premultiplied);
+
+    //the texture has two references, so it stays loaded until both are released
+    cache.release(a);
+    cache.evict_unused();
+    CHECK_EQ(cache.get_stats().textures_resident, 1u);
+    CHECK(cache.acquire(path) == a);
+    CHECK_EQ(cache.get_stats().hits, 2u);
+    cache.release(a);
+    cache.release(a);
+    cache.evict_unused();
+    CHECK_EQ(cache.get_stats().textures_resident, 0u);
+    CHECK_EQ(cache.get_stats().bytes_resident, 0u);
+    CHECK_EQ(cache.get_stats().evictions, 2u);
+
+    //an unknown texture or a texture released too often is ignored
+    Texture other;
+    cache.release(&other);
+    CHECK(cache.acquire(test::get_temp_dir() + "/cache_missing.png") == NULL);
+    CHECK_EQ(cache.get_stats().textures_resident, 0u);
+
+    cache.reset_stats();
+    CHECK_EQ(cache.get_stats().hits + cache.get_stats().misses + cache.get_stats().evictions, 0u);
+}
+
+TEST(texture_cache_evicts_least_recently_released) {
+    test::init_graphics();
+    std::string paths[3] = { write_cache_png("cache_lru_a", 1), write_cache_png("cache_lru_b", 2), write_cache_png("cache_lru_c", 3) };
+    TextureCache cache(CACHE_TEXTURE_BYTES * 8);
+
+    Texture* textures[3];
+    for (int n = 0; n < 3; ++n) textures[n] = cache.acquire(paths[n]);
+    cache.release(textures[1]);
+    cache.release(textures[0]);
+    cache.release(textures[2]);
+    CHECK_EQ(cache.get_stats().textures_resident, 3u);
+
+    //b was released first, so it goes first
+    cache.set_byte_budget(CACHE_TEXTURE_BYTES * 2);
+    CHECK_EQ(cache.get_stats().textures_resident, 2u);
+    CHECK_EQ(cache.get_stats().evictions, 1u);
+    CHECK(cache.acquire(paths[0]) == textures[0]);
+    CHECK(cache.acquire(paths[2]) == textures[2]);
+    CHECK_EQ(cache.get_stats().hits, 2u);
+
+    //referenced textures are never evicted, even when they alone go over the budget
+    Texture* b = cache.acquire(paths[1]);
+    CHECK(b != NULL);
+    CHECK_EQ(cache.get_stats().misses, 4u);
+    CHECK_EQ(cache.get_stats().textures_resident, 3u);
+    CHECK(cache.get_stats().bytes_resident > cache.get_byte_budget());
+
+    //releasing one while over budget evicts it straight away
+    cache.release(textures[0]);
+    CHECK_EQ(cache.get_stats().textures_resident, 2u);
+    CHECK_EQ(cache.get_stats().evictions, 2u);
+    CHECK_EQ(cache.get_stats().bytes_resident, uint64(CACHE_TEXTURE_BYTES * 2));
+
+    cache.release(textures[2]);
+    cache.release(b);
+    CHECK_EQ(cache.get_stats().textures_resident, 2u);
+    cache.clear();
+    CHECK_EQ(cache.get_stats().textures_resident, 0u);
+}
+
+TEST(texture_cache_dedupes_by_content) {
+    test::init_graphics();
+    std::string first = write_cache_png("cache_same_1", 50);
+    std::string second = write_cache_png("cache_same_2", 50);
+    std::string different = write_cache_png("cache_different", 51);
+    TextureCache cache;
+
+    Texture* a = cache.acquire_by_content(first);
+    CHECK(a != NULL);
+    CHECK(cache.acquire_by_content(second) == a);
+    CHECK(cache.acquire_by_content(different) != a);
+    CHECK(cache.acquire_by_content(first, true) != a);
+    CHECK_EQ(cache.get_stats().misses, 3u);
+    CHECK_EQ(cache.get_stats().hits, 1u);
+
+    //path keys and content keys don't share textures
+    CHECK(cache.acquire(first) != a);
+    CHECK_EQ(cache.get_stats().textures_resident, 4u);
+    CHECK(cache.acquire_by_content(test::get_temp_dir() + "/cache_missing.png") == NULL);
+    cache.clear();
+}
+
+TEST(texture_cache_shared_instance) {
+    CHECK(get_texture_cache() != NULL);
+    CHECK(get_texture_cache() == get_texture_cache());
+    CHECK_EQ(get_texture_cache()->get_byte_budget(), uint64(CONFIG_TEXTURE_CACHE_BYTE_BUDGET));
+}
@@ -0,0 +1,118 @@
+#include "Test.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <unistd.h>
+#include "graphics/Texture.h"
+#include "system/ImageIO.h"
+#include "system/TextureContainer.h"
+
+using namespace pxl;
+using namespace pxl::graphics;
+
+static Bitmap* create_test_bitmap(uint32 width, uint32 height, uint32 seed) {
+    //the bitmap takes ownership of the buffer
+    uint8* pixels = new uint8[width * height * 4];
+    srand(seed);
+    for (uint32 n = 0; n < width * height; ++n) {
+        pixels[n * 4] = uint8(n % width); pixels[n * 4 + 1] = uint8(n / width); pixels[n * 4 + 2] = uint8(rand() % 8); pixels[n * 4 + 3] = uint8(n % 7 == 0 ? 128 : 255);
+    }
+    Bitmap* bitmap = new Bitmap();
+    bitmap->create_bitmap(width, height, pixels, CHANNEL_RGBA);
+    return bitmap;
+}
+
+TEST(texture_container_round_trip) {
+    Bitmap* bitmap = create_test_bitmap(37, 21, 1);
+    for (int compress = 0; compress < 2; ++compress) {
+        std::string path = test::get_temp_dir() + "/round_trip" + std::to_string(compress) + TEXTURE_CONTAINER_EXTENSION;
+        CHECK(sys::save_texture_container(path, bitmap, compress != 0, true));
+
+        sys::TextureContainer container;
+        CHECK(container.open(path));
+        CHECK_EQ(container.is_compressed(), compress != 0);
+        CHECK_EQ(container.get_width(), 37u);
+        CHECK_EQ(container.get_height(), 21u);
+        CHECK(container.has_transparency());
+        CHECK(container.has_full_mip_chain());
+        CHECK_EQ(container.get_mip_width(1), 18u);
+        CHECK_EQ(container.get_mip_width(container.get_num_mips() - 1), 1u);
+        const uint8* pixels = container.get_mip_pixels(0);
+        CHECK(pixels != NULL && memcmp(pixels, bitmap->get_pixels(), 37 * 21 * 4) == 0);
+
+        //the texture is created from the container without going back through a bitmap
+        Texture texture;
+        CHECK(texture.create_texture(container));
+        CHECK(texture.has_transparency);
+    }
+    delete bitmap;
+}
+
+TEST(texture_container_rejects_truncated_files) {
+    Bitmap* bitmap = create_test_bitmap(16, 16, 2);
+    std::string path = test::get_temp_dir() + "/truncated" + TEXTURE_CONTAINER_EXTENSION;
+    CHECK(sys::save_texture_container(path, bitmap, true, false));
+    delete bitmap;
+
+    std::ifstream file(path.c_str(), std::ios::binary);
+    std::vector<uint8> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    sys::TextureContainer container;
+    CHECK(container.open_from_memory(&data[0], data.size()));
+    //the file ends in alignment padding, so only cuts into the payload itself make it invalid
+    sys::TextureContainerMip mip;
+    memcpy(&mip, &data[sizeof(sys::TextureContainerHeader)], sizeof(sys::TextureContainerMip));
+    size_t payload_end = mip.offset + mip.stored_size;
+    container.close();
+    for (size_t size = 0; size < payload_end; size += 7) CHECK(!container.open_from_memory(&data[0], size));
+}
+
+/** Evicts a file from the page cache, so the next load reads it from storage
+**/
+static void evict_file(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+/** Loads a 1024x1024 image into a texture from a png, a raw pxt and an lz4 pxt, with the files evicted from the page
+cache before every load (cold) and then already cached (warm)
+**/
+BENCHMARK(texture_container_cold_load) {
+    Bitmap* bitmap = create_test_bitmap(1024, 1024, 3);
+    std::string dir = test::get_temp_dir();
+    std::string paths[3] = { dir + "/cold.png", dir + "/cold_raw.pxt", dir + "/cold_lz4.pxt" };
+    test::write_png(paths[0], 1024, 1024, bitmap->get_pixels());
+    sys::save_texture_container(paths[1], bitmap, false);
+    sys::save_texture_container(paths[2], bitmap, true);
+    delete bitmap;
+
+    set_mock_gl_logging(false);
+    const char* names[3] = { "load_png", "pxt raw", "pxt lz4" };
+    const int loads = 10;
+    for (int cold = 1; cold >= 0; --cold) {
+        std::cout << "    " << (cold ? "cold:" : "warm:");
+        for (int f = 0; f < 3; ++f) {
+            double total_ms = 0;
+            for (int n = 0; n < loads; ++n) {
+                if (cold) evict_file(paths[f]);
+                double start = test::get_time_ms();
+                Texture texture;
+                if (f == 0) {
+                    texture.create_texture(paths[f]);
+                }else {
+                    sys::TextureContainer container;
+                    container.open(paths[f]);
+                    texture.create_texture(container);
+                }
+                total_ms += test::get_time_ms() - start;
+            }
+            std::ifstream file(paths[f].c_str(), std::ios::binary | std::ios::ate);
+            std::cout << " " << names[f] << " (" << file.tellg() / 1024 << " KB) " << total_ms / loads << " ms;";
+        }
+        std::cout << "\n";
+    }
+}
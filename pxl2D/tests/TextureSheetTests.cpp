@@ -0,0 +1,105 @@
+#include "Test.h"
+
+#include <chrono>
+#include <cstring>
+#include "graphics/TextureSheet.h"
+#include "system/ThreadPool.h"
+
+using namespace pxl;
+using namespace pxl::graphics;
+
+/** Fills a sheet with packed bitmaps tall enough that composite splits it into several bands
+**/
+static void add_test_bitmaps(TextureSheet& sheet, std::vector<Bitmap*>& bitmaps) {
+    for (uint32 n = 0; n < 12; ++n) {
+        Bitmap* bitmap = new Bitmap();
+        bitmap->create_bitmap(40 + n * 3, 50 + n * 5, Colour(n / 12.0f, .5f, 1 - (n / 12.0f), 1), CHANNEL_RGBA);
+        bitmaps.push_back(bitmap);
+        sheet.add_packed(bitmap);
+    }
+}
+
+TEST(texture_sheet_composite_from_pool_job) {
+    std::vector<Bitmap*> bitmaps;
+    TextureSheet sheet;
+    add_test_bitmaps(sheet, bitmaps);
+    PackSettings settings;
+    settings.max_width = 128;
+    CHECK(sheet.pack(settings));
+
+    Bitmap expected;
+    CHECK(sheet.composite(expected));
+    CHECK(expected.get_height() > CONFIG_TEXTURE_SHEET_BAND_ROWS * 2);
+
+    //every worker is busy with a job that composites, which would deadlock if the bands were queued behind it
+    sys::ThreadPool* pool = sys::get_thread_pool();
+    std::vector<Bitmap> results(pool->get_num_threads());
+    std::vector<std::future<bool>> jobs;
+    for (size_t n = 0; n < results.size(); ++n) {
+        Bitmap* result = &results[n];
+        jobs.push_back(pool->submit([&sheet, result]() { return sheet.composite(*result); }));
+    }
+    for (size_t n = 0; n < jobs.size(); ++n) {
+        bool finished = jobs[n].wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+        CHECK(finished);
+        if (!finished) std::abort();
+        CHECK(jobs[n].get());
+
+        size_t num_bytes = expected.get_width() * expected.get_height() * 4;
+        CHECK(memcmp(results[n].get_pixels(), expected.get_pixels(), num_bytes) == 0);
+    }
+
+    sheet.clear();
+    for (size_t n = 0; n < bitmaps.size(); ++n) delete bitmaps[n];
+}
+
+TEST(texture_sheet_composite_rotates_clockwise) {
+    //every pixel holds its own position and bitmap, so any pixel copied to the wrong place shows up
+    std::vector<Bitmap*> bitmaps;
+    TextureSheet sheet;
+    for (uint32 n = 0; n < 10; ++n) {
+        uint32 w = n % 2 == 0 ? 40 + n : 6 + n, h = n % 2 == 0 ? 6 + n : 40 + n;
+        uint8* pixels = new uint8[w * h * 4];
+        for (uint32 y = 0; y < h; ++y) {
+            for (uint32 x = 0; x < w; ++x) {
+                uint8* p = pixels + ((y * w + x) * 4);
+                p[0] = uint8(x); p[1] = uint8(y); p[2] = uint8(n); p[3] = 255;
+            }
+        }
+        Bitmap* bitmap = new Bitmap();
+        bitmap->create_bitmap(w, h, pixels, CHANNEL_RGBA);
+        bitmaps.push_back(bitmap);
+        sheet.add_packed(bitmap);
+    }
+    for (int method = 0; method < 2; ++method) {
+        PackSettings settings;
+        settings.method = method ? PACK_SKYLINE : PACK_MAX_RECTS;
+        settings.allow_rotation = true;
+        settings.padding = 1;
+        settings.max_width = 64;
+        CHECK(sheet.pack(settings));
+
+        Bitmap result;
+        CHECK(sheet.composite(result));
+        const std::vector<PackedRect>& rects = sheet.get_packed_rects();
+        uint32 num_rotated = 0, num_wrong = 0;
+        for (size_t n = 0; n < rects.size(); ++n) {
+            const PackedRect& rect = rects[n];
+            uint32 src_h = bitmaps[n]->get_height();
+            if (rect.rotated) ++num_rotated;
+            for (uint32 y = 0; y < rect.h; ++y) {
+                for (uint32 x = 0; x < rect.w; ++x) {
+                    const uint8* p = result.get_pixels() + (((rect.y + y) * result.get_width() + rect.x + x) * 4);
+                    //turned clockwise, the sheet's rows are the source's columns read from the bottom up
+                    uint32 src_x = rect.rotated ? y : x, src_y = rect.rotated ? src_h - 1 - x : y;
+                    if (p[0] != src_x || p[1] != src_y || p[2] != n) ++num_wrong;
+                }
+            }
+        }
+        CHECK(num_rotated > 0);
+        CHECK_EQ(num_wrong, 0u);
+    }
+
+    sheet.clear();
+    for (size_t n = 0; n < bitmaps.size(); ++n) delete bitmaps[n];
+}
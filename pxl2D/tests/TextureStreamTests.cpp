@@ -0,0 +1,164 @@
+#include "Test.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include "graphics/TextureStream.h"
+#include "system/ImageIO.h"
+
+using namespace pxl;
+using namespace pxl::graphics;
+
+/** Makes rgba pixels that differ from row to row, with a few transparent ones so has_transparency has something to find
+**/
+static std::vector<uint8> create_stream_pixels(uint32 width, uint32 height, uint32 seed) {
+    std::vector<uint8> pixels(width * height * 4);
+    srand(seed);
+    for (uint32 n = 0; n < width * height; ++n) {
+        uint8* p = &pixels[n * 4];
+        p[0] = uint8(n); p[1] = uint8(n / width); p[2] = uint8(rand()); p[3] = rand() % 7 == 0 ? 0 : 255;
+    }
+    return pixels;
+}
+
+/** Streams a png with a zero budget, checking every update uploads exactly one strip below the last, then checks the
+texture ends up holding the same pixels load_png decodes
+**/
+static void check_stream_matches_load_png(const std::string& path, const Channel* channel, uint32 strip_rows) {
+    test::init_graphics();
+    Bitmap* expected = sys::load_png(path, NULL, channel);
+    CHECK(expected != NULL);
+    if (expected == NULL) return;
+    const uint32 height = expected->get_height();
+
+    Texture texture;
+    TextureStream stream;
+    CHECK(stream.open(path, &texture, channel, strip_rows));
+    CHECK_EQ(uint32(texture.get_width()), expected->get_width());
+    CHECK_EQ(uint32(texture.get_height()), height);
+
+    reset_mock_gl();
+    uint32 num_updates = 0;
+    while (!stream.is_finished()) {
+        uint32 rows_before = stream.get_rows_uploaded();
+        uint32 uploads_before = test::count_gl_calls("glTexSubImage2D");
+        stream.update(0);
+        ++num_updates;
+
+        //one strip per update under a budget that's already spent, and every update moves forward
+        uint32 expected_rows = height - rows_before < strip_rows ? height - rows_before : strip_rows;
+        CHECK_EQ(stream.get_rows_uploaded(), rows_before + expected_rows);
+        CHECK_EQ(test::count_gl_calls("glTexSubImage2D"), uploads_before + 1);
+        if (num_updates > height) break;
+    }
+    CHECK(!stream.has_error());
+    CHECK_EQ(num_updates, (height + strip_rows - 1) / strip_rows);
+    CHECK_NEAR(stream.get_progress(), 1.0f, .0001f);
+
+    //the strips cover every row once, top to bottom and full width
+    const std::vector<MockGLCommand>& log = get_mock_gl_log();
+    int64 next_row = 0;
+    for (size_t n = 0; n < log.size(); ++n) {
+        if (strcmp(log[n].name, "glTexSubImage2D") != 0) continue;
+        CHECK_EQ(log[n].args[0], 0);
+        CHECK_EQ(log[n].args[1], next_row);
+        CHECK_EQ(log[n].args[2], int64(expected->get_width()));
+        next_row += log[n].args[3];
+    }
+    CHECK_EQ(next_row, int64(height));
+
+    const MockGLTexture* uploaded = get_mock_gl_texture(texture.get_id());
+    CHECK(uploaded != NULL);
+    if (uploaded != NULL) {
+        CHECK_EQ(uploaded->bytes_per_pixel, expected->get_channel().bytes_per_pixel);
+        CHECK_EQ(uploaded->pixels.size(), size_t(expected->get_width() * height * expected->get_channel().bytes_per_pixel));
+        CHECK(uploaded->pixels.size() == size_t(expected->get_width() * height * expected->get_channel().bytes_per_pixel) &&
+              memcmp(&uploaded->pixels[0], expected->get_pixels(), uploaded->pixels.size()) == 0);
+    }
+    CHECK_EQ(texture.has_transparency, expected->has_transparency);
+
+    texture.free();
+    delete expected;
+}
+
+TEST(texture_stream_strips_match_load_png) {
+    std::vector<uint8> pixels = create_stream_pixels(37, 50, 3);
+    std::string path = test::get_temp_dir() + "/stream.png";
+    CHECK(test::write_png(path, 37, 50, &pixels[0]));
+
+    check_stream_matches_load_png(path, NULL, 8);
+    check_stream_matches_load_png(path, NULL, 1);
+    check_stream_matches_load_png(path, NULL, 64);
+}
+
+TEST(texture_stream_converted_layouts) {
+    std::vector<uint8> pixels = create_stream_pixels(37, 50, 4);
+    std::string path = test::get_temp_dir() + "/stream_convert.png";
+    CHECK(test::write_png(path, 37, 50, &pixels[0]));
+
+    //rgb rows are 111 bytes, so the strips also check uploads with an unpack alignment of 1
+    check_stream_matches_load_png(path, &CHANNEL_RGB, 8);
+    check_stream_matches_load_png(path, &CHANNEL_RGBA_PREMULTIPLIED, 8);
+    check_stream_matches_load_png(path, &CHANNEL_RGB565, 7);
+    check_stream_matches_load_png(path, &CHANNEL_GRAY_ALPHA, 5);
+}
+
+TEST(texture_stream_interlaced) {
+    std::vector<uint8> pixels = create_stream_pixels(29, 41, 5);
+    std::string path = test::get_temp_dir() + "/stream_interlaced.png";
+    CHECK(test::write_png(path, 29, 41, &pixels[0], test::PNG_RGBA8_INTERLACED));
+
+    check_stream_matches_load_png(path, NULL, 8);
+    check_stream_matches_load_png(path, &CHANNEL_RGB, 6);
+}
+
+TEST(png_stream_reads_rows_in_order) {
+    std::vector<uint8> pixels = create_stream_pixels(23, 19, 6);
+    std::string path = test::get_temp_dir() + "/png_stream.png";
+    CHECK(test::write_png(path, 23, 19, &pixels[0]));
+
+    sys::PNGStream png;
+    CHECK(png.open(path));
+    CHECK_EQ(png.get_width(), 23u);
+    CHECK_EQ(png.get_height(), 19u);
+
+    std::vector<uint8> rows(23 * 4 * 4);
+    uint32 row = 0;
+    while (!png.is_finished()) {
+        CHECK_EQ(png.get_next_row(), row);
+        uint32 num_rows = png.read_rows(&rows[0], 4);
+        CHECK(num_rows > 0);
+        if (num_rows == 0) break;
+        CHECK(memcmp(&rows[0], &pixels[row * 23 * 4], num_rows * 23 * 4) == 0);
+        row += num_rows;
+    }
+    CHECK_EQ(row, 19u);
+    CHECK(!png.has_error());
+    CHECK(png.has_transparency());
+    CHECK_EQ(png.read_rows(&rows[0], 4), 0u);
+}
+
+TEST(texture_stream_truncated_png_stops) {
+    std::vector<uint8> pixels = create_stream_pixels(64, 64, 7);
+    std::string path = test::get_temp_dir() + "/stream_full.png";
+    CHECK(test::write_png(path, 64, 64, &pixels[0]));
+
+    //keep the header and the start of the image data
+    std::ifstream in(path.c_str(), std::ios::binary);
+    std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::string truncated_path = test::get_temp_dir() + "/stream_truncated.png";
+    std::ofstream out(truncated_path.c_str(), std::ios::binary);
+    out.write(&data[0], data.size() / 3);
+    out.close();
+
+    test::init_graphics();
+    Texture texture;
+    TextureStream stream;
+    CHECK(stream.open(truncated_path, &texture, NULL, 8));
+    uint32 num_updates = 0;
+    while (!stream.update(0) && num_updates < 64) ++num_updates;
+    CHECK(stream.is_finished());
+    CHECK(stream.has_error());
+    CHECK(stream.get_rows_uploaded() < 64u);
+    texture.free();
+}
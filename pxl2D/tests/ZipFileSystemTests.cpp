@@ -0,0 +1,226 @@
+#include "Test.h"
+
+#include <cstring>
+#include <fstream>
+#include <zlib.h>
+#include "graphics/Bitmap.h"
+#include "system/FileSystem.h"
+#include "system/ImageIO.h"
+
+using namespace pxl;
+
+/** Builds a zip archive in memory, one stored or deflated entry at a time
+**/
+struct ZipWriter {
+
+    std::vector<uint8> data;
+    std::vector<uint8> directory;
+    uint16 num_entries = 0;
+
+    static void put_u16(std::vector<uint8>& out, uint32 v) { out.push_back(uint8(v)); out.push_back(uint8(v >> 8)); }
+    static void put_u32(std::vector<uint8>& out, uint32 v) { put_u16(out, v & 0xffff); put_u16(out, v >> 16); }
+
+    /** Adds an entry and gets the offset of its payload in the archive
+    **/
+    size_t add(const std::string& name, const std::vector<uint8>& contents, bool deflated) {
+        std::vector<uint8> payload = contents;
+        if (deflated) {
+            //zip entries are raw deflate streams without a zlib header
+            payload.resize(deflateBound(NULL, uLong(contents.size())) + 64);
+            z_stream stream;
+            memset(&stream, 0, sizeof(z_stream));
+            deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+            stream.next_in = (Bytef*)(contents.empty() ? NULL : &contents[0]);
+            stream.avail_in = uInt(contents.size());
+            stream.next_out = &payload[0];
+            stream.avail_out = uInt(payload.size());
+            deflate(&stream, Z_FINISH);
+            payload.resize(stream.total_out);
+            deflateEnd(&stream);
+        }
+        uint32 crc = uint32(crc32(0, contents.empty() ? NULL : &contents[0], uInt(contents.size())));
+        uint32 header_offset = uint32(data.size());
+        uint16 method = deflated ? 8 : 0;
+
+        put_u32(data, 0x04034b50);
+        put_u16(data, 20); put_u16(data, 0); put_u16(data, method); put_u16(data, 0); put_u16(data, 0);
+        put_u32(data, crc); put_u32(data, uint32(payload.size())); put_u32(data, uint32(contents.size()));
+        put_u16(data, uint32(name.size())); put_u16(data, 0);
+        data.insert(data.end(), name.begin(), name.end());
+        size_t payload_offset = data.size();
+        data.insert(data.end(), payload.begin(), payload.end());
+
+        put_u32(directory, 0x02014b50);
+        put_u16(directory, 20); put_u16(directory, 20); put_u16(directory, 0); put_u16(directory, method);
+        put_u16(directory, 0); put_u16(directory, 0);
+        put_u32(directory, crc); put_u32(directory, uint32(payload.size())); put_u32(directory, uint32(contents.size()));
+        put_u16(directory, uint32(name.size())); put_u16(directory, 0); put_u16(directory, 0);
+        put_u16(directory, 0); put_u16(directory, 0); put_u32(directory, 0);
+        put_u32(directory, header_offset);
+        directory.insert(directory.end(), name.begin(), name.end());
+        ++num_entries;
+        return payload_offset;
+    }
+
+    /** Gets the finished archive, with the central directory and end record after the entries
+    **/
+    std::vector<uint8> finish(const std::string& comment = "") const {
+        std::vector<uint8> archive = data;
+        archive.insert(archive.end(), directory.begin(), directory.end());
+        put_u32(archive, 0x06054b50);
+        put_u16(archive, 0); put_u16(archive, 0); put_u16(archive, num_entries); put_u16(archive, num_entries);
+        put_u32(archive, uint32(directory.size())); put_u32(archive, uint32(data.size()));
+        put_u16(archive, uint32(comment.size()));
+        archive.insert(archive.end(), comment.begin(), comment.end());
+        return archive;
+    }
+};
+
+static std::vector<uint8> make_contents(size_t size, uint32 seed) {
+    //repeats often enough for deflate to shrink it
+    std::vector<uint8> contents(size);
+    for (size_t n = 0; n < size; ++n) contents[n] = uint8((n / 7) * seed);
+    return contents;
+}
+
+static std::string write_archive(const char* name, const std::vector<uint8>& archive) {
+    std::string path = test::get_temp_dir() + "/" + name;
+    std::ofstream file(path.c_str(), std::ios::binary);
+    if (!archive.empty()) file.write((const char*)&archive[0], archive.size());
+    return path;
+}
+
+/** Opens a file through a zip file system and checks it holds contents
+**/
+static bool zip_file_matches(sys::ZipFileSystem& zip, const std::string& name, const std::vector<uint8>& contents) {
+    sys::MappedFile file;
+    if (!file.open(name, &zip)) return false;
+    return file.get_size() == contents.size() && (contents.empty() || memcmp(file.get_data(), &contents[0], contents.size()) == 0);
+}
+
+TEST(zip_reads_stored_and_deflated_entries) {
+    std::vector<uint8> stored = make_contents(3000, 3);
+    std::vector<uint8> deflated = make_contents(20000, 5);
+    std::vector<uint8> empty;
+    ZipWriter writer;
+    writer.add("stored.bin", stored, false);
+    writer.add("dir/deflated.bin", deflated, true);
+    writer.add("empty_deflated.bin", empty, true);
+    writer.add("empty_stored.bin", empty, false);
+    writer.add("dir/", empty, false);
+    std::string path = write_archive("entries.zip", writer.finish("an archive comment"));
+
+    sys::ZipFileSystem zip;
+    CHECK(zip.open_archive(path));
+    CHECK_EQ(zip.get_num_entries(), size_t(4));
+    CHECK(zip_file_matches(zip, "stored.bin", stored));
+    CHECK(zip_file_matches(zip, "dir/deflated.bin", deflated));
+    CHECK(zip_file_matches(zip, "empty_deflated.bin", empty));
+    CHECK(zip_file_matches(zip, "empty_stored.bin", empty));
+    CHECK(zip.exists("dir/deflated.bin"));
+    CHECK(!zip.exists("dir/"));
+    CHECK(!zip.exists("deflated.bin"));
+
+    sys::MappedFile missing;
+    CHECK(!missing.open("missing.bin", &zip));
+}
+
+TEST(zip_strips_prefix) {
+    std::vector<uint8> sprite = make_contents(500, 7);
+    std::vector<uint8> lib = make_contents(200, 9);
+    ZipWriter writer;
+    writer.add("assets/", std::vector<uint8>(), false);
+    writer.add("assets/sprites/a.bin", sprite, true);
+    writer.add("lib/libgame.so", lib, false);
+    writer.add("assets", lib, false);
+    std::string path = write_archive("prefix.zip", writer.finish());
+
+    sys::ZipFileSystem zip;
+    CHECK(zip.open_archive(path, "assets/"));
+    CHECK_EQ(zip.get_num_entries(), size_t(1));
+    CHECK(zip_file_matches(zip, "sprites/a.bin", sprite));
+    CHECK(!zip.exists("assets/sprites/a.bin"));
+    CHECK(!zip.exists("lib/libgame.so"));
+
+    //reopening without a prefix serves every file by its full name
+    CHECK(zip.open_archive(path));
+    CHECK_EQ(zip.get_num_entries(), size_t(3));
+    CHECK(zip_file_matches(zip, "assets/sprites/a.bin", sprite));
+    CHECK(zip_file_matches(zip, "lib/libgame.so", lib));
+}
+
+TEST(zip_serves_pngs_as_current_file_system) {
+    std::vector<uint8> pixels(12 * 9 * 4);
+    for (size_t n = 0; n < pixels.size(); ++n) pixels[n] = uint8(n * 13);
+    std::string png_path = test::get_temp_dir() + "/zip_sprite.png";
+    CHECK(test::write_png(png_path, 12, 9, &pixels[0]));
+    std::ifstream png_file(png_path.c_str(), std::ios::binary);
+    std::vector<uint8> png((std::istreambuf_iterator<char>(png_file)), std::istreambuf_iterator<char>());
+
+    ZipWriter writer;
+    writer.add("assets/stored.png", png, false);
+    writer.add("assets/deflated.png", png, true);
+    std::string path = write_archive("pngs.zip", writer.finish());
+
+    sys::ZipFileSystem zip;
+    CHECK(zip.open_archive(path, "assets/"));
+    sys::set_file_system(&zip);
+    graphics::Bitmap* stored = sys::load_png("stored.png");
+    graphics::Bitmap* deflated = sys::load_png("deflated.png");
+    sys::set_file_system(NULL);
+
+    CHECK(stored != NULL && deflated != NULL);
+    if (stored != NULL) CHECK(memcmp(stored->get_pixels(), &pixels[0], pixels.size()) == 0);
+    if (deflated != NULL) CHECK(memcmp(deflated->get_pixels(), &pixels[0], pixels.size()) == 0);
+    delete stored;
+    delete deflated;
+}
+
+TEST(zip_rejects_truncated_and_corrupt_archives) {
+    std::vector<uint8> stored = make_contents(4000, 11);
+    std::vector<uint8> deflated = make_contents(4000, 13);
+    ZipWriter writer;
+    size_t stored_offset = writer.add("stored.bin", stored, false);
+    size_t deflated_offset = writer.add("deflated.bin", deflated, true);
+    const std::vector<uint8> archive = writer.finish();
+    sys::ZipFileSystem zip;
+
+    //every cut loses the end record, or leaves it pointing past the end of the file
+    const size_t cuts[] = { 0, 10, stored_offset + 100, deflated_offset + 10, archive.size() - 30, archive.size() - 1 };
+    for (size_t n = 0; n < sizeof(cuts) / sizeof(cuts[0]); ++n) {
+        std::vector<uint8> truncated(archive.begin(), archive.begin() + cuts[n]);
+        CHECK(!zip.open_archive(write_archive("truncated.zip", truncated)));
+        CHECK_EQ(zip.get_num_entries(), size_t(0));
+    }
+
+    //a central directory past the end of the archive
+    std::vector<uint8> bad_directory = archive;
+    bad_directory[bad_directory.size() - 6] = 0xff;
+    bad_directory[bad_directory.size() - 5] = 0xff;
+    CHECK(!zip.open_archive(write_archive("bad_directory.zip", bad_directory)));
+
+    //a corrupt deflate stream fails to open without taking the stored entry down with it
+    std::vector<uint8> corrupt = archive;
+    for (size_t n = deflated_offset; n < deflated_offset + 16; ++n) corrupt[n] ^= 0x5a;
+    CHECK(zip.open_archive(write_archive("corrupt.zip", corrupt)));
+    CHECK(zip.exists("deflated.bin"));
+    sys::MappedFile file;
+    CHECK(!file.open("deflated.bin", &zip));
+    CHECK(zip_file_matches(zip, "stored.bin", stored));
+
+    //a local header that doesn't start with its signature
+    std::vector<uint8> bad_header = archive;
+    bad_header[0] = 0;
+    CHECK(zip.open_archive(write_archive("bad_header.zip", bad_header)));
+    CHECK(!file.open("stored.bin", &zip));
+    CHECK(zip_file_matches(zip, "deflated.bin", deflated));
+
+    //an unsupported compression method, set in the central directory
+    std::vector<uint8> bad_method = archive;
+    size_t directory_offset = writer.data.size();
+    bad_method[directory_offset + 10] = 12;
+    CHECK(zip.open_archive(write_archive("bad_method.zip", bad_method)));
+    CHECK(!file.open("stored.bin", &zip));
+
+    CHECK(!zip.open_archive(test::get_temp_dir() + "/missing.zip"));
+}
@@ -0,0 +1,17 @@
+#include "SDL.h"
+
+//headless windows have no surface, so they report the default batch size of 1024x768
+
+int SDL_Init(unsigned int) { return 0; }
+void SDL_Quit() {}
+
+SDL_Window* SDL_CreateWindow(const char*, int, int, int, int, unsigned int) { return (SDL_Window*)1; }
+void SDL_DestroyWindow(SDL_Window*) {}
+
+void SDL_GetWindowSize(SDL_Window*, int* w, int* h) {
+    if (w != 0) *w = 1024;
+    if (h != 0) *h = 768;
+}
+
+SDL_GLContext SDL_GL_CreateContext(SDL_Window*) { return (SDL_GLContext)1; }
+void SDL_GL_DeleteContext(SDL_GLContext) {}
@@ -0,0 +1,20 @@
+#ifndef _PXL_TESTS_SDL_H
+#define _PXL_TESTS_SDL_H
+
+//stand in for the SDL functions pxl uses, so windows can be created (without showing anything) in the tests
+
+typedef struct SDL_Window SDL_Window;
+typedef void* SDL_GLContext;
+
+#define SDL_INIT_EVERYTHING 0
+#define SDL_WINDOW_OPENGL 0
+
+extern int SDL_Init(unsigned int flags);
+extern void SDL_Quit();
+extern SDL_Window* SDL_CreateWindow(const char* title, int x, int y, int w, int h, unsigned int flags);
+extern void SDL_DestroyWindow(SDL_Window* window);
+extern void SDL_GetWindowSize(SDL_Window* window, int* w, int* h);
+extern SDL_GLContext SDL_GL_CreateContext(SDL_Window* window);
+extern void SDL_GL_DeleteContext(SDL_GLContext context);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef _PXL_TESTS_GLEW_H
+#define _PXL_TESTS_GLEW_H
+
+//stand in for glew when building the tests headless. PXL_MOCK_GL redirects every GL call and GLEW_ capability
+//pxl uses, so only the GL types and enums are needed from the system headers
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#define GLEW_OK 0
+
+#endif